@@ -0,0 +1,107 @@
+#ifndef LIBWTK_SDL2_ANIMATION_SCHEDULER_HPP
+#define LIBWTK_SDL2_ANIMATION_SCHEDULER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+typedef std::size_t animation_handle;
+
+// Never returned by the scheduler, such that it can be used for animations
+// that do not run.
+animation_handle const NO_ANIMATION = 0;
+
+/**
+ * Drives animations and timers from the event loop. Animations are advanced
+ * once per frame while they run, timers fire when their deadline passed. When
+ * nothing is scheduled no frames are requested at all, and otherwise only at
+ * the next deadline, such that an idle application does not wake up.
+ */
+struct animation_scheduler
+{
+    typedef std::chrono::steady_clock clock;
+
+    /**
+     * Called with the time since the last step, the first step gets the time
+     * since the start. Returning false ends the animation.
+     */
+    typedef std::function<bool(clock::duration)> step_function;
+
+    animation_scheduler();
+
+    animation_handle start_animation(step_function step);
+
+    /**
+     * Fires once after the delay.
+     */
+    animation_handle start_timer(clock::duration delay, std::function<void()> f);
+
+    /**
+     * Fires every interval until it is stopped. Deadlines do not drift, but
+     * intervals missed entirely, e.g., during a suspend, are skipped.
+     */
+    animation_handle start_repeating_timer(clock::duration interval, std::function<void()> f);
+
+    /**
+     * Works for animations as well as timers. Stopping one that has ended
+     * already has no effect.
+     */
+    void stop(animation_handle h);
+
+    bool is_running(animation_handle h) const;
+
+    void set_frame_interval(clock::duration interval);
+
+    /**
+     * Steps the animations and fires the timers that are due. Animations and
+     * timers may be started and stopped from within.
+     */
+    void advance(clock::time_point now);
+
+    /**
+     * Milliseconds until advance() has to be called again, suitable for
+     * SDL_WaitEventTimeout(). Returns -1 when nothing is scheduled.
+     */
+    int timeout(clock::time_point now) const;
+
+    bool empty() const;
+
+    private:
+
+    struct animation
+    {
+        animation_handle handle;
+        step_function step;
+        clock::time_point last_step;
+    };
+
+    struct timer
+    {
+        animation_handle handle;
+        clock::time_point deadline;
+
+        // Zero for timers that fire once.
+        clock::duration interval;
+        std::function<void()> fire;
+    };
+
+    animation_handle next_handle();
+
+    // Orders the heap of timers, earliest on top.
+    static bool later_deadline(timer const & a, timer const & b);
+
+    void push_timer(timer t);
+
+    std::vector<animation> _animations;
+
+    // A binary heap with the earliest deadline on top.
+    std::vector<timer> _timers;
+
+    animation_handle _last_handle;
+    clock::duration _frame_interval;
+    clock::time_point _last_advance;
+};
+
+#endif
+
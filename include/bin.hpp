@@ -23,12 +23,16 @@ struct bin : widget
     // geometry of the bin (i.e. if there is some kind of padding).
     size_hint get_size_hint(int width, int height) const override;
 
-    std::vector<widget *> get_children() override;
-    std::vector<widget const *> get_children() const override;
+    widget_range get_children() override;
+    const_widget_range get_children() const override;
 
     protected:
 
     widget_ptr _child;
+
+    private:
+
+    widget * _child_ptr;
 };
 
 #endif
@@ -35,30 +35,40 @@ struct box : container
     widget * find_selectable(navigation_type nt, point center) override;
     widget * navigate_selectable_from_children(navigation_type nt, widget * w, point center) override;
     size_hint get_size_hint(int width, int height) const override;
+    widget * find_child_at(point p) override;
 
     ~box() override;
 
 
-    std::vector<widget *> get_children() override;
-    std::vector<widget const *> get_children() const override;
+    widget_range get_children() override;
+    const_widget_range get_children() const override;
 
     /**
      * @name Box Interface
      * @{
      */
 
-    /** @} */
+    std::size_t size() const;
 
-    private:
+    /**
+     * Inserts the child before the one at the position, a position past the
+     * end appends it. Only the box is laid out again if its size allows it.
+     */
+    void insert(std::size_t position, child c);
 
-    // Finds the relevant distance based on the containers orientation.
-    int relevant_distance(point old_center, point new_center) const;
+    /**
+     * Returns the removed widget, such that it may be inserted elsewhere.
+     * Throws std::out_of_range if there is no child at the position.
+     */
+    widget_ptr remove(std::size_t position);
+    widget_ptr replace(std::size_t position, child c);
 
-    // Check for orthogonality to container orientation.
-    bool is_orthogonal(navigation_type nt) const;
+    /** @} */
 
+    private:
 
     children_type _children;
+    std::vector<widget *> _child_ptrs;
     int _children_spacing;
     bool _children_homogeneous;
 
@@ -66,6 +76,45 @@ struct box : container
 
 };
 
+/**
+ * What the layout of a box uses of a child.
+ */
+struct box_layout_item
+{
+    size_hint hint;
+    bool expand;
+
+    // See region::can_use_intermediate_size().
+    bool intermediate;
+};
+
+/**
+ * @name Box Layout
+ * The layout and navigation of \ref box on children that are not necessarily
+ * stored in one, e.g., of a \ref static_box. Hints are queried with the width
+ * for vertical boxes and with the height for horizontal ones.
+ * @{
+ */
+
+/**
+ * Computes the boxes of the children within the area.
+ */
+void layout_box_items(box::orientation o, rect area, int spacing, bool homogeneous, box_layout_item const * items, rect * boxes, std::size_t n);
+
+size_hint box_items_size_hint(box::orientation o, int spacing, bool homogeneous, size_hint const * hints, std::size_t n);
+
+widget * find_selectable_in_box(box::orientation o, widget_range children, navigation_type nt, point center);
+
+/**
+ * Returns the next selectable widget after the child w, or nullptr if the
+ * navigation has to continue in the parent.
+ */
+widget * navigate_in_box(box::orientation o, widget_range children, widget * w, navigation_type nt, point center);
+
+widget * find_child_in_box(box::orientation o, widget_range children, point p);
+
+/** @} */
+
 widget_ptr hbox(box::children_type children);
 widget_ptr vbox(box::children_type children);
 
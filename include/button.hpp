@@ -10,6 +10,7 @@ struct button : selectable
     button(std::function<void()> callback);
 
     void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
     void on_mouse_up_event(mouse_up_event const & e) override;
     void on_mouse_down_event(mouse_down_event const & e) override;
     void on_key_event(key_event const & e) override;
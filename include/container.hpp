@@ -6,24 +6,47 @@
 #include "widget.hpp"
 
 // Base class for containers with multiple widgets that are all drawn to a
-// common area.
+// common area. Mouse events are only forwarded to the child at the position
+// and to the child that received the last mouse down event, until the
+// button is released.
 struct container : widget
 {
+    container();
     ~container() override;
     void on_draw(draw_context & dc, selection_context const & sc) const override;
     void on_mouse_up_event(mouse_up_event const & me) override;
     void on_mouse_down_event(mouse_down_event const & me) override;
     void on_mouse_move_event(mouse_move_event const & e) override;
+    void on_mouse_capture_released(pointer_id id) override;
 
-    std::vector<widget *> get_children() override = 0;
-    std::vector<widget const *> get_children() const override = 0;
+    widget_range get_children() override = 0;
+    const_widget_range get_children() const override = 0;
     void on_box_allocated() override = 0;
     widget * find_selectable(navigation_type nt, point center) override = 0;
 
+    // Returns the child at the point or nullptr. The default implementation
+    // tests all children, layouts with ordered children should provide a
+    // faster lookup.
+    virtual widget * find_child_at(point p);
+
     protected:
 
     void init_children();
 
+    // Ends the press of the pressed child with an up event outside of its
+    // box, e.g., once the container follows a drag instead, such that a
+    // button is not clicked.
+    void cancel_pressed_child(pointer_id id);
+
+    void detach_child(widget & child) override;
+
+    // Has to be called after children were added or removed. The layout is
+    // redone within the current box if possible.
+    void children_changed();
+
+    private:
+
+    widget * _pressed_child;
 };
 
 #endif
@@ -1,16 +1,26 @@
 #ifndef LIBWTK_SDL2_CONTEXT_INFO_HPP
 #define LIBWTK_SDL2_CONTEXT_INFO_HPP
 
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "animation_scheduler.hpp"
 #include "font_manager.hpp"
+#include "region.hpp"
 #include "swipe.hpp"
 
+struct widget_batch;
+
 struct context_info
 {
     context_info(font_manager & fm, swipe_config swipe_cfg);
 
     // fonts
-    vec text_size(std::string t, int max_line_width = -1, int font_idx = 0) const;
-    int text_minimum_width(std::string t, int font_idx = 0) const;
+    vec text_size(std::string_view t, int max_line_width = -1, int font_idx = 0) const;
+    vec text_size(interned_text const & t, int max_line_width = -1, int font_idx = 0) const;
+    int text_minimum_width(std::string_view t, int font_idx = 0) const;
+    void text_line_starts(std::string_view t, int max_line_width, std::vector<std::size_t> & starts, int font_idx = 0) const;
     unsigned int font_height(int font_idx = 0) const;
     int font_line_skip(int font_idx = 0) const;
 
@@ -19,9 +29,30 @@ struct context_info
 
     // input
     swipe_config const swipe_cfg;
+    void capture_mouse(widget & w, pointer_id id) const;
+
+    // layout
+    void set_region_control(region_control * rc);
+    void queue_redo_layout() const;
+    void notify_widget_detached(widget & w) const;
+
+    // Returns nullptr unless the widgets are changed in a batch.
+    void set_widget_batch(widget_batch * b);
+    widget_batch * get_widget_batch() const;
+
+    // animation
+    void set_animation_scheduler(animation_scheduler * as);
+
+    // Returns NO_ANIMATION if there is no scheduler.
+    animation_handle start_animation(animation_scheduler::step_function step) const;
+    void stop_animation(animation_handle h) const;
 
     private:
 
+    region_control * _region_control;
+    widget_batch * _widget_batch;
+    animation_scheduler * _animation_scheduler;
+
     // mutable is a necessary evil, but doesn't change it in a meaningful way
     mutable std::reference_wrapper<font_manager> _fm;
 };
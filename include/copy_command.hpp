@@ -1,6 +1,8 @@
 #ifndef LIBWTK_SDL2_COPY_COMMAND_HPP
 #define LIBWTK_SDL2_COPY_COMMAND_HPP
 
+#include <cstdint>
+
 #include "geometry.hpp"
 
 struct SDL_Texture;
@@ -16,6 +18,12 @@ struct copy_command
     // The offset of the target coordinates.
     int x_offset;
     int y_offset;
+
+    // The coverage of the source area, if it has been kept.
+    uint8_t const * alpha;
+
+    // The size on the target, differs from the source for scaled fonts.
+    vec size;
 };
 
 #endif
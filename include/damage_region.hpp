@@ -0,0 +1,31 @@
+#ifndef LIBWTK_SDL2_DAMAGE_REGION_HPP
+#define LIBWTK_SDL2_DAMAGE_REGION_HPP
+
+#include <vector>
+
+#include "geometry.hpp"
+
+// The area of a frame that has changed, kept as a small list of rectangles.
+// Rectangles are merged when that does not cover much more area, or when there
+// would be too many of them otherwise.
+struct damage_region
+{
+    damage_region();
+
+    void add(rect r);
+    void add(damage_region const & other);
+    void clear();
+
+    bool empty() const;
+    std::vector<rect> const & rects() const;
+
+    // The smallest rectangle that contains the whole region.
+    rect bounding_box() const;
+
+    private:
+
+    std::vector<rect> _rects;
+};
+
+#endif
+
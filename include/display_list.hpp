@@ -0,0 +1,90 @@
+#ifndef LIBWTK_SDL2_DISPLAY_LIST_HPP
+#define LIBWTK_SDL2_DISPLAY_LIST_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <SDL2/SDL_blendmode.h>
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+#include "geometry.hpp"
+#include "sdl_util.hpp"
+
+// The renderer state a drawing operation depends on.
+struct render_state
+{
+    SDL_Color draw_color;
+    SDL_BlendMode blend_mode;
+    std::optional<rect> clip;
+    std::optional<rect> viewport;
+};
+
+// The source of a copy. Backends that do not draw with the renderer use the
+// pixels instead of the texture, if they are available.
+struct texture_ref
+{
+    SDL_Texture * texture;
+
+    // Coverage of the copied source area, one byte per pixel and rows of the
+    // source width, drawn in the color modulation of the texture.
+    uint8_t const * alpha;
+
+    SDL_Surface * surface;
+};
+
+bool same_texture(texture_ref const & a, texture_ref const & b);
+
+bool same_color(SDL_Color a, SDL_Color b);
+bool same_optional_rect(std::optional<rect> const & a, std::optional<rect> const & b);
+
+bool operator==(render_state const & a, render_state const & b);
+
+enum class display_command_type
+{
+    FILL_RECT,
+    DRAW_RECT,
+    COPY
+};
+
+struct display_command
+{
+    display_command_type type;
+    render_state state;
+
+    // Relative to the viewport of the state.
+    rect target;
+
+    // Only used for copies.
+    texture_ref texture;
+    std::optional<rect> source;
+    std::optional<SDL_Color> color_mod;
+};
+
+/**
+ * Drawing operations recorded by a draw_context. Submitting the list to a
+ * draw_context merges operations that do not depend on their order.
+ */
+struct display_list
+{
+    void clear();
+
+    bool empty() const;
+
+    void push(display_command const & c);
+
+    // Keeps a texture alive until the list is cleared or destroyed.
+    void own(unique_texture_ptr t);
+
+    std::vector<display_command> const & commands() const;
+
+    private:
+
+    std::vector<display_command> _commands;
+    std::vector<unique_texture_ptr> _owned_textures;
+};
+
+#endif
+
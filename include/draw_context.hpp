@@ -1,142 +1,79 @@
 #ifndef LIBWTK_SDL2_DRAW_CONTEXT_HPP
 #define LIBWTK_SDL2_DRAW_CONTEXT_HPP
 
+#include <array>
+#include <cstddef>
 #include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
 #include <SDL2/SDL_surface.h>
 #include <SDL2/SDL_render.h>
 
 #include "copy_command.hpp"
+#include "damage_region.hpp"
+#include "display_list.hpp"
 #include "font_manager.hpp"
 #include "geometry.hpp"
+#include "memory_budget.hpp"
+#include "render_backend.hpp"
+#include "sdl_util.hpp"
+#include "theme.hpp"
 
-// TODO replace rendering with a virtual interface that might as well blit images
-struct color_theme
+struct draw_context : memory_client
 {
-    color_theme();
-
-    SDL_Color button_bg_color;
-    SDL_Color button_fg_color;
-    SDL_Color button_frame_color;
-    SDL_Color button_pressed_bg_color;
-    SDL_Color button_selected_bg_color;
-
-    SDL_Color entry_selected_bg_color;
-    SDL_Color entry_highlight_bg_color;
-
-    SDL_Color entry_box_bg_color;
-    SDL_Color entry_box_frame_color;
-    SDL_Color entry_box_selected_frame_color;
-
-    SDL_Color bg_color;
-
-    // displays the status of something, but not related to direct user interaction
-    SDL_Color active_color;
-
-    SDL_Color hightlight_color;
-};
-
-/*
-struct theme
-{
-    enum class box_type
-    {
-        BUTTON,
-        LIST,
-        TEXT_ENTRY
-    };
-
-    enum class state
-    {
-        IDLE = 0
-        PRESSED = 1,
-        SELECTED = 2,
-    };
-
-    static state operator|(state l, state r)
-    {
-        return static_cast<state>(static_cast<int>(l) | static_cast<int>(r));
-    }
+    // draw to a window exclusively
+    draw_context(SDL_Renderer * renderer, font_manager & fm);
 
-    static bool operator&(state l, state r)
-    {
-        return static_cast<int>(l) & static_cast<int>(r);
-    }
+    // Draws with the backend instead. The renderer is still used for the
+    // textures of the font caches and blitted surfaces. A backend that needs
+    // pixels makes the font manager keep the coverage of rendered words.
+    draw_context(SDL_Renderer * renderer, font_manager & fm, std::unique_ptr<render_backend> backend);
 
-    virtual int box_border_width(box_type bt, state s) = 0;
-    virtual void draw_box(box_type bt, state s, rect box) = 0;
-};
+    void present();
 
-struct default_theme : theme
-{
-    int box_border_width(box_type bt, state s) override
-    {
-    }
-    void draw_box(box_type bt, state s, rect box) override
-    {
-    }
+    // Presents a frame where only the given area has changed. Backends may
+    // then only update those parts of the display.
+    void present(damage_region const & damage);
 
-    struct box_colors
-    {
-        SDL_Color bg;
-        SDL_Color fg;
-        SDL_Color frame;
-    };
+    // Restricts all drawing to the rectangle, in addition to the clip rect
+    // used for drawing. Pass nullptr to draw everywhere again.
+    void set_scissor(rect const * r);
+    std::optional<rect> get_scissor() const;
 
-    default_theme()
-        : button_bg_color{25, 25, 25}
-        , button_fg_color{235, 235, 235}
-        , button_frame_color{105, 105, 105}
-        , button_pressed_bg_color{105, 55, 55}
-        , button_selected_bg_color{55, 55, 105}
-        , entry_bg_color{255, 255, 255}
-        , entry_frame_color{100, 100, 100}
-        , entry_selected_bg_color{250, 200, 200}
-        , bg_color{0, 0, 0}
-        , active_color{230, 230, 255}
-    {
-        box_colors base { {25, 25, 25}, {235, 235, 235}, {105, 105, 105} };
-
-        // 0 - theme::box_type::BUTTON
-        _colors[(int)box_type::BUTTON][(int)state::IDLE] = base;
-        base.bg = {105, 55, 55};
-        _colors[(int)box_type::BUTTON][(int)state::PRESSED] = base;
-        base.frame = {55, 55, 105} // TODO brighter
-        _colors[(int)box_type::BUTTON][(int)state::PRESSED | state::SELECTED] = base;
-        base.bg = {25, 25, 25};
-        _colors[(int)box_type::BUTTON][(int)state::SELECTED] = base;
-
-        // 1 - theme::box_type::LIST
-        base = {{255, 255, 255}, {0, 0, 0}, {100, 100, 100}};
-        _colors[(int)box_type::LIST][(int)state::IDLE] = base;
-        _colors[(int)box_type::LIST][(int)state::PRESSED] = base;
-        base.frame = {55, 55, 105};
-        _colors[(int)box_type::LIST][(int)state::PRESSED | state::SELECTED] = base;
-        _colors[(int)box_type::LIST][(int)state::SELECTED] = base;
-
-        // 2 - theme::box_type::TEXT_ENTRY
-    }
+    // Containers that only show part of their children, e.g., when
+    // scrolling, may restrict the visible area to their viewport. Nested
+    // areas are intersected.
+    void push_visible_area(rect r);
+    void pop_visible_area();
 
-    private:
+    // Whether anything drawn within the box might be visible, considering the
+    // scissor and the visible area. Used to skip the drawing of widgets.
+    bool is_visible(rect box) const;
 
-    // for each state includes colors for: background, foreground (e.g., font), frame
-    box_colors[2][4] _colors;
-};
-*/
+    // The theme is shared by all widgets of the context, changing it renders
+    // its sprites again.
+    void set_theme(std::shared_ptr<theme const> t);
+    theme const & get_theme() const;
 
-struct draw_context
-{
-    // draw to a window exclusively
-    draw_context(SDL_Renderer * renderer, font_manager & fm);
-
-    void present();
+    // Draws the sprite of the theme stretched to the box.
+    void draw_box(box_type bt, box_state s, rect box);
 
     // button (heightened box)
     void draw_button_box(rect box, bool activated, bool selected);
-    void draw_button_text(std::string const & text, rect abs_rect);
+    void draw_button_text(std::string_view text, rect abs_rect);
+    void draw_button_text(interned_text const & text, rect abs_rect);
 
     // entry (lowered box)
     void draw_entry_box(rect box, bool selected);
-    void draw_entry_text(std::string text, rect abs_rect, int texture_x_offset = 0, int texture_y_offset = 0);
+    void draw_entry_background(rect box);
+    void draw_entry_text(std::string_view text, rect abs_rect, int texture_x_offset = 0, int texture_y_offset = 0);
     void draw_entry_pressed_background(rect box);
     void draw_entry_active_background(rect box);
     void draw_entry_hightlighted_background(rect box);
@@ -145,8 +82,13 @@ struct draw_context
     void draw_radio_entry(rect box, bool active, bool selected);
 
     // Draws a string in the box and returns the actually used height within the
-    // box.
-    int draw_label_text(rect box, std::string text, bool wrap, int font_idx = 0);
+    // box. The background has to be cleared before.
+    int draw_label_text(rect box, std::string_view text, bool wrap, int font_idx = 0);
+    int draw_label_text(rect box, interned_text const & text, bool wrap, int font_idx = 0);
+
+    // Draws a single line of text at the origin, clipped to the box, e.g.,
+    // a line that is only partially visible.
+    void draw_text_line(point origin, rect clip_box, std::string_view text, int font_idx = 0);
 
     void draw_background(rect box);
 
@@ -155,20 +97,176 @@ struct draw_context
     void set_color_alpha(SDL_Color c);
     void draw_rect_filled(rect r);
     void draw_rect(rect r);
+    void draw_rect_blended(rect r, SDL_Color c);
+    // Surfaces are uploaded to a cached texture. It is reused as long as the
+    // surface is not invalidated, which is necessary whenever its content
+    // changes. A surface has to be forgotten before it is freed, otherwise a
+    // new surface at the same address would be drawn with the old texture.
     void blit(SDL_Surface * s, const rect * srcrect, const rect * dstrect);
+    void invalidate_surface(SDL_Surface * s);
+    void forget_surface(SDL_Surface * s);
     void run_copy_commands(std::vector<copy_command> const & commands, point origin, SDL_Color color);
     void copy_texture(SDL_Texture * t, rect src, rect dst);
     void copy_texture(SDL_Texture * t, rect dst);
 
+    // Memory for temporary data of the current frame, e.g., of drawing
+    // passes. Everything is released at once when the frame is presented.
+    std::pmr::memory_resource * frame_resource();
+
+    // The number of textures copied so far, for profiling.
+    std::size_t copy_count() const;
+
+    // Has to be called if the renderer state was changed by someone else
+    // during a frame.
+    void invalidate_render_state();
+
+    // Drops the textures owned by the context after the renderer lost them,
+    // e.g., with SDL_RENDER_DEVICE_RESET. They are created again when they
+    // are drawn next.
+    void reset_textures();
+
+    // memory client interface
+
+    // Counts the textures of blitted surfaces, those not drawn in the current
+    // frame are given up when limited, least recently drawn first.
+    std::size_t resident_bytes() const override;
+    void set_memory_limit(std::optional<std::size_t> bytes) override;
+
+    // Record all drawing operations into the display list instead of
+    // executing them. Textures that are used have to stay valid until the list
+    // is submitted.
+    void begin_recording(display_list & dl);
+    void end_recording();
+
+    // Executes a display list. Operations with the same state are merged into
+    // one call if that does not change the result.
+    void submit(display_list const & dl);
+
+    // Creates a texture that can be drawn to with push_target(). Returns an
+    // empty pointer if the renderer does not support render targets.
+    unique_texture_ptr create_target_texture(vec size);
+
+    // Uploads a surface into a texture owned by the caller, e.g., once an
+    // image was decoded in the background. Throws std::runtime_error on
+    // failure.
+    unique_texture_ptr create_texture(SDL_Surface * s);
+
+    // A texture that is updated often, e.g., by a video. Throws
+    // std::runtime_error on failure.
+    unique_texture_ptr create_streaming_texture(vec size);
+
+    // Gives write access to the pixels of a streaming texture, which are
+    // ARGB8888. The function gets the pixels and the pitch in bytes and has to
+    // write all of them.
+    void update_streaming_texture(SDL_Texture * t, std::function<void(void *, int)> const & write);
+
+    // Redirects drawing into the texture until pop_target() is called. The
+    // texture is cleared unless asked otherwise and its top-left corner
+    // corresponds to origin, such that widgets may draw with their usual
+    // coordinates. Drawing into a texture is never recorded. Targets may be
+    // nested.
+    void push_target(SDL_Texture * t, point origin, bool clear = true);
+    void pop_target();
+
     private:
 
+    void end_frame();
+
+    // Changes the state used by following operations.
+    void set_draw_color(SDL_Color c);
+    void set_blend_mode(SDL_BlendMode bm);
+    void set_clip(rect const * r);
+    void set_viewport(rect const * r);
+
+    struct surface_texture_entry
+    {
+        unique_texture_ptr texture;
+        vec size;
+
+        // Detects a reallocated pixel buffer.
+        void * pixels;
+
+        bool dirty;
+        std::size_t frame;
+    };
+
+    SDL_Texture * surface_texture(SDL_Surface * s);
+    void trim_surface_textures();
+
+    // Renders all sprites of the theme into one surface.
+    void render_sprites();
+
+    color_theme const & colors() const;
+
+    // Draw the laid out text of the public variants.
+    void draw_button_layout(std::tuple<vec, std::vector<copy_command>> const & result, rect abs_rect);
+    int draw_label_layout(std::tuple<vec, std::vector<copy_command>> const & result, rect box);
+
+    // All drawing goes through these.
+    void fill_rect(rect r);
+    void frame_rect(rect r);
+    void copy(texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod);
+
+    // Moves the state and the target into the coordinates of the current
+    // render target.
+    render_state translated_state() const;
+    rect translated_target(rect r) const;
+
     SDL_Renderer * _renderer;
 
     font_manager & _fm;
 
+    std::unique_ptr<render_backend> _backend;
+
+    render_state _state;
+
+    display_list * _recording;
+
+    // In the coordinates of the renderer.
+    std::optional<rect> _scissor;
+
+    // Intersected with the previous one.
+    std::vector<rect> _visible_areas;
+
+    struct target_entry
+    {
+        SDL_Texture * texture;
+        point origin;
+        display_list * recording;
+        render_state state;
+        std::optional<rect> scissor;
+        std::vector<rect> visible_areas;
+    };
+
+    // The render targets that have been replaced, the current one is drawn
+    // to with an offset of _origin.
+    std::vector<target_entry> _targets;
+    SDL_Texture * _target;
+    point _origin;
+
+    std::unordered_map<SDL_Surface *, surface_texture_entry> _surface_textures;
+    std::optional<std::size_t> _surface_memory_limit;
+    std::size_t _frame;
+
+    std::size_t _copy_count;
+
+    // Reused for every batch of copies.
+    std::vector<texture_quad> _quads;
+
+    static constexpr std::size_t FRAME_BUFFER_BYTES = 16 * 1024;
+
+    alignas(std::max_align_t) std::array<std::byte, FRAME_BUFFER_BYTES> _frame_buffer;
+    std::pmr::monotonic_buffer_resource _frame_resource;
+
     //rect _clip_box;
 
-    color_theme _theme;
+    std::shared_ptr<theme const> _theme;
+
+    // Sprites for every box type and state, created when drawing the first
+    // box. The texture is only created if the backend draws textures.
+    unique_surface_ptr _sprite_surface;
+    unique_texture_ptr _sprite_texture;
+    std::vector<rect> _sprites;
 };
 
 #endif
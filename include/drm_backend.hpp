@@ -0,0 +1,74 @@
+#ifndef LIBWTK_SDL2_DRM_BACKEND_HPP
+#define LIBWTK_SDL2_DRM_BACKEND_HPP
+
+#include <cstdint>
+#include <string>
+
+#include <SDL2/SDL_surface.h>
+
+#include "geometry.hpp"
+#include "software_backend.hpp"
+
+struct _drmModeCrtc;
+
+// Shows frames on a display through DRM/KMS directly, without a window system.
+// Frames are drawn on the CPU into one of two dumb buffers, which is then
+// flipped on vertical blank. Afterwards only the damaged area is copied to the
+// other buffer, so widget_context::draw_dirty() should be called without dirty
+// redraws.
+//
+// Only available if libwtk-sdl2 has been built with libdrm.
+struct drm_backend : software_backend
+{
+    // Uses the first connected connector with its preferred mode.
+    drm_backend(std::string device = "/dev/dri/card0");
+    ~drm_backend() override;
+
+    drm_backend(drm_backend const &) = delete;
+    drm_backend & operator=(drm_backend const &) = delete;
+
+    // Blocks until the frame is shown.
+    void present(damage_region const * damage) override;
+
+    // The resolution of the display.
+    vec size() const;
+
+    private:
+
+    struct buffer
+    {
+        uint32_t handle;
+        uint32_t pitch;
+        uint64_t size;
+        uint32_t fb_id;
+        uint8_t * map;
+
+        // Refers to the mapped memory.
+        unique_surface_ptr surface;
+    };
+
+    void init(std::string const & device);
+    void release();
+
+    void create_buffer(buffer & b);
+    void destroy_buffer(buffer & b);
+
+    void wait_for_flip();
+
+    int _fd;
+    uint32_t _connector_id;
+    uint32_t _crtc_id;
+
+    // The configuration before taking over the display, restored afterwards.
+    _drmModeCrtc * _saved_crtc;
+
+    vec _size;
+    buffer _buffers[2];
+
+    // The buffer that is drawn to, the other one is shown.
+    int _back;
+    bool _flip_pending;
+};
+
+#endif
+
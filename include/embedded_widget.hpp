@@ -18,6 +18,7 @@ struct embedded_widget : widget
     template <typename... Args>
     embedded_widget(Args &&... args)
         : _embedded_widget(std::forward<Args>(args)...)
+        , _embedded_ptr(&_embedded_widget)
     {
         _embedded_widget.set_parent(this);
     }
@@ -30,18 +31,22 @@ struct embedded_widget : widget
     void on_mouse_move_event(mouse_move_event const & e) override { _embedded_widget.on_mouse_move_event(e); }
     void on_key_event(key_event const & e) override { _embedded_widget.on_key_event(e); }
     void on_activate() override { _embedded_widget.on_activate(); }
-    std::vector<widget *> get_children() override { return { &_embedded_widget }; }
-    std::vector<widget const *> get_children() const override { return { &_embedded_widget }; }
+    widget_range get_children() override { return { &_embedded_ptr, 1 }; }
+    const_widget_range get_children() const override { return widget_range(&_embedded_ptr, 1); }
     void on_box_allocated() override { _embedded_widget.apply_layout(get_box()); }
     widget * find_selectable(navigation_type nt, point center) override { return _embedded_widget.find_selectable(nt, center); }
     widget * navigate_selectable(navigation_type nt, point center) override { return _embedded_widget.navigate_selectable(nt, center); }
     widget * navigate_selectable_from_children(navigation_type nt, widget * w, point center) override { return navigate_selectable_parent(nt, center); }
-    size_hint get_size_hint(int width, int height) const override { return _embedded_widget.get_size_hint(width, height); }
+    size_hint get_size_hint(int width, int height) const override { return _embedded_widget.query_size_hint(width, height); }
     virtual bool can_use_intermediate_size() const { return _embedded_widget.can_use_intermediate_size(); }
 
     protected:
 
     BaseWidget _embedded_widget;
+
+    private:
+
+    widget * _embedded_ptr;
 };
 
 #endif
@@ -0,0 +1,85 @@
+#ifndef LIBWTK_SDL2_EVENT_RECORDING_HPP
+#define LIBWTK_SDL2_EVENT_RECORDING_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL_events.h>
+
+#include "word_cache_file.hpp"
+
+struct widget_context;
+
+// Input events are recorded together with the frames they were drawn in. Only
+// events that do not refer to memory outside the event itself are supported,
+// e.g., input, touch and window events. Others are skipped.
+
+struct recorded_event
+{
+    // Milliseconds since the recording started.
+    uint32_t timestamp;
+
+    // The end of a frame does not carry an event.
+    bool frame_end;
+    bool full_redraw;
+    SDL_Event event;
+};
+
+struct event_recorder
+{
+    // Throws std::runtime_error if the file cannot be created.
+    event_recorder(std::string path);
+
+    void add(SDL_Event const & ev);
+
+    // Marks that the events since the last frame were followed by drawing.
+    void end_frame(bool full_redraw);
+
+    // Throws std::runtime_error if the file could not be written.
+    void finish();
+
+    private:
+
+    void write(uint32_t type, uint16_t flags, void const * payload, std::size_t size);
+
+    std::ofstream _out;
+    Uint32 _start_ticks;
+};
+
+// Reads a file written by event_recorder. A file of another format or from
+// another SDL version yields no events.
+struct event_reader
+{
+    event_reader(std::string const & path);
+
+    // Returns false once there are no more events.
+    bool next(recorded_event & e);
+
+    private:
+
+    mapped_file _file;
+    uint8_t const * _ptr;
+    uint8_t const * _end;
+};
+
+struct replay_frame
+{
+    // Of the last event in the frame.
+    uint32_t timestamp;
+
+    std::size_t events;
+
+    // Handling the events and drawing.
+    std::chrono::nanoseconds time;
+};
+
+// Feeds the recorded events to the context as fast as possible and draws
+// whenever a frame was drawn during the recording. Returns the time taken by
+// each frame.
+std::vector<replay_frame> replay_events(widget_context & ctx, std::string const & path);
+
+#endif
+
@@ -0,0 +1,122 @@
+#ifndef LIBWTK_SDL2_EVENT_SOURCE_HPP
+#define LIBWTK_SDL2_EVENT_SOURCE_HPP
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct widget_context;
+
+/**
+ * Input that does not arrive as SDL events, e.g., a LIRC socket, an evdev
+ * device or a network control channel. The file descriptor is watched while
+ * the event loop waits for SDL events. Once it is readable on_readable() is
+ * called on the thread of the event loop, which can act on the context
+ * directly, e.g., with widget_context::navigate_selection().
+ */
+struct event_source
+{
+    virtual ~event_source();
+
+    /**
+     * May be called from another thread, but never while on_readable() runs.
+     * A negative value is not watched, e.g., after the end of the input.
+     */
+    virtual int fd() const = 0;
+
+    /**
+     * Has to read what is available without blocking.
+     */
+    virtual void on_readable(widget_context & ctx) = 0;
+};
+
+/**
+ * Splits the input into lines, which are passed without copying. Lines that do
+ * not fit the buffer are dropped.
+ */
+struct line_event_source : event_source
+{
+    /**
+     * Takes ownership of the file descriptor.
+     */
+    line_event_source(int fd, std::function<void(std::string_view, widget_context &)> handle_line);
+    ~line_event_source() override;
+
+    int fd() const override;
+    void on_readable(widget_context & ctx) override;
+
+    private:
+
+    int _fd;
+    std::function<void(std::string_view, widget_context &)> _handle_line;
+
+    std::array<char, 4096> _buffer;
+    std::size_t _filled;
+    bool _dropping;
+};
+
+/**
+ * Maps a command onto the selection of the context: UP, DOWN, LEFT, RIGHT,
+ * NEXT and PREV navigate, OK, ENTER and SELECT activate. The names are also
+ * accepted with a KEY_ prefix, as used by LIRC. Returns false for anything
+ * else.
+ */
+bool dispatch_navigation_command(std::string_view command, widget_context & ctx);
+
+/**
+ * The button name of a line sent by lircd, which looks like
+ * "0000000000f40bf0 00 KEY_UP remote". Repeated presses are included, empty
+ * if the line is malformed.
+ */
+std::string_view lirc_button(std::string_view line);
+
+/**
+ * Watches the file descriptors on a thread that only waits. If one becomes
+ * readable, the event loop is woken up with an SDL event and the sources are
+ * dispatched on its thread. Watching resumes once that is done. This keeps
+ * the event loop in SDL_WaitEvent() without periodic wakeups.
+ */
+struct event_source_watcher
+{
+    event_source_watcher(uint32_t wakeup_event);
+    ~event_source_watcher();
+
+    void add(event_source & s);
+    void remove(event_source & s);
+
+    /**
+     * Calls on_readable() for the sources that became readable. Returns
+     * whether there were any.
+     */
+    bool dispatch(widget_context & ctx);
+
+    private:
+
+    void run();
+
+    // Makes the watching thread pick up changes.
+    void interrupt();
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+
+    // Only changed by the thread of the event loop.
+    std::vector<event_source *> _sources;
+
+    // Not watched until they are dispatched.
+    std::vector<event_source *> _ready;
+
+    bool _stop;
+    int _pipe[2];
+    uint32_t const _wakeup_event;
+    std::thread _thread;
+};
+
+#endif
+
@@ -1,18 +1,36 @@
 #ifndef LIBWTK_SDL2_FONT_MANAGER_HPP
 #define LIBWTK_SDL2_FONT_MANAGER_HPP
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <SDL2/SDL_render.h>
 
 #include "font.hpp"
+#include "font_registry.hpp"
 #include "font_word_cache.hpp"
 #include "geometry.hpp"
+#include "memory_budget.hpp"
+#include "thread_pool.hpp"
 
-struct font_manager
+// Fonts are only registered when they are loaded and opened once they are
+// used first. Errors of opening a font, e.g., font_not_found, are thus thrown
+// by the first use.
+struct font_manager : memory_client
 {
     font_manager(SDL_Renderer * renderer, std::vector<font> fonts);
+
+    // Fonts are shared with other users of the registry.
+    font_manager(SDL_Renderer * renderer, std::vector<font> fonts, font_registry & registry);
+    ~font_manager();
     font_manager(font_manager const &) = delete;
     font_manager & operator=(font_manager const &) = delete;
 
@@ -20,18 +38,140 @@ struct font_manager
 
     std::size_t load_font(font f);
 
+    // Opens a registered font on a background thread, such that it is ready
+    // when it is used first. Using it earlier waits for it.
+    void open_font_async(std::size_t font_idx);
+
+    bool is_font_open(std::size_t font_idx) const;
+
+    // Adds a font of another size that shares the rendered words of a loaded
+    // font, whose glyphs are scaled when drawing. The layout is the one of the
+    // loaded font, scaled as well. Trades sharpness for memory, the loaded
+    // font should be the largest size of the face.
+    std::size_t load_scaled_font(std::size_t font_idx, unsigned int size);
+
+    // Sets the byte budget of every font, also applies to fonts loaded later.
+    // A font shared with other managers of the registry is budgeted by the
+    // manager that opened it first, the budget of the others applies once it
+    // has been destroyed and they take over.
+    void set_cache_byte_budget(std::size_t bytes);
+
+    // Drops the rendered words of every font, e.g., after the renderer lost
+    // its textures.
+    void clear_caches();
+
+    // Called once a frame has been presented. Ends the frame only of the
+    // fonts the manager owns, such that a shared font does not age faster.
+    void end_frame();
+
+    // Render words that are not cached yet on background threads. The
+    // threads are shared by all fonts.
+    void enable_async_rendering(std::size_t num_threads = 1);
+
+    // Returns whether any word has been added.
+    bool upload_rendered_words();
+
+    // Applies to every font, see font_word_cache::set_render_deadline().
+    void set_render_deadline(std::optional<std::chrono::steady_clock::time_point> deadline);
+    bool take_deferred_words();
+
+    void prewarm(std::vector<std::string> const & texts, int font_idx = 0);
+
+    // Keep rendered words of every font in files within the directory to
+    // speed up the next start.
+    void enable_persistent_cache(std::string directory);
+    void flush_persistent_cache();
+
+    // Also applies to fonts loaded later.
+    void set_keep_alpha(bool keep);
+
+    // The first also applies to fonts loaded later. Selecting it for a single
+    // font allows labels to choose it with their font index.
+    void set_glyph_run_mode(glyph_run_mode mode);
+    void set_glyph_run_mode(glyph_run_mode mode, int font_idx);
+
+    // Sums up the statistics of all fonts, a font shared with another manager
+    // includes its usage as well.
+    font_cache_stats cache_stats() const;
+    font_cache_stats cache_stats(int font_idx) const;
+    void reset_cache_stats();
+
+    // memory client interface
+
+    // Fonts keep what they use in the order they were loaded, later ones get
+    // what is left. Fonts opened later are limited from the next call on. A
+    // font shared with another manager is limited by the one that owns it,
+    // see set_cache_byte_budget().
+    std::size_t resident_bytes() const override;
+    void set_memory_limit(std::optional<std::size_t> bytes) override;
+
     // forwarded interface
 
-    std::tuple<vec, std::vector<copy_command>> text(std::string t, int max_line_width = -1, int font_idx = 0);
-    vec text_size(std::string t, int max_line_width = -1, int font_idx = 0);
-    int text_minimum_width(std::string t, int font_idx = 0);
+    std::tuple<vec, std::vector<copy_command>> const & text(std::string_view t, int max_line_width = -1, int font_idx = 0);
+    std::tuple<vec, std::vector<copy_command>> const & text(interned_text const & t, int max_line_width = -1, int font_idx = 0);
+    vec text_size(std::string_view t, int max_line_width = -1, int font_idx = 0);
+    vec text_size(interned_text const & t, int max_line_width = -1, int font_idx = 0);
+    void text_line_starts(std::string_view t, int max_line_width, std::vector<std::size_t> & starts, int font_idx = 0);
+    int text_minimum_width(std::string_view t, int font_idx = 0);
     unsigned int font_height(int font_idx = 0) const;
     int font_line_skip(int font_idx = 0) const;
 
     private:
 
+    // Whether the font is drawn with the words of another size.
+    bool is_scaled(int font_idx) const;
+
+    // Forward to the cache of the font and scale the result if necessary.
+    template <typename Text>
+    std::tuple<vec, std::vector<copy_command>> const & forward_text(Text const & t, int max_line_width, int font_idx);
+    template <typename Text>
+    vec forward_text_size(Text const & t, int max_line_width, int font_idx);
+
+    // Whether the cache appears before the index, i.e., it is already handled.
+    // Fonts that are not open yet count as duplicates.
+    bool is_duplicate(std::size_t font_idx) const;
+
+    // Opens the font if necessary.
+    font_word_cache & cache(std::size_t font_idx) const;
+
+    // Whether the manager owns the cache, i.e., ends its frames and sets its
+    // budget. Claims caches without an owner.
+    bool owns_cache(font_word_cache & fwc) const;
+
+    // Applies the settings of the manager to a font that has just been
+    // opened.
+    void configure(font_word_cache & fwc, font const & f) const;
+
     SDL_Renderer * _renderer;
-    std::vector<font_word_cache> _font_word_caches;
+    font_registry * _registry;
+    std::shared_ptr<thread_pool> _pool;
+
+    // Empty until the font is opened, which does not change the observable
+    // state of the manager. Fonts may be opened by a parallel layout, the
+    // flag tells whether the cache can be used without locking.
+    mutable std::vector<std::shared_ptr<font_word_cache>> _font_word_caches;
+    mutable std::deque<std::atomic<bool>> _open;
+    mutable std::mutex _open_mutex;
+
+    // Valid while a font is opened on a background thread.
+    mutable std::vector<std::future<std::shared_ptr<font_word_cache>>> _opening;
+
+    // The font whose cache is used, differs for scaled fonts.
+    std::vector<std::size_t> _cache_indices;
+
+    std::optional<std::size_t> _cache_byte_budget;
+    std::optional<std::string> _persistent_cache_directory;
+    bool _keep_alpha;
+    std::optional<glyph_run_mode> _glyph_run_mode;
+    std::optional<std::chrono::steady_clock::time_point> _render_deadline;
+    std::vector<font> _fonts;
+
+    // The size relative to the one of the cache, 1 for fonts that are not
+    // scaled.
+    std::vector<double> _scales;
+
+    // The result for scaled fonts.
+    std::tuple<vec, std::vector<copy_command>> _scaled_text;
 
 };
 
@@ -0,0 +1,44 @@
+#ifndef LIBWTK_SDL2_FONT_REGISTRY_HPP
+#define LIBWTK_SDL2_FONT_REGISTRY_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <SDL2/SDL_render.h>
+
+#include "font.hpp"
+#include "font_word_cache.hpp"
+
+/**
+ * Shares font caches between several font managers, e.g., multiple widget
+ * contexts on the same renderer. A cache is destroyed once it is not used by
+ * any font manager anymore. The manager that opens a cache first owns it: it
+ * ends the frames of the cache and sets its budget, see
+ * font_word_cache::claim_owner().
+ */
+struct font_registry
+{
+    font_registry();
+    font_registry(font_registry const &) = delete;
+    font_registry & operator=(font_registry const &) = delete;
+
+    /**
+     * Returns the cache for the font on the renderer, it is created if
+     * necessary. May be called from several threads, e.g., when fonts are
+     * opened in the background.
+     */
+    std::shared_ptr<font_word_cache> get(SDL_Renderer * renderer, font f);
+
+    private:
+
+    typedef std::tuple<SDL_Renderer *, std::string, unsigned int> key_type;
+
+    std::mutex _mutex;
+    std::map<key_type, std::weak_ptr<font_word_cache>> _caches;
+};
+
+#endif
+
@@ -1,10 +1,23 @@
 #ifndef LIBWTK_SDL2_FONT_WORD_CACHE_HPP
 #define LIBWTK_SDL2_FONT_WORD_CACHE_HPP
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <SDL2/SDL_ttf.h>
@@ -12,7 +25,11 @@
 #include "copy_command.hpp"
 #include "font.hpp"
 #include "geometry.hpp"
+#include "interned_text.hpp"
 #include "sdl_util.hpp"
+#include "texture_atlas.hpp"
+#include "thread_pool.hpp"
+#include "word_cache_file.hpp"
 
 struct font_not_found : std::runtime_error
 {
@@ -26,10 +43,63 @@ struct font_render_error : std::runtime_error
 
 struct word_fragment
 {
-    std::string word;
+    // Refers to the text that is split.
+    std::string_view word;
     std::size_t extra_spaces;
 };
 
+// Splits a text into words separated by spaces. Multiple spaces are recorded as
+// extra spaces of the preceding word.
+struct word_splitter
+{
+    word_splitter(std::string_view t);
+
+    // Returns false if there are no more words.
+    bool next(word_fragment & wf);
+
+    private:
+
+    std::string_view _t;
+    std::size_t _pos;
+};
+
+// Which words are composed of individually cached glyphs instead of being
+// rendered as a whole. Composing loses ligatures but avoids rasterizing every
+// value of text that changes constantly, e.g., counters and times.
+enum class glyph_run_mode
+{
+    NEVER,
+
+    // Words that consist only of digits and the punctuation around numbers.
+    NUMERIC,
+
+    ALWAYS
+};
+
+// Counters for tuning the cache size. Times include uploading the rendered
+// words.
+struct font_cache_stats
+{
+    // Lookups of rendered words.
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+
+    // Lookups of complete layouts.
+    std::size_t layout_hits;
+    std::size_t layout_misses;
+
+    std::size_t entries;
+    std::size_t bytes_resident;
+    std::size_t atlas_pages;
+
+    // Time spent rendering words, on this thread and on background threads.
+    std::chrono::nanoseconds render_time;
+    std::chrono::nanoseconds async_render_time;
+
+    font_cache_stats & operator+=(font_cache_stats const & other);
+};
+
 struct font_word_cache
 {
     font_word_cache(SDL_Renderer * renderer, font f);
@@ -38,18 +108,36 @@ struct font_word_cache
     font_word_cache(font_word_cache const &) = delete;
     font_word_cache(font_word_cache && other);
 
-    // Renders words onto textures with a cache. A proper layout is then created
-    // to fit the textures on the given line width.
+    // Renders words onto textures with a cache. Words are packed into shared
+    // atlas pages, only words too large for a page get their own texture. A
+    // proper layout is then created to fit the textures on the given line
+    // width.
     //
     // The result is the required space and the commands necessary to copy it to
-    // a render target. Note that it is not guaranteed that the textures are
-    // still valid after another call only in between calls.
+    // a render target. The textures stay valid until the current frame ends,
+    // afterwards they may be evicted to stay within the byte budget. Layouts
+    // are cached, the returned reference is only valid until the next call.
     //
     // TODO add offset parameter
-    std::tuple<vec, std::vector<copy_command>> text(std::string t, int max_line_width = -1);
+    std::tuple<vec, std::vector<copy_command>> const & text(std::string_view t, int max_line_width = -1);
+
+    // Uses the hash of the interned text for the layout cache.
+    std::tuple<vec, std::vector<copy_command>> const & text(interned_text const & t, int max_line_width = -1);
+
+    // Measure text with the same layout as text() but without rendering any
+    // words. Measuring may happen from several threads at once, e.g., during
+    // a parallel layout, as long as nothing else uses the cache meanwhile.
+    // Cached results are looked up concurrently, anything else is measured
+    // one at a time.
+    vec text_size(std::string_view t, int max_line_width = -1);
+    vec text_size(interned_text const & t, int max_line_width = -1);
 
-    vec text_size(std::string t, int max_line_width = -1);
-    int text_minimum_width(std::string t);
+    // The byte offsets of the lines of the text wrapped to the width, the
+    // first line starts at 0. Text without words has no lines. Measures like
+    // text_size().
+    void text_line_starts(std::string_view t, int max_line_width, std::vector<std::size_t> & starts);
+
+    int text_minimum_width(std::string_view t);
 
     unsigned int font_height() const;
 
@@ -57,26 +145,303 @@ struct font_word_cache
 
     void clear();
 
-    private:
+    // Limits the memory used by rendered words. Once the budget is exceeded
+    // the least recently used words are evicted, except those used in the
+    // current frame.
+    void set_byte_budget(std::size_t bytes);
+    std::size_t byte_budget() const;
+    std::size_t used_bytes() const;
 
-    template <typename BackInsertIt>
-    vec compute_text_layout(std::string t, int max_line_width, BackInsertIt it);
+    // Limits the memory further, e.g., to share it with other caches, see
+    // memory_budget. Pass std::nullopt to only keep to the byte budget.
+    void set_memory_limit(std::optional<std::size_t> bytes);
+
+    // Marks the end of a frame, words used so far may be evicted afterwards.
+    void end_frame();
+
+    // A cache shared by several users, e.g., the font managers of a
+    // font_registry, has a single owner that ends its frames and sets its
+    // budget and limit, the others only use it. The first user that claims
+    // the cache owns it until it releases it. Returns whether the user owns
+    // the cache.
+    bool claim_owner(void const * user);
+    void release_owner(void const * user);
+
+    // Words that are not cached yet are rendered by the pool instead of
+    // blocking text(). Until they are uploaded the text is laid out with blank
+    // space in their place. Pass nullptr to render synchronously again.
+    void set_thread_pool(std::shared_ptr<thread_pool> pool);
+
+    // Uploads words that have been rendered in the background. Must be called
+    // from the thread that uses the renderer. Returns whether any word was
+    // added, in which case text that has been drawn before may be incomplete.
+    // Throws font_render_error for a word that can not be rendered, the word
+    // is not requested again and stays blank, the others are still uploaded
+    // by later calls.
+    bool upload_rendered_words();
+
+    // Once the deadline has passed no more words are rendered or uploaded,
+    // text is laid out with blank space in their place instead. Bounds the
+    // time of a frame that shows a lot of new text. Pass std::nullopt to
+    // render everything right away again.
+    void set_render_deadline(std::optional<std::chrono::steady_clock::time_point> deadline);
+
+    // Whether words have been left out because of the deadline since the last
+    // call. They are rendered once the text is drawn again.
+    bool take_deferred_words();
+
+    // Renders all words of the texts ahead of time, in the background if a
+    // thread pool is set.
+    void prewarm(std::vector<std::string> const & texts);
+
+    // Loads words rendered in a previous run from the file, if it has been
+    // written for the same font file and size. Afterwards the pixels of new
+    // words are kept as well, such that they can be written to the file with
+    // flush_persistent_cache(). Should be called only once, before drawing.
+    void enable_persistent_cache(std::string path);
+
+    // Writes all cached words, most recently used first. Throws
+    // std::runtime_error if writing fails.
+    void flush_persistent_cache();
+
+    // Defaults to glyph_run_mode::NUMERIC. Changing it clears the cache.
+    void set_glyph_run_mode(glyph_run_mode mode);
+    glyph_run_mode get_glyph_run_mode() const;
+
+    // Keeps the coverage of rendered words in memory and passes it along with
+    // the copy commands. Needed to draw text without the renderer. Words that
+    // are cached already are discarded when this is enabled.
+    void set_keep_alpha(bool keep);
+
+    font_cache_stats stats() const;
+    void reset_stats();
+
+    private:
 
     int get_word_left_kerning(std::string_view const word);
     int get_word_right_kerning(std::string_view const word);
 
-    // Correctly handles dimension for a nullptr.
-    vec texture_dim_nullptr(SDL_Texture * texture) const;
+    // The kerning of a glyph with a space, before and after the glyph.
+    struct space_kerning_pair
+    {
+        int before;
+        int after;
+    };
+
+    // Latin-1 is looked up in a table filled when the font is opened, other
+    // characters are cached once they are used.
+    space_kerning_pair space_kerning(uint32_t c);
+
+    struct word_entry
+    {
+        SDL_Texture * texture;
+
+        // The area of the texture that contains the word.
+        rect source;
+
+        // Whether the texture belongs to the entry instead of the atlas.
+        bool dedicated;
+
+        // Position in the usage order, the list node owns the key.
+        std::list<std::string>::iterator lru_pos;
+
+        // The frame the entry was used in last.
+        std::size_t frame;
+
+        // The alpha channel of the rendered word, only available with a
+        // persistent cache. Words loaded from the cache refer to the mapped
+        // file instead of owning a copy.
+        std::unique_ptr<uint8_t[]> alpha_storage;
+        uint8_t const * alpha;
+    };
+
+    // Renders the words if used_words is given and records the entries,
+    // otherwise only measures them. Records where lines start if line_starts
+    // is given.
+    template <typename BackInsertIt>
+    vec compute_text_layout(std::string_view t, int max_line_width, BackInsertIt it, std::vector<word_entry *> * used_words, std::vector<std::size_t> * line_starts = nullptr);
+
+    struct layout_entry
+    {
+        std::string text;
+        int max_line_width;
+        std::tuple<vec, std::vector<copy_command>> result;
+
+        // Whether the result contains the size and copy commands. Copy
+        // commands are only valid if no word has been evicted since.
+        bool sized;
+        bool rendered;
+        std::size_t generation;
+        std::vector<word_entry *> words;
+    };
+
+    // The hash is the one of the text, which is computed only once for
+    // interned texts.
+    std::tuple<vec, std::vector<copy_command>> const & text(std::string_view t, std::size_t hash, int max_line_width);
+    vec text_size(std::string_view t, std::size_t hash, int max_line_width);
+
+    // Finds the cached layout or creates an empty one.
+    layout_entry & layout(std::string_view t, std::size_t hash, int max_line_width);
+
+    // Lookups that do not change the cache, for measuring under a shared
+    // lock.
+    layout_entry const * find_layout(std::string_view t, std::size_t hash, int max_line_width) const;
+    bool find_word_width(std::string_view w, int & width) const;
+
+    static std::size_t entry_bytes(word_entry const & e);
+
+    // Marks the entry as used in the current frame.
+    void touch(word_entry & e);
+
+    // The byte budget, lowered to the memory limit.
+    std::size_t effective_byte_budget() const;
+    void evict(std::size_t required_bytes);
 
     // May return nullptr for zero-length text.
-    SDL_Texture * word(std::string);
+    word_entry * word(std::string_view w);
+
+    // The width of a word as it would be rendered, does not rasterize.
+    int word_width(std::string_view w);
+
+    // Adds a rendered word, takes ownership of the surface. The alpha channel
+    // is copied from the surface if it is not given. The word is the most
+    // recently used one, or the least recently used one when words are
+    // loaded in the order of the least recently used list.
+    word_entry * insert_word(std::string key, SDL_Surface * s, uint8_t const * alpha = nullptr, bool least_recent = false);
+
+    // Either renders the word or only measures it. A word that is rendered in
+    // the background is recorded as nullptr. The rendered pieces of the word
+    // are left in _placed.
+    int layout_word_width(std::string_view w, std::vector<word_entry *> * used_words);
+
+    // Renders or requests a single word and records it. Glyphs of runs are
+    // few and all of them are needed, e.g., the digits of a counter, they are
+    // rendered even past the deadline.
+    word_entry * layout_word(std::string_view w, std::vector<word_entry *> * used_words, bool run_glyph);
+
+    // Lays out the glyphs of the word into _glyph_run if it is composed of
+    // glyphs. The width is the one of the composed word.
+    bool glyph_run(std::string_view w, int & width);
+
+    // Renders the word unless it is cached already.
+    void prewarm_word(std::string_view w);
+
+    // Does not need the font, the word might still not be composable.
+    bool might_be_glyph_run(std::string_view w) const;
+
+    // Whether the word is a single glyph that glyph runs are composed of.
+    bool is_run_glyph(std::string_view w) const;
+
+    struct glyph_piece
+    {
+        // Refers to the word.
+        std::string_view glyph;
+        int x;
+    };
+
+    struct placed_entry
+    {
+        word_entry * entry;
+        int x;
+    };
+
+    // Shared with the tasks of the thread pool, such that it outlives the
+    // cache while rendering.
+    struct async_state
+    {
+        async_state(font f, Uint32 wakeup_event);
+        ~async_state();
+
+        font const f;
+
+        // Pushed once rendered words are available.
+        Uint32 const wakeup_event;
+
+        // A font must not be used by multiple threads at once, the workers
+        // use their own.
+        std::mutex font_mutex;
+        TTF_Font * ttf_font;
+
+        std::mutex rendered_mutex;
+        std::vector<std::pair<std::string, unique_surface_ptr>> rendered;
+
+        std::atomic<bool> cancelled;
+
+        std::atomic<std::int64_t> render_nanoseconds;
+    };
+
+    // Starts rendering the word in the background, if it is not already.
+    void request_word(std::string_view w);
+
+    bool past_render_deadline();
 
     SDL_Renderer * _renderer;
-    std::unordered_map<std::string, SDL_Texture *> _prerendered;
+    // Keys refer to the strings in _lru, such that lookups do not need to
+    // allocate.
+    std::unordered_map<std::string_view, word_entry> _prerendered;
+
+    // Cached words, most recently used first.
+    std::list<std::string> _lru;
+
+    // Widths of words that were measured but not necessarily rendered. Keys
+    // refer to the strings in _word_width_keys.
+    std::unordered_map<std::string_view, int> _word_widths;
+    std::deque<std::string> _word_width_keys;
+
+    std::size_t _byte_budget;
+    std::optional<std::size_t> _memory_limit;
+    std::size_t _used_bytes;
+    std::size_t _frame;
+
+    // Claimed from any thread that opens the cache, nullptr if unowned.
+    std::atomic<void const *> _owner;
+
+    // Keyed on a hash of the text and the line width.
+    std::unordered_map<std::size_t, layout_entry> _layouts;
+
+    // Changes whenever a word is evicted.
+    std::size_t _eviction_generation;
+
+    texture_atlas _atlas;
+    font _font_desc;
     TTF_Font * _font;
     int _space_advance;
     int _space_minx;
 
+    std::array<space_kerning_pair, 256> _latin_space_kerning;
+    std::unordered_map<uint32_t, space_kerning_pair> _space_kerning;
+
+    std::shared_ptr<thread_pool> _pool;
+    std::shared_ptr<async_state> _async;
+    std::unordered_set<std::string> _pending;
+
+    // Words that could not be rendered, they are not requested again and
+    // stay blank.
+    std::unordered_set<std::string> _failed;
+
+    // The persistent cache is disabled if the path is empty.
+    std::string _persistent_path;
+    mapped_file _persistent_file;
+    uint64_t _font_hash;
+
+    glyph_run_mode _glyph_run_mode;
+
+    // Reused for every word.
+    std::vector<glyph_piece> _glyph_run;
+    std::vector<placed_entry> _placed;
+
+    bool _keep_alpha;
+
+    std::optional<std::chrono::steady_clock::time_point> _render_deadline;
+    bool _inserted_since_deadline;
+    bool _deferred_words;
+
+    // Only counters are kept, the rest is derived when asked for.
+    font_cache_stats _stats;
+
+    // Held exclusively by everything that changes the words or layouts, and
+    // shared for cached measurements.
+    std::shared_mutex _measure_mutex;
 };
 
 #endif
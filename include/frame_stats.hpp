@@ -0,0 +1,71 @@
+#ifndef LIBWTK_SDL2_FRAME_STATS_HPP
+#define LIBWTK_SDL2_FRAME_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Of the samples that are kept, all zero if there are none.
+struct duration_percentiles
+{
+    std::size_t samples;
+    std::chrono::nanoseconds p50;
+    std::chrono::nanoseconds p95;
+    std::chrono::nanoseconds p99;
+};
+
+// Reported for every frame that was presented.
+struct frame_report
+{
+    // Handling events, layout and drawing, without presenting.
+    std::chrono::nanoseconds frame_time;
+
+    // The timestamp of the oldest input event handled in the frame, in SDL
+    // ticks, and the time from it until presenting returned. A backend that
+    // presents asynchronously returns before the frame is shown.
+    std::optional<uint32_t> input_timestamp;
+    std::optional<std::chrono::milliseconds> input_latency;
+};
+
+/**
+ * Keeps frame times and the latency from input to presenting for a number of
+ * recent frames.
+ */
+struct frame_stats
+{
+    frame_stats(std::size_t max_samples = 1000);
+
+    void reset();
+
+    void add(frame_report const & r);
+
+    duration_percentiles frame_times() const;
+
+    // Only frames that handled input are considered.
+    duration_percentiles input_latencies() const;
+
+    private:
+
+    struct sample_ring
+    {
+        std::vector<std::chrono::nanoseconds> samples;
+
+        // The oldest sample once the ring is full.
+        std::size_t next;
+    };
+
+    void push(sample_ring & r, std::chrono::nanoseconds t);
+    duration_percentiles percentiles(sample_ring const & r) const;
+
+    std::size_t _max_samples;
+    sample_ring _frame_times;
+    sample_ring _input_latencies;
+
+    // Reused for sorting.
+    mutable std::vector<std::chrono::nanoseconds> _sorted;
+};
+
+#endif
+
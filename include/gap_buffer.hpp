@@ -0,0 +1,54 @@
+#ifndef LIBWTK_SDL2_GAP_BUFFER_HPP
+#define LIBWTK_SDL2_GAP_BUFFER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * Stores text with a gap at the position where it is edited. Inserting and
+ * erasing at the gap only touches the edited bytes, moving the gap only moves
+ * the text in between. Positions are byte offsets into the text without the
+ * gap.
+ */
+struct gap_buffer
+{
+    gap_buffer(std::string_view text = std::string_view());
+
+    // Replaces the text, the gap is at the end afterwards.
+    void assign(std::string_view text);
+
+    std::size_t size() const;
+    bool empty() const;
+
+    std::size_t gap_position() const;
+    void move_gap(std::size_t pos);
+
+    void insert(std::string_view text);
+
+    // Erase bytes directly before or after the gap.
+    void erase_before(std::size_t n);
+    void erase_after(std::size_t n);
+
+    std::string_view before_gap() const;
+    std::string_view after_gap() const;
+    std::string str() const;
+
+    char operator[](std::size_t pos) const;
+
+    // The position of the neighbouring UTF-8 character, limited to the text.
+    std::size_t next_character(std::size_t pos) const;
+    std::size_t prev_character(std::size_t pos) const;
+
+    private:
+
+    // Makes the gap at least n bytes large.
+    void reserve_gap(std::size_t n);
+
+    std::string _data;
+    std::size_t _gap_start;
+    std::size_t _gap_end;
+};
+
+#endif
+
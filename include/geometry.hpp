@@ -26,6 +26,9 @@ bool within_rect(point p, rect const & r);
 
 bool fits(vec v, rect const & r);
 
+// checks whether the inner rectangle lies completely within the outer one
+bool contains_rect(rect const & outer, rect const & inner);
+
 point rect_center(rect const & r);
 point rect_origin(rect const & r);
 
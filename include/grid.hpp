@@ -1,6 +1,7 @@
 #ifndef LIBWTK_SDL2_TABLE_HPP
 #define LIBWTK_SDL2_TABLE_HPP
 
+#include <memory_resource>
 #include <vector>
 
 #include "container.hpp"
@@ -26,23 +27,60 @@ struct grid : container
     grid(vec size, std::vector<entry> entries, int padding);
     ~grid() override;
 
-    std::vector<widget *> get_children() override;
-    std::vector<widget const *> get_children() const override;
+    widget_range get_children() override;
+    const_widget_range get_children() const override;
     void on_box_allocated() override;
     widget * find_selectable(navigation_type nt, point center) override;
     widget * navigate_selectable_from_children(navigation_type nt, widget * w, point center) override;
 
     size_hint get_size_hint(int width, int height) const override;
+    widget * find_child_at(point p) override;
+
+    /**
+     * @name Grid Interface
+     * @{
+     */
+
+    /**
+     * Throws std::runtime_error if the placement is not within the grid or
+     * overlaps another entry. Only the grid is laid out again if its size
+     * allows it.
+     */
+    void insert(entry e);
+
+    /**
+     * Removes the entry covering the cell and returns its widget, such that it
+     * may be inserted elsewhere. Returns nullptr if the cell is empty.
+     */
+    widget_ptr remove(point cell);
+
+    /**
+     * Keeps the placement of the entry covering the cell. Returns the previous
+     * widget or nullptr if the cell is empty.
+     */
+    widget_ptr replace(point cell, widget_ptr wptr);
+
+    /** @} */
 
     private:
 
-    int length_with_spacing(std::vector<int> const & lengths) const;
+    // The index of the entry covering the cell or -1.
+    int entry_at(point cell) const;
+
+    void index_cells();
+
+    int length_with_spacing(std::pmr::vector<int> const & lengths) const;
     void min_cell_dimensions(int * min_widths, int * min_heights) const;
-    void compute_offsets(std::vector<int> & lengths, std::vector<int> & offsets, int n, int box_length, int box_start);
+    void compute_offsets(std::pmr::vector<int> & lengths, std::vector<int> & offsets, int n, int box_length, int box_start);
+
+    // The cells are stored column by column.
+    int cell_index(int x, int y) const;
 
     std::vector<entry> _entries;
+    std::vector<widget *> _child_ptrs;
     vec _size;
-    std::vector<std::vector<int>> _grid;
+    // The index of the entry in each cell or -1.
+    std::vector<int> _cells;
     int _spacing;
 
     std::vector<int> _x_offsets;
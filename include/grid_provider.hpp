@@ -0,0 +1,58 @@
+#ifndef LIBWTK_SDL2_GRID_PROVIDER_HPP
+#define LIBWTK_SDL2_GRID_PROVIDER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "list_provider.hpp"
+
+/**
+ * Supplies the items of a grid_view on demand. The rows of the list are the
+ * captions shown below the images.
+ */
+struct grid_provider : list_provider
+{
+    ~grid_provider() override;
+
+    /**
+     * The file of the image of the item, e.g., an album cover. An empty
+     * string shows a placeholder.
+     */
+    virtual std::string image_path(std::size_t index) const = 0;
+};
+
+/**
+ * Formats captions and image paths when they are requested.
+ */
+struct generated_grid_provider : grid_provider
+{
+    generated_grid_provider(std::size_t size, std::function<void(std::size_t, std::string &)> format_caption, std::function<std::string(std::size_t)> image_path);
+
+    std::size_t size() const override;
+    std::string_view row(std::size_t index) const override;
+    std::string image_path(std::size_t index) const override;
+
+    /**
+     * Only changes the size, the notification tells what happened to the items.
+     */
+    void insert_items(std::size_t position, std::size_t n);
+    void remove_items(std::size_t position, std::size_t n);
+
+    /**
+     * Items requested earlier might differ now.
+     */
+    void change_items(std::size_t position, std::size_t n);
+
+    private:
+
+    std::size_t _size;
+    std::function<void(std::size_t, std::string &)> _format_caption;
+    std::function<std::string(std::size_t)> _image_path;
+
+    // Reused for every caption.
+    mutable std::string _buffer;
+};
+
+#endif
+
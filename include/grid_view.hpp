@@ -0,0 +1,132 @@
+#ifndef LIBWTK_SDL2_GRID_VIEW_HPP
+#define LIBWTK_SDL2_GRID_VIEW_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "grid_provider.hpp"
+#include "image_loader.hpp"
+#include "sdl_util.hpp"
+#include "selectable.hpp"
+
+/**
+ * Shows many items of the same size in rows, e.g., album covers with their
+ * titles. Unlike grid, items are requested from the provider only when they
+ * are shown.
+ *
+ * The visible items and a row above and below are kept in a fixed number of
+ * slots, an item always uses the slot of its index modulo their number. Items
+ * that scroll out of view hand their slot to those that scroll in, cancelling
+ * images that are still being decoded. Images are decoded in the background
+ * at the size of a cell and shown once they are ready.
+ */
+struct grid_view : selectable, list_observer
+{
+    /**
+     * The loader has to outlive the grid view. The cell size is the one of the
+     * images, the caption is shown below.
+     */
+    grid_view(std::shared_ptr<grid_provider> provider, image_loader & loader, vec cell_size, std::function<void(std::size_t)> activate_callback);
+    ~grid_view() override;
+
+    void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
+    void on_mouse_down_event(mouse_down_event const & e) override;
+    void on_mouse_up_event(mouse_up_event const & e) override;
+    void on_mouse_move_event(mouse_move_event const & e) override;
+    void on_activate() override;
+
+    widget * navigate_selectable(navigation_type nt, point center) override;
+
+    void on_box_allocated() override;
+
+    void release_resources() override;
+
+    size_hint get_size_hint(int width, int height) const override;
+
+    void on_rows_inserted(std::size_t position, std::size_t n) override;
+    void on_rows_removed(std::size_t position, std::size_t n) override;
+    void on_rows_changed(std::size_t position, std::size_t n) override;
+
+    /**
+     * @name Grid View Interface
+     * @{
+     */
+
+    void set_provider(std::shared_ptr<grid_provider> provider);
+
+    /**
+     * The offset in pixels from the top of the first row, limited to the
+     * height of all rows.
+     */
+    void set_scroll_offset(int offset);
+    int get_scroll_offset() const;
+
+    /**
+     * The selected item is moved by navigation and activated by return.
+     */
+    void set_selected_position(std::size_t position);
+    std::size_t get_selected_position() const;
+
+    /**
+     * Scrolls as little as possible to show the whole item.
+     */
+    void scroll_to_item(std::size_t index);
+
+    /** @} */
+
+    private:
+
+    struct cell_slot
+    {
+        // Past the end if the slot is unused.
+        std::size_t index;
+
+        std::shared_ptr<image_request> pending;
+
+        // Uploaded when drawn.
+        unique_surface_ptr decoded;
+        unique_texture_ptr texture;
+    };
+
+    int row_height() const;
+    std::size_t row_count() const;
+
+    // The box of the cell of the item, including the caption.
+    rect cell_box(std::size_t index) const;
+
+    // The item at the point or past the end.
+    std::size_t hit_item(point p) const;
+
+    // Assigns the items around the visible rows to their slots.
+    void update_slots();
+    void assign_slot(std::size_t slot, std::size_t index);
+    void reset_slot(cell_slot & s);
+
+    // Slots of items at or after the position show other items now.
+    void reset_slots_from(std::size_t position);
+
+    void draw_cell(draw_context & dc, selection_context const & sc, std::size_t index) const;
+
+    std::shared_ptr<grid_provider> _provider;
+    image_loader & _loader;
+    vec _cell_size;
+    std::function<void(std::size_t)> _activate_callback;
+
+    std::size_t _columns;
+    int _scroll_offset;
+    std::size_t _selected_position;
+
+    mutable std::vector<cell_slot> _slots;
+
+    // Set while dragging.
+    std::optional<int> _drag_start_offset;
+};
+
+#endif
+
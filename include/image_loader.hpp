@@ -0,0 +1,89 @@
+#ifndef LIBWTK_SDL2_IMAGE_LOADER_HPP
+#define LIBWTK_SDL2_IMAGE_LOADER_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <SDL2/SDL_surface.h>
+
+#include "geometry.hpp"
+#include "sdl_util.hpp"
+#include "thread_pool.hpp"
+#include "update_queue.hpp"
+
+struct image_loader;
+
+/**
+ * An image that is decoded in the background. Everything except cancel() has
+ * to be used on the thread that drains the update queue of the loader.
+ */
+struct image_request
+{
+    image_request();
+
+    /**
+     * The callback is not called anymore, and decoding is skipped if it did
+     * not start yet. May be called from any thread.
+     */
+    void cancel();
+    bool is_cancelled() const;
+
+    bool is_done() const;
+
+    /**
+     * The size of the image before it was scaled down, only valid once done.
+     */
+    vec original_size() const;
+
+    /**
+     * Called once the image is decoded, immediately if that happened already.
+     * The surface is empty if the image could not be loaded.
+     */
+    void on_ready(std::function<void(unique_surface_ptr)> f);
+
+    private:
+
+    friend image_loader;
+
+    void complete();
+
+    std::atomic<bool> _cancelled;
+    bool _done;
+
+    // Written by the worker before completion is posted.
+    unique_surface_ptr _surface;
+    vec _original_size;
+    std::function<void(unique_surface_ptr)> _on_ready;
+};
+
+/**
+ * The size within the maximum that preserves the aspect ratio, the size itself
+ * if it fits already. A component of 0 is not limited.
+ */
+vec fit_image_size(vec size, vec max_size);
+
+/**
+ * Decodes images with SDL_image on a pool of threads. Completion is announced
+ * through the update queue, e.g., the one of a widget_context, where the
+ * surface can be uploaded.
+ */
+struct image_loader
+{
+    image_loader(std::shared_ptr<update_queue> updates, std::size_t num_threads = 1);
+
+    /**
+     * Images larger than the maximum size are scaled down while decoding,
+     * preserving their aspect ratio. A component of 0 is not limited.
+     */
+    std::shared_ptr<image_request> load(std::string filename, vec max_size = { 0, 0 });
+
+    private:
+
+    std::shared_ptr<update_queue> _updates;
+    thread_pool _pool;
+};
+
+#endif
+
@@ -0,0 +1,51 @@
+#ifndef LIBWTK_SDL2_INTERNED_TEXT_HPP
+#define LIBWTK_SDL2_INTERNED_TEXT_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// An immutable text that is stored only once, no matter how many widgets use
+// it. The hash and the number of characters are computed when it is created,
+// such that caches can look it up without hashing it again. Copies only share
+// the storage.
+struct interned_text
+{
+    // The empty text.
+    interned_text();
+
+    // Looks the text up in the table of interned texts and adds it if it is
+    // not there yet. Texts are removed once no handle refers to them anymore.
+    explicit interned_text(std::string_view t);
+
+    std::string_view view() const;
+    std::string const & str() const;
+    operator std::string_view() const;
+
+    bool empty() const;
+
+    // The same as std::hash<std::string_view> of the text.
+    std::size_t hash() const;
+
+    // The number of UTF-8 characters.
+    std::size_t length() const;
+
+    // Interned texts are equal if and only if they share their storage.
+    bool operator==(interned_text const & other) const;
+    bool operator!=(interned_text const & other) const;
+
+    struct data
+    {
+        std::string text;
+        std::size_t hash;
+        std::size_t length;
+    };
+
+    private:
+
+    std::shared_ptr<data const> _data;
+};
+
+#endif
+
@@ -1,8 +1,30 @@
 #ifndef LIBWTK_SDL2_KEY_EVENT_HPP
 #define LIBWTK_SDL2_KEY_EVENT_HPP
 
+#include <string_view>
+
+enum class key_type
+{
+    // Text was entered, e.g., by a keyboard or an on-screen keyboard.
+    TEXT,
+
+    BACKSPACE,
+    FORWARD_DELETE,
+    LEFT,
+    RIGHT,
+    HOME,
+    END,
+
+    OTHER
+};
+
 struct key_event
 {
+    key_type type = key_type::OTHER;
+
+    // The UTF-8 encoded text of TEXT events, only valid while the event is
+    // dispatched.
+    std::string_view text;
 };
 
 #endif
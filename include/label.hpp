@@ -4,35 +4,52 @@
 // TODO tiny DSEL for markup and font size
 // TODO sum-of-product type would be better suited for paragraph
 
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "interned_text.hpp"
 #include "widget.hpp"
 
 /**
  * A type to pass a paragraph with trailing newlines to a label. A paragraph
  * can use a different font and trailing newlines will use that fonts height.
+ * The text is interned, copying a paragraph does not copy it.
  */
 struct paragraph
 {
-    paragraph(std::string text, int trailing_newlines, int font_idx);
-    paragraph(std::string text, int trailing_newlines);
-    paragraph(std::string text);
+    paragraph(interned_text text, int trailing_newlines, int font_idx);
+    paragraph(std::string_view text, int trailing_newlines, int font_idx);
+    paragraph(std::string_view text, int trailing_newlines);
+    paragraph(std::string_view text);
     paragraph() = default;
 
+    bool operator==(paragraph const & other) const;
+    bool operator!=(paragraph const & other) const;
+
     // TODO add font style, etc.
-    std::string text;
+    interned_text text;
     int trailing_newlines;
     int font_idx;
 };
 
+/**
+ * Splits the text into paragraphs at newlines, empty lines become trailing
+ * newlines of the paragraph before.
+ */
+std::vector<paragraph> parse_text_fragments(std::string_view text);
+
 /**
  * A widget to display (wrapped) text. 
  */
 struct label : widget
 {
     label(std::vector<paragraph> content = std::vector<paragraph>());
-    label(std::string text);
+    label(std::string_view text);
     ~label() override;
 
     void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
 
     size_hint get_size_hint(int width, int height) const override;
 
@@ -42,14 +59,23 @@ struct label : widget
      */
 
     /**
-     * Set text by parsing a string for paragraphs.
+     * Set text by parsing a string for paragraphs. Nothing happens if the text
+     * is unchanged, text without newlines is not parsed.
      */
-    void set_text(std::string text);
+    void set_text(std::string_view text);
+
+    /**
+     * Set the content to a single paragraph. This is the cheapest way to
+     * update a frequently changing label. Nothing happens if the paragraph is
+     * unchanged.
+     */
+    void set_paragraph(paragraph p);
 
     std::string get_text() const;
 
     /**
-     * Set the content of a label by giving the paragraphs directly.
+     * Set the content of a label by giving the paragraphs directly. Nothing
+     * happens if the content is unchanged.
      */
     void set_content(std::vector<paragraph> content);
 
@@ -77,6 +103,8 @@ struct label : widget
 
     private:
 
+    void content_changed();
+
     std::vector<paragraph> _content;
 
     int _minimum_width;
@@ -0,0 +1,72 @@
+#ifndef LIBWTK_SDL2_LAYOUT_ARENA_HPP
+#define LIBWTK_SDL2_LAYOUT_ARENA_HPP
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+
+#include "thread_pool.hpp"
+
+/**
+ * Memory for temporary data of layout passes. Allocations are never freed
+ * individually but all at once when the outermost activation ends. As long as
+ * a pass fits into the initial buffer it does not allocate at all.
+ *
+ * An arena may also provide a thread pool to evaluate independent parts of a
+ * layout pass in parallel.
+ */
+struct layout_arena
+{
+    layout_arena();
+    layout_arena(layout_arena const &) = delete;
+    layout_arena & operator=(layout_arena const &) = delete;
+
+    /**
+     * The resource of the active arena of the current thread. Without an
+     * active arena the default resource is returned.
+     */
+    static std::pmr::memory_resource * resource();
+
+    /**
+     * Calls f for every index in [0, n) with the thread pool of the active
+     * arena, or sequentially if there is none. Tasks run on other threads
+     * without an active arena, i.e., they allocate from the default resource
+     * and nested calls are sequential.
+     */
+    static void parallel_for(std::size_t n, std::function<void(std::size_t)> const & f);
+
+    /**
+     * Pass nullptr to evaluate layouts sequentially again.
+     */
+    void set_thread_pool(std::shared_ptr<thread_pool> pool);
+
+    /**
+     * Makes the arena active for the current thread while in scope.
+     * Activations of the same arena may be nested.
+     */
+    struct activation
+    {
+        activation(layout_arena & a);
+        ~activation();
+
+        private:
+
+        layout_arena & _arena;
+        layout_arena * _previous;
+    };
+
+    private:
+
+    static constexpr std::size_t INITIAL_BYTES = 16 * 1024;
+
+    alignas(std::max_align_t) std::array<std::byte, INITIAL_BYTES> _buffer;
+    std::pmr::monotonic_buffer_resource _resource;
+    std::size_t _depth;
+
+    std::shared_ptr<thread_pool> _pool;
+};
+
+#endif
+
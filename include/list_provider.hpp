@@ -0,0 +1,114 @@
+#ifndef LIBWTK_SDL2_LIST_PROVIDER_HPP
+#define LIBWTK_SDL2_LIST_PROVIDER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Is told about changes of the rows of a list_provider.
+ */
+struct list_observer
+{
+    virtual ~list_observer();
+
+    /**
+     * The rows are at [position, position + n) afterwards.
+     */
+    virtual void on_rows_inserted(std::size_t position, std::size_t n) = 0;
+
+    /**
+     * The rows were at [position, position + n) before.
+     */
+    virtual void on_rows_removed(std::size_t position, std::size_t n) = 0;
+
+    virtual void on_rows_changed(std::size_t position, std::size_t n) = 0;
+};
+
+/**
+ * Supplies the rows of a list_view on demand, such that they do not have to
+ * exist up front. Only the rows that are shown are requested.
+ */
+struct list_provider
+{
+    virtual ~list_provider();
+
+    virtual std::size_t size() const = 0;
+
+    /**
+     * The text of the row, which is only required to stay valid until the
+     * next call. This allows rows to be formatted into a buffer.
+     */
+    virtual std::string_view row(std::size_t index) const = 0;
+
+    void add_observer(list_observer & o);
+    void remove_observer(list_observer & o);
+
+    protected:
+
+    /**
+     * Has to be called by implementations after the rows changed.
+     */
+    void notify_rows_inserted(std::size_t position, std::size_t n);
+    void notify_rows_removed(std::size_t position, std::size_t n);
+    void notify_rows_changed(std::size_t position, std::size_t n);
+
+    private:
+
+    std::vector<list_observer *> _observers;
+};
+
+/**
+ * Refers to a vector that has to outlive the provider. Changes of the vector
+ * have to be announced with the notification functions.
+ */
+struct vector_list_provider : list_provider
+{
+    vector_list_provider(std::vector<std::string> const & values);
+
+    std::size_t size() const override;
+    std::string_view row(std::size_t index) const override;
+
+    using list_provider::notify_rows_inserted;
+    using list_provider::notify_rows_removed;
+    using list_provider::notify_rows_changed;
+
+    private:
+
+    std::reference_wrapper<std::vector<std::string> const> _values;
+};
+
+/**
+ * Formats rows when they are requested.
+ */
+struct generated_list_provider : list_provider
+{
+    generated_list_provider(std::size_t size, std::function<void(std::size_t, std::string &)> format_row);
+
+    std::size_t size() const override;
+    std::string_view row(std::size_t index) const override;
+
+    /**
+     * Only changes the size, the notification tells what happened to the rows.
+     */
+    void insert_rows(std::size_t position, std::size_t n);
+    void remove_rows(std::size_t position, std::size_t n);
+
+    /**
+     * Rows formatted earlier might differ now.
+     */
+    void change_rows(std::size_t position, std::size_t n);
+
+    private:
+
+    std::size_t _size;
+    std::function<void(std::size_t, std::string &)> _format_row;
+
+    // Reused for every row.
+    mutable std::string _buffer;
+};
+
+#endif
+
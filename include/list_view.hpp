@@ -1,19 +1,29 @@
 #ifndef LIBWTK_SDL2_LIST_VIEW_HPP
 #define LIBWTK_SDL2_LIST_VIEW_HPP
 
+#include <chrono>
 #include <vector>
 #include <functional>
+#include <memory>
 #include <optional>
 
+#include <SDL2/SDL_render.h>
+
+#include "list_provider.hpp"
+#include "prefix_index.hpp"
+#include "sdl_util.hpp"
 #include "selectable.hpp"
 
-// TODO change to vector_view ?
-struct list_view : selectable
+// Rows are requested from the provider only when they are shown.
+struct list_view : selectable, list_observer
 {
+    // The vector has to outlive the list view.
     list_view(std::vector<std::string> const & values, std::size_t position, std::function<void(std::size_t)> activate_callback);
+    list_view(std::shared_ptr<list_provider> provider, std::size_t position, std::function<void(std::size_t)> activate_callback);
     ~list_view() override;
 
     void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
     void on_mouse_up_event(mouse_up_event const & e) override;
     void on_mouse_down_event(mouse_down_event const & e) override;
     void on_key_event(key_event const & e) override;
@@ -21,8 +31,14 @@ struct list_view : selectable
 
     void on_box_allocated() override;
 
+    void release_resources() override;
+
     size_hint get_size_hint(int width, int height) const override;
 
+    void on_rows_inserted(std::size_t position, std::size_t n) override;
+    void on_rows_removed(std::size_t position, std::size_t n) override;
+    void on_rows_changed(std::size_t position, std::size_t n) override;
+
     /**
      * @name List View Interface
      * @{
@@ -33,7 +49,9 @@ struct list_view : selectable
     void set_selected_position(std::size_t position);
     void set_highlight_position(std::size_t position);
     void set_list(std::vector<std::string> const & values, std::size_t position = 0);
+    void set_provider(std::shared_ptr<list_provider> provider, std::size_t position = 0);
 
+    std::size_t get_position() const;
     std::size_t get_visible_entries() const;
 
     void scroll_up(std::size_t amount);
@@ -41,14 +59,82 @@ struct list_view : selectable
     void scroll_up();
     void scroll_down();
 
+    /**
+     * Text typed while the list is selected jumps to the first row starting
+     * with it. The index has to refer to the provider of the list.
+     */
+    void set_prefix_index(std::shared_ptr<prefix_index> index);
+
+    /**
+     * Selects and shows the first row that is not less than the prefix, e.g.,
+     * for an alphabet strip. Returns false if there is no index or it is not
+     * ready yet.
+     */
+    bool jump_to_prefix(std::string_view prefix);
+
     /** @} */
 
+    protected:
+
+    /**
+     * Draws the content of a row on top of its background.
+     */
+    virtual void draw_row_content(draw_context & dc, rect entry_rect, std::size_t index) const;
+
+    /**
+     * The width of the content of the rows, which limits horizontal scrolling.
+     * By default the widest row that has been drawn.
+     */
+    virtual int content_width() const;
+
+    // The cached rows have to be drawn again, e.g., after their layout changed.
+    void invalidate_cached_rows() const;
+
+    std::size_t get_x_shift() const;
+
     private:
 
+    std::size_t max_x_shift() const;
+
     int scroll_distance(int movement_height) const;
 
+    // Keeps scrolling with the velocity of a swipe in pixels per second,
+    // slowing down over time. Returns false if the swipe was too slow.
+    bool start_kinetic_scrolling(int velocity);
+    void stop_kinetic_scrolling();
+    bool step_kinetic_scrolling(animation_scheduler::clock::duration dt);
+
     int hit_entry(int y) const;
 
+    // Selects the row and scrolls it to the top.
+    void show_row(std::size_t row);
+
+    // Whether any of the rows is shown.
+    bool rows_visible(std::size_t position, std::size_t n) const;
+
+    enum class row_background { NORMAL, PRESSED, ACTIVE, HIGHLIGHTED };
+
+    // What is shown in a row of the visible window.
+    struct row_slot
+    {
+        // Past the end for rows below the list.
+        std::size_t index;
+        row_background background;
+
+        bool operator==(row_slot const & other) const;
+        bool operator!=(row_slot const & other) const;
+    };
+
+    row_slot visible_slot(std::size_t k, rect rows_box, selection_context const & sc) const;
+
+    // Draws the slot into the rectangle of its row.
+    void draw_row(draw_context & dc, rect r, row_slot s) const;
+
+    // Draws the rows into a texture and copies it, which reuses the rows that
+    // did not change, also when scrolling. Returns false if render targets
+    // are not supported.
+    bool draw_cached_rows(draw_context & dc, selection_context const & sc, rect rows_box) const;
+
     std::optional<point> _opt_pressed_point;
 
     std::size_t _position;
@@ -59,13 +145,42 @@ struct list_view : selectable
 
     std::size_t _x_shift;
 
-    // TODO more columns and other types
-    std::reference_wrapper<std::vector<std::string> const> _values;
+    std::shared_ptr<list_provider> _provider;
 
     std::function<void(std::size_t)> _activate_callback;
 
+    std::shared_ptr<prefix_index> _prefix_index;
+
+    // Typed text, which starts over after a pause.
+    std::string _type_ahead;
+    std::chrono::steady_clock::time_point _last_type_ahead;
+
     int _row_height;
     int _visible_entries;
+
+    // Grows with the rows drawn, measured by the word cache.
+    mutable int _max_row_width;
+
+    // Two textures with the rows of the visible window, scrolling copies the
+    // current one shifted into the other.
+    mutable unique_texture_ptr _row_textures[2];
+    mutable std::size_t _row_texture;
+    mutable vec _row_texture_size;
+
+    // The content of the current texture.
+    mutable std::vector<row_slot> _cached_rows;
+    mutable std::vector<row_slot> _slots;
+    mutable std::size_t _cached_position;
+    mutable std::size_t _cached_x_shift;
+    mutable bool _rows_valid;
+
+    animation_handle _kinetic_animation;
+
+    // In rows per second, positive values scroll down.
+    double _kinetic_velocity;
+
+    // The part of a row that has not been scrolled yet.
+    double _kinetic_offset;
 };
 
 #endif
@@ -0,0 +1,88 @@
+#ifndef LIBWTK_SDL2_MEMORY_BUDGET_HPP
+#define LIBWTK_SDL2_MEMORY_BUDGET_HPP
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+/**
+ * Keeps memory that can be given up and recreated on demand, e.g., a cache of
+ * textures, and registers with a memory_budget to share a limit with others.
+ */
+struct memory_client
+{
+    virtual ~memory_client();
+
+    /**
+     * The bytes currently kept by the client.
+     */
+    virtual std::size_t resident_bytes() const = 0;
+
+    /**
+     * Evicts until the client keeps at most the given bytes and stays within
+     * them until the limit changes, in addition to any budget of its own.
+     * Memory used by the current frame may be kept. With std::nullopt only
+     * the budget of the client applies again.
+     */
+    virtual void set_memory_limit(std::optional<std::size_t> bytes) = 0;
+};
+
+/**
+ * Shares a limit among the memory clients of a context. Clients of a higher
+ * priority keep what they use, the others are limited to what is left, such
+ * that the least important ones are evicted first.
+ */
+struct memory_budget
+{
+    memory_budget();
+
+    /**
+     * The client has to be removed before it is destroyed. Clients of the
+     * same priority are handled in the order they were added.
+     */
+    void add_client(memory_client & c, int priority);
+    void remove_client(memory_client & c);
+
+    /**
+     * Applies with the next call to enforce(). Without a limit every client
+     * only keeps to its own budget.
+     */
+    void set_byte_limit(std::optional<std::size_t> bytes);
+    std::optional<std::size_t> byte_limit() const;
+
+    /**
+     * Summed up over all clients.
+     */
+    std::size_t resident_bytes() const;
+
+    /**
+     * Divides the limit among the clients, called after every frame.
+     */
+    void enforce();
+
+    /**
+     * Lets every client drop as much as possible, e.g., when the system is
+     * low on memory. Clients grow again with the next call to enforce().
+     */
+    void release_all();
+
+    private:
+
+    struct client_entry
+    {
+        memory_client * client;
+        int priority;
+    };
+
+    // Highest priority first.
+    std::vector<client_entry> _clients;
+
+    std::optional<std::size_t> _byte_limit;
+
+    // Whether the clients were told a limit, which has to be lifted once
+    // there is none.
+    bool _limited;
+};
+
+#endif
+
@@ -1,19 +1,33 @@
 #ifndef LIBWTK_SDL2_MOUSE_EVENT_HPP
 #define LIBWTK_SDL2_MOUSE_EVENT_HPP
 
+#include <cstdint>
 #include <optional>
 
 #include "geometry.hpp"
 
+// Distinguishes the mouse and the fingers of a touch screen, fingers use the
+// finger id of SDL.
+typedef int64_t pointer_id;
+
+pointer_id const MOUSE_POINTER_ID = -1;
+
 struct mouse_down_event
 {
     point position;
+
+    pointer_id pointer = MOUSE_POINTER_ID;
 };
 
 struct mouse_movement
 {
     point origin;
     vec length;
+
+    // In pixels per second and pixels per second squared, estimated from the
+    // most recent part of the path.
+    vec velocity;
+    vec acceleration;
 };
 
 struct mouse_up_event
@@ -21,13 +35,18 @@ struct mouse_up_event
     point position;
 
     std::optional<mouse_movement> opt_movement;
+
+    pointer_id pointer = MOUSE_POINTER_ID;
 };
 
 struct mouse_move_event
 {
-    // TODO add optional button of down position then it is not necessary to
-    // keep such state in the individual widgets
     point position;
+
+    // Only set while the pointer is down.
+    std::optional<mouse_movement> opt_movement;
+
+    pointer_id pointer = MOUSE_POINTER_ID;
 };
 
 #endif
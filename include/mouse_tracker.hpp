@@ -1,24 +1,62 @@
 #ifndef LIBWTK_SDL2_MOUSE_TRACKER_HPP
 #define LIBWTK_SDL2_MOUSE_TRACKER_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 
 #include "mouse_event.hpp"
 
 // Tracks mouse movement and state and produces events in a way that widgets
-// don't have to hold a lot of internal state.
+// don't have to hold a lot of internal state. Every pointer that is down keeps
+// the end of its path, in fixed storage. Times are in milliseconds, as in the
+// timestamps of SDL events.
 struct mouse_tracker
 {
-    void mouse_down(point p);
-    mouse_up_event mouse_up(point p);
+    mouse_tracker();
 
-    mouse_move_event mouse_move(point p);
+    void mouse_down(point p, uint32_t time, pointer_id id = MOUSE_POINTER_ID);
+    mouse_up_event mouse_up(point p, uint32_t time, pointer_id id = MOUSE_POINTER_ID);
 
-    // TODO add mouse movement path
+    mouse_move_event mouse_move(point p, uint32_t time, pointer_id id = MOUSE_POINTER_ID);
+
+    // Pointers that are tracked at most, more are reported without movement.
+    static std::size_t const MAX_POINTERS = 10;
+
+    static std::size_t const MAX_SAMPLES = 16;
 
     private:
 
-    std::optional<point> _opt_down_pos;
+    struct sample
+    {
+        point position;
+        uint32_t time;
+    };
+
+    struct pointer_state
+    {
+        pointer_id id;
+        bool down;
+        point down_position;
+
+        // Oldest first once full.
+        std::array<sample, MAX_SAMPLES> samples;
+        std::size_t next_sample;
+        std::size_t num_samples;
+
+        void add_sample(point p, uint32_t time);
+
+        // The k-th most recent sample.
+        sample const & recent(std::size_t k) const;
+
+        mouse_movement movement() const;
+    };
+
+    // Returns nullptr if the pointer is not down.
+    pointer_state * find_pointer(pointer_id id);
+
+    std::array<pointer_state, MAX_POINTERS> _pointers;
 };
 
 #endif
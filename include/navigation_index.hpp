@@ -0,0 +1,70 @@
+#ifndef LIBWTK_SDL2_NAVIGATION_INDEX_HPP
+#define LIBWTK_SDL2_NAVIGATION_INDEX_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "geometry.hpp"
+
+enum class navigation_type;
+struct widget;
+
+/**
+ * The visible selectable widgets of a tree, in tree order and sorted by the
+ * coordinates of their centers. Navigating becomes a lookup instead of a walk
+ * through the containers.
+ *
+ * In contrast to the navigation of the containers, 2-dimensional navigation
+ * is purely geometric: the nearest widget in the direction is chosen, where
+ * an offset across the direction counts twice.
+ */
+struct navigation_index
+{
+    navigation_index();
+
+    void rebuild(widget & root);
+
+    /**
+     * Whether it was built with the current layout.
+     */
+    bool is_current() const;
+
+    /**
+     * Returns nullptr if there is no widget in the direction, like the
+     * navigation of the containers. The widget has to be in the index.
+     */
+    widget * navigate(navigation_type nt, widget const * from, point center) const;
+
+    bool contains(widget const * w) const;
+
+    std::size_t size() const;
+
+    private:
+
+    struct entry
+    {
+        widget * w;
+        point center;
+    };
+
+    // Candidates sorted by one coordinate, the nearest ones are found with a
+    // binary search and the scan stops once the distance along the axis
+    // exceeds the best cost.
+    widget * nearest(std::vector<std::size_t> const & sorted, bool horizontal, bool forward, widget const * from, point center) const;
+
+    // In tree order, i.e., tab order.
+    std::vector<entry> _entries;
+
+    // Indices of entries.
+    std::vector<std::size_t> _by_x;
+    std::vector<std::size_t> _by_y;
+
+    std::unordered_map<widget const *, std::size_t> _positions;
+
+    std::size_t _generation;
+    bool _built;
+};
+
+#endif
+
@@ -13,10 +13,11 @@ struct notebook : widget
     ~notebook() override;
 
     void on_child_dirty(widget * w) override;
-    std::vector<widget *> get_visible_children() override;
-    std::vector<widget const *> get_visible_children() const override;
+    widget_range get_visible_children() override;
+    const_widget_range get_visible_children() const override;
 
     void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
     void on_mouse_up_event(mouse_up_event const & e) override;
     void on_mouse_down_event(mouse_down_event const & e) override;
 
@@ -26,7 +27,8 @@ struct notebook : widget
     widget * navigate_selectable(navigation_type nt, point center) override;
     widget * navigate_selectable_from_children(navigation_type nt, widget * w, point center) override;
 
-    std::vector<widget *> get_children() override;
+    widget_range get_children() override;
+    const_widget_range get_children() const override;
 
     size_hint get_size_hint(int width, int height) const override;
 
@@ -36,18 +38,62 @@ struct notebook : widget
      */
 
     std::size_t get_page() const;
+
+    /**
+     * Hidden pages are only laid out once they are shown.
+     */
     void set_page(std::size_t index);
 
+    /**
+     * Releases the resources of pages that are not among the given number of
+     * most recently shown pages, see \ref widget::release_resources(). With 0
+     * all pages keep their resources, which is the default.
+     */
+    void set_page_retention(std::size_t pages);
+
+    std::size_t page_count() const;
+
+    /**
+     * Inserts the page before the one at the index, an index past the end
+     * appends it. The shown page stays the same, unless the notebook was
+     * empty.
+     */
+    void insert_page(std::size_t index, widget_ptr page);
+
+    /**
+     * Returns the removed page, such that it may be inserted elsewhere. If it
+     * was shown, the next one is shown instead. Throws std::out_of_range if
+     * there is no page at the index.
+     */
+    widget_ptr remove_page(std::size_t index);
+    widget_ptr replace_page(std::size_t index, widget_ptr page);
+
     /** @} */
 
     private:
 
+    // Redoes the layout within the current box if possible.
+    void pages_changed();
+
     widget * get_shown_widget();
     widget const * get_shown_widget() const;
 
+    // Lays out the shown page if the box changed while it was hidden.
+    void layout_shown_page();
+
+    void release_unused_pages();
 
     std::vector<widget_ptr> _pages;
+    std::vector<widget *> _page_ptrs;
     std::size_t _current_page_index;
+
+    // Whether the page was hidden when the box changed.
+    std::vector<bool> _stale_layouts;
+
+    std::size_t _page_retention;
+
+    // Most recently shown first, only pages that were not released.
+    std::vector<std::size_t> _recent_pages;
 };
 
 #endif
@@ -0,0 +1,48 @@
+#ifndef LIBWTK_SDL2_OFFSCREEN_RENDERER_HPP
+#define LIBWTK_SDL2_OFFSCREEN_RENDERER_HPP
+
+#include <cstddef>
+#include <string>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+#include "geometry.hpp"
+#include "sdl_util.hpp"
+
+// Renders into a surface in memory instead of a window, which does not need a
+// video driver. Meant for benchmarks and tests, a widget_context is created
+// with the renderer as usual.
+struct offscreen_renderer
+{
+    offscreen_renderer(vec size);
+    ~offscreen_renderer();
+
+    offscreen_renderer(offscreen_renderer const &) = delete;
+    offscreen_renderer & operator=(offscreen_renderer const &) = delete;
+
+    SDL_Renderer * renderer() const;
+    rect box() const;
+
+    // The current content in ARGB8888, after all drawing operations have
+    // finished. Changes when drawing continues.
+    SDL_Surface * frame();
+
+    // A copy of the current content.
+    unique_surface_ptr copy_frame();
+
+    // Writes the current content as a BMP file. Throws std::runtime_error on
+    // failure.
+    void save_frame(std::string const & path);
+
+    private:
+
+    unique_surface_ptr _surface;
+    SDL_Renderer * _renderer;
+};
+
+// The number of pixels that differ between two frames of the same size.
+std::size_t frame_difference(SDL_Surface * a, SDL_Surface * b);
+
+#endif
+
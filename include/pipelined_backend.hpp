@@ -0,0 +1,117 @@
+#ifndef LIBWTK_SDL2_PIPELINED_BACKEND_HPP
+#define LIBWTK_SDL2_PIPELINED_BACKEND_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "render_backend.hpp"
+
+// Draws and presents frames on a thread of its own. The operations of a frame
+// are recorded into a display list and executed by another backend once the
+// frame is presented, such that the thread handling events records the next
+// frame while the previous one is drawn and shown, e.g., while a drm_backend
+// waits for vertical blank. At most two frames are in flight, presenting
+// blocks until the older one has been shown.
+//
+// Only backends that draw without the renderer and do not use the window
+// system when presenting can be used, e.g., drm_backend or a software_backend
+// with a framebuffer of its own. Coverage of text is copied with the frame,
+// surfaces are kept alive until it is shown, their pixels must not change
+// meanwhile.
+struct pipelined_backend : render_backend
+{
+    // Throws std::runtime_error if the backend needs the renderer.
+    pipelined_backend(std::unique_ptr<render_backend> backend);
+    ~pipelined_backend() override;
+
+    pipelined_backend(pipelined_backend const &) = delete;
+    pipelined_backend & operator=(pipelined_backend const &) = delete;
+
+    void fill_rects(render_state const & s, rect const * rs, int count) override;
+    void draw_rects(render_state const & s, rect const * rs, int count) override;
+    void copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod) override;
+
+    // Hands the frame to the render thread. Rethrows errors that happened
+    // while an earlier frame was drawn or presented.
+    void present(damage_region const * damage) override;
+
+    // Render targets are not supported by backends without a renderer.
+    unique_texture_ptr create_target_texture(vec size) override;
+    void set_target(SDL_Texture * t, bool clear) override;
+
+    bool needs_pixels() const override;
+
+    void invalidate_state() override;
+
+    // Blocks until every presented frame has been shown, e.g., before the
+    // framebuffer is read.
+    void wait_for_frames();
+
+    private:
+
+    struct coverage_block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        std::size_t size;
+    };
+
+    struct frame
+    {
+        display_list commands;
+        std::optional<damage_region> damage;
+        bool invalidate_state;
+
+        // Referenced by the commands, released by the recording thread.
+        std::vector<SDL_Surface *> surfaces;
+
+        // Copied coverage, blocks are kept when the frame is reused.
+        std::vector<coverage_block> blocks;
+        std::size_t block_index;
+        std::size_t block_used;
+    };
+
+    // Copies coverage into the recorded frame, the pointer stays valid until
+    // the frame is reused.
+    uint8_t const * keep_coverage(uint8_t const * alpha, std::size_t size);
+
+    void record_rects(display_command_type type, render_state const & s, rect const * rs, int count);
+
+    // Prepares a frame for recording.
+    void recycle(frame & f);
+
+    void run();
+    void execute(frame & f);
+
+    // Throws the first error of the render thread.
+    void rethrow_error();
+
+    std::unique_ptr<render_backend> _backend;
+
+    std::unique_ptr<frame> _recording;
+
+    std::mutex _mutex;
+    std::condition_variable _frame_queued;
+    std::condition_variable _frame_shown;
+
+    // The oldest frame is the one that is executed.
+    std::deque<std::unique_ptr<frame>> _queued;
+    std::vector<std::unique_ptr<frame>> _shown;
+    std::exception_ptr _error;
+    bool _stopping;
+
+    // Only used by the render thread, to draw rectangles in runs.
+    std::vector<rect> _rects;
+
+    std::thread _thread;
+};
+
+#endif
+
@@ -0,0 +1,66 @@
+#ifndef LIBWTK_SDL2_PIXEL_STREAM_HPP
+#define LIBWTK_SDL2_PIXEL_STREAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "geometry.hpp"
+#include "update_queue.hpp"
+
+/**
+ * Hands frames of ARGB8888 pixels from a producer thread to the thread that
+ * draws, e.g., for a visualizer or video. Three buffers are used, such that
+ * neither side waits for the other; frames the consumer did not get to are
+ * dropped. Frames are tightly packed, the pitch is four times the width.
+ */
+struct pixel_stream : std::enable_shared_from_this<pixel_stream>
+{
+    /**
+     * Publishing posts to the queue to call the listener on its thread.
+     */
+    pixel_stream(vec size, std::shared_ptr<update_queue> updates);
+
+    vec size() const;
+
+    /**
+     * Producer side. The buffer belongs to the producer until publish().
+     */
+    uint32_t * back_buffer();
+    void publish();
+
+    /**
+     * Consumer side. Calls the function with the latest frame if there is a
+     * new one. Returns whether that was the case.
+     */
+    bool consume(std::function<void(uint32_t const *)> const & f);
+
+    /**
+     * Called on the thread of the update queue after frames were published.
+     * Bursts of frames cause one call.
+     */
+    void set_listener(std::function<void()> listener);
+
+    private:
+
+    vec const _size;
+    std::shared_ptr<update_queue> _updates;
+
+    std::vector<uint32_t> _buffers[3];
+
+    // Only the swaps are protected, not the buffers themselves.
+    std::mutex _mutex;
+    std::size_t _back;
+    std::size_t _ready;
+    std::size_t _front;
+    bool _fresh;
+
+    std::atomic<bool> _notify_pending;
+    std::function<void()> _listener;
+};
+
+#endif
+
@@ -0,0 +1,86 @@
+#ifndef LIBWTK_SDL2_PREFIX_INDEX_HPP
+#define LIBWTK_SDL2_PREFIX_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "list_provider.hpp"
+
+/**
+ * Finds rows of a list_provider by a prefix of their text, e.g., to jump to
+ * the first artist starting with "R". Keys are compared without ASCII case and
+ * only their first bytes are kept, which suffices for typing ahead.
+ *
+ * The keys are copied from the provider on the calling thread and sorted in
+ * the background. Lookups are a binary search and fail until the index is
+ * ready. Changes of the rows let the index build itself again on the next
+ * lookup.
+ */
+struct prefix_index : list_observer
+{
+    prefix_index(std::shared_ptr<list_provider> provider);
+    ~prefix_index() override;
+
+    void on_rows_inserted(std::size_t position, std::size_t n) override;
+    void on_rows_removed(std::size_t position, std::size_t n) override;
+    void on_rows_changed(std::size_t position, std::size_t n) override;
+
+    // Whether lookups reflect the current rows, starts building otherwise.
+    bool is_ready();
+
+    /**
+     * The row with the smallest key that starts with the prefix.
+     */
+    std::optional<std::size_t> find(std::string_view prefix);
+
+    /**
+     * The row with the smallest key that is not less than the prefix, or the
+     * last key. Suits jumping with an alphabet strip where letters may have no
+     * rows.
+     */
+    std::optional<std::size_t> find_nearest(std::string_view prefix);
+
+    private:
+
+    struct key_entry
+    {
+        uint32_t offset;
+        uint32_t row;
+        uint8_t length;
+    };
+
+    struct sorted_keys
+    {
+        // The keys of all rows after each other.
+        std::string data;
+        std::vector<key_entry> entries;
+
+        std::string_view key(key_entry const & e) const;
+    };
+
+    void start_building();
+
+    // The first entry that is not less than the prefix, if ready.
+    std::vector<key_entry>::const_iterator lower_bound(std::string_view prefix);
+
+    std::shared_ptr<list_provider> _provider;
+
+    sorted_keys _keys;
+    std::future<sorted_keys> _building;
+
+    // Whether the rows changed since building was started.
+    bool _stale;
+    bool _ready;
+
+    // Reused for folding prefixes.
+    std::string _prefix;
+};
+
+#endif
+
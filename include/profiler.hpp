@@ -0,0 +1,113 @@
+#ifndef LIBWTK_SDL2_PROFILER_HPP
+#define LIBWTK_SDL2_PROFILER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+struct region;
+
+struct profile_counter
+{
+    std::size_t calls;
+    std::chrono::nanoseconds time;
+};
+
+// Measurements of a region or a type of regions.
+struct region_profile
+{
+    std::string type;
+
+    // Drawing of the widget itself, without its children.
+    profile_counter draw;
+
+    // Includes the layout of children.
+    profile_counter layout;
+    profile_counter size_hint;
+
+    std::size_t texture_copies;
+
+    region_profile & operator+=(region_profile const & other);
+};
+
+enum class profile_kind
+{
+    DRAW,
+    LAYOUT,
+    SIZE_HINT
+};
+
+/**
+ * Records time and call counts of drawing and layout for each region. Only
+ * the active profiler of a thread records anything, otherwise measuring costs
+ * next to nothing.
+ */
+struct profiler
+{
+    profiler();
+
+    void reset();
+
+    /**
+     * Regions are identified by their address, which may be reused after a
+     * region has been destroyed.
+     */
+    std::unordered_map<region const *, region_profile> const & regions() const;
+
+    /**
+     * Sums up the measurements of all regions with the same dynamic type.
+     */
+    std::unordered_map<std::string, region_profile> types() const;
+
+    /**
+     * Keeps the durations of the most recent frames.
+     */
+    void add_frame_time(std::chrono::nanoseconds t);
+    std::deque<std::chrono::nanoseconds> const & frame_times() const;
+
+    void record(region const & r, profile_kind k, std::chrono::nanoseconds t, std::size_t texture_copies);
+
+    static profiler * active();
+
+    /**
+     * Makes the profiler active for the current scope.
+     */
+    struct activation
+    {
+        activation(profiler * p);
+        ~activation();
+
+        private:
+
+        profiler * _previous;
+    };
+
+    /**
+     * Measures the remaining scope and records it with the active profiler.
+     */
+    struct scope
+    {
+        scope(region const & r, profile_kind k);
+        ~scope();
+
+        void set_texture_copies(std::size_t n);
+
+        private:
+
+        profiler * _p;
+        region const & _r;
+        profile_kind _k;
+        std::size_t _texture_copies;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    private:
+
+    std::unordered_map<region const *, region_profile> _regions;
+    std::deque<std::chrono::nanoseconds> _frame_times;
+};
+
+#endif
+
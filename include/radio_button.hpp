@@ -24,6 +24,7 @@ struct radio_button : selectable
     ~radio_button();
 
     void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
     void on_activate() override;
     void on_mouse_up_event(mouse_up_event const & e) override;
     void on_key_event(key_event const & e) override;
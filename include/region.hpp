@@ -1,7 +1,13 @@
 #ifndef LIBWTK_SDL2_REGION_HPP
 #define LIBWTK_SDL2_REGION_HPP
 
+#include <array>
+#include <cstddef>
+
 #include "geometry.hpp"
+#include "mouse_event.hpp"
+
+struct widget;
 
 struct size_hint
 {
@@ -12,11 +18,45 @@ struct size_hint
     vec natural;
 };
 
+enum class redo_layout_type
+{
+    // Try whether the new minimum size fits the allocated box.
+    TRY_LOCAL_MIN,
+    // Try whether the new natural size fits the allocated box.
+    TRY_LOCAL_NAT,
+
+    // Redo the layout for the whole tree.
+    FULL
+};
+
+/**
+ * Performs a layout of the whole tree when a region can not be laid out
+ * locally.
+ */
+struct region_control
+{
+    virtual void queue_redo_layout() = 0;
+
+    /**
+     * Called before a widget is removed from the tree, references to it and
+     * its subtree have to be dropped.
+     */
+    virtual void on_widget_detached(widget & w);
+
+    /**
+     * Sends all move and up events of the pointer directly to the widget until
+     * it is released.
+     */
+    virtual void capture_mouse(widget & w, pointer_id id);
+};
+
 /**
  * A region whose space gets allocated with a specific size.
  */
 struct region
 {
+    region();
+
     /**
      * @name Layout
      * @{
@@ -24,7 +64,9 @@ struct region
 
     /**
      * In the simplest case this just sets the bounding box but may involve more
-     * complex calculations (e.g., with widget containers).
+     * complex calculations (e.g., with widget containers). Nothing is done if
+     * the box did not change and the size hint has not been invalidated since
+     * the last layout, since the layout of the subtree would be the same.
      */
     void apply_layout(rect box);
 
@@ -42,6 +84,27 @@ struct region
      */
     virtual size_hint get_size_hint(int width = -1, int height = -1) const = 0;
 
+    /**
+     * Should be used instead of calling \ref get_size_hint() of another region
+     * directly. Results are cached for the last few constraints until
+     * \ref invalidate_size_hint() is called. Calls that are not cached are
+     * profiled.
+     */
+    size_hint query_size_hint(int width = -1, int height = -1) const;
+
+    /**
+     * Has to be called whenever the result of \ref get_size_hint() might
+     * change, e.g., when the content of a widget changes. Regions depending on
+     * this one are notified with \ref on_size_hint_invalidated().
+     */
+    void invalidate_size_hint();
+
+    /**
+     * Called after the size hint has been invalidated. Widgets use this to
+     * invalidate the size hint of their parent.
+     */
+    virtual void on_size_hint_invalidated();
+
     /**
      * Whether a region is able to use an intermediate value between minimal and
      * natural size (e.g., assigning more width or height). This might change
@@ -54,70 +117,79 @@ struct region
      */
     virtual bool can_use_intermediate_size() const;
 
-    /** @} */
+    /**
+     * Should be called when the size hint changed, after
+     * \ref invalidate_size_hint(). If the new size fits the current box, the
+     * region is laid out within it again. Otherwise the request is passed on
+     * with \ref on_redo_layout_request().
+     */
+    void redo_layout(redo_layout_type t = redo_layout_type::TRY_LOCAL_NAT);
 
-    /*
-    void redo_layout()
-    {
-        auto & rc = get_region_controller();
-        auto const t = rc.preferred_redo_layout_type();
+    /**
+     * Called when the region could not be laid out within its box. Widgets
+     * pass the request to their parent, which might be able to absorb the
+     * change, or the root queues a layout of the whole tree.
+     */
+    virtual void on_redo_layout_request(redo_layout_type t);
+
+    /**
+     * Called after the layout of the region has been redone locally.
+     */
+    virtual void on_layout_redone();
 
-        if (redo_layout_type::FULL == t)
-        {
-            rc.queue_redo_layout();
-        }
-        else
-        {
-            auto const sh = get_size_hint(_box.w, _box.h);
-            vec const & size = redo_layout_type::TRY_LOCAL_MIN == t ? sh.minimum : sh.natural;
-            try_redo_layout_in(size);
-        }
-    }
+    /**
+     * Called first by \ref redo_layout(). Returns true if the request is
+     * handled later instead, e.g., when many widgets are changed at once.
+     */
+    virtual bool defer_redo_layout(redo_layout_type t);
+
+    /** @} */
 
-    virtual void on_redo_layout_request() = 0;
-    */
 
     /**
      * Get the region's assigned bounding box.
      */
     rect const & get_box() const;
 
+    /**
+     * Changes whenever any region got a different box or the visible regions
+     * changed otherwise, such that data derived from the layout can tell
+     * whether it is outdated.
+     */
+    static std::size_t layout_generation();
+
+    protected:
+
+    /**
+     * Has to be called when the visible regions change without a layout,
+     * e.g., when switching pages.
+     */
+    static void advance_layout_generation();
+
     private:
 
-    /*
-    void try_redo_layout_in(vec v)
+    rect _box;
+
+    struct size_hint_cache_entry
     {
-        if (fits(v, _box))
-        {
-            apply_layout(_box);
-        }
-        else
-        {
-            on_redo_layout_request();
-        }
-    }
-    */
+        int width;
+        int height;
+        vec minimal;
+        vec natural;
+    };
 
-    rect _box;
-};
+    // Layouts query their children with few different constraints.
+    static constexpr std::size_t SIZE_HINT_CACHE_ENTRIES = 4;
 
-/*
-enum class redo_layout_type
-{
-    // Try whether the new minimum size fits the allocated box.
-    TRY_LOCAL_MIN,
-    // Try whether the new natural size fits the allocated box.
-    TRY_LOCAL_NAT,
+    mutable std::array<size_hint_cache_entry, SIZE_HINT_CACHE_ENTRIES> _size_hint_cache;
+    mutable std::size_t _size_hint_cache_size;
 
-    // Redo the layout for the whole tree.
-    FULL
-};
+    // The entry that is replaced next.
+    mutable std::size_t _size_hint_cache_next;
 
-struct region_control
-{
-    virtual void queue_redo_layout() = 0;
+    // Whether the layout within the box is up to date.
+    bool _layout_valid;
 };
-*/
 
 #endif
 
@@ -0,0 +1,62 @@
+#ifndef LIBWTK_SDL2_RENDER_BACKEND_HPP
+#define LIBWTK_SDL2_RENDER_BACKEND_HPP
+
+#include <cstdint>
+#include <optional>
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_render.h>
+
+#include "damage_region.hpp"
+#include "display_list.hpp"
+#include "geometry.hpp"
+#include "sdl_util.hpp"
+
+// A part of a texture that is copied as one of many.
+struct texture_quad
+{
+    rect source;
+    rect target;
+
+    // The coverage of the source area, see texture_ref.
+    uint8_t const * alpha;
+};
+
+// Executes the drawing operations of a draw_context. Every operation gets the
+// complete state it depends on, a backend may keep track of what it has
+// applied already.
+struct render_backend
+{
+    virtual ~render_backend();
+
+    virtual void fill_rects(render_state const & s, rect const * rs, int count) = 0;
+    virtual void draw_rects(render_state const & s, rect const * rs, int count) = 0;
+
+    // If the color modulation is not given the one from the last copy of the
+    // texture is used.
+    virtual void copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod) = 0;
+
+    // Copies several parts of one texture with the color modulation, e.g., the
+    // words of a text. The coverage of texture_ref is replaced by the one of
+    // each quad. The default implementation copies one at a time.
+    virtual void copy_quads(render_state const & s, texture_ref const & t, texture_quad const * quads, int count, SDL_Color color_mod);
+
+    // Only the damaged area has changed since the last frame.
+    virtual void present(damage_region const * damage) = 0;
+
+    // Textures that can be drawn to, returns an empty pointer if those are not
+    // supported. Drawing to a target may start with the texture cleared,
+    // otherwise it keeps its content.
+    virtual unique_texture_ptr create_target_texture(vec size) = 0;
+    virtual void set_target(SDL_Texture * t, bool clear) = 0;
+
+    // Whether copies have to provide the pixels of their source, textures
+    // alone can not be drawn then.
+    virtual bool needs_pixels() const = 0;
+
+    // The state of the backend may have been changed by someone else.
+    virtual void invalidate_state();
+};
+
+#endif
+
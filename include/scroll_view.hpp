@@ -0,0 +1,141 @@
+#ifndef LIBWTK_SDL2_SCROLL_VIEW_HPP
+#define LIBWTK_SDL2_SCROLL_VIEW_HPP
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "container.hpp"
+#include "sdl_util.hpp"
+
+/**
+ * A container that stacks its children vertically and shows a part of them,
+ * e.g., for long settings pages. Only the children within a window around the
+ * visible part are laid out and drawn, their heights are queried from the top
+ * when they are needed first.
+ *
+ * The window is drawn into a texture, such that scrolling within it only
+ * copies another part and children that change are drawn into it alone. Once
+ * the visible part leaves the window it is moved, reusing what overlaps.
+ *
+ * Navigating into a child scrolls it into view. Dragging the content vertically
+ * scrolls it as well, children that capture the pointer themselves, e.g., a
+ * slider, keep their drags.
+ */
+struct scroll_view : container
+{
+    scroll_view(std::vector<widget_ptr> children, int children_spacing = 5);
+    ~scroll_view() override;
+
+    void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
+    void on_child_dirty(widget * w) override;
+
+    void on_mouse_down_event(mouse_down_event const & me) override;
+    void on_mouse_up_event(mouse_up_event const & me) override;
+    void on_mouse_move_event(mouse_move_event const & e) override;
+    void on_mouse_capture_released(pointer_id id) override;
+
+    widget_range get_visible_children() override;
+    const_widget_range get_visible_children() const override;
+    widget_range get_children() override;
+    const_widget_range get_children() const override;
+
+    void on_box_allocated() override;
+
+    // Heights of the children are measured again.
+    void on_size_hint_invalidated() override;
+
+    void release_resources() override;
+
+    widget * find_selectable(navigation_type nt, point center) override;
+    widget * navigate_selectable_from_children(navigation_type nt, widget * w, point center) override;
+    widget * find_child_at(point p) override;
+
+    size_hint get_size_hint(int width, int height) const override;
+
+    /**
+     * @name Scroll View Interface
+     * @{
+     */
+
+    /**
+     * The offset in pixels from the top of the content, limited to its height.
+     */
+    void set_scroll_offset(int offset);
+    int get_scroll_offset() const;
+
+    /**
+     * Scrolls as little as possible to show the whole child, or its top if it
+     * is higher than the view.
+     */
+    void scroll_to_child(std::size_t index);
+
+    /**
+     * Children that have not been measured yet are assumed to have the average
+     * height of those that have been.
+     */
+    int get_content_height() const;
+
+    /** @} */
+
+    protected:
+
+    void draw_children(draw_context & dc, selection_context const & sc) const override;
+
+    private:
+
+    // Queries the heights of the children that start above the offset from
+    // the top of the content.
+    void measure_until(int offset);
+    void measure_next();
+    void reset_measurements();
+
+    // Moves the window if necessary and lays out the children within.
+    void layout_window();
+
+    int window_height() const;
+
+    // Draws the background and the children within the area.
+    void draw_area(draw_context & dc, selection_context const & sc, rect area) const;
+
+    bool is_visible_child(widget const * w) const;
+
+    std::vector<widget_ptr> _children;
+    std::vector<widget *> _child_ptrs;
+    int _children_spacing;
+
+    // The top of the measured children followed by the end of the last one,
+    // each including the spacing after it.
+    std::vector<int> _tops;
+    int _measured_width;
+
+    int _scroll_offset;
+
+    // Set while a pointer is down within the view, the press becomes a drag
+    // once it moved far enough.
+    std::optional<int> _drag_start_offset;
+    pointer_id _drag_pointer;
+    bool _dragging;
+
+    // The part of the content that is laid out, relative to its top.
+    int _window_top;
+    std::vector<widget *> _window_children;
+
+    // Set while children are only moved, which does not change how they look.
+    bool _moving_children;
+
+    mutable unique_texture_ptr _textures[2];
+    mutable std::size_t _texture;
+    mutable vec _texture_size;
+
+    // The window that the current texture shows.
+    mutable int _drawn_window_top;
+    mutable bool _texture_valid;
+
+    // Children that have to be drawn into the texture again.
+    mutable std::vector<widget const *> _dirty_children;
+};
+
+#endif
+
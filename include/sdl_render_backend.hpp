@@ -0,0 +1,71 @@
+#ifndef LIBWTK_SDL2_SDL_RENDER_BACKEND_HPP
+#define LIBWTK_SDL2_SDL_RENDER_BACKEND_HPP
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_version.h>
+
+#include "render_backend.hpp"
+
+// Draws with an SDL renderer.
+struct sdl_render_backend : render_backend
+{
+    sdl_render_backend(SDL_Renderer * renderer);
+
+    void fill_rects(render_state const & s, rect const * rs, int count) override;
+    void draw_rects(render_state const & s, rect const * rs, int count) override;
+    void copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod) override;
+
+    // Submits all quads with a single call of SDL_RenderGeometry() if it is
+    // available.
+    void copy_quads(render_state const & s, texture_ref const & t, texture_quad const * quads, int count, SDL_Color color_mod) override;
+
+    // The software renderer then only updates the damaged parts of the window
+    // surface, other renderers present the whole frame.
+    void present(damage_region const * damage) override;
+
+    unique_texture_ptr create_target_texture(vec size) override;
+    void set_target(SDL_Texture * t, bool clear) override;
+
+    bool needs_pixels() const override;
+
+    void invalidate_state() override;
+
+    private:
+
+    // Changes the renderer state only if necessary. Some backends flush their
+    // batch on every change.
+    void apply_state(render_state const & s);
+
+    // Like apply_state() for the color modulation of a texture, which is
+    // kept by the texture.
+    void set_texture_color_mod(SDL_Texture * t, SDL_Color c);
+
+    // Whether presenting copies the window surface to the display.
+    bool updates_window_surface() const;
+
+    SDL_Renderer * _renderer;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // Reused for every batch of quads.
+    std::vector<SDL_Vertex> _vertices;
+    std::vector<int> _indices;
+#endif
+
+    // The known renderer state, nothing is known after invalidation.
+    std::optional<SDL_Color> _applied_draw_color;
+    std::optional<SDL_BlendMode> _applied_blend_mode;
+    std::optional<std::optional<rect>> _applied_clip;
+    std::optional<std::optional<rect>> _applied_viewport;
+
+    // Dropped as well once any texture has been destroyed.
+    std::unordered_map<SDL_Texture *, SDL_Color> _applied_color_mods;
+    std::size_t _color_mod_destructions;
+};
+
+#endif
+
@@ -1,5 +1,6 @@
 #ifndef LIBWTK_SDL2_UTIL
 #define LIBWTK_SDL2_UTIL
+#include <cstddef>
 #include <memory>
 
 #include <SDL2/SDL_rect.h>
@@ -21,6 +22,14 @@ struct texture_destroyer
 
 typedef std::unique_ptr<SDL_Texture, texture_destroyer> unique_texture_ptr;
 
+// Every texture of the library is destroyed with this, such that state kept
+// per texture, e.g., by a render backend, can be dropped once a texture at the
+// same address might be another one.
+void destroy_texture(SDL_Texture * t);
+
+// Increases with every destroyed texture.
+std::size_t texture_destructions();
+
 SDL_Texture * load_raw_texture_from_image(SDL_Renderer * r, std::string filename);
 
 unique_texture_ptr load_texture_from_image(SDL_Renderer * r, std::string filename);
@@ -47,6 +56,12 @@ std::tuple<SDL_Rect, SDL_Rect, SDL_Rect> scale_preserve_ar(vec size, SDL_Rect ta
 // blit a surface to another surface while preserving aspect ratio
 void blit_preserve_ar(SDL_Surface * source, SDL_Surface * dest, SDL_Rect const * destrect);
 
+// Shrinks a surface by averaging the pixels covered by each target pixel,
+// which does not alias like the sampling of the renderer or SDL_BlitScaled.
+// The size is limited to that of the surface, the result is ARGB8888. Throws
+// std::runtime_error on failure.
+unique_surface_ptr downscale_surface(SDL_Surface * s, vec size);
+
 vec texture_dim(SDL_Texture const * tex);
 
 #endif
@@ -5,6 +5,7 @@
 #include "key_event.hpp"
 
 enum class navigation_type;
+struct navigation_index;
 struct widget;
 
 // TODO work with shared_ptr (in case a selected widget gets removed)
@@ -39,6 +40,10 @@ struct selection_context
 
     void change_widget_area(rect new_box);
 
+    // Navigates with the index instead of the containers, as long as the
+    // selected widget is part of it. The index has to be kept up to date.
+    void set_navigation_index(navigation_index const * index);
+
     private:
 
     void unselect_helper();
@@ -47,6 +52,7 @@ struct selection_context
     point _selected_position;
     widget * _selected_widget;
     rect _widget_area;
+    navigation_index const * _index;
 };
 
 #endif
@@ -3,6 +3,7 @@
 
 #include <functional>
 
+#include "animation_scheduler.hpp"
 #include "selectable.hpp"
 
 struct slider : selectable
@@ -26,6 +27,7 @@ struct slider : selectable
     ~slider() override;
 
     void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
     void on_mouse_up_event(mouse_up_event const & e) override;
     void on_mouse_down_event(mouse_down_event const & e) override;
     void on_mouse_move_event(mouse_move_event const & e) override;
@@ -51,6 +53,15 @@ struct slider : selectable
      */
     int get_value() const;
 
+    /**
+     * By default the value callback only fires once the knob is released.
+     * With drag updates it also fires while dragging, but changes are
+     * coalesced such that it fires at most once per frame, or at most once
+     * per \ref min_interval if given. The final value is always delivered on
+     * release.
+     */
+    void set_drag_updates(bool enabled, animation_scheduler::clock::duration min_interval = animation_scheduler::clock::duration::zero());
+
     /** @} */
 
     private:
@@ -58,7 +69,12 @@ struct slider : selectable
     void refresh_knob_box();
     int get_step_with_abs_pos(int abs_pos);
     void set_step(int step);
-    void emit_value_callback(int step);
+    void emit_value_callback();
+
+    // Fires the callback for changes during a drag once it is due.
+    void schedule_drag_update();
+    bool step_drag_update();
+    void stop_drag_update();
 
     int _start;
     int _end;
@@ -70,6 +86,14 @@ struct slider : selectable
 
     int _pressed_step;
 
+    // The step that has been passed to the callback last.
+    int _reported_step;
+
+    bool _drag_updates;
+    animation_scheduler::clock::duration _drag_update_interval;
+    animation_scheduler::clock::time_point _last_drag_update;
+    animation_handle _drag_update_animation;
+
     rect _knob_box;
     int _step_width;
     int _step_width_rems;
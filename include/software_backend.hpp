@@ -0,0 +1,62 @@
+#ifndef LIBWTK_SDL2_SOFTWARE_BACKEND_HPP
+#define LIBWTK_SDL2_SOFTWARE_BACKEND_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_video.h>
+
+#include "render_backend.hpp"
+
+// Draws directly into a 32-bit framebuffer with the CPU. Text is drawn from the
+// coverage kept by the font caches and surfaces are blitted, textures without
+// pixels are skipped. Render targets are not supported.
+struct software_backend : render_backend
+{
+    // Draws to the surface of the window and updates the damaged parts of it
+    // when presenting.
+    software_backend(SDL_Window * window);
+
+    // The owner of the surface is responsible to show it.
+    software_backend(SDL_Surface * framebuffer);
+
+    void fill_rects(render_state const & s, rect const * rs, int count) override;
+    void draw_rects(render_state const & s, rect const * rs, int count) override;
+    void copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod) override;
+
+    void present(damage_region const * damage) override;
+
+    unique_texture_ptr create_target_texture(vec size) override;
+    void set_target(SDL_Texture * t, bool clear) override;
+
+    bool needs_pixels() const override;
+
+    protected:
+
+    // The framebuffer has to be set before drawing.
+    software_backend();
+
+    void set_framebuffer(SDL_Surface * framebuffer);
+
+    private:
+
+    // The area the state allows drawing in and the offset of the viewport.
+    rect bounds(render_state const & s, point & origin) const;
+
+    void fill(render_state const & s, rect r);
+
+    SDL_Window * _window;
+    SDL_Surface * _framebuffer;
+
+    // Mirrors the color modulation of textures, which is set once for a run of
+    // copies.
+    std::unordered_map<SDL_Texture *, SDL_Color> _color_mods;
+
+    // A row of coverage sampled for a scaled copy.
+    std::vector<uint8_t> _scaled_coverage;
+};
+
+#endif
+
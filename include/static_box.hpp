@@ -0,0 +1,194 @@
+#ifndef LIBWTK_SDL2_STATIC_BOX_HPP
+#define LIBWTK_SDL2_STATIC_BOX_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "box.hpp"
+#include "container.hpp"
+
+/**
+ * Describes a child of a static_box that is constructed in place from the
+ * arguments, see \ref static_child().
+ */
+template <typename Widget, typename... Args>
+struct static_child_spec
+{
+    typedef Widget widget_type;
+
+    bool expand;
+    std::tuple<Args...> args;
+};
+
+template <typename Widget, typename... Args>
+static_child_spec<Widget, std::decay_t<Args>...> static_child(bool expand, Args &&... args)
+{
+    return { expand, std::tuple<std::decay_t<Args>...>(std::forward<Args>(args)...) };
+}
+
+// A child of a static_box, constructed in place since widgets can not be
+// moved.
+template <typename Widget>
+struct static_box_slot
+{
+    template <typename... Args>
+    static_box_slot(static_child_spec<Widget, Args...> && spec)
+        : expand(spec.expand)
+        , widget(std::make_from_tuple<Widget>(std::move(spec.args)))
+    {
+    }
+
+    // The type is known, the call does not go through the vtable.
+    bool can_use_intermediate_size() const
+    {
+        return widget.Widget::can_use_intermediate_size();
+    }
+
+    bool expand;
+    Widget widget;
+};
+
+/**
+ * A box with a fixed set of children, which are stored within the box instead
+ * of being allocated on their own. A screen that is known at compile time is
+ * then a single allocation, and the children are neither reference counted
+ * nor reached through pointers when they are laid out and drawn: both iterate
+ * the tuple of children with their concrete types. The layout and navigation
+ * are those of \ref box. Children can not be added, removed or replaced. For
+ * example:
+ *
+ *     auto b = make_static_vbox(5, false,
+ *                  static_child<label>(false, "Title"),
+ *                  static_child<text_button>(true, "OK", [](){}));
+ *     b->get<1>().set_label("Cancel");
+ */
+template <typename... Widgets>
+struct static_box : container
+{
+    template <typename... Specs>
+    static_box(box::orientation o, int children_spacing, bool children_homogeneous, Specs... specs)
+        : _children(std::move(specs)...)
+        , _child_ptrs(std::apply([](auto &... slots){ return std::array<widget *, sizeof...(Widgets)> { { &slots.widget... } }; }, _children))
+        , _children_spacing(children_spacing)
+        , _children_homogeneous(children_homogeneous)
+        , _o(o)
+    {
+        static_assert(sizeof...(Specs) == sizeof...(Widgets), "every child needs a specification");
+        init_children();
+    }
+
+    void on_box_allocated() override
+    {
+        rect const & area = get_box();
+        bool const vertical = _o == box::orientation::VERTICAL;
+        auto const items = std::apply([&](auto const &... slots)
+        {
+            return std::array<box_layout_item, sizeof...(Widgets)>
+            { {
+                { vertical ? slots.widget.query_size_hint(area.w, -1) : slots.widget.query_size_hint(-1, area.h)
+                , slots.expand
+                , slots.can_use_intermediate_size()
+                }...
+            } };
+        }, _children);
+
+        std::array<rect, sizeof...(Widgets)> boxes;
+        layout_box_items(_o, area, _children_spacing, _children_homogeneous, items.data(), boxes.data(), boxes.size());
+
+        std::apply([&](auto &... slots)
+        {
+            std::size_t k = 0;
+            (slots.widget.apply_layout(boxes[k++]), ...);
+        }, _children);
+    }
+
+    size_hint get_size_hint(int width, int height) const override
+    {
+        bool const horizontal = _o == box::orientation::HORIZONTAL;
+        auto const hints = std::apply([&](auto const &... slots)
+        {
+            return std::array<size_hint, sizeof...(Widgets)>
+            { { (horizontal ? slots.widget.query_size_hint(-1, height) : slots.widget.query_size_hint(width, -1))... } };
+        }, _children);
+        return box_items_size_hint(_o, _children_spacing, _children_homogeneous, hints.data(), hints.size());
+    }
+
+    widget * find_selectable(navigation_type nt, point center) override
+    {
+        return find_selectable_in_box(_o, get_children(), nt, center);
+    }
+
+    widget * navigate_selectable_from_children(navigation_type nt, widget * w, point center) override
+    {
+        widget * result = navigate_in_box(_o, get_children(), w, nt, center);
+        return result != nullptr ? result : navigate_selectable_parent(nt, center);
+    }
+
+    widget * find_child_at(point p) override
+    {
+        return find_child_in_box(_o, get_children(), p);
+    }
+
+    widget_range get_children() override
+    {
+        return widget_range(_child_ptrs.data(), _child_ptrs.size());
+    }
+
+    const_widget_range get_children() const override
+    {
+        return widget_range(_child_ptrs.data(), _child_ptrs.size());
+    }
+
+    template <std::size_t I>
+    auto & get()
+    {
+        return std::get<I>(_children).widget;
+    }
+
+    template <std::size_t I>
+    auto const & get() const
+    {
+        return std::get<I>(_children).widget;
+    }
+
+    protected:
+
+    void draw_children(draw_context & dc, selection_context const & sc) const override
+    {
+        // Children of a box do not overlap, the order does not matter.
+        std::apply([&](auto const &... slots){ (slots.widget.draw(dc, sc), ...); }, _children);
+    }
+
+    private:
+
+    std::tuple<static_box_slot<Widgets>...> _children;
+
+    // For the traversals of the widget tree.
+    std::array<widget *, sizeof...(Widgets)> _child_ptrs;
+
+    int _children_spacing;
+    bool _children_homogeneous;
+    box::orientation _o;
+};
+
+template <typename... Specs>
+static_box(box::orientation, int, bool, Specs...) -> static_box<typename Specs::widget_type...>;
+
+template <typename... Specs>
+std::shared_ptr<static_box<typename Specs::widget_type...>> make_static_hbox(int children_spacing, bool children_homogeneous, Specs... specs)
+{
+    return std::make_shared<static_box<typename Specs::widget_type...>>(box::orientation::HORIZONTAL, children_spacing, children_homogeneous, std::move(specs)...);
+}
+
+template <typename... Specs>
+std::shared_ptr<static_box<typename Specs::widget_type...>> make_static_vbox(int children_spacing, bool children_homogeneous, Specs... specs)
+{
+    return std::make_shared<static_box<typename Specs::widget_type...>>(box::orientation::VERTICAL, children_spacing, children_homogeneous, std::move(specs)...);
+}
+
+#endif
+
@@ -0,0 +1,84 @@
+#ifndef LIBWTK_SDL2_TABLE_PROVIDER_HPP
+#define LIBWTK_SDL2_TABLE_PROVIDER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "list_provider.hpp"
+
+/**
+ * Determines how the cells of a column are shown.
+ */
+enum class cell_type
+{
+    TEXT,
+
+    // Aligned to the right, e.g., track numbers or durations.
+    NUMBER
+};
+
+/**
+ * Supplies the cells of the rows of a table_view on demand. A row of the list
+ * are its cells separated by spaces, such that a table can be shown by a
+ * list_view as well.
+ */
+struct table_provider : list_provider
+{
+    ~table_provider() override;
+
+    virtual std::size_t column_count() const = 0;
+
+    // Text by default.
+    virtual cell_type column_type(std::size_t column) const;
+
+    /**
+     * The text of the cell, which is only required to stay valid until the
+     * next call.
+     */
+    virtual std::string_view cell(std::size_t row, std::size_t column) const = 0;
+
+    std::string_view row(std::size_t index) const override;
+
+    private:
+
+    mutable std::string _row_buffer;
+};
+
+/**
+ * Formats cells when they are requested.
+ */
+struct generated_table_provider : table_provider
+{
+    generated_table_provider(std::size_t size, std::vector<cell_type> columns, std::function<void(std::size_t, std::size_t, std::string &)> format_cell);
+
+    std::size_t size() const override;
+    std::size_t column_count() const override;
+    cell_type column_type(std::size_t column) const override;
+    std::string_view cell(std::size_t row, std::size_t column) const override;
+
+    /**
+     * Only changes the size, the notification tells what happened to the rows.
+     */
+    void insert_rows(std::size_t position, std::size_t n);
+    void remove_rows(std::size_t position, std::size_t n);
+
+    /**
+     * Rows formatted earlier might differ now.
+     */
+    void change_rows(std::size_t position, std::size_t n);
+
+    private:
+
+    std::size_t _size;
+    std::vector<cell_type> _columns;
+    std::function<void(std::size_t, std::size_t, std::string &)> _format_cell;
+
+    // Reused for every cell.
+    mutable std::string _buffer;
+};
+
+#endif
+
@@ -0,0 +1,66 @@
+#ifndef LIBWTK_SDL2_TABLE_VIEW_HPP
+#define LIBWTK_SDL2_TABLE_VIEW_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "list_view.hpp"
+#include "table_provider.hpp"
+
+/**
+ * A list_view that shows the cells of a row in aligned columns. The width of a
+ * column is the widest of its cells that have been shown, only the visible
+ * rows are measured. The text of the cells is laid out from the word cache,
+ * such that cells that repeat, e.g., artists or albums, share their textures.
+ */
+struct table_view : list_view
+{
+    table_view(std::shared_ptr<table_provider> provider, std::size_t position, std::function<void(std::size_t)> activate_callback);
+    ~table_view() override;
+
+    void on_draw(draw_context & dc, selection_context const & sc) const override;
+
+    void on_rows_inserted(std::size_t position, std::size_t n) override;
+    void on_rows_removed(std::size_t position, std::size_t n) override;
+    void on_rows_changed(std::size_t position, std::size_t n) override;
+
+    /**
+     * @name Table View Interface
+     * @{
+     */
+
+    /**
+     * Replaces the provider, the column widths are measured again. Has to be
+     * used instead of \ref list_view::set_provider().
+     */
+    void set_provider(std::shared_ptr<table_provider> provider, std::size_t position = 0);
+
+    std::vector<int> const & get_column_widths() const;
+
+    /** @} */
+
+    protected:
+
+    void draw_row_content(draw_context & dc, rect entry_rect, std::size_t index) const override;
+    int content_width() const override;
+
+    private:
+
+    // Grows the columns to fit the visible rows, unless they have been measured
+    // already.
+    void measure_visible_rows() const;
+
+    std::shared_ptr<table_provider> _table;
+
+    mutable std::vector<int> _column_widths;
+
+    // The visible rows that have been measured, invalid after changes.
+    mutable std::size_t _measured_position;
+    mutable std::size_t _measured_count;
+    mutable bool _measured_valid;
+};
+
+#endif
+
@@ -1,15 +1,17 @@
 #ifndef LIBWTK_SDL2_TEXT_BUTTON_HPP
 #define LIBWTK_SDL2_TEXT_BUTTON_HPP
 
-#include <string>
+#include <string_view>
 
 #include "button.hpp"
+#include "interned_text.hpp"
 
 struct button;
 
 struct text_button : button
 {
-    text_button(std::string text, std::function<void()> callback);
+    text_button(std::string_view text, std::function<void()> callback);
+    text_button(interned_text text, std::function<void()> callback);
 
     ~text_button() override;
 
@@ -18,7 +20,8 @@ struct text_button : button
      * @{
      */
 
-    void set_label(std::string text);
+    void set_label(std::string_view text);
+    void set_label(interned_text text);
 
     /** @} */
 
@@ -27,7 +30,7 @@ struct text_button : button
     void draw_drawable(draw_context & dc, rect box) const override;
     vec get_drawable_size() const override;
 
-    std::string _text;
+    interned_text _text;
 };
 
 #endif
@@ -0,0 +1,103 @@
+#ifndef LIBWTK_SDL2_TEXT_ENTRY_HPP
+#define LIBWTK_SDL2_TEXT_ENTRY_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gap_buffer.hpp"
+#include "selectable.hpp"
+
+/**
+ * A single line of editable text, e.g., for searching. Text is entered with
+ * the key events received while the entry is selected. Platforms with an
+ * on-screen keyboard show it after SDL_StartTextInput() has been called.
+ *
+ * The text is kept in a gap buffer at the cursor and drawn as the text before
+ * and after the cursor. Typing only lays out the text before the cursor again,
+ * which consists of cached words except the edited one, and only the span from
+ * the edit to the end and the caret are redrawn.
+ */
+struct text_entry : selectable
+{
+    text_entry(std::string_view text = std::string_view(), std::function<void(std::string const &)> change_callback = nullptr);
+    ~text_entry() override;
+
+    void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
+    void on_mouse_down_event(mouse_down_event const & e) override;
+    void on_key_event(key_event const & e) override;
+    void on_activate() override;
+
+    void on_box_allocated() override;
+
+    size_hint get_size_hint(int width, int height) const override;
+
+    /**
+     * @name Text Entry Interface
+     * @{
+     */
+
+    /**
+     * Replaces the text without calling the change callback, the cursor is
+     * placed at the end.
+     */
+    void set_text(std::string_view text);
+    std::string get_text() const;
+
+    /**
+     * The cursor is a byte offset into the text, which is moved to the start of
+     * the character it points into.
+     */
+    void set_cursor(std::size_t position);
+    std::size_t get_cursor() const;
+
+    /**
+     * Called with the text when the entry is activated, e.g., by return.
+     */
+    void set_activate_callback(std::function<void(std::string const &)> activate_callback);
+
+    /** @} */
+
+    private:
+
+    void insert(std::string_view text);
+    void erase_before();
+    void erase_after();
+
+    // Redraws starting with the position in the text and notifies.
+    void text_changed(int from_x);
+
+    // Updates the position of the caret and scrolls to make it visible.
+    // Returns whether the text was scrolled.
+    bool update_caret();
+
+    // The width of the text up to a cursor at its end.
+    int prefix_width(std::string_view prefix) const;
+
+    // The closest cursor position to the x-coordinate relative to the text.
+    std::size_t position_at(int x);
+
+    rect text_box() const;
+    rect caret_rect() const;
+
+    gap_buffer _buffer;
+
+    // Relative to the start of the text.
+    int _caret_x;
+
+    // The amount the text is scrolled to the left.
+    int _x_shift;
+
+    std::function<void(std::string const &)> _change_callback;
+    std::function<void(std::string const &)> _activate_callback;
+
+    // Reused when measuring.
+    mutable std::string _measure_buffer;
+    std::vector<std::size_t> _positions;
+};
+
+#endif
+
@@ -0,0 +1,108 @@
+#ifndef LIBWTK_SDL2_TEXT_VIEW_HPP
+#define LIBWTK_SDL2_TEXT_VIEW_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "label.hpp"
+#include "widget.hpp"
+
+/**
+ * A scrollable view of long wrapped text, e.g., lyrics or log output. The line
+ * breaks of every paragraph are kept for the current width, such that only
+ * paragraphs that changed are wrapped again and only the visible lines are
+ * drawn. Scrolling long text costs the same as scrolling a short one.
+ */
+struct text_view : widget
+{
+    text_view(std::vector<paragraph> content = std::vector<paragraph>());
+    text_view(std::string_view text);
+    ~text_view() override;
+
+    void on_draw(draw_context & dc, selection_context const & sc) const override;
+    bool is_opaque() const override;
+    void on_mouse_down_event(mouse_down_event const & e) override;
+    void on_mouse_up_event(mouse_up_event const & e) override;
+    void on_mouse_move_event(mouse_move_event const & e) override;
+
+    void on_box_allocated() override;
+
+    size_hint get_size_hint(int width, int height) const override;
+
+    /**
+     * @name Text View Interface
+     * @{
+     */
+
+    /**
+     * Set text by parsing a string for paragraphs, see \ref label::set_text().
+     */
+    void set_text(std::string_view text);
+
+    void set_content(std::vector<paragraph> content);
+    std::vector<paragraph> const & get_content() const;
+
+    /**
+     * Only the new paragraph is wrapped. A view that is scrolled to the end
+     * stays there, which suits log output.
+     */
+    void append_paragraph(paragraph p);
+
+    /**
+     * Replaces a single paragraph, only it is wrapped again.
+     */
+    void set_paragraph(std::size_t index, paragraph p);
+
+    /**
+     * The offset in pixels from the top of the text, limited to the height of
+     * the text.
+     */
+    void set_scroll_offset(int offset);
+    int get_scroll_offset() const;
+    void scroll_to_end();
+
+    int get_content_height() const;
+
+    /** @} */
+
+    private:
+
+    struct wrapped_paragraph
+    {
+        // The width it has been wrapped for, -1 if it has not been wrapped.
+        int width;
+        std::vector<std::size_t> line_starts;
+        int line_skip;
+    };
+
+    // Wraps the paragraph for the current width if necessary.
+    void wrap(std::size_t index);
+
+    // Recomputes the positions of the paragraphs starting with the index.
+    void update_tops(std::size_t index);
+
+    int max_scroll_offset() const;
+
+    // The text of a line without trailing spaces.
+    std::string_view line_text(std::size_t index, std::size_t line) const;
+
+    std::vector<paragraph> _content;
+    std::vector<wrapped_paragraph> _wrapped;
+
+    // The offset of each paragraph from the top of the text, followed by the
+    // height of the text.
+    std::vector<int> _tops;
+
+    // -1 until a box is allocated.
+    int _wrap_width;
+
+    int _scroll_offset;
+
+    // Set while dragging.
+    std::optional<int> _drag_start_offset;
+};
+
+#endif
+
@@ -0,0 +1,114 @@
+#ifndef LIBWTK_SDL2_TEXTURE_ATLAS_HPP
+#define LIBWTK_SDL2_TEXTURE_ATLAS_HPP
+
+#include <utility>
+#include <vector>
+
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_surface.h>
+
+#include "geometry.hpp"
+
+/**
+ * Packs many small surfaces into a few large texture pages. Rectangles are
+ * allocated with a shelf packer: Every page is split into horizontal shelves
+ * and each shelf is filled from left to right. This works very well for text
+ * since rendered words of one font all have the same height.
+ *
+ * Drawing several entries of the same page does not require a texture switch,
+ * which allows the renderer to batch the copies.
+ */
+struct texture_atlas
+{
+    /**
+     * An allocated area on one of the pages.
+     */
+    struct allocation
+    {
+        SDL_Texture * texture;
+        rect source;
+    };
+
+    /**
+     * Does not use the renderer until the first surface is inserted, such
+     * that the atlas may be created on another thread than the one of the
+     * renderer.
+     */
+    texture_atlas(SDL_Renderer * renderer, vec page_size = { 1024, 1024 });
+    ~texture_atlas();
+
+    texture_atlas(texture_atlas const &) = delete;
+    texture_atlas(texture_atlas && other);
+
+    /**
+     * Copies the surface to a free area on one of the pages. A new page is
+     * created if necessary. If the surface does not fit on a page at all the
+     * returned allocation has a nullptr texture.
+     */
+    allocation insert(SDL_Surface * s);
+
+    /**
+     * Returns the area of an allocation to the atlas, such that it may be
+     * reused by another entry. A page is destroyed once all of its
+     * allocations have been released.
+     */
+    void release(allocation const & a);
+
+    /**
+     * Destroys all pages. Any allocation handed out before is invalid
+     * afterwards.
+     */
+    void clear();
+
+    std::size_t page_count() const;
+
+    /**
+     * Limited by the renderer, which is queried on the first call.
+     */
+    vec page_size() const;
+
+    private:
+
+    struct shelf
+    {
+        int y;
+        int height;
+
+        // The next free position.
+        int x;
+
+        // Released areas to the left of the free position, sorted by their
+        // position (x and width).
+        std::vector<std::pair<int, int>> free_slots;
+    };
+
+    struct page
+    {
+        SDL_Texture * texture;
+        std::vector<shelf> shelves;
+
+        // The start of the unused area below all shelves.
+        int y;
+
+        // The number of allocations that have not been released.
+        std::size_t live;
+    };
+
+    bool allocate(page & p, vec size, rect & result);
+
+    // Try to reuse a released area of a shelf.
+    bool allocate_free_slot(shelf & sh, int width, int & x);
+
+    page create_page();
+
+    // Respects the limits of the renderer once.
+    void limit_page_size() const;
+
+    SDL_Renderer * _renderer;
+    mutable vec _page_size;
+    mutable bool _page_size_limited;
+    std::vector<page> _pages;
+};
+
+#endif
+
@@ -2,6 +2,7 @@
 #define LIBWTK_SDL2_TEXTURE_BUTTON_HPP
 
 #include "button.hpp"
+#include "image_loader.hpp"
 
 struct texture_button : button
 {
@@ -16,6 +17,12 @@ struct texture_button : button
 
     void set_texture(shared_texture_ptr texture);
 
+    /**
+     * The current texture is shown until the image is decoded. Replacing a
+     * pending image cancels it.
+     */
+    void set_texture(std::shared_ptr<image_request> pending);
+
     /** @} */
 
     private:
@@ -23,7 +30,12 @@ struct texture_button : button
     void draw_drawable(draw_context & dc, rect box) const override;
     vec get_drawable_size() const override;
 
-    shared_texture_ptr _texture;
+    void cancel_pending();
+
+    // Created from the decoded surface when drawing.
+    mutable shared_texture_ptr _texture;
+    mutable unique_surface_ptr _decoded;
+    std::shared_ptr<image_request> _pending;
 };
 
 #endif
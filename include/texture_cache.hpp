@@ -0,0 +1,105 @@
+#ifndef LIBWTK_SDL2_TEXTURE_CACHE_HPP
+#define LIBWTK_SDL2_TEXTURE_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+
+#include <SDL2/SDL_render.h>
+
+#include "geometry.hpp"
+#include "memory_budget.hpp"
+#include "sdl_util.hpp"
+
+struct texture_cache_stats
+{
+    std::size_t hits;
+    std::size_t misses;
+    std::size_t evictions;
+
+    std::size_t entries;
+
+    // Of the textures kept alive by the cache itself.
+    std::size_t bytes_retained;
+};
+
+/**
+ * Shares textures loaded from image files, such that an icon used by many
+ * widgets is decoded and uploaded once. Textures stay alive as long as anyone
+ * uses them. In addition the cache keeps the most recently used ones for
+ * later use, up to a byte budget.
+ *
+ * Textures belong to their renderer, the cache has to be cleared before a
+ * renderer is destroyed.
+ */
+struct texture_cache : memory_client
+{
+    texture_cache(std::size_t byte_budget = 16 * 1024 * 1024);
+
+    /**
+     * Images larger than the size are scaled down, preserving their aspect
+     * ratio. A component of 0 is not limited. Throws std::runtime_error if
+     * the image could not be loaded.
+     */
+    shared_texture_ptr load(SDL_Renderer * r, std::string const & path, vec size = { 0, 0 });
+
+    void set_byte_budget(std::size_t bytes);
+    std::size_t byte_budget() const;
+
+    texture_cache_stats stats() const;
+
+    /**
+     * Textures in use stay valid, but are not shared with later loads.
+     */
+    void clear();
+
+    /**
+     * @name Memory Client Interface
+     * Only the textures retained by the cache count, a limit also applies to
+     * the most recently used one.
+     * @{
+     */
+    std::size_t resident_bytes() const override;
+    void set_memory_limit(std::optional<std::size_t> bytes) override;
+    /** @} */
+
+    private:
+
+    typedef std::tuple<SDL_Renderer *, std::string, int, int> key;
+
+    struct entry;
+    typedef std::map<key, entry>::iterator entry_iterator;
+
+    struct entry
+    {
+        std::weak_ptr<SDL_Texture> weak;
+
+        // Set while the entry is in the LRU list.
+        shared_texture_ptr retained;
+        std::list<entry_iterator>::iterator lru_pos;
+        std::size_t bytes;
+    };
+
+    void retain(entry_iterator it, shared_texture_ptr t);
+    void evict();
+
+    std::map<key, entry> _entries;
+
+    // Most recently used first.
+    std::list<entry_iterator> _lru;
+
+    std::size_t _byte_budget;
+    std::optional<std::size_t> _memory_limit;
+    std::size_t _bytes_retained;
+
+    std::size_t _hits;
+    std::size_t _misses;
+    std::size_t _evictions;
+};
+
+#endif
+
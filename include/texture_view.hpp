@@ -6,6 +6,8 @@
 #include <SDL2/SDL.h>
 
 #include "geometry.hpp"
+#include "image_loader.hpp"
+#include "pixel_stream.hpp"
 #include "sdl_util.hpp"
 #include "widget.hpp"
 
@@ -43,20 +45,75 @@ struct texture_view : widget
 
     void set_texture(unique_texture_ptr p, int min_width = -1, int nat_width = -1);
 
+    /**
+     * Shows a placeholder until the image is decoded, then it is uploaded
+     * when drawn next. Replacing a pending image cancels it.
+     */
+    void set_texture(std::shared_ptr<image_request> pending, int min_width = -1, int nat_width = -1);
+
+    /**
+     * Loads the image scaled down to the box of the widget. It is decoded
+     * again once the box changes a lot. The loader has to outlive the widget
+     * or until another texture is set.
+     */
+    void set_image(image_loader & loader, std::string filename, int min_width = -1, int nat_width = -1);
+
+    /**
+     * Keeps a streaming texture of the size that is updated in place, e.g.,
+     * for a visualizer. Only this widget is redrawn after an update.
+     */
+    void set_streaming(vec size, int min_width = -1, int nat_width = -1);
+
+    /**
+     * Writes the next frame directly into the streaming texture when the
+     * widget is drawn next, without another copy. The function gets the
+     * ARGB8888 pixels and the pitch in bytes and has to write all of them.
+     */
+    void update_stream(std::function<void(void *, int)> write);
+
+    /**
+     * Streams frames produced on another thread, the latest one is uploaded
+     * whenever the widget is drawn.
+     */
+    void set_stream(std::shared_ptr<pixel_stream> stream, int min_width = -1, int nat_width = -1);
+
     /** @} */
 
     private:
 
+    void cancel_pending();
+    void attach_pending(std::shared_ptr<image_request> pending, int min_width, int nat_width);
+    void load_image();
+    void reload_if_scaled_badly();
+
+    void stop_streaming();
+
     void refresh_target();
     vec fit_to_width(int width) const;
     int decode_min_width_param(int min_width) const;
     int decode_nat_width_param(int nat_width) const;
 
-    unique_texture_ptr _p;
+    // Created from the decoded surface when drawing.
+    mutable unique_texture_ptr _p;
+    mutable unique_surface_ptr _decoded;
+    std::shared_ptr<image_request> _pending;
+
     vec _size;
     int _min_width;
     int _nat_width;
     rect _target;
+
+    // Set while the image comes from a loader.
+    image_loader * _loader;
+    std::string _filename;
+    vec _requested_size;
+    int _min_width_param;
+    int _nat_width_param;
+
+    // The texture is created when drawing.
+    bool _streaming;
+    mutable std::function<void(void *, int)> _stream_write;
+    std::shared_ptr<pixel_stream> _stream;
 };
 
 #endif
@@ -0,0 +1,96 @@
+#ifndef LIBWTK_SDL2_THEME_HPP
+#define LIBWTK_SDL2_THEME_HPP
+
+#include <SDL2/SDL_pixels.h>
+#include <SDL2/SDL_surface.h>
+
+#include "geometry.hpp"
+
+struct color_theme
+{
+    color_theme();
+
+    SDL_Color button_bg_color;
+    SDL_Color button_fg_color;
+    SDL_Color button_frame_color;
+    SDL_Color button_pressed_bg_color;
+    SDL_Color button_selected_bg_color;
+
+    SDL_Color entry_fg_color;
+    SDL_Color entry_selected_bg_color;
+    SDL_Color entry_highlight_bg_color;
+
+    SDL_Color entry_box_bg_color;
+    SDL_Color entry_box_frame_color;
+    SDL_Color entry_box_selected_frame_color;
+
+    // text outside of boxes, e.g., of labels
+    SDL_Color fg_color;
+    SDL_Color bg_color;
+
+    // displays the status of something, but not related to direct user interaction
+    SDL_Color active_color;
+
+    SDL_Color hightlight_color;
+};
+
+enum class box_type
+{
+    BUTTON,
+    ENTRY,
+
+    // the mark of an active radio button
+    RADIO_MARK
+};
+
+int const BOX_TYPE_COUNT = 3;
+
+enum class box_state
+{
+    IDLE = 0,
+    PRESSED = 1,
+    SELECTED = 2,
+    PRESSED_SELECTED = 3
+};
+
+int const BOX_STATE_COUNT = 4;
+
+box_state make_box_state(bool pressed, bool selected);
+
+/**
+ * Decides the look of the boxes drawn by a draw_context. Every combination of
+ * box type and state is rendered once as a nine-slice sprite: the corners are
+ * copied as they are, the edges and the center are stretched to the size of
+ * the box. Looks of any complexity therefore cost the same when drawing.
+ *
+ * The default implementation draws a box filled with the background color and
+ * a frame of one pixel, optionally with rounded corners. Derive to draw other
+ * sprites.
+ */
+struct theme
+{
+    theme(color_theme colors = color_theme(), int corner_radius = 0);
+    virtual ~theme();
+
+    color_theme const & colors() const;
+
+    /**
+     * The width of the corners of the sprite, which are not stretched. The
+     * sprite has a size of 2 * border_width() + 1 in both dimensions.
+     */
+    virtual int border_width(box_type bt) const;
+
+    /**
+     * Draws the sprite into the area of the ARGB8888 surface, which is
+     * transparent before.
+     */
+    virtual void render_box(box_type bt, box_state s, SDL_Surface * target, rect area) const;
+
+    private:
+
+    color_theme _colors;
+    int _corner_radius;
+};
+
+#endif
+
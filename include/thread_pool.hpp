@@ -0,0 +1,49 @@
+#ifndef LIBWTK_SDL2_THREAD_POOL_HPP
+#define LIBWTK_SDL2_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed number of worker threads that run submitted tasks in order of
+ * submission. Tasks still queued when the pool is destroyed are discarded,
+ * running tasks are waited for.
+ */
+struct thread_pool
+{
+    thread_pool(std::size_t num_threads = 1);
+    ~thread_pool();
+
+    thread_pool(thread_pool const &) = delete;
+    thread_pool & operator=(thread_pool const &) = delete;
+
+    void submit(std::function<void()> task);
+
+    /**
+     * Calls f for every index in [0, n) and returns once all calls are done.
+     * Indices are claimed one at a time by the workers and the calling thread,
+     * which also works on them. So idle workers take over the remaining work
+     * and nested calls from within a task do not wait for queued tasks. The
+     * first exception thrown by f is rethrown.
+     */
+    void parallel_for(std::size_t n, std::function<void(std::size_t)> const & f);
+
+    std::size_t size() const;
+
+    private:
+
+    void run();
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<std::function<void()>> _tasks;
+    bool _stop;
+    std::vector<std::thread> _threads;
+};
+
+#endif
+
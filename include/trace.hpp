@@ -0,0 +1,106 @@
+#ifndef LIBWTK_SDL2_TRACE_HPP
+#define LIBWTK_SDL2_TRACE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct trace_event
+{
+    // Both have to be string literals.
+    char const * category;
+    char const * name;
+
+    // Relative to the creation of the tracer.
+    std::chrono::nanoseconds start;
+    std::chrono::nanoseconds duration;
+};
+
+/**
+ * Records a timeline of the phases of frames, e.g., event handling, layout,
+ * drawing and text rendering. Only the active tracer of a thread records
+ * anything. The scopes are compiled out entirely if LIBWTK_SDL2_NO_TRACING
+ * is defined when building the library.
+ */
+struct tracer
+{
+    tracer();
+
+    void reset();
+
+    std::vector<trace_event> const & events() const;
+
+    /**
+     * Events beyond the limit are dropped, such that tracing can not exhaust
+     * memory when it is forgotten.
+     */
+    void set_max_events(std::size_t n);
+    std::size_t dropped_events() const;
+
+    void record(char const * category, char const * name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /**
+     * Writes the events in the JSON format of the Chrome trace viewer, which
+     * is also understood by Perfetto.
+     */
+    void write_chrome_trace(std::ostream & out) const;
+
+    /**
+     * Throws std::runtime_error if the file could not be written.
+     */
+    void write_chrome_trace(std::string const & path) const;
+
+    static tracer * active();
+
+    /**
+     * Makes the tracer active for the current scope.
+     */
+    struct activation
+    {
+        activation(tracer * t);
+        ~activation();
+
+        private:
+
+        tracer * _previous;
+    };
+
+    /**
+     * Measures the remaining scope and records it with the active tracer.
+     * Costs a thread local lookup if no tracer is active.
+     */
+    struct scope
+    {
+        scope(char const * category, char const * name);
+        ~scope();
+
+        private:
+
+        tracer * _t;
+        char const * _category;
+        char const * _name;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+    private:
+
+    std::chrono::steady_clock::time_point _origin;
+    std::vector<trace_event> _events;
+    std::size_t _max_events;
+    std::size_t _dropped_events;
+};
+
+#define LIBWTK_SDL2_TRACE_CONCAT_IMPL(a, b) a##b
+#define LIBWTK_SDL2_TRACE_CONCAT(a, b) LIBWTK_SDL2_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef LIBWTK_SDL2_NO_TRACING
+#define LIBWTK_SDL2_TRACE_SCOPE(category, name)
+#else
+#define LIBWTK_SDL2_TRACE_SCOPE(category, name) tracer::scope LIBWTK_SDL2_TRACE_CONCAT(trace_scope_, __LINE__)(category, name)
+#endif
+
+#endif
+
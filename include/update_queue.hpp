@@ -0,0 +1,51 @@
+#ifndef LIBWTK_SDL2_UPDATE_QUEUE_HPP
+#define LIBWTK_SDL2_UPDATE_QUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+/**
+ * Carries updates from any number of threads to the thread that owns the
+ * widgets, without locks. Posting to an empty queue pushes a single SDL
+ * event to wake up an event loop that waits for input. Further updates until
+ * the next drain do not push another, such that bursts cause one frame.
+ */
+struct update_queue
+{
+    /**
+     * Pass (uint32_t)-1 to not push wakeup events.
+     */
+    update_queue(uint32_t wakeup_event);
+    ~update_queue();
+
+    update_queue(update_queue const &) = delete;
+    update_queue & operator=(update_queue const &) = delete;
+
+    /**
+     * May be called from any thread.
+     */
+    void post(std::function<void()> update);
+
+    /**
+     * Runs the pending updates in the order they were posted. Must only be
+     * called from one thread. Returns whether anything was run.
+     */
+    bool drain();
+
+    private:
+
+    struct node
+    {
+        std::function<void()> update;
+        node * next;
+    };
+
+    // The most recently posted update first.
+    std::atomic<node *> _head;
+
+    uint32_t const _wakeup_event;
+};
+
+#endif
+
@@ -1,7 +1,9 @@
 #ifndef LIBWTK_SDL2_UTF8_HPP
 #define LIBWTK_SDL2_UTF8_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <string_view>
 
 int utf8_byte_count(uint8_t start_byte);
 
@@ -13,5 +15,22 @@ bool is_utf8_following_byte(uint8_t b);
 // assumes a non-empty and well-formed utf8 string
 int count_utf8_backwards(char const * ptr);
 
+// returned for malformed sequences
+uint32_t const UTF8_REPLACEMENT_CHARACTER = 0xfffd;
+
+// decode the character at ptr, which has to be before end, and write the
+// number of consumed bytes to length
+uint32_t decode_utf8(char const * ptr, char const * end, int & length);
+
+// decode the first and last character of a string, returns a space for an
+// empty string
+uint32_t decode_first_utf8(std::string_view s);
+uint32_t decode_last_utf8(std::string_view s);
+
+// the number of bytes until the first non-ascii character
+std::size_t utf8_ascii_prefix_length(std::string_view s);
+
+bool is_valid_utf8(std::string_view s);
+
 #endif
 
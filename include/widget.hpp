@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "context_info.hpp"
+#include "damage_region.hpp"
 #include "draw_context.hpp"
 #include "geometry.hpp"
 #include "key_event.hpp"
@@ -14,6 +15,7 @@
 #include "region.hpp"
 #include "selection_context.hpp"
 #include "swipe.hpp"
+#include "widget_range.hpp"
 
 struct widget;
 
@@ -71,36 +73,95 @@ struct widget : region
      * mark itself at least as `dirty_type::CHILD_DIRTY` and to propagate the
      * change with \ref notify_parent_child_dirty().
      */
-    virtual std::vector<widget *> get_visible_children();
-    virtual std::vector<widget const *> get_visible_children() const;
+    virtual widget_range get_visible_children();
+    virtual const_widget_range get_visible_children() const;
 
     /**
      * Sets all dirty flags to clean. Drawing in general will not reset the
      * dirty state. This is because it won't have to when not using dirty-based
      * drawing and most importantly if double buffering is used the widget has
      * to be drawn two times.
+     *
+     * Has to be called after a full redraw as well, since marking widgets
+     * dirty stops at ancestors that are already dirty.
      */
     void clear_dirty();
 
+    /**
+     * Marks the widget for redrawing and notifies the parent. Propagation
+     * stops at the first widget that has already been notified, overrides of
+     * \ref on_child_dirty() are called until then.
+     */
     void mark_dirty();
     void mark_child_dirty(widget * child);
 
+    /**
+     * Marks only an area within the box for redrawing, e.g., the old and the
+     * new position of a moving part. Dirty-based drawing then clips drawing
+     * to the area and only adds it to the damage region. Marking the whole
+     * widget takes precedence.
+     */
+    void mark_dirty(rect area);
+
     /**
      * Recursively draws all widgets without dirty checking. There is also no
-     * need to call \ref clear_dirty().
+     * need to call \ref clear_dirty(). Subtrees outside of the visible area of
+     * the draw context are skipped.
      */
     void draw(draw_context & dc, selection_context const & sc) const;
 
     /**
-     * Recursively draws all dirty widgets.
+     * Recursively draws all dirty widgets. The boxes of the widgets that have
+     * been redrawn are added to the damage region, if one is given.
+     */
+    void draw_dirty(draw_context & dc, selection_context const & sc, damage_region * damage = nullptr) const;
+
+    /**
+     * Like \ref draw_dirty() but also resets the dirty flags of the widgets
+     * visited, which saves another traversal with \ref clear_dirty().
      */
-    void draw_dirty(draw_context & dc, selection_context const & sc) const;
+    void draw_and_clear_dirty(draw_context & dc, selection_context const & sc, damage_region * damage = nullptr);
 
     /**
      *  Draw the widget. No children should be drawn here.
      */ 
     virtual void on_draw(draw_context & dc, selection_context const & sc) const = 0;
 
+    /**
+     * Whether \ref on_draw() covers the whole box with opaque content. The
+     * default implementation returns false. Opaque widgets allow their parent
+     * to skip clearing the background, and covered siblings are not drawn if
+     * the parent lets children overlap.
+     */
+    virtual bool is_opaque() const;
+
+    /**
+     * Whether visible children may be drawn on top of each other. If so,
+     * children that are completely covered by an opaque child in front of
+     * them are skipped. The default implementation returns false, since
+     * testing every pair of children is not worth it for layouts.
+     */
+    virtual bool children_may_overlap() const;
+
+    /**
+     * A retained widget renders itself and its children into a texture once
+     * and afterwards only copies the texture, until anything within the
+     * subtree is marked dirty or the size changes. This is useful for static
+     * subtrees whose parent is redrawn frequently. Renderers without support
+     * for render targets draw the subtree as usual.
+     */
+    void set_retained(bool retained);
+    bool is_retained() const;
+
+    /**
+     * Drops textures of the subtree that are only kept to speed up drawing,
+     * e.g., because it is hidden and will not be drawn soon. They are
+     * recreated when drawing again. Widgets with caches of their own should
+     * release them as well and call the default implementation, which
+     * releases the retained texture and recurses into all children.
+     */
+    virtual void release_resources();
+
     /** @} */
 
     /**
@@ -113,6 +174,18 @@ struct widget : region
     virtual void on_mouse_move_event(mouse_move_event const & e);
     virtual void on_key_event(key_event const & e);
 
+    /**
+     * Called on every ancestor of a widget that captured a pointer before the
+     * widget receives the up event directly, which does not pass them.
+     * Containers forget the child that was pressed.
+     */
+    virtual void on_mouse_capture_released(pointer_id id);
+
+    /**
+     * Calls \ref on_mouse_capture_released() on all ancestors.
+     */
+    void notify_ancestors_mouse_capture_released(pointer_id id);
+
     /**
      *  A widget may get activated by other means (e.g., infrared remote or
      *  return key).
@@ -133,6 +206,28 @@ struct widget : region
      */
     void set_context_info(context_info const & ci);
 
+    /**
+     * Propagates the invalidation to the parent, since its size hint usually
+     * depends on those of its children.
+     */
+    void on_size_hint_invalidated() override;
+
+    /**
+     * Passes the request on to the parent. The root widget queues a layout of
+     * the whole tree with the region control of its context.
+     */
+    void on_redo_layout_request(redo_layout_type t) override;
+
+    /**
+     * The boxes of children might have changed, so the widget is redrawn.
+     */
+    void on_layout_redone() override;
+
+    /**
+     * Defers the request while the context is in a batch of changes.
+     */
+    bool defer_redo_layout(redo_layout_type t) override;
+
     /**
      * Should not be set manually. Containers are responsible for linking their
      * children to them.
@@ -141,9 +236,11 @@ struct widget : region
 
     /**
      * Return child widgets in Z-order. Should be implemented by containers.
+     * The range is traversed frequently, so it should not be created on the
+     * fly but refer to pointers stored within the container.
      */
-    virtual std::vector<widget *> get_children();
-    virtual std::vector<widget const *> get_children() const;
+    virtual widget_range get_children();
+    virtual const_widget_range get_children() const;
 
     /**
      * @name Selection Navigation
@@ -188,8 +285,31 @@ struct widget : region
 
     private:
 
+    // Scans the flattened tree, which is equivalent to the recursive passes.
+    friend struct widget_tree;
+
+    // Notifies parents of dirty widgets once the batch is committed.
+    friend struct widget_batch;
+
     dirty_type _dirty;
 
+    // Restricts the redraw of a dirty widget, the whole box otherwise.
+    std::optional<rect> _dirty_area;
+
+    // Draws the dirty widget and adds what was drawn to the damage region.
+    void draw_dirty_area(draw_context & dc, selection_context const & sc, damage_region * damage) const;
+
+    // Draws without considering the retained texture.
+    void draw_subtree(draw_context & dc, selection_context const & sc) const;
+    void draw_retained(draw_context & dc, selection_context const & sc) const;
+
+    bool _retained;
+    mutable unique_texture_ptr _retained_texture;
+    mutable vec _retained_size;
+
+    // Whether the texture shows the current state of the subtree.
+    mutable bool _retained_valid;
+
     protected:
 
     /**
@@ -203,12 +323,44 @@ struct widget : region
      */
     std::optional<swipe_info> get_swipe_info_with_context_info(mouse_up_event const & e);
 
+    /**
+     * Helper to receive all move and up events of the pointer directly, e.g.,
+     * to follow a drag that started over a child. Lasts until the pointer is
+     * released.
+     */
+    void capture_mouse(pointer_id id);
+
     /**
      * Helper to continue a navigation in a parent once the current widget is
      * exhausted.
      */
     widget * navigate_selectable_parent(navigation_type nt, point center);
 
+    /**
+     * Helper to skip drawing a background that will be covered by an opaque
+     * visible child anyway.
+     */
+    bool is_covered_by_children() const;
+
+    /**
+     * Draws the visible children after \ref on_draw() in reversed Z-order.
+     * Containers that show their children differently, e.g., from a texture
+     * while scrolling, may override this.
+     */
+    virtual void draw_children(draw_context & dc, selection_context const & sc) const;
+
+    /**
+     * Links a child that is added after construction and shares the context
+     * with its subtree.
+     */
+    void attach_child(widget & child);
+
+    /**
+     * Has to be called before a child is removed, such that the context drops
+     * references to its subtree, e.g., the selection.
+     */
+    virtual void detach_child(widget & child);
+
     /** @} */
 
     widget * _parent;
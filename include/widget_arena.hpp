@@ -0,0 +1,103 @@
+#ifndef LIBWTK_SDL2_WIDGET_ARENA_HPP
+#define LIBWTK_SDL2_WIDGET_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+/**
+ * Allocates the widgets of a tree, together with the control blocks of their
+ * pointers, from one growing buffer instead of one heap allocation each. The
+ * widgets end up next to each other in memory in the order they are created.
+ *
+ * Memory is never reused for single widgets, the whole buffer is freed once
+ * the arena and every widget created from it are gone. Screens that are
+ * rebuilt, e.g., search results, should therefore use a new arena for every
+ * build. An arena must only be used by one thread at a time.
+ */
+struct widget_arena
+{
+    widget_arena(std::size_t initial_bytes = DEFAULT_INITIAL_BYTES);
+    widget_arena(widget_arena const &) = delete;
+    widget_arena & operator=(widget_arena const &) = delete;
+
+    /**
+     * Creates the widget within the arena. The pointer is used like any
+     * other and keeps the memory of the arena alive.
+     */
+    template <typename Widget, typename... Args>
+    std::shared_ptr<Widget> make(Args &&... args);
+
+    /**
+     * The memory taken from the arena so far.
+     */
+    std::size_t allocated_bytes() const;
+
+    static constexpr std::size_t DEFAULT_INITIAL_BYTES = 64 * 1024;
+
+    private:
+
+    struct state
+    {
+        state(std::size_t initial_bytes);
+
+        std::pmr::monotonic_buffer_resource resource;
+        std::size_t allocated_bytes;
+    };
+
+    // Copied into every control block, such that the memory outlives all
+    // widgets.
+    template <typename T>
+    struct allocator
+    {
+        typedef T value_type;
+
+        allocator(std::shared_ptr<state> s)
+            : s(std::move(s))
+        {
+        }
+
+        template <typename U>
+        allocator(allocator<U> const & other)
+            : s(other.s)
+        {
+        }
+
+        T * allocate(std::size_t n)
+        {
+            s->allocated_bytes += n * sizeof(T);
+            return static_cast<T *>(s->resource.allocate(n * sizeof(T), alignof(T)));
+        }
+
+        // Released with the whole buffer.
+        void deallocate(T *, std::size_t)
+        {
+        }
+
+        template <typename U>
+        bool operator==(allocator<U> const & other) const
+        {
+            return s == other.s;
+        }
+
+        template <typename U>
+        bool operator!=(allocator<U> const & other) const
+        {
+            return s != other.s;
+        }
+
+        std::shared_ptr<state> s;
+    };
+
+    std::shared_ptr<state> _state;
+};
+
+template <typename Widget, typename... Args>
+std::shared_ptr<Widget> widget_arena::make(Args &&... args)
+{
+    return std::allocate_shared<Widget>(allocator<Widget>(_state), std::forward<Args>(args)...);
+}
+
+#endif
+
@@ -0,0 +1,64 @@
+#ifndef LIBWTK_SDL2_WIDGET_BATCH_HPP
+#define LIBWTK_SDL2_WIDGET_BATCH_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "region.hpp"
+
+struct widget;
+
+/**
+ * Collects the dirty notifications and layout requests of widgets while many
+ * of them are changed at once, e.g., when a new track updates labels, the
+ * cover and the slider. They are handled together when the batch is
+ * committed, such that a layout request is redone once per widget and not at
+ * all if an ancestor is laid out anyway.
+ *
+ * Used through widget_context::batch, widgets find the active batch in their
+ * context_info.
+ */
+struct widget_batch
+{
+    widget_batch();
+
+    /**
+     * The parent of the widget is notified at commit.
+     */
+    void defer_child_dirty(widget & w);
+
+    /**
+     * Multiple requests of a widget are merged into the strongest one.
+     */
+    void defer_redo_layout(widget & w, redo_layout_type t);
+
+    /**
+     * Has to be called by widgets that are destroyed during the batch.
+     */
+    void forget(widget const & w);
+
+    bool empty() const;
+
+    /**
+     * Lays out the widgets first, which might mark further widgets dirty, and
+     * then notifies the parents of dirty widgets. The batch has to be inactive
+     * already, such that requests while committing take effect immediately.
+     */
+    void commit();
+
+    private:
+
+    typedef std::unordered_map<widget const *, redo_layout_type> layout_map;
+
+    static bool has_pending_ancestor(widget const & w, layout_map const & pending);
+
+    std::vector<widget *> _dirty;
+
+    // In the order of the first request.
+    std::vector<widget *> _layouts;
+    layout_map _layout_types;
+};
+
+#endif
+
@@ -1,33 +1,103 @@
 #ifndef LIBWTK_SDL2_WIDGET_CONTEXT_HPP
 #define LIBWTK_SDL2_WIDGET_CONTEXT_HPP
 
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
 
 #include <SDL2/SDL_events.h>
+#include <SDL2/SDL_stdinc.h>
 #include <SDL2/SDL_video.h>
 
+#include "animation_scheduler.hpp"
 #include "context_info.hpp"
+#include "damage_region.hpp"
 #include "draw_context.hpp"
+#include "event_recording.hpp"
+#include "event_source.hpp"
 #include "font.hpp"
 #include "font_word_cache.hpp"
 #include "font_manager.hpp"
+#include "font_registry.hpp"
+#include "frame_stats.hpp"
 #include "geometry.hpp"
+#include "layout_arena.hpp"
+#include "memory_budget.hpp"
 #include "mouse_tracker.hpp"
+#include "navigation_index.hpp"
+#include "profiler.hpp"
+#include "render_backend.hpp"
 #include "selection_context.hpp"
+#include "texture_cache.hpp"
+#include "trace.hpp"
+#include "update_queue.hpp"
+#include "widget_batch.hpp"
+#include "widget_tree.hpp"
 
 struct widget;
 
-struct widget_context
+struct widget_context : region_control
 {
 
     widget_context(SDL_Renderer * renderer, std::vector<font> fonts, widget & main_widget);
     widget_context(SDL_Renderer * renderer, std::vector<font> fonts, widget & main_widget, rect box);
 
+    // Share rendered text with other contexts using the same registry.
+    widget_context(SDL_Renderer * renderer, font_registry & registry, std::vector<font> fonts, widget & main_widget);
+    widget_context(SDL_Renderer * renderer, font_registry & registry, std::vector<font> fonts, widget & main_widget, rect box);
+
+    // Draw with a different backend, e.g., directly to a framebuffer. The
+    // renderer is only used for textures.
+    // Wrapped in a pipelined_backend, frames are shown on a thread of
+    // their own while the next one is handled.
+    widget_context(SDL_Renderer * renderer, std::unique_ptr<render_backend> backend, std::vector<font> fonts, widget & main_widget, rect box);
+
+    // Motion events are not dispatched if a later motion of the same pointer
+    // is already queued in SDL, only the mouse tracker sees them. Replayed
+    // events are not queued and therefore all dispatched.
     void process_event(SDL_Event const & ev);
 
+    // Enabled by default.
+    void set_motion_coalescing(bool enabled);
+
+    // Waits for events, processes everything that is pending and then draws
+    // once. Returns false when SDL_QUIT is received or the handler, which is
+    // called before an event is processed, returns false. Window size changes
+    // are coalesced and cause a full redraw.
+    //
+    // While animations or timers are scheduled it waits at most until the
+    // next frame of an animation or the nearest timer deadline. Waking up
+    // without events advances the animations and fires the timers that are
+    // due. Otherwise it sleeps until the next event.
+    //
+    // With a renderer that synchronizes to vertical blank this draws at most
+    // once per vertical blank.
+    bool process_frame(std::function<bool(SDL_Event const &)> const & handler = {}, int dirty_redraws = 1);
+
+    // Calls process_frame() until it returns false. Between events, timers
+    // and animations the process sleeps in SDL.
+    void run(std::function<bool(SDL_Event const &)> const & handler = {}, int dirty_redraws = 1);
+
+    // Limits process_frame(), events are collected until the next frame is
+    // due. 0 disables the limit.
+    void set_frame_rate_cap(unsigned int fps);
+
+    // Done by process_frame() before drawing. Event loops of their own have to
+    // call this and wait at most the timeout of the scheduler for events.
+    void advance_animations();
+
+    animation_scheduler & get_animation_scheduler();
+
     void draw(bool present = true);
-    void draw_dirty(int dirty_redraws = 1);
+
+    // Draws dirty widgets and presents the frame. dirty_redraws is the number
+    // of older buffers, the areas changed in the frames they missed are
+    // repainted as well. Returns the area that changed in this frame.
+    damage_region const & draw_dirty(int dirty_redraws = 1);
 
     void select_widget(widget & w);
     void unselect_widget();
@@ -35,6 +105,177 @@ struct widget_context
 
     void change_widget_area(rect new_box);
 
+    // Like change_widget_area() but the layout is done once before the next
+    // frame is drawn, such that many resizes only cause one layout. Window
+    // size changes passed to process_event() are handled this way.
+    void resize(rect new_box);
+
+    // Called when a widget could not be laid out locally. The layout of the
+    // whole tree is redone before the next frame is drawn.
+    void queue_redo_layout() override;
+
+    // Drops the capture, the selection and pending batched changes within the
+    // subtree of a widget that is removed from its container.
+    void on_widget_detached(widget & w) override;
+
+    // Changes many widgets at once, e.g., all that show the current track.
+    // While a batch is active, widgets that become dirty do not notify their
+    // parents and layout requests are not handled. Both are merged and done
+    // in one pass when the outermost batch ends, such that a widget is laid
+    // out at most once. Batches nest and have to end before drawing. Updates
+    // passed to post() are run in a batch.
+    void begin_batch();
+    void end_batch();
+
+    struct batch
+    {
+        batch(widget_context & ctx);
+        ~batch();
+
+        private:
+
+        widget_context & _ctx;
+    };
+
+    // Keep a flattened copy of the widget tree to speed up dirty redraws and
+    // finding widgets, which is worthwhile for large trees.
+    void set_flat_tree(bool enabled);
+
+    // Navigate the selection with an index of the selectable widgets that is
+    // rebuilt after the layout changed. Worthwhile for large trees, although
+    // 2-dimensional navigation is then purely geometric.
+    void set_navigation_index(bool enabled);
+
+    // Returns the innermost widget on top of the point or nullptr.
+    widget * find_widget_at(point p);
+
+    // On mouse down the innermost widget at the position captures the pointer
+    // and receives all its move and up events directly until it is released.
+    // Without a capture events are dispatched from the main widget. A capture
+    // set while handling mouse down is kept, e.g., by a container that follows
+    // drags. Every pointer, i.e., the mouse and each finger, has a capture of
+    // its own. The ancestors of the widget are notified before it receives
+    // the up event. The widget has to stay alive while it holds the capture.
+    void capture_mouse(widget & w, pointer_id id = MOUSE_POINTER_ID) override;
+    void release_mouse(pointer_id id = MOUSE_POINTER_ID);
+    widget * get_mouse_capture(pointer_id id = MOUSE_POINTER_ID) const;
+
+    // Limits the memory used for rendered text per font.
+    void set_font_cache_byte_budget(std::size_t bytes);
+
+    // Render text in the background. Words appear once they are available,
+    // which causes a redraw.
+    void enable_async_text_rendering(std::size_t num_threads = 1);
+
+    // Limits the time a frame spends on rendering and uploading new words,
+    // counted from the start of the frame. Words beyond it are left blank and
+    // follow in the next frames, such that a screen full of new text is not
+    // drawn in one long frame. Pass zero to draw everything right away, which
+    // is the default.
+    void set_frame_render_budget(std::chrono::steady_clock::duration budget);
+
+    // Evaluates the size hints of the children of boxes and grids on a pool
+    // of threads, in addition to the one doing the layout. Only pays off for
+    // wide trees with expensive size hints. Pass 0 to lay out sequentially
+    // again.
+    void enable_parallel_layout(std::size_t num_threads);
+
+    // Fonts are opened when they are used first. Opening a font in the
+    // background avoids the delay on the frame that first uses it.
+    void open_font_async(std::size_t font_idx);
+
+    void prewarm_text(std::vector<std::string> const & texts, int font_idx = 0);
+
+    // Store rendered text in the directory, such that the next start does not
+    // need to render it again. Flushing writes the current cache contents.
+    void enable_persistent_text_cache(std::string directory);
+    void flush_persistent_text_cache();
+
+    font_cache_stats get_font_cache_stats() const;
+
+    // Changes the look of the boxes and the colors. Cached drawings of the
+    // widgets are dropped, draw() has to be called to show it everywhere.
+    void set_theme(std::shared_ptr<theme const> t);
+
+    // Images shared by the widgets of this context, e.g., icons.
+    texture_cache & get_texture_cache();
+
+    // A budget for rendered text, textures of blitted surfaces and cached
+    // images together, checked after every frame. What text does not use is
+    // left to blitted surfaces and the rest to cached images, which are thus
+    // evicted first. Each font is also limited by set_font_cache_byte_budget().
+    void set_texture_byte_budget(std::size_t bytes);
+
+    // The budget shared by the caches of the context. Applications may add
+    // caches of their own, which are limited after every frame as well.
+    memory_budget & get_memory_budget();
+
+    // Lets every cache drop what it can, as well as the retained drawings of
+    // the widgets, e.g., when the system is low on memory. Everything is
+    // created again once it is drawn. Called for SDL_APP_LOWMEMORY.
+    //
+    // After SDL_RENDER_TARGETS_RESET the retained drawings are dropped and
+    // everything is redrawn. After SDL_RENDER_DEVICE_RESET the textures of
+    // the context are dropped as well, textures given to widgets by the
+    // application, e.g., of a texture_view, have to be set again.
+    void release_memory();
+
+    // Record the time spent drawing and laying out each widget, as well as
+    // frame times.
+    void set_profiling(bool enabled);
+
+    // Draws a graph of recent frame times and highlights redrawn areas. Also
+    // records frame times.
+    void set_profiler_overlay(bool enabled);
+
+    profiler const & get_profiler() const;
+    void reset_profiler();
+
+    // Keeps frame times and the latency from the oldest input event handled
+    // in a frame until it was presented, see frame_stats. The callback is
+    // called for every frame that is presented, regardless of whether the
+    // statistics are kept.
+    void set_frame_stats(bool enabled);
+    frame_stats const & get_frame_stats() const;
+    void reset_frame_stats();
+    void set_frame_callback(std::function<void(frame_report const &)> callback);
+
+    // Shows a square in the bottom left corner that is white in frames that
+    // handled input and black otherwise, such that the latency until the
+    // display changes can be measured externally, e.g., with a photodiode.
+    void set_latency_marker(bool enabled);
+
+    // Records a timeline of event handling, layout, drawing, text rendering,
+    // texture uploads and presenting. Nothing is recorded if the library is
+    // built with LIBWTK_SDL2_NO_TRACING.
+    void set_tracing(bool enabled);
+    tracer & get_tracer();
+
+    // Records the events passed to process_event() and process_frame() along
+    // with the frames drawn, such that they can be replayed with
+    // replay_events(). Throws std::runtime_error if the file cannot be
+    // created.
+    void start_event_recording(std::string path);
+
+    // Throws std::runtime_error if the recording could not be written.
+    void stop_event_recording();
+
+    // Runs the update on the thread drawing the widgets, before the next
+    // frame is laid out and drawn. May be called from any thread, e.g., to
+    // change widgets after a network notification. Updates posted in a burst
+    // wake up process_frame() once.
+    void post(std::function<void()> update);
+
+    // Producers may keep the queue, posting to it after the context is gone
+    // has no effect.
+    std::shared_ptr<update_queue> get_update_queue() const;
+
+    // Input from file descriptors is handled by process_frame() along with
+    // SDL events, e.g., from a remote control. The source has to stay alive
+    // until it is removed.
+    void add_event_source(event_source & s);
+    void remove_event_source(event_source & s);
+
     // forwarded
     void activate();
     void navigate_selection(navigation_type nt);
@@ -43,6 +284,46 @@ struct widget_context
 
     void set_context_info(widget *);
 
+    void init(widget & main_widget, rect box);
+
+    // Words that have been finished in the background require a redraw.
+    void upload_rendered_words();
+
+    // Words beyond the render budget are drawn in the next frame.
+    void begin_render_budget(std::chrono::steady_clock::time_point frame_start);
+    void end_render_budget();
+
+    void drain_updates();
+
+    void push_damage_history(damage_region const & damage);
+
+    // Whether a later motion of the same pointer is queued.
+    bool superseded_motion(SDL_Event const & ev);
+
+    void update_layout();
+
+    // The time is the timestamp of the event.
+    void mouse_down(point p, Uint32 time, pointer_id id = MOUSE_POINTER_ID);
+    void mouse_up(point p, Uint32 time, pointer_id id = MOUSE_POINTER_ID);
+    void mouse_move(point p, Uint32 time, pointer_id id = MOUSE_POINTER_ID);
+
+    // Returns nullptr if nothing has to be recorded.
+    profiler * active_profiler();
+    tracer * active_tracer();
+
+    // Limits the caches to the budget after they changed with a frame.
+    void enforce_memory_budget();
+
+    // Records the frame and draws the overlay.
+    void finish_frame(std::chrono::nanoseconds frame_time);
+
+    // Drawn on top of everything, if it was painted over or its state
+    // changed. Adds the marker to the damage of the frame.
+    void draw_latency_marker(damage_region & frame, damage_region const & stale);
+
+    // Called once the frame has been presented.
+    void report_frame(std::chrono::nanoseconds frame_time);
+
     rect _box;
     SDL_Renderer * _renderer;
     font_manager _fm;
@@ -52,6 +333,68 @@ struct widget_context
     widget & _main_widget;
     context_info _context_info;
     std::optional<vec> _mouse_down_position;
+
+    damage_region _damage;
+
+    // The damage of the previous frames, most recent first.
+    std::deque<damage_region> _damage_history;
+
+    Uint32 _min_frame_interval;
+    std::chrono::steady_clock::duration _frame_render_budget;
+    Uint32 _last_frame_ticks;
+
+    profiler _profiler;
+    bool _profiling;
+    bool _profiler_overlay;
+
+    // The area covered by the overlay in the last frame.
+    damage_region _overlay_damage;
+
+    tracer _tracer;
+    bool _tracing;
+
+    frame_stats _frame_stats;
+    bool _frame_stats_enabled;
+    std::function<void(frame_report const &)> _frame_callback;
+
+    // Of the oldest input event since the last frame.
+    std::optional<Uint32> _oldest_input_timestamp;
+
+    bool _latency_marker;
+    bool _latency_marker_lit;
+
+    std::optional<widget_tree> _tree;
+
+    // The flattened tree might refer to removed widgets until the changed
+    // containers are drawn.
+    bool _tree_stale;
+    std::optional<navigation_index> _navigation_index;
+
+    std::unordered_map<pointer_id, widget *> _mouse_captures;
+
+    bool _coalesce_motion;
+
+    bool _redo_layout_queued;
+
+    widget_batch _batch;
+    unsigned int _batch_depth;
+    std::optional<rect> _pending_box;
+
+    layout_arena _layout_arena;
+
+    std::unique_ptr<event_recorder> _event_recorder;
+
+    animation_scheduler _animations;
+
+    std::shared_ptr<update_queue> _updates;
+
+    texture_cache _texture_cache;
+
+    // Refers to the caches above, declared after them.
+    memory_budget _memory_budget;
+
+    // Only started once there is a source.
+    std::unique_ptr<event_source_watcher> _source_watcher;
 };
 
 #endif
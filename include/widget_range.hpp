@@ -0,0 +1,71 @@
+#ifndef LIBWTK_SDL2_WIDGET_RANGE_HPP
+#define LIBWTK_SDL2_WIDGET_RANGE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+struct widget;
+
+/**
+ * A non-owning view of a sequence of widget pointers. Containers store the
+ * pointers of their children once, such that iterating them does not
+ * allocate.
+ *
+ * The view is invalidated when the children of the container change.
+ */
+template <typename Widget>
+struct basic_widget_range
+{
+    typedef Widget * const * iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+
+    basic_widget_range()
+        : _begin(nullptr)
+        , _end(nullptr)
+    {
+    }
+
+    basic_widget_range(iterator begin, std::size_t size)
+        : _begin(begin)
+        , _end(begin + size)
+    {
+    }
+
+    basic_widget_range(std::vector<Widget *> const & ptrs)
+        : basic_widget_range(ptrs.data(), ptrs.size())
+    {
+    }
+
+    /**
+     * A view of mutable widgets may be used to iterate over constant ones.
+     */
+    template <typename W, typename = std::enable_if_t<std::is_same_v<W const, Widget> && !std::is_same_v<W, Widget>>>
+    basic_widget_range(basic_widget_range<W> r)
+        // Pointers that only differ in constness are similar types.
+        : _begin(reinterpret_cast<iterator>(r.begin()))
+        , _end(reinterpret_cast<iterator>(r.end()))
+    {
+    }
+
+    iterator begin() const { return _begin; }
+    iterator end() const { return _end; }
+    reverse_iterator rbegin() const { return reverse_iterator(_end); }
+    reverse_iterator rend() const { return reverse_iterator(_begin); }
+
+    std::size_t size() const { return _end - _begin; }
+    bool empty() const { return _begin == _end; }
+    Widget * operator[](std::size_t k) const { return _begin[k]; }
+
+    private:
+
+    iterator _begin;
+    iterator _end;
+};
+
+typedef basic_widget_range<widget> widget_range;
+typedef basic_widget_range<widget const> const_widget_range;
+
+#endif
+
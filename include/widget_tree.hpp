@@ -0,0 +1,71 @@
+#ifndef LIBWTK_SDL2_WIDGET_TREE_HPP
+#define LIBWTK_SDL2_WIDGET_TREE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "damage_region.hpp"
+#include "draw_context.hpp"
+#include "geometry.hpp"
+#include "selection_context.hpp"
+
+struct widget;
+
+/**
+ * A flattened copy of the visible widget tree. Widgets are stored in drawing
+ * order, i.e., every widget is followed by its subtree and children appear in
+ * reversed Z-order. Passes over the tree become linear scans that skip
+ * subtrees which do not need to be visited.
+ *
+ * The dirty state stays with the widgets, since marking widgets dirty does
+ * not know about the tree. Changes of the visible children are detected
+ * whenever a dirty subtree is visited, which is the case when containers
+ * mark themselves dirty as required.
+ */
+struct widget_tree
+{
+    widget_tree();
+
+    /**
+     * Flattens the tree of root.
+     */
+    void rebuild(widget & root);
+
+    /**
+     * Has to be called after the layout changed.
+     */
+    void update_boxes();
+
+    std::size_t size() const;
+
+    /**
+     * Equivalent to \ref widget::draw_and_clear_dirty() on the root.
+     */
+    void draw_and_clear_dirty(draw_context & dc, selection_context const & sc, damage_region * damage);
+
+    /**
+     * Returns the innermost widget on top of the point or nullptr.
+     */
+    widget * find_widget_at(point p) const;
+
+    private:
+
+    void flatten(widget * w);
+
+    // Only for the subtree at index k.
+    void update_boxes(std::size_t k);
+
+    // Whether the visible children of the widget at index k are the ones
+    // stored, optionally for the whole subtree.
+    bool children_match(std::size_t k) const;
+    bool subtree_matches(std::size_t k) const;
+
+    std::vector<widget *> _widgets;
+    std::vector<rect> _boxes;
+
+    // Including the widget itself, the next sibling is at index + size.
+    std::vector<std::size_t> _subtree_sizes;
+};
+
+#endif
+
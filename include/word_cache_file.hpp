@@ -0,0 +1,74 @@
+#ifndef LIBWTK_SDL2_WORD_CACHE_FILE_HPP
+#define LIBWTK_SDL2_WORD_CACHE_FILE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "geometry.hpp"
+
+// A file that is mapped read-only into memory. An unreadable file results in
+// an empty mapping.
+struct mapped_file
+{
+    mapped_file();
+    mapped_file(std::string const & path);
+    ~mapped_file();
+
+    mapped_file(mapped_file const &) = delete;
+    mapped_file(mapped_file && other);
+    mapped_file & operator=(mapped_file && other);
+
+    uint8_t const * data() const;
+    std::size_t size() const;
+
+    private:
+
+    void unmap();
+
+    uint8_t const * _data;
+    std::size_t _size;
+};
+
+// FNV-1a, returns 0 if the file cannot be read.
+uint64_t hash_file(std::string const & path);
+
+// Reads words and their alpha bitmaps from a file written by
+// word_cache_writer. The file has to belong to the same font file and size,
+// otherwise it is ignored.
+struct word_cache_reader
+{
+    word_cache_reader(mapped_file const & f, uint64_t font_hash, uint32_t font_size);
+
+    // Returns false once there are no more entries. Pointers refer to the
+    // mapped file.
+    bool next(std::string_view & word, vec & size, uint8_t const * & alpha);
+
+    private:
+
+    uint8_t const * _ptr;
+    uint8_t const * _end;
+    uint32_t _remaining;
+};
+
+// Writes a new cache file, which replaces an old one once finished.
+struct word_cache_writer
+{
+    word_cache_writer(std::string path, uint64_t font_hash, uint32_t font_size);
+
+    void add(std::string_view word, vec size, uint8_t const * alpha);
+
+    // Throws std::runtime_error if the file could not be written.
+    void finish();
+
+    private:
+
+    std::string _path;
+    std::string _tmp_path;
+    std::ofstream _out;
+    uint32_t _count;
+};
+
+#endif
+
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <limits>
+
+#include "animation_scheduler.hpp"
+
+// Roughly the refresh rate of common displays.
+std::chrono::milliseconds const DEFAULT_FRAME_INTERVAL(16);
+
+// A repeating timer without an interval would fire forever.
+std::chrono::milliseconds const MIN_TIMER_INTERVAL(1);
+
+animation_scheduler::animation_scheduler()
+    : _last_handle(NO_ANIMATION)
+    , _frame_interval(DEFAULT_FRAME_INTERVAL)
+    , _last_advance(clock::now())
+{
+}
+
+animation_handle animation_scheduler::start_animation(step_function step)
+{
+    animation_handle const h = next_handle();
+    _animations.push_back({ h, std::move(step), clock::now() });
+    return h;
+}
+
+animation_handle animation_scheduler::start_timer(clock::duration delay, std::function<void()> f)
+{
+    animation_handle const h = next_handle();
+    push_timer({ h, clock::now() + delay, clock::duration::zero(), std::move(f) });
+    return h;
+}
+
+animation_handle animation_scheduler::start_repeating_timer(clock::duration interval, std::function<void()> f)
+{
+    clock::duration const i = std::max<clock::duration>(interval, MIN_TIMER_INTERVAL);
+    animation_handle const h = next_handle();
+    push_timer({ h, clock::now() + i, i, std::move(f) });
+    return h;
+}
+
+void animation_scheduler::stop(animation_handle h)
+{
+    if (h == NO_ANIMATION)
+        return;
+
+    // Animations are only marked, advance() might be iterating over them.
+    for (auto & a : _animations)
+    {
+        if (a.handle == h)
+            a.handle = NO_ANIMATION;
+    }
+
+    auto it = std::find_if(_timers.begin(), _timers.end(), [h](timer const & t){ return t.handle == h; });
+    if (it != _timers.end())
+    {
+        _timers.erase(it);
+        std::make_heap(_timers.begin(), _timers.end(), later_deadline);
+    }
+}
+
+bool animation_scheduler::is_running(animation_handle h) const
+{
+    return h != NO_ANIMATION
+        && (std::any_of(_animations.begin(), _animations.end(), [h](animation const & a){ return a.handle == h; })
+            || std::any_of(_timers.begin(), _timers.end(), [h](timer const & t){ return t.handle == h; }));
+}
+
+void animation_scheduler::set_frame_interval(clock::duration interval)
+{
+    _frame_interval = interval;
+}
+
+void animation_scheduler::advance(clock::time_point now)
+{
+    _last_advance = now;
+
+    // Timers started by the callbacks fire in this call if they are due.
+    while (!_timers.empty() && _timers.front().deadline <= now)
+    {
+        std::pop_heap(_timers.begin(), _timers.end(), later_deadline);
+        timer t = std::move(_timers.back());
+        _timers.pop_back();
+
+        if (t.interval != clock::duration::zero())
+        {
+            // Rescheduled before it fires, such that it can stop itself.
+            clock::time_point deadline = t.deadline + t.interval;
+            if (deadline <= now)
+                deadline = now + t.interval - (now - t.deadline) % t.interval;
+            push_timer({ t.handle, deadline, t.interval, t.fire });
+        }
+
+        t.fire();
+    }
+
+    // Animations added by the callbacks are first advanced in the next call.
+    // The vector may grow, so entries are accessed by index.
+    std::size_t const n = _animations.size();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        if (_animations[k].handle == NO_ANIMATION)
+            continue;
+
+        clock::duration const dt = now - _animations[k].last_step;
+        _animations[k].last_step = now;
+
+        // Moved out, the callback might add animations.
+        step_function step = std::move(_animations[k].step);
+        bool const keep = step(dt);
+        _animations[k].step = std::move(step);
+        if (!keep)
+            _animations[k].handle = NO_ANIMATION;
+    }
+
+    _animations.erase(std::remove_if(_animations.begin(), _animations.end(), [](animation const & a){ return a.handle == NO_ANIMATION; }), _animations.end());
+}
+
+int animation_scheduler::timeout(clock::time_point now) const
+{
+    bool const animating = std::any_of(_animations.begin(), _animations.end(), [](animation const & a){ return a.handle != NO_ANIMATION; });
+
+    if (!animating && _timers.empty())
+        return -1;
+
+    clock::time_point due = animating ? _last_advance + _frame_interval : _timers.front().deadline;
+    if (!_timers.empty())
+        due = std::min(due, _timers.front().deadline);
+
+    if (due <= now)
+        return 0;
+
+    // Round up, waking up too early would only cause another wait. Timers
+    // far ahead would overflow the milliseconds of SDL, waking up earlier
+    // does no harm.
+    auto const remaining = std::chrono::ceil<std::chrono::milliseconds>(due - now);
+    return static_cast<int>(std::min<std::chrono::milliseconds::rep>(remaining.count(), std::numeric_limits<int>::max()));
+}
+
+bool animation_scheduler::empty() const
+{
+    return _timers.empty() && std::all_of(_animations.begin(), _animations.end(), [](animation const & a){ return a.handle == NO_ANIMATION; });
+}
+
+animation_handle animation_scheduler::next_handle()
+{
+    _last_handle++;
+    if (_last_handle == NO_ANIMATION)
+        _last_handle++;
+    return _last_handle;
+}
+
+bool animation_scheduler::later_deadline(timer const & a, timer const & b)
+{
+    return a.deadline > b.deadline;
+}
+
+void animation_scheduler::push_timer(timer t)
+{
+    _timers.push_back(std::move(t));
+    std::push_heap(_timers.begin(), _timers.end(), later_deadline);
+}
+
@@ -0,0 +1,306 @@
+// Micro-benchmarks of text layout, container layout and drawing. Everything is
+// drawn offscreen, such that no display is needed.
+//
+// Usage: libwtk-sdl2-benchmark [FILTER]
+// Only benchmarks whose name contains FILTER are run.
+//
+// Usage: libwtk-sdl2-benchmark --replay FILE [TRACE.json]
+// Replays events recorded with libwtk-sdl2-test --record FILE and reports the
+// time of each frame. Optionally writes a trace of the replay, which can be
+// opened with chrome://tracing or Perfetto.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include "box.hpp"
+#include "demo_widgets.hpp"
+#include "event_recording.hpp"
+#include "font_word_cache.hpp"
+#include "grid.hpp"
+#include "label.hpp"
+#include "list_provider.hpp"
+#include "list_view.hpp"
+#include "navigation_type.hpp"
+#include "offscreen_renderer.hpp"
+#include "widget.hpp"
+#include "widget_context.hpp"
+
+// Each benchmark runs at least this long.
+std::chrono::nanoseconds const MIN_DURATION = std::chrono::milliseconds(500);
+
+// More line widths than layouts are cached, cycling through them lays out
+// the text every time while the words stay cached.
+std::size_t const LINE_WIDTH_CYCLE = 5000;
+
+std::string filter;
+
+// Calls f with increasing iteration numbers and reports the average time.
+template <typename F>
+void benchmark(std::string const & name, F f)
+{
+    if (name.find(filter) == std::string::npos)
+        return;
+
+    using namespace std::chrono;
+
+    // Fills caches that are expected to be filled in practice.
+    f(0);
+
+    std::size_t iterations = 0;
+    nanoseconds elapsed(0);
+    auto const start = steady_clock::now();
+    while (elapsed < MIN_DURATION)
+    {
+        f(++iterations);
+        elapsed = steady_clock::now() - start;
+    }
+
+    std::cout << name << ": " << iterations << " iterations, "
+              << elapsed.count() / iterations << "ns per iteration" << std::endl;
+}
+
+void text_benchmarks(SDL_Renderer * renderer, font f)
+{
+    font_word_cache fwc(renderer, f);
+
+    std::vector<std::pair<std::string, std::string>> const texts
+        { { "short", "Button #1" }
+        , { "long", "This text should hopefully produce a linebreak. Otherwise something is not working correctly. You may use Tab and Shift+Tab to focus widgets or use Shift and the corresponding arrow key for a 2-dimensional direction." }
+        , { "utf8", "Grüße aus Köln – Ελληνικά και кириллица, ½ ≤ ¾ · naïve façade" }
+        };
+
+    for (auto const & p : texts)
+    {
+        std::string const & t = p.second;
+
+        benchmark("text/measure/" + p.first, [&](std::size_t i)
+        {
+            fwc.text_size(t, 10000 + i % LINE_WIDTH_CYCLE);
+        });
+
+        benchmark("text/measure_wrapped/" + p.first, [&](std::size_t i)
+        {
+            fwc.text_size(t, 100 + i % LINE_WIDTH_CYCLE);
+        });
+
+        benchmark("text/layout/" + p.first, [&](std::size_t i)
+        {
+            fwc.text(t, 10000 + i % LINE_WIDTH_CYCLE);
+            fwc.end_frame();
+        });
+
+        benchmark("text/cached/" + p.first, [&](std::size_t)
+        {
+            fwc.text(t);
+            fwc.end_frame();
+        });
+
+        benchmark("text/uncached/" + p.first, [&](std::size_t)
+        {
+            fwc.clear();
+            fwc.text(t);
+            fwc.end_frame();
+        });
+    }
+}
+
+// Alternates between horizontal and vertical boxes, there are width^depth
+// labels.
+widget_ptr nested_boxes(int depth, int width, bool vertical)
+{
+    box::children_type children;
+    for (int k = 0; k < width; ++k)
+    {
+        widget_ptr child = depth <= 1
+                         ? std::make_shared<label>("Item " + std::to_string(k))
+                         : nested_boxes(depth - 1, width, !vertical);
+        children.push_back({ true, child });
+    }
+    return vertical ? vbox(children, 2) : hbox(children, 2);
+}
+
+widget_ptr label_grid(int size)
+{
+    std::vector<grid::entry> entries;
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+            entries.push_back({ { x, y, 1, 1 }, std::make_shared<label>(std::to_string(x) + "," + std::to_string(y)) });
+    }
+    return std::make_shared<grid>(vec{ size, size }, entries, 2);
+}
+
+void layout_benchmarks(SDL_Renderer * renderer)
+{
+    // The area changes like when resizing the window, which mostly misses the
+    // cached size hints.
+    auto run = [renderer](std::string const & name, widget_ptr w)
+    {
+        widget_context ctx(renderer, demo_fonts(), *w);
+        benchmark(name, [&](std::size_t i)
+        {
+            ctx.change_widget_area({ 0, 0, 1600 - static_cast<int>(i % 400), 1000 });
+        });
+    };
+
+    std::vector<std::pair<int, int>> const shapes { { 1, 64 }, { 1, 1024 }, { 2, 32 }, { 3, 8 }, { 4, 6 }, { 8, 2 }, { 12, 2 } };
+    for (auto const & s : shapes)
+        run("layout/box/depth" + std::to_string(s.first) + "_width" + std::to_string(s.second), nested_boxes(s.first, s.second, true));
+
+    for (int size : { 4, 16, 32 })
+        run("layout/grid/" + std::to_string(size) + "x" + std::to_string(size), label_grid(size));
+}
+
+void draw_benchmarks(SDL_Renderer * renderer)
+{
+    widget_ptr w = demo_widget(renderer);
+    widget_context ctx(renderer, demo_fonts(), *w);
+    ctx.draw();
+
+    benchmark("draw/full", [&](std::size_t)
+    {
+        ctx.draw();
+    });
+
+    benchmark("draw/dirty_unchanged", [&](std::size_t)
+    {
+        ctx.draw_dirty();
+    });
+
+    // Changes the selected widget, which redraws two of them.
+    benchmark("draw/dirty_selection", [&](std::size_t)
+    {
+        ctx.navigate_selection(navigation_type::NEXT);
+        ctx.draw_dirty();
+    });
+
+    ctx.set_flat_tree(true);
+    benchmark("draw/dirty_selection_flat_tree", [&](std::size_t)
+    {
+        ctx.navigate_selection(navigation_type::NEXT);
+        ctx.draw_dirty();
+    });
+}
+
+void list_view_benchmarks(SDL_Renderer * renderer)
+{
+    for (std::size_t n : { 5000, 100000, 1000000 })
+    {
+        std::vector<std::string> values;
+        values.reserve(n);
+        for (std::size_t k = 0; k < n; ++k)
+            values.push_back("generic" + std::to_string(k));
+
+        list_view lv(values, 0, [](std::size_t){});
+        widget_context ctx(renderer, demo_fonts(), lv);
+        ctx.draw();
+
+        benchmark("list_view/scroll/" + std::to_string(n), [&](std::size_t i)
+        {
+            // Back and forth, such that the end is never reached.
+            if (i % 2000 < 1000)
+                lv.scroll_down();
+            else
+                lv.scroll_up();
+            ctx.draw_dirty();
+        });
+
+        benchmark("list_view/jump/" + std::to_string(n), [&](std::size_t i)
+        {
+            lv.set_position(i * 7919 % n);
+            ctx.draw_dirty();
+        });
+    }
+
+    // Rows are formatted when they are shown instead.
+    for (std::size_t n : { 5000, 100000, 1000000 })
+    {
+        list_view lv(std::make_shared<generated_list_provider>(n, [](std::size_t k, std::string & row){ row = "generic" + std::to_string(k); }), 0, [](std::size_t){});
+        widget_context ctx(renderer, demo_fonts(), lv);
+        ctx.draw();
+
+        benchmark("list_view/generated_jump/" + std::to_string(n), [&](std::size_t i)
+        {
+            lv.set_position(i * 7919 % n);
+            ctx.draw_dirty();
+        });
+    }
+}
+
+void replay(SDL_Renderer * renderer, std::string const & path, std::string const & trace_path)
+{
+    widget_ptr w = demo_widget(renderer);
+    widget_context ctx(renderer, demo_fonts(), *w);
+    ctx.draw();
+    ctx.set_tracing(!trace_path.empty());
+
+    std::chrono::nanoseconds total(0);
+    std::chrono::nanoseconds slowest(0);
+    std::vector<replay_frame> const frames = replay_events(ctx, path);
+    for (std::size_t k = 0; k < frames.size(); ++k)
+    {
+        replay_frame const & f = frames[k];
+        std::cout << "frame " << k << " at " << f.timestamp << "ms: " << f.events << " events, "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(f.time).count() << "us" << std::endl;
+        total += f.time;
+        slowest = std::max(slowest, f.time);
+    }
+
+    if (!frames.empty())
+    {
+        std::cout << frames.size() << " frames, "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(total).count() / frames.size() << "us on average, "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(slowest).count() << "us at most" << std::endl;
+    }
+
+    if (!trace_path.empty())
+        ctx.get_tracer().write_chrome_trace(trace_path);
+}
+
+int main(int argc, char * argv[])
+{
+    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS);
+
+    if (TTF_Init() == -1)
+    {
+        std::cerr << "Could not initialize font rendering:"
+                  << TTF_GetError() << '.' << std::endl;
+        std::exit(1);
+    }
+
+    bool const replaying = argc >= 3 && std::string(argv[1]) == "--replay";
+    if (argc >= 2 && !replaying)
+        filter = argv[1];
+
+    // Fonts have to be closed before TTF_Quit().
+    {
+        // The size of the window of the test program.
+        offscreen_renderer off({ 1600, 1000 });
+
+        if (replaying)
+        {
+            replay(off.renderer(), argv[2], argc >= 4 ? argv[3] : "");
+            TTF_Quit();
+            SDL_Quit();
+            return 0;
+        }
+
+        text_benchmarks(off.renderer(), demo_fonts().front());
+        layout_benchmarks(off.renderer());
+        draw_benchmarks(off.renderer());
+        list_view_benchmarks(off.renderer());
+    }
+
+    TTF_Quit();
+    SDL_Quit();
+}
+
@@ -2,6 +2,7 @@
 
 bin::bin(widget_ptr child)
     : _child(child)
+    , _child_ptr(child.get())
 {
     _child->set_parent(this);
 }
@@ -43,16 +44,16 @@ widget * bin::navigate_selectable_from_children(navigation_type nt, widget * w,
 
 size_hint bin::get_size_hint(int width, int height) const
 {
-    return _child->get_size_hint(width, height);
+    return _child->query_size_hint(width, height);
 }
 
-std::vector<widget *> bin::get_children()
+widget_range bin::get_children()
 {
-    return { _child.get() };
+    return { &_child_ptr, 1 };
 }
 
-std::vector<widget const *> bin::get_children() const
+const_widget_range bin::get_children() const
 {
-    return { _child.get() };
+    return widget_range(&_child_ptr, 1);
 }
 
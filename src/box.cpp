@@ -2,293 +2,336 @@
 #include <iterator>
 
 #include "box.hpp"
+#include "layout_arena.hpp"
 #include "util.hpp"
 
 // TODO default setting singleton
 box::box(orientation o, box::children_type children)
-    : box(o, children, 5, false)
+    : box(o, std::move(children), 5, false)
 {
 }
 
 box::box(orientation o, box::children_type children, int children_spacing)
-    : box(o, children, children_spacing, false)
+    : box(o, std::move(children), children_spacing, false)
 {
 }
 
 box::box(orientation o, box::children_type children, bool children_homogeneous)
-    : box(o, children, 5, children_homogeneous)
+    : box(o, std::move(children), 5, children_homogeneous)
 {
 }
 
 box::box(orientation o, box::children_type children, int children_spacing, bool children_homogeneous)
-    : _children(children)
+    : _children(std::move(children))
     , _children_spacing(children_spacing)
     , _children_homogeneous(children_homogeneous)
     , _o(o)
 {
+    for (auto const & c : _children)
+        _child_ptrs.push_back(c.wptr.get());
     init_children();
 }
 
-void box::on_box_allocated()
+void layout_box_items(box::orientation o, rect area, int spacing, bool homogeneous, box_layout_item const * items, rect * boxes, std::size_t n)
 {
-    std::size_t const n = _children.size();
-
-    if (n > 0)
-    {
-
-        // TODO properly handle orthogonal size (e.g., center, align, etc.)
-        //      currently it is filled
+    if (n == 0)
+        return;
 
-        using namespace std;
+    // TODO properly handle orthogonal size (e.g., center, align, etc.)
+    //      currently it is filled
 
-        int const spacing_length = (n - 1) * _children_spacing;
+    using namespace std;
 
-        int min_sum = 0;
-        int nat_sum = 0;
-        vector<size_hint> size_hints;
-        size_hints.reserve(n);
+    int const spacing_length = (n - 1) * spacing;
 
+    int min_sum = 0;
+    int nat_sum = 0;
+    // Temporary data is allocated from the arena of the layout pass.
+    pmr::memory_resource * const mr = layout_arena::resource();
 
-        if (_children_homogeneous)
+    if (homogeneous)
+    {
+        for (size_t k = 0; k < n; ++k)
         {
-            for (auto const & c : _children)
+            auto const & sh = items[k].hint;
+            if (o == box::orientation::VERTICAL)
             {
-                auto & wptr = c.wptr;
-                if (_o == orientation::VERTICAL)
-                {
-                    size_hints.push_back(wptr->get_size_hint(get_box().w, -1));
-                    auto const & sh = size_hints.back();
-                    min_sum += sh.minimal.h;
-                    nat_sum += sh.natural.h;
-                }
-                else
-                {
-                    size_hints.push_back(wptr->get_size_hint(-1, get_box().h));
-                    auto const & sh = size_hints.back();
-                    min_sum += sh.minimal.w;
-                    nat_sum += sh.natural.w;
-                }
+                min_sum += sh.minimal.h;
+                nat_sum += sh.natural.h;
             }
-
-            if (_o == orientation::HORIZONTAL)
+            else
             {
-                int const avail_width = get_box().w - spacing_length;
+                min_sum += sh.minimal.w;
+                nat_sum += sh.natural.w;
+            }
+        }
 
-                bool const use_natural_width = avail_width >= nat_sum;
-                int const used_width = use_natural_width
-                                     ? avail_width
-                                     : std::max(min_sum, avail_width);
+        if (o == box::orientation::HORIZONTAL)
+        {
+            int const avail_width = area.w - spacing_length;
 
-                length_distributor ld(used_width, n);
+            bool const use_natural_width = avail_width >= nat_sum;
+            int const used_width = use_natural_width
+                                 ? avail_width
+                                 : std::max(min_sum, avail_width);
 
-                int xoffset = get_box().x;
+            length_distributor ld(used_width, n);
 
-                for (std::size_t k = 0; k < n; ++k)
-                {
-                    int const child_width = ld.dist_end(k);
+            int xoffset = area.x;
 
-                    _children[k].wptr->apply_layout({ xoffset, get_box().y, child_width, get_box().h });
-                    xoffset += child_width + _children_spacing;
-                }
-            }
-            else
+            for (std::size_t k = 0; k < n; ++k)
             {
-                int const avail_height = get_box().h - spacing_length;
+                int const child_width = ld.dist_end(k);
 
-                bool const use_natural_height = avail_height >= nat_sum;
-                int const used_height = use_natural_height
-                                      ? avail_height
-                                      : std::max(min_sum, avail_height);
+                boxes[k] = { xoffset, area.y, child_width, area.h };
+                xoffset += child_width + spacing;
+            }
+        }
+        else
+        {
+            int const avail_height = area.h - spacing_length;
 
-                length_distributor ld(used_height, n);
+            bool const use_natural_height = avail_height >= nat_sum;
+            int const used_height = use_natural_height
+                                  ? avail_height
+                                  : std::max(min_sum, avail_height);
 
-                int yoffset = get_box().y;
+            length_distributor ld(used_height, n);
 
-                for (std::size_t k = 0; k < n; ++k)
-                {
-                    int const child_height = ld.dist_end(k);
+            int yoffset = area.y;
 
-                    _children[k].wptr->apply_layout({ get_box().x, yoffset, get_box().w, child_height });
-                    yoffset += child_height + _children_spacing;
-                }
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                int const child_height = ld.dist_end(k);
+
+                boxes[k] = { area.x, yoffset, area.w, child_height };
+                yoffset += child_height + spacing;
             }
         }
-        else
+    }
+    else
+    {
+        // Algorithm outline:
+        // 1. Ask for minimum and natural size of each widget
+        // 2. Calculate difference with available space for both minimal and
+        //    natural size.
+        // 3. If natural size will fit for every widget use natural size,
+        //    otherwise use minimum size.
+        // 4. Distribute left-over space to widgets with expand property.
+        int num_expand = 0;
+
+        for (size_t k = 0; k < n; ++k)
         {
-            // Algorithm outline:
-            // 1. Ask for minimum and natural size of each widget
-            // 2. Calculate difference with available space for both minimal and
-            //    natural size.
-            // 3. If natural size will fit for every widget use natural size,
-            //    otherwise use minimum size.
-            // 4. Distribute left-over space to widgets with expand property.
-            int num_expand = 0;
-
-            for (auto const & c : _children)
-            {
-                auto const & wptr = c.wptr;
-
-                if (_o == orientation::VERTICAL)
-                {
-                    size_hints.push_back(wptr->get_size_hint(get_box().w, -1));
-                    min_sum += size_hints.back().minimal.h;
-                    nat_sum += size_hints.back().natural.h;
-                }
-                else
-                {
-                    size_hints.push_back(wptr->get_size_hint(-1, get_box().h));
-                    min_sum += size_hints.back().minimal.w;
-                    nat_sum += size_hints.back().natural.w;
-                }
+            auto const & sh = items[k].hint;
 
-                if (c.expand)
-                    num_expand += 1;
+            if (o == box::orientation::VERTICAL)
+            {
+                min_sum += sh.minimal.h;
+                nat_sum += sh.natural.h;
             }
+            else
+            {
+                min_sum += sh.minimal.w;
+                nat_sum += sh.natural.w;
+            }
+
+            if (items[k].expand)
+                num_expand += 1;
+        }
 
-            int const max_length = _o == orientation::HORIZONTAL ? get_box().w : get_box().h;
-            int const avail_after_spacing = max(0, max_length - spacing_length);
+        int const max_length = o == box::orientation::HORIZONTAL ? area.w : area.h;
+        int const avail_after_spacing = max(0, max_length - spacing_length);
 
-            int const rem_space_min_length = avail_after_spacing - min_sum;
+        int const rem_space_min_length = avail_after_spacing - min_sum;
 
-            bool const use_natural_size = nat_sum <= avail_after_spacing;
-            bool const fill_to_natural = !use_natural_size && rem_space_min_length > 0;
+        bool const use_natural_size = nat_sum <= avail_after_spacing;
+        bool const fill_to_natural = !use_natural_size && rem_space_min_length > 0;
 
-            // The amounts that are used to partially fill the children to their
-            // natural size.
-            vector<int> partial_nat_size_incs;
-            length_distributor ld(use_natural_size ? avail_after_spacing - nat_sum : 0, num_expand);
+        // The amounts that are used to partially fill the children to their
+        // natural size.
+        pmr::vector<int> partial_nat_size_incs(mr);
+        length_distributor ld(use_natural_size ? avail_after_spacing - nat_sum : 0, num_expand);
 
-            if (fill_to_natural)
+        if (fill_to_natural)
+        {
+            // 1. Sort differences between natural size (or use min heap).
+            // 2. While there is the minimum difference times the remaining
+            //    widgets space left:
+            //    Fill all remaining widgets equally by the minimum
+            //    difference (only for widgets that support intermediate
+            //    sizes). Subtract that from every remaining difference.
+            //
+            //    TODO add option to fill all widgets to a percentage
+
+            int rem_space = rem_space_min_length;
+
+            // This is used to avoid subtracting from all elements of the heap.
+            int allocated = 0;
+
+            // Differences and the corresponding index.
+            auto cmp_first = [](auto a, auto b){ return get<0>(a) > get<0>(b); };
+            pmr::vector<pair<int, size_t>> diff_heap(mr);
+            diff_heap.reserve(n);
+            for (size_t k = 0; k < n; ++k)
             {
-                // 1. Sort differences between natural size (or use min heap).
-                // 2. While there is the minimum difference times the remaining
-                //    widgets space left:
-                //    Fill all remaining widgets equally by the minimum
-                //    difference (only for widgets that support intermediate
-                //    sizes). Subtract that from every remaining difference.
-                //
-                //    TODO add option to fill all widgets to a percentage
-
-                int rem_space = rem_space_min_length;
-
-                // This is used to avoid subtracting from all elements of the heap.
-                int allocated = 0;
-
-                // Differences and the corresponding index.
-                auto cmp_first = [](auto a, auto b){ return get<0>(a) > get<0>(b); };
-                vector<pair<int, size_t>> diff_heap;
-                diff_heap.reserve(n);
-                for (size_t k = 0; k < n; ++k)
+                if (items[k].intermediate)
                 {
-                    if (_children[k].wptr->can_use_intermediate_size())
-                    {
-                        auto const & sh = size_hints[k];
-                        // TODO limit to 0 ?
-                        int const nat_inc = _o == orientation::HORIZONTAL ? sh.natural.w - sh.minimal.w : sh.natural.h - sh.minimal.h;
-                        diff_heap.emplace_back(nat_inc, k);
-                    }
+                    auto const & sh = items[k].hint;
+                    // TODO limit to 0 ?
+                    int const nat_inc = o == box::orientation::HORIZONTAL ? sh.natural.w - sh.minimal.w : sh.natural.h - sh.minimal.h;
+                    diff_heap.emplace_back(nat_inc, k);
                 }
+            }
+
+            make_heap(begin(diff_heap), end(diff_heap), cmp_first);
 
-                make_heap(begin(diff_heap), end(diff_heap), cmp_first);
+            pmr::vector<int> tmp_partial_nat_size_incs(n, 0, mr);
+            do
+            {
+                pop_heap(begin(diff_heap), end(diff_heap), cmp_first);
+                int min_idx;
+                int min_diff;
+                tie(min_diff, min_idx) = diff_heap.back();
+                {
+                    int const new_allocated = min_diff;
+                    min_diff -= allocated;
+                    allocated = new_allocated;
+                }
 
-                vector<int> tmp_partial_nat_size_incs(n, 0);
-                do
+                int const next_allocation = min_diff * diff_heap.size();
+                // can we allocate the current size for each?
+                if (next_allocation <= rem_space)
                 {
-                    pop_heap(begin(diff_heap), end(diff_heap), cmp_first);
-                    int min_idx;
-                    int min_diff;
-                    tie(min_diff, min_idx) = diff_heap.back();
+                    // allocate min diff for every widget (including the popped one)
+                    for (auto const & p : diff_heap)
                     {
-                        int const new_allocated = min_diff;
-                        min_diff -= allocated;
-                        allocated = new_allocated;
+                        tmp_partial_nat_size_incs[get<1>(p)] += min_diff;
                     }
 
-                    int const next_allocation = min_diff * diff_heap.size();
-                    // can we allocate the current size for each?
-                    if (next_allocation <= rem_space)
-                    {
-                        // allocate min diff for every widget (including the popped one)
-                        for (auto const & p : diff_heap)
-                        {
-                            tmp_partial_nat_size_incs[get<1>(p)] += min_diff;
-                        }
+                    diff_heap.pop_back();
+                }
+                else
+                {
+                    length_distributor ld(rem_space, diff_heap.size());
 
-                        diff_heap.pop_back();
-                    }
-                    else
+                    for (std::size_t k = 0; k < diff_heap.size(); ++k)
                     {
-                        length_distributor ld(rem_space, diff_heap.size());
-
-                        for (std::size_t k = 0; k < diff_heap.size(); ++k)
-                        {
-                            tmp_partial_nat_size_incs[get<1>(diff_heap[k])] += ld.dist_end(k);
-                        }
-                        break;
+                        tmp_partial_nat_size_incs[get<1>(diff_heap[k])] += ld.dist_end(k);
                     }
-
-                    rem_space -= next_allocation;
+                    break;
                 }
-                // Protect against violated pre-conditions. E.g., when there is
-                // not enough space for the widgets.
-                // TODO figure out when this happens
-                while (!diff_heap.empty());
-                partial_nat_size_incs.swap(tmp_partial_nat_size_incs);
-            }
 
-            int offset = _o == orientation::HORIZONTAL ? get_box().x : get_box().y;
+                rem_space -= next_allocation;
+            }
+            // Protect against violated pre-conditions. E.g., when there is
+            // not enough space for the widgets.
+            // TODO figure out when this happens
+            while (!diff_heap.empty());
+            partial_nat_size_incs.swap(tmp_partial_nat_size_incs);
+        }
 
-            for (size_t k = 0; k < n; k++)
-            {
-                auto & c = _children[k];
+        int offset = o == box::orientation::HORIZONTAL ? area.x : area.y;
 
-                // Distribute remaining length or fill to natural size.
-                int const extra_length = fill_to_natural
-                                       ? partial_nat_size_incs[k]
-                                       : (c.expand ? ld.dist_end(k) : 0);
+        for (size_t k = 0; k < n; k++)
+        {
+            // Distribute remaining length or fill to natural size.
+            int const extra_length = fill_to_natural
+                                   ? partial_nat_size_incs[k]
+                                   : (items[k].expand ? ld.dist_end(k) : 0);
 
-                auto const & sh = size_hints[k];
-                vec const & size = use_natural_size ? sh.natural : sh.minimal;
+            auto const & sh = items[k].hint;
+            vec const & size = use_natural_size ? sh.natural : sh.minimal;
 
-                if (_o == orientation::HORIZONTAL)
-                {
-                    // TODO should both lengths be limited?
-                    int w = min(size.w + extra_length, get_box().w);
-                    c.wptr->apply_layout({ offset, get_box().y, w, get_box().h });
-                    offset += w + _children_spacing;
-                }
-                else
-                {
-                    int h = min(size.h + extra_length, get_box().h);
-                    c.wptr->apply_layout({ get_box().x, offset, get_box().w, h });
-                    offset += h + _children_spacing;
-                }
+            if (o == box::orientation::HORIZONTAL)
+            {
+                // TODO should both lengths be limited?
+                int w = min(size.w + extra_length, area.w);
+                boxes[k] = { offset, area.y, w, area.h };
+                offset += w + spacing;
+            }
+            else
+            {
+                int h = min(size.h + extra_length, area.h);
+                boxes[k] = { area.x, offset, area.w, h };
+                offset += h + spacing;
             }
         }
     }
 }
 
-widget * box::find_selectable(navigation_type nt, point center)
+void box::on_box_allocated()
+{
+    std::size_t const n = _children.size();
+    if (n == 0)
+        return;
+
+    // Children are independent of each other, their size hints may be
+    // evaluated in parallel. They are cached for the loop below.
+    layout_arena::parallel_for(n, [this](std::size_t k)
+    {
+        if (_o == orientation::VERTICAL)
+            _children[k].wptr->query_size_hint(get_box().w, -1);
+        else
+            _children[k].wptr->query_size_hint(-1, get_box().h);
+    });
+
+    std::pmr::memory_resource * const mr = layout_arena::resource();
+    std::pmr::vector<box_layout_item> items(mr);
+    items.reserve(n);
+    for (auto const & c : _children)
+    {
+        size_hint const sh = _o == orientation::VERTICAL
+                           ? c.wptr->query_size_hint(get_box().w, -1)
+                           : c.wptr->query_size_hint(-1, get_box().h);
+        items.push_back({ sh, c.expand, c.wptr->can_use_intermediate_size() });
+    }
+
+    std::pmr::vector<rect> boxes(n, mr);
+    layout_box_items(_o, get_box(), _children_spacing, _children_homogeneous, items.data(), boxes.data(), n);
+    for (std::size_t k = 0; k < n; ++k)
+        _children[k].wptr->apply_layout(boxes[k]);
+}
+
+// Finds the relevant distance based on the containers orientation.
+int relevant_distance(box::orientation o, point old_center, point new_center)
+{
+    return std::abs(o == box::orientation::HORIZONTAL ? old_center.x - new_center.x : old_center.y - new_center.y);
+}
+
+// Check for orthogonality to container orientation.
+bool is_orthogonal(box::orientation o, navigation_type nt)
+{
+    return
+        ((nt == navigation_type::NEXT_X || nt == navigation_type::PREV_X)
+            && o == box::orientation::VERTICAL
+        )
+        ||
+        ((nt == navigation_type::NEXT_Y || nt == navigation_type::PREV_Y)
+            && o == box::orientation::HORIZONTAL
+        );
+}
+
+widget * find_selectable_in_box(box::orientation o, widget_range children, navigation_type nt, point center)
 {
     // When the navigation request is orthogonal, pick the widget with the
     // closest distance on that particular dimension.
-    if (is_orthogonal(nt))
+    if (is_orthogonal(o, nt))
     {
 
-        widget * min_w;
+        widget * min_w = nullptr;
         int min_distance;
 
         std::size_t k = 0;
 
         // Find a selectable widget for a start.
-        for (; k < _children.size(); ++k)
+        for (; k < children.size(); ++k)
         {
-            min_w = _children[k].wptr->find_selectable(nt, center);
+            min_w = children[k]->find_selectable(nt, center);
 
             if (min_w != nullptr)
             {
                 auto found_widget_center = rect_center(min_w->get_box());
-                min_distance = relevant_distance(center, found_widget_center);
+                min_distance = relevant_distance(o, center, found_widget_center);
                 break;
             }
         }
@@ -298,14 +341,14 @@ widget * box::find_selectable(navigation_type nt, point center)
         else
         {
             // Refine by finding a selectable widget with a smaller distance.
-            for (++k; k < _children.size(); ++k)
+            for (++k; k < children.size(); ++k)
             {
-                auto new_w = _children[k].wptr->find_selectable(nt, center);
+                auto new_w = children[k]->find_selectable(nt, center);
 
                 if (new_w != nullptr)
                 {
                     auto new_center = rect_center(new_w->get_box());
-                    int new_distance = relevant_distance(center, new_center);
+                    int new_distance = relevant_distance(o, center, new_center);
 
                     if (new_distance < min_distance)
                     {
@@ -330,9 +373,9 @@ widget * box::find_selectable(navigation_type nt, point center)
     {
         if (is_forward(nt))
         {
-            for (auto c : _children)
+            for (widget * c : children)
             {
-                auto w = c.wptr->find_selectable(nt, center);
+                auto w = c->find_selectable(nt, center);
                 if (w != nullptr)
                 {
                     return w;
@@ -341,9 +384,9 @@ widget * box::find_selectable(navigation_type nt, point center)
         }
         else
         {
-            for (auto it = _children.rbegin(); it != _children.rend(); ++it)
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
             {
-                auto w = it->wptr->find_selectable(nt, center);
+                auto w = (*it)->find_selectable(nt, center);
                 if (w != nullptr)
                 {
                     return w;
@@ -354,68 +397,61 @@ widget * box::find_selectable(navigation_type nt, point center)
     return nullptr;
 }
 
-widget * box::navigate_selectable_from_children(navigation_type nt, widget * w, point center)
+widget * navigate_in_box(box::orientation o, widget_range children, widget * w, navigation_type nt, point center)
 {
     // When navigating in a linear container like box, we don't have to consider
     // the center hint, as we're either orthogonal with the navigation request,
     // then the parent will handle it, or we're parallel to it, then we just
     // need to pick a consecutive widget.
 
-    if (is_orthogonal(nt))
-    {
-        return navigate_selectable_parent(nt, center);
-    }
-    else
-    {
-        auto const begin = _children.begin();
-        auto const end = _children.end();
+    if (is_orthogonal(o, nt))
+        return nullptr;
 
-        // locate widget in container
-        auto it = std::find_if(begin, end, [w](child const & c){ return c.wptr.get() == w; });
+    // locate widget in container
+    auto const begin = children.begin();
+    auto const end = children.end();
+    auto it = std::find(begin, end, w);
+    if (it == end)
+        return nullptr;
 
-        // find first selectable widget of all navigationally consecutive widgets
-        while (true)
+    // find first selectable widget of all navigationally consecutive widgets
+    while (true)
+    {
+        if (is_forward(nt))
         {
-            if (is_forward(nt))
-            {
-                it++;
-            }
-            else
-            {
-                it--;
-            }
-
-            if (it == end || it < begin)
-            {
-                return navigate_selectable_parent(nt, center);
-            }
-            else
-            {
-                auto result = it->wptr->find_selectable(nt, center);
-                if (result != nullptr)
-                    return result;
-            }
+            ++it;
+            if (it == end)
+                return nullptr;
         }
+        else
+        {
+            if (it == begin)
+                return nullptr;
+            --it;
+        }
+
+        auto result = (*it)->find_selectable(nt, center);
+        if (result != nullptr)
+            return result;
     }
 }
 
-size_hint box::get_size_hint(int width, int height) const
+size_hint box_items_size_hint(box::orientation o, int spacing, bool homogeneous, size_hint const * hints, std::size_t n)
 {
-    int const spacing = _children.empty() ? 0 : (_children.size() - 1) * _children_spacing;
+    int const spacing_length = n == 0 ? 0 : (n - 1) * spacing;
     vec minimal = { 0, 0 };
     vec natural = { 0, 0 };
 
     int hom_minimal_max = 0;
     int hom_natural_max = 0;
-    for (auto & c : _children)
+    for (std::size_t k = 0; k < n; ++k)
     {
-        if (_o == orientation::HORIZONTAL)
+        auto const & sh = hints[k];
+        if (o == box::orientation::HORIZONTAL)
         {
-            auto sh = c.wptr->get_size_hint(-1, height);
-
             minimal.h = std::max(sh.minimal.h, minimal.h);
             natural.h = std::max(sh.natural.h, natural.h);
-            if (_children_homogeneous)
+            if (homogeneous)
             {
                 hom_minimal_max = std::max(sh.minimal.w, hom_minimal_max);
                 hom_natural_max = std::max(sh.natural.w, hom_natural_max);
@@ -428,11 +464,9 @@ size_hint box::get_size_hint(int width, int height) const
         }
         else
         {
-            auto sh = c.wptr->get_size_hint(width, -1);
-
             minimal.w = std::max(sh.minimal.w, minimal.w);
             natural.w = std::max(sh.natural.w, natural.w);
-            if (_children_homogeneous)
+            if (homogeneous)
             {
                 hom_minimal_max = std::max(sh.minimal.h, hom_minimal_max);
                 hom_natural_max = std::max(sh.natural.h, hom_natural_max);
@@ -445,97 +479,155 @@ size_hint box::get_size_hint(int width, int height) const
         }
     }
 
-    if (_children_homogeneous)
+    if (homogeneous)
     {
-        if (_o == orientation::HORIZONTAL)
+        if (o == box::orientation::HORIZONTAL)
         {
-            minimal.w += hom_minimal_max * _children.size() + spacing;
-            natural.w += hom_natural_max * _children.size() + spacing;
+            minimal.w += hom_minimal_max * n + spacing_length;
+            natural.w += hom_natural_max * n + spacing_length;
         }
         else
         {
-            minimal.h += hom_minimal_max * _children.size() + spacing;
-            natural.h += hom_natural_max * _children.size() + spacing;
+            minimal.h += hom_minimal_max * n + spacing_length;
+            natural.h += hom_natural_max * n + spacing_length;
         }
     }
 
     return size_hint(minimal, natural);
 }
 
+widget * find_child_in_box(box::orientation o, widget_range children, point p)
+{
+    // Children are laid out in order, find the last one starting before the
+    // point.
+    bool const horizontal = o == box::orientation::HORIZONTAL;
+    int const pos = horizontal ? p.x : p.y;
+    auto it = std::upper_bound(children.begin(), children.end(), pos, [=](int v, widget * c)
+    {
+        rect const & b = c->get_box();
+        return v < (horizontal ? b.x : b.y);
+    });
+
+    if (it == children.begin())
+        return nullptr;
+
+    widget * c = *std::prev(it);
+    return within_rect(p, c->get_box()) ? c : nullptr;
+}
+
+widget * box::find_selectable(navigation_type nt, point center)
+{
+    return find_selectable_in_box(_o, _child_ptrs, nt, center);
+}
+
+widget * box::navigate_selectable_from_children(navigation_type nt, widget * w, point center)
+{
+    widget * result = navigate_in_box(_o, _child_ptrs, w, nt, center);
+    return result != nullptr ? result : navigate_selectable_parent(nt, center);
+}
+
+size_hint box::get_size_hint(int width, int height) const
+{
+    std::pmr::vector<size_hint> hints(layout_arena::resource());
+    hints.reserve(_children.size());
+    for (auto const & c : _children)
+        hints.push_back(_o == orientation::HORIZONTAL ? c.wptr->query_size_hint(-1, height) : c.wptr->query_size_hint(width, -1));
+    return box_items_size_hint(_o, _children_spacing, _children_homogeneous, hints.data(), hints.size());
+}
+
 box::~box()
 {
 }
 
-int box::relevant_distance(point old_center, point new_center) const
+std::size_t box::size() const
 {
-    return std::abs(_o == orientation::HORIZONTAL ? old_center.x - new_center.x : old_center.y - new_center.y);
+    return _children.size();
 }
 
-bool box::is_orthogonal(navigation_type nt) const
+void box::insert(std::size_t position, child c)
 {
-    return
-        ((nt == navigation_type::NEXT_X || nt == navigation_type::PREV_X)
-            && _o == orientation::VERTICAL
-        )
-        ||
-        ((nt == navigation_type::NEXT_Y || nt == navigation_type::PREV_Y)
-            && _o == orientation::HORIZONTAL
-        );
+    position = std::min(position, _children.size());
+    attach_child(*c.wptr);
+    _child_ptrs.insert(_child_ptrs.begin() + position, c.wptr.get());
+    _children.insert(_children.begin() + position, std::move(c));
+    children_changed();
+}
+
+widget_ptr box::remove(std::size_t position)
+{
+    widget_ptr wptr = std::move(_children.at(position).wptr);
+    detach_child(*wptr);
+    _children.erase(_children.begin() + position);
+    _child_ptrs.erase(_child_ptrs.begin() + position);
+    children_changed();
+    return wptr;
+}
+
+widget_ptr box::replace(std::size_t position, child c)
+{
+    child & old = _children.at(position);
+    detach_child(*old.wptr);
+    attach_child(*c.wptr);
+    _child_ptrs[position] = c.wptr.get();
+    std::swap(old, c);
+    children_changed();
+    return std::move(c.wptr);
+}
+
+widget * box::find_child_at(point p)
+{
+    return find_child_in_box(_o, _child_ptrs, p);
 }
 
-std::vector<widget *> box::get_children()
+widget_range box::get_children()
 {
-    std::vector<widget *> result;
-    std::for_each(std::begin(_children), std::end(_children), [&](auto c){ result.push_back(c.wptr.get()); });
-    return result;
+    return _child_ptrs;
 }
 
-std::vector<widget const *> box::get_children() const
+const_widget_range box::get_children() const
 {
-    std::vector<widget const *> result;
-    std::for_each(std::begin(_children), std::end(_children), [&](auto c){ result.push_back(c.wptr.get()); });
-    return result;
+    return widget_range(_child_ptrs);
 }
 
 widget_ptr hbox(box::children_type children)
 {
-    return std::make_shared<box>(box::orientation::HORIZONTAL, children);
+    return std::make_shared<box>(box::orientation::HORIZONTAL, std::move(children));
 }
 
 widget_ptr vbox(box::children_type children)
 {
-    return std::make_shared<box>(box::orientation::VERTICAL, children);
+    return std::make_shared<box>(box::orientation::VERTICAL, std::move(children));
 }
 
 
 widget_ptr hbox(box::children_type children, int children_spacing)
 {
-    return std::make_shared<box>(box::orientation::HORIZONTAL, children, children_spacing);
+    return std::make_shared<box>(box::orientation::HORIZONTAL, std::move(children), children_spacing);
 }
 
 widget_ptr vbox(box::children_type children, int children_spacing)
 {
-    return std::make_shared<box>(box::orientation::VERTICAL, children, children_spacing);
+    return std::make_shared<box>(box::orientation::VERTICAL, std::move(children), children_spacing);
 }
 
 
 widget_ptr hbox(box::children_type children, bool children_homogeneous)
 {
-    return std::make_shared<box>(box::orientation::HORIZONTAL, children, children_homogeneous);
+    return std::make_shared<box>(box::orientation::HORIZONTAL, std::move(children), children_homogeneous);
 }
 
 widget_ptr vbox(box::children_type children, bool children_homogeneous)
 {
-    return std::make_shared<box>(box::orientation::VERTICAL, children, children_homogeneous);
+    return std::make_shared<box>(box::orientation::VERTICAL, std::move(children), children_homogeneous);
 }
 
 widget_ptr hbox(box::children_type children, int children_spacing, bool children_homogeneous)
 {
-    return std::make_shared<box>(box::orientation::HORIZONTAL, children, children_spacing, children_homogeneous);
+    return std::make_shared<box>(box::orientation::HORIZONTAL, std::move(children), children_spacing, children_homogeneous);
 }
 
 widget_ptr vbox(box::children_type children, int children_spacing, bool children_homogeneous)
 {
-    return std::make_shared<box>(box::orientation::VERTICAL, children, children_spacing, children_homogeneous);
+    return std::make_shared<box>(box::orientation::VERTICAL, std::move(children), children_spacing, children_homogeneous);
 }
 
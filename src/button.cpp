@@ -14,6 +14,11 @@ void button::on_draw(draw_context & dc, selection_context const & sc) const
     draw_drawable(dc, get_box());
 }
 
+bool button::is_opaque() const
+{
+    return true;
+}
+
 void button::on_mouse_down_event(mouse_down_event const & e)
 {
     bool const hit = within_rect(e.position, get_box());
@@ -26,6 +26,11 @@ void color_widget::on_draw(draw_context & dc, selection_context const & sc) cons
     }
 }
 
+bool color_widget::is_opaque() const
+{
+    return true;
+}
+
 void color_widget::on_mouse_up_event(mouse_up_event const & e)
 {
     if (within_rect(e.position, get_box())
@@ -1,5 +1,10 @@
 #include "container.hpp"
 
+container::container()
+    : _pressed_child(nullptr)
+{
+}
+
 container::~container()
 {
 }
@@ -11,28 +16,57 @@ void container::on_draw(draw_context & dc, selection_context const & sc) const
 
 void container::on_mouse_down_event(mouse_down_event const & me)
 {
-    // TODO need logic to capture mouse moves outside of a widget
-    for (auto c : get_children())
-    {
-        c->on_mouse_down_event(me);
-    }
+    _pressed_child = find_child_at(me.position);
+    if (_pressed_child != nullptr)
+        _pressed_child->on_mouse_down_event(me);
 }
 
 void container::on_mouse_up_event(mouse_up_event const & me)
 {
-    // TODO need logic to capture mouse moves outside of a widget
-    for (auto c : get_children())
-    {
-        c->on_mouse_up_event(me);
-    }
+    // The pressed child captures the mouse, e.g., to release a button outside
+    // of its box.
+    widget * hit = find_child_at(me.position);
+    if (_pressed_child != nullptr)
+        _pressed_child->on_mouse_up_event(me);
+    if (hit != nullptr && hit != _pressed_child)
+        hit->on_mouse_up_event(me);
+    _pressed_child = nullptr;
 }
 
 void container::on_mouse_move_event(mouse_move_event const & e)
 {
-    for (auto c : get_children())
+    widget * hit = find_child_at(e.position);
+    if (_pressed_child != nullptr)
+        _pressed_child->on_mouse_move_event(e);
+    if (hit != nullptr && hit != _pressed_child)
+        hit->on_mouse_move_event(e);
+}
+
+void container::on_mouse_capture_released(pointer_id id)
+{
+    // The up event goes to the capturing descendant directly.
+    _pressed_child = nullptr;
+}
+
+void container::cancel_pressed_child(pointer_id id)
+{
+    if (_pressed_child == nullptr)
+        return;
+
+    widget * w = _pressed_child;
+    _pressed_child = nullptr;
+    rect const & b = w->get_box();
+    w->on_mouse_up_event({ { b.x - 1, b.y - 1 }, std::nullopt, id });
+}
+
+widget * container::find_child_at(point p)
+{
+    for (widget * c : get_children())
     {
-        c->on_mouse_move_event(e);
+        if (within_rect(p, c->get_box()))
+            return c;
     }
+    return nullptr;
 }
 
 void container::init_children()
@@ -44,3 +78,21 @@ void container::init_children()
     }
 }
 
+void container::detach_child(widget & child)
+{
+    if (_pressed_child == &child)
+        _pressed_child = nullptr;
+    widget::detach_child(child);
+}
+
+void container::children_changed()
+{
+    // Indices of the visible widgets are outdated, even if no box changes.
+    advance_layout_generation();
+    invalidate_size_hint();
+    redo_layout();
+
+    // Removed children leave a gap otherwise.
+    mark_dirty();
+}
+
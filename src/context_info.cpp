@@ -2,20 +2,84 @@
 
 context_info::context_info(font_manager & fm, swipe_config swipe_cfg)
     : swipe_cfg(swipe_cfg)
+    , _region_control(nullptr)
+    , _widget_batch(nullptr)
+    , _animation_scheduler(nullptr)
     , _fm(fm)
 {
 }
 
-vec context_info::text_size(std::string t, int max_line_width, int font_idx) const
+void context_info::set_region_control(region_control * rc)
+{
+    _region_control = rc;
+}
+
+void context_info::queue_redo_layout() const
+{
+    if (_region_control != nullptr)
+        _region_control->queue_redo_layout();
+}
+
+void context_info::notify_widget_detached(widget & w) const
+{
+    if (_region_control != nullptr)
+        _region_control->on_widget_detached(w);
+}
+
+void context_info::capture_mouse(widget & w, pointer_id id) const
+{
+    if (_region_control != nullptr)
+        _region_control->capture_mouse(w, id);
+}
+
+void context_info::set_widget_batch(widget_batch * b)
+{
+    _widget_batch = b;
+}
+
+widget_batch * context_info::get_widget_batch() const
+{
+    return _widget_batch;
+}
+
+void context_info::set_animation_scheduler(animation_scheduler * as)
+{
+    _animation_scheduler = as;
+}
+
+animation_handle context_info::start_animation(animation_scheduler::step_function step) const
+{
+    if (_animation_scheduler == nullptr)
+        return NO_ANIMATION;
+    return _animation_scheduler->start_animation(std::move(step));
+}
+
+void context_info::stop_animation(animation_handle h) const
+{
+    if (_animation_scheduler != nullptr)
+        _animation_scheduler->stop(h);
+}
+
+vec context_info::text_size(std::string_view t, int max_line_width, int font_idx) const
+{
+    return _fm.get().text_size(t, max_line_width, font_idx);
+}
+
+vec context_info::text_size(interned_text const & t, int max_line_width, int font_idx) const
 {
     return _fm.get().text_size(t, max_line_width, font_idx);
 }
 
-int context_info::text_minimum_width(std::string t, int font_idx) const
+int context_info::text_minimum_width(std::string_view t, int font_idx) const
 {
     return _fm.get().text_minimum_width(t, font_idx);
 }
 
+void context_info::text_line_starts(std::string_view t, int max_line_width, std::vector<std::size_t> & starts, int font_idx) const
+{
+    _fm.get().text_line_starts(t, max_line_width, starts, font_idx);
+}
+
 unsigned int context_info::font_height(int font_idx) const
 {
     return _fm.get().font_height(font_idx);
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <limits>
+
+#include "damage_region.hpp"
+
+// Every rectangle costs a separate redraw, a few are enough to cover the
+// typical case of some changed widgets.
+std::size_t const MAX_DAMAGE_RECTS = 8;
+
+long area(rect const & r)
+{
+    return static_cast<long>(r.w) * r.h;
+}
+
+rect union_rect(rect const & a, rect const & b)
+{
+    rect result;
+    SDL_UnionRect(&a, &b, &result);
+    return result;
+}
+
+// The area that would be covered by merging without being damaged.
+long merge_waste(rect const & a, rect const & b)
+{
+    rect overlap;
+    long const covered = area(a) + area(b) - (SDL_IntersectRect(&a, &b, &overlap) ? area(overlap) : 0);
+    return area(union_rect(a, b)) - covered;
+}
+
+damage_region::damage_region()
+{
+}
+
+void damage_region::add(rect r)
+{
+    if (r.w <= 0 || r.h <= 0)
+        return;
+
+    // Merging may allow further merges with the grown rectangle.
+    bool merged;
+    do
+    {
+        merged = false;
+        for (auto it = _rects.begin(); it != _rects.end(); ++it)
+        {
+            if (SDL_HasIntersection(&*it, &r) || merge_waste(*it, r) <= 0)
+            {
+                r = union_rect(*it, r);
+                _rects.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+    while (merged);
+
+    _rects.push_back(r);
+
+    if (_rects.size() > MAX_DAMAGE_RECTS)
+    {
+        // Merge the pair that wastes the least area.
+        std::size_t best_i = 0;
+        std::size_t best_j = 1;
+        long best_waste = std::numeric_limits<long>::max();
+        for (std::size_t i = 0; i < _rects.size(); ++i)
+        {
+            for (std::size_t j = i + 1; j < _rects.size(); ++j)
+            {
+                long const waste = merge_waste(_rects[i], _rects[j]);
+                if (waste < best_waste)
+                {
+                    best_waste = waste;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+
+        rect const u = union_rect(_rects[best_i], _rects[best_j]);
+        _rects.erase(_rects.begin() + best_j);
+        _rects.erase(_rects.begin() + best_i);
+        add(u);
+    }
+}
+
+void damage_region::add(damage_region const & other)
+{
+    for (rect const & r : other._rects)
+        add(r);
+}
+
+void damage_region::clear()
+{
+    _rects.clear();
+}
+
+bool damage_region::empty() const
+{
+    return _rects.empty();
+}
+
+std::vector<rect> const & damage_region::rects() const
+{
+    return _rects;
+}
+
+rect damage_region::bounding_box() const
+{
+    if (_rects.empty())
+        return { 0, 0, 0, 0 };
+
+    rect result = _rects.front();
+    for (rect const & r : _rects)
+        result = union_rect(result, r);
+    return result;
+}
+
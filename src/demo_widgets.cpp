@@ -0,0 +1,142 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "box.hpp"
+#include "color_widget.hpp"
+#include "demo_widgets.hpp"
+#include "empty.hpp"
+#include "grid.hpp"
+#include "label.hpp"
+#include "list_provider.hpp"
+#include "list_view.hpp"
+#include "notebook.hpp"
+#include "padding.hpp"
+#include "radio_button.hpp"
+#include "sdl_util.hpp"
+#include "slider.hpp"
+#include "swipe_area.hpp"
+#include "text_button.hpp"
+#include "texture_button.hpp"
+#include "texture_view.hpp"
+
+widget_ptr cw()
+{
+    return std::make_shared<color_widget>();
+}
+
+widget_ptr num_button()
+{
+    static int k = 0;
+    k++;
+    int n = k;
+    return std::make_shared<text_button>(std::string("Button #") + std::to_string(n), [=](){ std::cout << "click" << n << std::endl; });
+}
+
+widget_ptr labeled_slider(int start, int end, int num_steps)
+{
+    auto l = std::make_shared<label>(std::to_string(start));
+    l->set_minimum_width(40);
+    auto s = std::make_shared<slider>(start, end, num_steps, [l](int i){ l->set_text(std::to_string(i)); });
+    s->set_drag_updates(true);
+    return hbox({ { false, l }, { true, s } }, 2);
+}
+
+std::vector<font> demo_fonts()
+{
+    return { { "/usr/share/fonts/TTF/DejaVuSans.ttf", 15 }
+           , { "/usr/share/fonts/TTF/DejaVuSans.ttf", 20 }
+           };
+}
+
+widget_ptr demo_widget(SDL_Renderer * renderer)
+{
+    std::vector<std::string> const fixed_values{"a", "b", "c", "d", "testwdfkosadjflkajskdfjlaskdjflkasdjdfklajsdlkfjasldkdfjflkasddjflkdsjlfkjdsalkkfjdkk", "test1", "test2", "a very long string this is indeed", "foo", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a", "a"};
+
+    // The remaining rows are only formatted when shown.
+    auto test_values = std::make_shared<generated_list_provider>(fixed_values.size() + 5000, [fixed_values](std::size_t k, std::string & row)
+    {
+        if (k < fixed_values.size())
+            row = fixed_values[k];
+        else
+            row = "generic" + std::to_string(k - fixed_values.size());
+    });
+
+    auto nb = std::make_shared<notebook>(std::vector<widget_ptr>
+        { cw()
+        , std::make_shared<swipe_area>([](swipe_direction dir){ std::cout << "swipe " << to_string(dir) << std::endl; }, [](){ std::cout << "press" << std::endl; })
+        });
+
+    auto nb_indicator = std::make_shared<label>("Active Notebook Widget: Color");
+    nb_indicator->set_wrap(true);
+    auto nb_controls = hbox({ { false, std::make_shared<text_button>("Color", [nb, nb_indicator](){ nb->set_page(0); nb_indicator->set_text("Active Notebook Widget: Color"); })}
+                            , { false, std::make_shared<text_button>("Swipe", [nb, nb_indicator](){ nb->set_page(1); nb_indicator->set_text("Active Notebook Widget: Swipe"); })}
+                            }, 20, true);
+
+    // The widget outlives this function, refer to it weakly to avoid a cycle.
+    auto lv_ref = std::make_shared<std::weak_ptr<list_view>>();
+    auto lv = std::make_shared<list_view>(test_values, 0, [lv_ref](std::size_t p){ std::cout << "press list_view at " << p << std::endl; if (auto lv = lv_ref->lock()) lv->set_highlight_position(p); });
+    *lv_ref = lv;
+
+    auto col1 = vbox({ { true, lv }, { false, nb_indicator }, { true, nb }, { false, nb_controls } }, 20);
+    auto col2 = vbox({ { true, cw() }, { false, std::make_shared<texture_view>(load_texture_from_image(renderer, PKGDATA"/test.jpeg")) }, { true, cw() } }, 20);
+    std::vector<grid::entry> grid_entries
+        { { { 0, 0, 2, 2 }, num_button() }
+        , { { 0, 2, 1, 1 }, num_button() }
+        , { { 1, 2, 1, 1 }, num_button() }
+        , { { 2, 0, 1, 3 }, num_button() }
+        , { { 0, 3, 3, 1 }, num_button() }
+        , { { 3, 0, 1, 1 }, num_button() }
+        , { { 3, 1, 1, 3 }, num_button() }
+        };
+    auto l1 = std::make_shared<label>("This text should hopefully produce a linebreak. Otherwise something is not working correctly.\n\nYou may use Tab and Shift+Tab to focus widgets or use Shift and the corresponding arrow key for a 2-dimensional direction.");
+    l1->set_wrap(true);
+    l1->set_maximum_width(500);
+
+    auto l2 = std::make_shared<label>(std::vector<paragraph>{ paragraph("This is a bigger font.", 0, 1) });
+    l2->set_wrap(true);
+
+    auto col3 = vbox( { { false, num_button() }
+                      , { false, cw() }
+                      , { false, l1 }
+                      , { true, std::make_shared<grid, vec>({ 4, 4 }, grid_entries, 20) }
+                      , { false, std::make_shared<label>(std::vector<paragraph>{paragraph("Text 1, Paragraph 1."), paragraph("Text 1, Paragraph 2.")}) }
+                      , { true, cw() }
+                      , { true, std::make_shared<label>(std::vector<paragraph>{paragraph("Text 2, Paragraph 1.")}) }
+                      , { false, labeled_slider(-50, -100, 11) }
+                      , { false, labeled_slider(0, 30, 31) }
+                      }, 20);
+    auto col5 = vbox( { { false, num_button() }
+                      , { true, std::make_shared<empty>() }
+                      , { false, l2 }
+                      , { true, std::make_shared<empty>() }
+                      , { false, std::make_shared<texture_button>(load_shared_texture_from_image(renderer, PKGDATA"/smile.png"), [](){}) }
+                      , { false, radio_box_from_labels({"Foo", "Bar", "Baz"}, [](int i){ std::cout << "Selected option " << i << std::endl; })}
+                      , { true, std::make_shared<empty>() }
+                      , { false, std::make_shared<text_button>("Quit", [](){ SDL_Event ev { .type = SDL_QUIT }; SDL_PushEvent(&ev); })}
+                      }
+                    , 20);
+
+    //auto col4 = vbox({ { true, num_button() }, { true, num_button() }, { true, num_button() } }, 20, true);
+
+    ///*
+    auto main_widget = std::make_shared<padding>(20, hbox(
+        { { true, col1 }
+        , { false, col2  }
+        , { true, col3 }
+        //, { false, col4 }
+        , { false, col5 }
+        }, 20));
+    //*/
+    //widget & main_widget = *col4.get();
+
+    /*
+    padding main_widget(20, vbox({ { false, std::make_shared<label>("This text should hopefully produce a linebreak. Otherwise something is not working correctly.\n\nYou may use Tab and Shift+Tab to focus widgets or use Shift and the corresponding arrow key for a 2-dimensional direction.")}, { false, cw()} , { false, num_button() }, { false, num_button() } }, 20, false));
+    */
+
+    return main_widget;
+}
+
@@ -0,0 +1,20 @@
+#ifndef LIBWTK_SDL2_DEMO_WIDGETS_HPP
+#define LIBWTK_SDL2_DEMO_WIDGETS_HPP
+
+#include <vector>
+
+#include <SDL2/SDL_render.h>
+
+#include "font.hpp"
+#include "widget.hpp"
+
+// The widget tree of the test program, shared with the benchmarks. Not part
+// of the library.
+
+std::vector<font> demo_fonts();
+
+// Images are loaded with the renderer.
+widget_ptr demo_widget(SDL_Renderer * renderer);
+
+#endif
+
@@ -0,0 +1,53 @@
+#include "display_list.hpp"
+
+bool same_texture(texture_ref const & a, texture_ref const & b)
+{
+    return a.texture == b.texture && a.surface == b.surface;
+}
+
+bool same_color(SDL_Color a, SDL_Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+bool same_optional_rect(std::optional<rect> const & a, std::optional<rect> const & b)
+{
+    if (!a.has_value() || !b.has_value())
+        return a.has_value() == b.has_value();
+    return SDL_RectEquals(&a.value(), &b.value());
+}
+
+bool operator==(render_state const & a, render_state const & b)
+{
+    return same_color(a.draw_color, b.draw_color)
+        && a.blend_mode == b.blend_mode
+        && same_optional_rect(a.clip, b.clip)
+        && same_optional_rect(a.viewport, b.viewport);
+}
+
+void display_list::clear()
+{
+    _commands.clear();
+    _owned_textures.clear();
+}
+
+bool display_list::empty() const
+{
+    return _commands.empty();
+}
+
+void display_list::push(display_command const & c)
+{
+    _commands.push_back(c);
+}
+
+void display_list::own(unique_texture_ptr t)
+{
+    _owned_textures.push_back(std::move(t));
+}
+
+std::vector<display_command> const & display_list::commands() const
+{
+    return _commands;
+}
+
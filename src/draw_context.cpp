@@ -1,115 +1,742 @@
 #include "draw_context.hpp"
+#include "sdl_render_backend.hpp"
 #include "sdl_util.hpp"
-
-color_theme::color_theme()
-    : button_bg_color{25, 25, 25}
-    , button_fg_color{235, 235, 235}
-    , button_frame_color{105, 105, 105}
-    , button_pressed_bg_color{105, 55, 55}
-    , button_selected_bg_color{55, 55, 105}
-
-    , entry_selected_bg_color{250, 200, 200}
-    , entry_highlight_bg_color{240, 240, 240}
-
-    , entry_box_bg_color{255, 255, 255}
-    , entry_box_frame_color{100, 100, 100}
-    , entry_box_selected_frame_color{155, 155, 205}
-
-    , bg_color{0, 0, 0}
-    , active_color{230, 230, 255}
-    , hightlight_color{210, 210, 210}
-{}
+#include "trace.hpp"
 
 draw_context::draw_context(SDL_Renderer * renderer, font_manager & fm)
+    : draw_context(renderer, fm, std::make_unique<sdl_render_backend>(renderer))
+{
+}
+
+draw_context::draw_context(SDL_Renderer * renderer, font_manager & fm, std::unique_ptr<render_backend> backend)
     : _renderer(renderer)
     , _fm(fm)
+    , _backend(std::move(backend))
+    , _state{ { 0, 0, 0, 0 }, SDL_BLENDMODE_NONE, std::nullopt, std::nullopt }
+    , _recording(nullptr)
+    , _target(nullptr)
+    , _origin{ 0, 0 }
+    , _frame(0)
+    , _copy_count(0)
+    , _frame_resource(_frame_buffer.data(), _frame_buffer.size())
+    , _theme(std::make_shared<theme>())
 {
+    // Text is drawn from the coverage of the words instead of their textures.
+    if (_backend->needs_pixels())
+        _fm.set_keep_alpha(true);
 }
 
+// Number of frames a texture of a surface is kept without being used.
+std::size_t const SURFACE_TEXTURE_FRAMES = 120;
+
 void draw_context::present()
 {
-    SDL_RenderPresent(_renderer);
+    LIBWTK_SDL2_TRACE_SCOPE("frame", "present");
+    _backend->present(nullptr);
+    end_frame();
+}
+
+void draw_context::present(damage_region const & damage)
+{
+    LIBWTK_SDL2_TRACE_SCOPE("frame", "present");
+    _backend->present(&damage);
+    end_frame();
+}
+
+void draw_context::set_scissor(rect const * r)
+{
+    _scissor = r == nullptr ? std::nullopt : std::optional<rect>(*r);
+}
+
+std::optional<rect> draw_context::get_scissor() const
+{
+    return _scissor;
+}
+
+void draw_context::push_visible_area(rect r)
+{
+    if (!_visible_areas.empty() && SDL_IntersectRect(&_visible_areas.back(), &r, &r) != SDL_TRUE)
+        r = { r.x, r.y, 0, 0 };
+    _visible_areas.push_back(r);
+}
+
+void draw_context::pop_visible_area()
+{
+    _visible_areas.pop_back();
+}
+
+bool draw_context::is_visible(rect box) const
+{
+    // Drawing into a target is relative to the origin, scissor and visible
+    // areas are reset while doing so.
+    if (_scissor.has_value() && SDL_HasIntersection(&_scissor.value(), &box) != SDL_TRUE)
+        return false;
+    if (!_visible_areas.empty() && SDL_HasIntersection(&_visible_areas.back(), &box) != SDL_TRUE)
+        return false;
+    return true;
+}
+
+void draw_context::end_frame()
+{
+    _fm.end_frame();
+
+    // Drop textures of surfaces that are not blitted anymore.
+    for (auto it = _surface_textures.begin(); it != _surface_textures.end();)
+    {
+        if (_frame - it->second.frame > SURFACE_TEXTURE_FRAMES)
+            it = _surface_textures.erase(it);
+        else
+            ++it;
+    }
+    _frame++;
+    _frame_resource.release();
+
+    // The application may use the renderer in between frames.
+    invalidate_render_state();
+}
+
+std::pmr::memory_resource * draw_context::frame_resource()
+{
+    return &_frame_resource;
+}
+
+void draw_context::invalidate_render_state()
+{
+    _backend->invalidate_state();
+}
+
+void draw_context::begin_recording(display_list & dl)
+{
+    _recording = &dl;
+}
+
+void draw_context::end_recording()
+{
+    _recording = nullptr;
+}
+
+unique_texture_ptr draw_context::create_target_texture(vec size)
+{
+    return _backend->create_target_texture(size);
+}
+
+unique_texture_ptr draw_context::create_streaming_texture(vec size)
+{
+    unique_texture_ptr t(SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, size.w, size.h));
+    if (!t)
+        throw std::runtime_error(std::string("could not create streaming texture: ") + SDL_GetError());
+    return t;
+}
+
+void draw_context::update_streaming_texture(SDL_Texture * t, std::function<void(void *, int)> const & write)
+{
+    LIBWTK_SDL2_TRACE_SCOPE("upload", "update_streaming_texture");
+
+    void * pixels;
+    int pitch;
+    if (SDL_LockTexture(t, nullptr, &pixels, &pitch) < 0)
+        throw std::runtime_error(std::string("could not lock texture: ") + SDL_GetError());
+    write(pixels, pitch);
+    SDL_UnlockTexture(t);
+}
+
+unique_texture_ptr draw_context::create_texture(SDL_Surface * s)
+{
+    LIBWTK_SDL2_TRACE_SCOPE("upload", "upload_image");
+
+    unique_texture_ptr t(SDL_CreateTextureFromSurface(_renderer, s));
+    if (!t)
+        throw std::runtime_error(std::string("could not create texture for surface: ") + SDL_GetError());
+    return t;
+}
+
+void draw_context::push_target(SDL_Texture * t, point origin, bool clear)
+{
+    _backend->set_target(t, clear);
+
+    _targets.push_back({ _target, _origin, _recording, _state, _scissor, std::move(_visible_areas) });
+    _target = t;
+    _origin = origin;
+    _recording = nullptr;
+    _scissor.reset();
+    _visible_areas.clear();
+}
+
+void draw_context::pop_target()
+{
+    target_entry & e = _targets.back();
+
+    // The previous target is drawn to again, what it has so far stays.
+    _backend->set_target(e.texture, false);
+
+    _target = e.texture;
+    _origin = e.origin;
+    _recording = e.recording;
+    _state = e.state;
+    _scissor = e.scissor;
+    _visible_areas = std::move(e.visible_areas);
+    _targets.pop_back();
+}
+
+// Only commands that are close to each other are considered for merging,
+// otherwise checking for overlaps gets too expensive.
+std::size_t const MERGE_LOOKAHEAD = 32;
+
+bool mergeable(display_command const & a, display_command const & b)
+{
+    if (a.type != b.type || !(a.state == b.state))
+        return false;
+
+    if (a.type == display_command_type::COPY)
+    {
+        return same_texture(a.texture, b.texture)
+            && a.color_mod.has_value() == b.color_mod.has_value()
+            && (!a.color_mod.has_value() || same_color(a.color_mod.value(), b.color_mod.value()));
+    }
+
+    return true;
+}
+
+// The area that may be touched by a command in renderer coordinates.
+rect absolute_target(display_command const & c)
+{
+    rect r = c.target;
+    if (c.state.viewport.has_value())
+    {
+        r.x += c.state.viewport->x;
+        r.y += c.state.viewport->y;
+    }
+    return r;
+}
+
+void draw_context::submit(display_list const & dl)
+{
+    auto const & cs = dl.commands();
+
+    std::pmr::memory_resource * const mr = frame_resource();
+    std::pmr::vector<bool> done(cs.size(), false, mr);
+    std::pmr::vector<std::size_t> batch(mr);
+    std::pmr::vector<rect> blockers(mr);
+    std::pmr::vector<rect> targets(mr);
+
+    for (std::size_t i = 0; i < cs.size(); ++i)
+    {
+        if (done[i])
+            continue;
+
+        // Collect commands that can be executed together with this one. A
+        // command may only be moved in front of others if it does not overlap
+        // with them, such that the result is the same.
+        batch.assign(1, i);
+        blockers.clear();
+        for (std::size_t j = i + 1; j < cs.size() && j < i + MERGE_LOOKAHEAD; ++j)
+        {
+            if (done[j])
+                continue;
+
+            rect const r = absolute_target(cs[j]);
+            bool const blocked = std::any_of(blockers.begin(), blockers.end(), [&](rect const & b){ return SDL_HasIntersection(&b, &r); });
+
+            if (!blocked && mergeable(cs[i], cs[j]))
+            {
+                batch.push_back(j);
+                done[j] = true;
+            }
+            else
+            {
+                blockers.push_back(r);
+            }
+        }
+
+        auto const & c = cs[i];
+
+        switch (c.type)
+        {
+            case display_command_type::FILL_RECT:
+            case display_command_type::DRAW_RECT:
+                targets.clear();
+                for (auto k : batch)
+                    targets.push_back(cs[k].target);
+
+                if (c.type == display_command_type::FILL_RECT)
+                    _backend->fill_rects(c.state, targets.data(), targets.size());
+                else
+                    _backend->draw_rects(c.state, targets.data(), targets.size());
+                break;
+            case display_command_type::COPY:
+                // The color modulation is the same for the whole batch.
+                if (c.color_mod.has_value() && batch.size() > 1 && std::all_of(batch.begin(), batch.end(), [&](std::size_t k){ return cs[k].source.has_value(); }))
+                {
+                    _quads.clear();
+                    for (auto k : batch)
+                        _quads.push_back({ cs[k].source.value(), cs[k].target, cs[k].texture.alpha });
+                    _backend->copy_quads(c.state, c.texture, _quads.data(), _quads.size(), c.color_mod.value());
+                }
+                else
+                {
+                    for (auto k : batch)
+                    {
+                        auto const & bc = cs[k];
+                        _backend->copy(bc.state, bc.texture, bc.source.has_value() ? &bc.source.value() : nullptr, bc.target, k == i ? c.color_mod : std::nullopt);
+                    }
+                }
+                break;
+        }
+    }
+}
+
+void draw_context::set_draw_color(SDL_Color c)
+{
+    _state.draw_color = c;
+}
+
+void draw_context::set_blend_mode(SDL_BlendMode bm)
+{
+    _state.blend_mode = bm;
+}
+
+void draw_context::set_clip(rect const * r)
+{
+    _state.clip = r == nullptr ? std::nullopt : std::optional<rect>(*r);
+}
+
+void draw_context::set_viewport(rect const * r)
+{
+    _state.viewport = r == nullptr ? std::nullopt : std::optional<rect>(*r);
+}
+
+render_state draw_context::translated_state() const
+{
+    render_state s = _state;
+
+    if (_scissor.has_value())
+    {
+        // The clip rect is relative to the viewport.
+        rect scissor = _scissor.value();
+        if (s.viewport.has_value())
+        {
+            scissor.x -= s.viewport->x;
+            scissor.y -= s.viewport->y;
+        }
+
+        rect clip = scissor;
+        if (s.clip.has_value() && SDL_IntersectRect(&s.clip.value(), &scissor, &clip) != SDL_TRUE)
+            clip = { scissor.x, scissor.y, 0, 0 };
+        s.clip = clip;
+    }
+
+    // The clip rect is relative to the viewport, so only one of them has to
+    // be moved.
+    std::optional<rect> & r = s.viewport.has_value() ? s.viewport : s.clip;
+    if (r.has_value())
+    {
+        r->x -= _origin.x;
+        r->y -= _origin.y;
+    }
+    return s;
+}
+
+rect draw_context::translated_target(rect r) const
+{
+    // Targets are relative to the viewport.
+    if (!_state.viewport.has_value())
+    {
+        r.x -= _origin.x;
+        r.y -= _origin.y;
+    }
+    return r;
+}
+
+void draw_context::fill_rect(rect r)
+{
+    r = translated_target(r);
+    if (_recording != nullptr)
+    {
+        _recording->push({ display_command_type::FILL_RECT, translated_state(), r, {}, std::nullopt, std::nullopt });
+    }
+    else
+    {
+        _backend->fill_rects(translated_state(), &r, 1);
+    }
+}
+
+void draw_context::frame_rect(rect r)
+{
+    r = translated_target(r);
+    if (_recording != nullptr)
+    {
+        _recording->push({ display_command_type::DRAW_RECT, translated_state(), r, {}, std::nullopt, std::nullopt });
+    }
+    else
+    {
+        _backend->draw_rects(translated_state(), &r, 1);
+    }
+}
+
+void draw_context::copy(texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod)
+{
+    dst = translated_target(dst);
+    _copy_count++;
+    if (_recording != nullptr)
+    {
+        _recording->push({ display_command_type::COPY, translated_state(), dst, t, src == nullptr ? std::nullopt : std::optional<rect>(*src), color_mod });
+    }
+    else
+    {
+        _backend->copy(translated_state(), t, src, dst, color_mod);
+    }
 }
 
 void draw_context::draw_rect_filled(rect r)
 {
-    SDL_RenderFillRect(_renderer, &r);
+    fill_rect(r);
 }
 
 void draw_context::draw_rect(rect r)
 {
-    SDL_RenderDrawRect(_renderer, &r);
+    frame_rect(r);
+}
+
+void draw_context::draw_rect_blended(rect r, SDL_Color c)
+{
+    set_blend_mode(SDL_BLENDMODE_BLEND);
+    set_draw_color(c);
+    fill_rect(r);
+    set_blend_mode(SDL_BLENDMODE_NONE);
+}
+
+std::size_t draw_context::copy_count() const
+{
+    return _copy_count;
 }
 
 void draw_context::blit(SDL_Surface * s, const rect * srcrect, const rect * dstrect)
 {
-    // TODO inefficient
-    SDL_Texture * tex = SDL_CreateTextureFromSurface(_renderer, s);
-    //SDL_RenderCopyEx(_renderer, tex, srcrect, dstrect, 0, nullptr, SDL_FLIP_NONE);
-    SDL_RenderCopy(_renderer, tex, srcrect, dstrect);
-    SDL_DestroyTexture(tex);
+    rect const dst = dstrect == nullptr ? origin_rect({ s->w, s->h }) : *dstrect;
+    // Uploading is not necessary if the backend blits the surface itself.
+    SDL_Texture * t = _backend->needs_pixels() ? nullptr : surface_texture(s);
+    copy({ t, nullptr, s }, srcrect, dst, std::nullopt);
 }
 
-void draw_context::draw_button_box(rect box, bool activated, bool selected)
+void draw_context::invalidate_surface(SDL_Surface * s)
+{
+    auto it = _surface_textures.find(s);
+    if (it != _surface_textures.end())
+        it->second.dirty = true;
+}
+
+void draw_context::forget_surface(SDL_Surface * s)
+{
+    _surface_textures.erase(s);
+}
+
+SDL_Texture * draw_context::surface_texture(SDL_Surface * s)
+{
+    auto & e = _surface_textures[s];
+    e.frame = _frame;
+
+    bool const same_layout = e.texture && e.size.w == s->w && e.size.h == s->h;
+    if (same_layout && !e.dirty && e.pixels == s->pixels)
+        return e.texture.get();
+
+    LIBWTK_SDL2_TRACE_SCOPE("upload", "upload_surface");
+
+    if (!same_layout)
+    {
+        e.texture.reset(SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, s->w, s->h));
+        if (!e.texture)
+            throw std::runtime_error(std::string("could not create texture for surface: ") + SDL_GetError());
+
+        if (SDL_SetTextureBlendMode(e.texture.get(), SDL_BLENDMODE_BLEND) < 0)
+            throw std::runtime_error(SDL_GetError());
+
+        e.size = { s->w, s->h };
+    }
+
+    // Reuse the texture, only the pixels are uploaded again.
+    unique_surface_ptr converted;
+    SDL_Surface * source = s;
+    if (s->format->format != SDL_PIXELFORMAT_ARGB8888)
+    {
+        converted.reset(SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0));
+        if (!converted)
+            throw std::runtime_error(std::string("could not convert surface: ") + SDL_GetError());
+        source = converted.get();
+    }
+
+    if (SDL_MUSTLOCK(source))
+        SDL_LockSurface(source);
+    int const result = SDL_UpdateTexture(e.texture.get(), nullptr, source->pixels, source->pitch);
+    if (SDL_MUSTLOCK(source))
+        SDL_UnlockSurface(source);
+
+    if (result < 0)
+        throw std::runtime_error(std::string("could not update texture for surface: ") + SDL_GetError());
+
+    e.pixels = s->pixels;
+    e.dirty = false;
+    return e.texture.get();
+}
+
+void draw_context::trim_surface_textures()
+{
+    if (!_surface_memory_limit.has_value())
+        return;
+
+    std::size_t const limit = _surface_memory_limit.value();
+    std::size_t bytes = resident_bytes();
+    while (bytes > limit)
+    {
+        auto oldest = _surface_textures.end();
+        for (auto it = _surface_textures.begin(); it != _surface_textures.end(); ++it)
+        {
+            // The texture might still be drawn by batched copies.
+            if (it->second.frame != _frame && (oldest == _surface_textures.end() || it->second.frame < oldest->second.frame))
+                oldest = it;
+        }
+        if (oldest == _surface_textures.end())
+            break;
+
+        if (oldest->second.texture)
+            bytes -= static_cast<std::size_t>(oldest->second.size.w) * oldest->second.size.h * 4;
+        _surface_textures.erase(oldest);
+    }
+}
+
+std::size_t draw_context::resident_bytes() const
+{
+    std::size_t result = 0;
+    for (auto const & p : _surface_textures)
+    {
+        if (p.second.texture)
+            result += static_cast<std::size_t>(p.second.size.w) * p.second.size.h * 4;
+    }
+    return result;
+}
+
+void draw_context::set_memory_limit(std::optional<std::size_t> bytes)
+{
+    _surface_memory_limit = bytes;
+    trim_surface_textures();
+}
+
+void draw_context::reset_textures()
+{
+    _surface_textures.clear();
+
+    // Sprites are rendered again with the next box.
+    _sprites.clear();
+    _sprite_texture.reset();
+}
+
+void draw_context::set_theme(std::shared_ptr<theme const> t)
+{
+    _theme = std::move(t);
+    _sprites.clear();
+    _sprite_texture.reset();
+    _sprite_surface.reset();
+}
+
+theme const & draw_context::get_theme() const
 {
-    set_color(activated ? _theme.button_pressed_bg_color : (selected ? _theme.button_selected_bg_color : _theme.button_bg_color));
-    SDL_RenderFillRect(_renderer, &box);
-    set_color(_theme.button_frame_color);
-    SDL_RenderDrawRect(_renderer, &box);
+    return *_theme;
 }
 
-void set_texture_color_mod(SDL_Texture * t, SDL_Color c)
+color_theme const & draw_context::colors() const
 {
-    Uint8 r, g, b;
-    if (SDL_GetTextureColorMod(t, &r, &g, &b) < 0)
-        throw std::runtime_error(SDL_GetError());
+    return _theme->colors();
+}
+
+// Keeps linear filtering of stretched slices from picking up neighbours.
+int const SPRITE_SPACING = 1;
+
+void draw_context::render_sprites()
+{
+    LIBWTK_SDL2_TRACE_SCOPE("draw", "render_sprites");
+
+    // Sprites are placed in a row, each type in its own column.
+    _sprites.clear();
+    vec size { 0, 0 };
+    for (int bt = 0; bt < BOX_TYPE_COUNT; ++bt)
+    {
+        int const side = 2 * _theme->border_width(static_cast<box_type>(bt)) + 1;
+        for (int bs = 0; bs < BOX_STATE_COUNT; ++bs)
+            _sprites.push_back({ size.w, bs * (side + SPRITE_SPACING), side, side });
+        size.w += side + SPRITE_SPACING;
+        size.h = std::max(size.h, BOX_STATE_COUNT * (side + SPRITE_SPACING));
+    }
+
+    _sprite_surface.reset(SDL_CreateRGBSurfaceWithFormat(0, size.w, size.h, 32, SDL_PIXELFORMAT_ARGB8888));
+    if (!_sprite_surface)
+        throw std::runtime_error(std::string("could not create sprites: ") + SDL_GetError());
+    SDL_FillRect(_sprite_surface.get(), nullptr, 0);
+    SDL_SetSurfaceBlendMode(_sprite_surface.get(), SDL_BLENDMODE_BLEND);
+
+    for (int bt = 0; bt < BOX_TYPE_COUNT; ++bt)
+    {
+        for (int bs = 0; bs < BOX_STATE_COUNT; ++bs)
+            _theme->render_box(static_cast<box_type>(bt), static_cast<box_state>(bs), _sprite_surface.get(), _sprites[bt * BOX_STATE_COUNT + bs]);
+    }
+
+    if (!_backend->needs_pixels())
+    {
+        _sprite_texture = create_texture(_sprite_surface.get());
+        SDL_SetTextureBlendMode(_sprite_texture.get(), SDL_BLENDMODE_BLEND);
+    }
+}
+
+// Splits a length into the part before, in between and after the stretched
+// center. Borders shrink if the box is too small.
+void nine_slice_spans(int pos, int length, int border, int (&starts)[3], int (&lengths)[3])
+{
+    int const b = std::min(border, length / 2);
+    starts[0] = pos;
+    lengths[0] = b;
+    starts[1] = pos + b;
+    lengths[1] = length - 2 * b;
+    starts[2] = pos + length - b;
+    lengths[2] = b;
+}
+
+void draw_context::draw_box(box_type bt, box_state s, rect box)
+{
+    if (box.w <= 0 || box.h <= 0)
+        return;
+
+    if (_sprites.empty())
+        render_sprites();
+
+    rect const & sprite = _sprites[static_cast<int>(bt) * BOX_STATE_COUNT + static_cast<int>(s)];
+    int const border = (sprite.w - 1) / 2;
+
+    int src_x[3], src_w[3], src_y[3], src_h[3];
+    nine_slice_spans(sprite.x, sprite.w, border, src_x, src_w);
+    nine_slice_spans(sprite.y, sprite.h, border, src_y, src_h);
+
+    int dst_x[3], dst_w[3], dst_y[3], dst_h[3];
+    nine_slice_spans(box.x, box.w, border, dst_x, dst_w);
+    nine_slice_spans(box.y, box.h, border, dst_y, dst_h);
+
+    // A box smaller than the corners shows their outer parts.
+    for (int k : { 0, 2 })
+    {
+        if (dst_w[k] < border)
+        {
+            if (k == 2)
+                src_x[k] += border - dst_w[k];
+            src_w[k] = dst_w[k];
+        }
+        if (dst_h[k] < border)
+        {
+            if (k == 2)
+                src_y[k] += border - dst_h[k];
+            src_h[k] = dst_h[k];
+        }
+    }
+
+    texture_ref const t { _sprite_texture.get(), nullptr, _sprite_surface.get() };
+    SDL_Color const white { 255, 255, 255, 255 };
+
+    _quads.clear();
+    for (int j = 0; j < 3; ++j)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (dst_w[i] <= 0 || dst_h[j] <= 0)
+                continue;
+
+            rect const source { src_x[i], src_y[j], src_w[i], src_h[j] };
+            rect const target { dst_x[i], dst_y[j], dst_w[i], dst_h[j] };
+            if (_recording != nullptr)
+                copy(t, &source, target, white);
+            else
+                _quads.push_back({ source, translated_target(target), nullptr });
+        }
+    }
+
+    if (!_quads.empty())
+    {
+        _copy_count += _quads.size();
+        _backend->copy_quads(translated_state(), t, _quads.data(), _quads.size(), white);
+    }
+}
 
-    if (r != c.r || g != c.g || b != c.b)
-        SDL_SetTextureColorMod(t, c.r, c.g, c.b);
+void draw_context::draw_button_box(rect box, bool activated, bool selected)
+{
+    draw_box(box_type::BUTTON, make_box_state(activated, selected), box);
 }
 
 void draw_context::run_copy_commands(std::vector<copy_command> const & commands, point origin, SDL_Color color)
 {
-    for (auto const & c : commands)
+    if (_recording != nullptr)
     {
-        set_texture_color_mod(c.texture, color);
-        vec size = texture_dim(c.texture);
-        rect target { origin.x + c.x_offset, origin.y + c.y_offset, size.w, size.h };
-        SDL_RenderCopy(_renderer, c.texture, &c.source, &target);
+        // Recorded copies carry their color each.
+        for (auto const & c : commands)
+        {
+            rect target { origin.x + c.x_offset, origin.y + c.y_offset, c.size.w, c.size.h };
+            copy({ c.texture, c.alpha, nullptr }, &c.source, target, color);
+        }
+        return;
+    }
+
+    // Consecutive words on the same atlas page are drawn at once.
+    render_state const state = translated_state();
+    for (std::size_t begin = 0; begin < commands.size();)
+    {
+        SDL_Texture * const t = commands[begin].texture;
+
+        _quads.clear();
+        std::size_t end = begin;
+        for (; end < commands.size() && commands[end].texture == t; ++end)
+        {
+            auto const & c = commands[end];
+            rect const target { origin.x + c.x_offset, origin.y + c.y_offset, c.size.w, c.size.h };
+            _quads.push_back({ c.source, translated_target(target), c.alpha });
+        }
+
+        _copy_count += _quads.size();
+        _backend->copy_quads(state, { t, nullptr, nullptr }, _quads.data(), _quads.size(), color);
+        begin = end;
     }
 }
 
 void draw_context::copy_texture(SDL_Texture * t, rect src, rect dst)
 {
-    SDL_RenderCopy(_renderer, t, &src, &dst);
+    copy({ t, nullptr, nullptr }, &src, dst, std::nullopt);
 }
 
 void draw_context::copy_texture(SDL_Texture * t, rect dst)
 {
-    SDL_RenderCopy(_renderer, t, nullptr, &dst);
+    copy({ t, nullptr, nullptr }, nullptr, dst, std::nullopt);
+}
+
+void draw_context::draw_button_text(std::string_view text, rect abs_rect)
+{
+    draw_button_layout(_fm.text(text), abs_rect);
+}
+
+void draw_context::draw_button_text(interned_text const & text, rect abs_rect)
+{
+    draw_button_layout(_fm.text(text), abs_rect);
 }
 
-void draw_context::draw_button_text(std::string const & text, rect abs_rect)
+void draw_context::draw_button_layout(std::tuple<vec, std::vector<copy_command>> const & result, rect abs_rect)
 {
-    auto result = _fm.text(text);
     vec const & size = std::get<0>(result);
 
     // center text in abs_rect
     point origin { abs_rect.x + (abs_rect.w - size.w) / 2, abs_rect.y + (abs_rect.h - size.h) / 2 };
 
     //blit(text_surf_ptr.get(), nullptr, &target_rect);
-    run_copy_commands(std::get<1>(result), origin, _theme.button_fg_color);
+    run_copy_commands(std::get<1>(result), origin, colors().button_fg_color);
 }
 
 void draw_context::draw_entry_box(rect box, bool selected)
 {
-    set_color(_theme.entry_box_bg_color);
-    SDL_RenderFillRect(_renderer, &box);
-    set_color(selected ? _theme.entry_box_selected_frame_color : _theme.entry_box_frame_color);
-    SDL_RenderDrawRect(_renderer, &box);
+    draw_box(box_type::ENTRY, make_box_state(false, selected), box);
 }
 
-void draw_context::draw_entry_text(std::string text, rect abs_rect, int texture_x_offset, int texture_y_offset)
+void draw_context::draw_entry_text(std::string_view text, rect abs_rect, int texture_x_offset, int texture_y_offset)
 {
     int const remaining_w = abs_rect.w - std::max(0, texture_x_offset);
     int const remaining_h = abs_rect.h - std::max(0, texture_y_offset);
@@ -118,67 +745,88 @@ void draw_context::draw_entry_text(std::string text, rect abs_rect, int texture_
     // Probably only useful to avoid text rendering.
     if (remaining_w >= 0 && remaining_h >= 0)
     {
-        auto result = _fm.text(text);
+        auto const & result = _fm.text(text);
 
         // Set clipping such that nothing gets drawn outside of the specified box.
-        SDL_RenderSetClipRect(_renderer, &abs_rect);
+        set_clip(&abs_rect);
         // Use a viewport to translate relative texture coordinates to the box.
-        SDL_RenderSetViewport(_renderer, &abs_rect);
-        run_copy_commands(std::get<1>(result), { texture_x_offset, texture_y_offset }, { 0, 0, 0 });
-        SDL_RenderSetViewport(_renderer, nullptr);
-        SDL_RenderSetClipRect(_renderer, nullptr);
+        set_viewport(&abs_rect);
+        run_copy_commands(std::get<1>(result), { texture_x_offset, texture_y_offset }, colors().entry_fg_color);
+        set_viewport(nullptr);
+        set_clip(nullptr);
     }
 }
 
-int draw_context::draw_label_text(rect box, std::string text, bool wrap, int font_idx)
+int draw_context::draw_label_text(rect box, std::string_view text, bool wrap, int font_idx)
+{
+    return draw_label_layout(_fm.text(text, wrap ? box.w : -1, font_idx), box);
+}
+
+int draw_context::draw_label_text(rect box, interned_text const & text, bool wrap, int font_idx)
+{
+    return draw_label_layout(_fm.text(text, wrap ? box.w : -1, font_idx), box);
+}
+
+void draw_context::draw_text_line(point origin, rect clip_box, std::string_view text, int font_idx)
+{
+    auto const & result = _fm.text(text, -1, font_idx);
+
+    set_clip(&clip_box);
+    run_copy_commands(std::get<1>(result), origin, colors().fg_color);
+    set_clip(nullptr);
+}
+
+int draw_context::draw_label_layout(std::tuple<vec, std::vector<copy_command>> const & result, rect box)
 {
-    auto result = _fm.text(text, wrap ? box.w : -1, font_idx);
     vec const & size = std::get<0>(result);
 
     point origin { box.x, box.y };
 
     // TODO fade effect when clipped?
 
-    set_color({0, 0, 0});
-    draw_rect_filled(box);
-
-    SDL_RenderSetClipRect(_renderer, &box);
-    run_copy_commands(std::get<1>(result), origin, { 255, 255, 255});
-    SDL_RenderSetClipRect(_renderer, nullptr);
+    set_clip(&box);
+    run_copy_commands(std::get<1>(result), origin, colors().fg_color);
+    set_clip(nullptr);
     return size.h;
 }
 
 void draw_context::draw_background(rect box)
 {
-    set_color(_theme.bg_color);
-    SDL_RenderFillRect(_renderer, &box);
+    set_color(colors().bg_color);
+    fill_rect(box);
+}
+
+void draw_context::draw_entry_background(rect box)
+{
+    set_color(colors().entry_box_bg_color);
+    fill_rect(box);
 }
 
 void draw_context::draw_entry_pressed_background(rect box)
 {
-    set_color(_theme.entry_selected_bg_color);
-    SDL_RenderFillRect(_renderer, &box);
+    set_color(colors().entry_selected_bg_color);
+    fill_rect(box);
 }
 
 void draw_context::draw_entry_active_background(rect box)
 {
-    set_color(_theme.active_color);
-    SDL_RenderFillRect(_renderer, &box);
+    set_color(colors().active_color);
+    fill_rect(box);
 }
 
 void draw_context::draw_entry_hightlighted_background(rect box)
 {
-    set_color(_theme.entry_highlight_bg_color);
-    SDL_RenderFillRect(_renderer, &box);
+    set_color(colors().entry_highlight_bg_color);
+    fill_rect(box);
 }
 
 void draw_context::draw_entry_position_indicator(rect box)
 {
-    SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(_renderer, 150, 250, 150, 200);
+    set_blend_mode(SDL_BLENDMODE_BLEND);
+    set_draw_color({150, 250, 150, 200});
 
-    SDL_RenderFillRect(_renderer, &box);
-    SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_NONE);
+    fill_rect(box);
+    set_blend_mode(SDL_BLENDMODE_NONE);
 }
 
 void draw_context::draw_radio_entry(rect box, bool active, bool selected)
@@ -188,17 +836,17 @@ void draw_context::draw_radio_entry(rect box, bool active, bool selected)
     {
         // TODO draw active with circle instead of rectangle
         rect mark_rect = center_vec_within_rect(length(box) / 2, box);
-        set_color({0, 0, 0});
-        SDL_RenderFillRect(_renderer, &mark_rect);
+        draw_box(box_type::RADIO_MARK, box_state::IDLE, mark_rect);
     }
 }
 
 void draw_context::set_color(SDL_Color c)
 {
-    SDL_SetRenderDrawColor(_renderer, c.r, c.g, c.b, 0);
+    // Opaque, such that render target textures keep what has been drawn.
+    set_draw_color({ c.r, c.g, c.b, 255 });
 }
 
 void draw_context::set_color_alpha(SDL_Color c)
 {
-    SDL_SetRenderDrawColor(_renderer, c.r, c.g, c.b, c.a);
+    set_draw_color(c);
 }
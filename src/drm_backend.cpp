@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+#include "drm_backend.hpp"
+
+std::runtime_error drm_error(std::string what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Finds a CRTC that can drive the connector, preferably the current one.
+uint32_t find_crtc(int fd, drmModeRes const * res, drmModeConnector const * conn)
+{
+    if (conn->encoder_id != 0)
+    {
+        std::unique_ptr<drmModeEncoder, decltype(&drmModeFreeEncoder)> enc(drmModeGetEncoder(fd, conn->encoder_id), drmModeFreeEncoder);
+        if (enc && enc->crtc_id != 0)
+            return enc->crtc_id;
+    }
+
+    for (int i = 0; i < conn->count_encoders; ++i)
+    {
+        std::unique_ptr<drmModeEncoder, decltype(&drmModeFreeEncoder)> enc(drmModeGetEncoder(fd, conn->encoders[i]), drmModeFreeEncoder);
+        if (!enc)
+            continue;
+
+        for (int j = 0; j < res->count_crtcs; ++j)
+        {
+            if (enc->possible_crtcs & (1u << j))
+                return res->crtcs[j];
+        }
+    }
+
+    return 0;
+}
+
+drm_backend::drm_backend(std::string device)
+    : _fd(-1)
+    , _connector_id(0)
+    , _crtc_id(0)
+    , _saved_crtc(nullptr)
+    , _size{ 0, 0 }
+    , _buffers{}
+    , _back(1)
+    , _flip_pending(false)
+{
+    try
+    {
+        init(device);
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+}
+
+drm_backend::~drm_backend()
+{
+    release();
+}
+
+void drm_backend::init(std::string const & device)
+{
+    _fd = open(device.c_str(), O_RDWR | O_CLOEXEC);
+    if (_fd < 0)
+        throw drm_error("could not open " + device);
+
+    uint64_t has_dumb = 0;
+    if (drmGetCap(_fd, DRM_CAP_DUMB_BUFFER, &has_dumb) < 0 || has_dumb == 0)
+        throw std::runtime_error("DRM device does not support dumb buffers");
+
+    std::unique_ptr<drmModeRes, decltype(&drmModeFreeResources)> res(drmModeGetResources(_fd), drmModeFreeResources);
+    if (!res)
+        throw drm_error("could not get DRM resources");
+
+    drmModeModeInfo mode;
+    for (int i = 0; i < res->count_connectors && _crtc_id == 0; ++i)
+    {
+        std::unique_ptr<drmModeConnector, decltype(&drmModeFreeConnector)> conn(drmModeGetConnector(_fd, res->connectors[i]), drmModeFreeConnector);
+        if (!conn || conn->connection != DRM_MODE_CONNECTED || conn->count_modes == 0)
+            continue;
+
+        uint32_t const crtc_id = find_crtc(_fd, res.get(), conn.get());
+        if (crtc_id == 0)
+            continue;
+
+        // The preferred mode is usually the first one.
+        mode = conn->modes[0];
+        for (int m = 0; m < conn->count_modes; ++m)
+        {
+            if (conn->modes[m].type & DRM_MODE_TYPE_PREFERRED)
+            {
+                mode = conn->modes[m];
+                break;
+            }
+        }
+
+        _connector_id = conn->connector_id;
+        _crtc_id = crtc_id;
+    }
+
+    if (_crtc_id == 0)
+        throw std::runtime_error("no connected display found on " + device);
+
+    _size = { mode.hdisplay, mode.vdisplay };
+    for (buffer & b : _buffers)
+        create_buffer(b);
+
+    _saved_crtc = drmModeGetCrtc(_fd, _crtc_id);
+    if (drmModeSetCrtc(_fd, _crtc_id, _buffers[0].fb_id, 0, 0, &_connector_id, 1, &mode) < 0)
+        throw drm_error("could not set mode");
+
+    set_framebuffer(_buffers[_back].surface.get());
+}
+
+void drm_backend::release()
+{
+    if (_fd < 0)
+        return;
+
+    // Buffers must not be destroyed while they are shown.
+    if (_flip_pending)
+    {
+        try
+        {
+            wait_for_flip();
+        }
+        catch (std::exception const &)
+        {
+        }
+    }
+
+    if (_saved_crtc != nullptr)
+    {
+        drmModeSetCrtc(_fd, _saved_crtc->crtc_id, _saved_crtc->buffer_id, _saved_crtc->x, _saved_crtc->y, &_connector_id, 1, &_saved_crtc->mode);
+        drmModeFreeCrtc(_saved_crtc);
+        _saved_crtc = nullptr;
+    }
+
+    for (buffer & b : _buffers)
+        destroy_buffer(b);
+
+    close(_fd);
+    _fd = -1;
+}
+
+void drm_backend::create_buffer(buffer & b)
+{
+    drm_mode_create_dumb creq {};
+    creq.width = _size.w;
+    creq.height = _size.h;
+    creq.bpp = 32;
+    if (drmIoctl(_fd, DRM_IOCTL_MODE_CREATE_DUMB, &creq) < 0)
+        throw drm_error("could not create dumb buffer");
+
+    b.handle = creq.handle;
+    b.pitch = creq.pitch;
+    b.size = creq.size;
+
+    if (drmModeAddFB(_fd, _size.w, _size.h, 24, 32, b.pitch, b.handle, &b.fb_id) < 0)
+        throw drm_error("could not add framebuffer");
+
+    drm_mode_map_dumb mreq {};
+    mreq.handle = b.handle;
+    if (drmIoctl(_fd, DRM_IOCTL_MODE_MAP_DUMB, &mreq) < 0)
+        throw drm_error("could not map dumb buffer");
+
+    void * map = mmap(nullptr, b.size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, mreq.offset);
+    if (map == MAP_FAILED)
+        throw drm_error("could not map dumb buffer");
+
+    b.map = static_cast<uint8_t *>(map);
+    std::memset(b.map, 0, b.size);
+
+    b.surface.reset(SDL_CreateRGBSurfaceWithFormatFrom(b.map, _size.w, _size.h, 32, b.pitch, SDL_PIXELFORMAT_RGB888));
+    if (!b.surface)
+        throw std::runtime_error(std::string("could not create surface for dumb buffer: ") + SDL_GetError());
+}
+
+void drm_backend::destroy_buffer(buffer & b)
+{
+    b.surface.reset();
+
+    if (b.map != nullptr)
+    {
+        munmap(b.map, b.size);
+        b.map = nullptr;
+    }
+
+    if (b.fb_id != 0)
+    {
+        drmModeRmFB(_fd, b.fb_id);
+        b.fb_id = 0;
+    }
+
+    if (b.handle != 0)
+    {
+        drm_mode_destroy_dumb dreq {};
+        dreq.handle = b.handle;
+        drmIoctl(_fd, DRM_IOCTL_MODE_DESTROY_DUMB, &dreq);
+        b.handle = 0;
+    }
+}
+
+void drm_backend::wait_for_flip()
+{
+    drmEventContext ev {};
+    ev.version = 2;
+    ev.page_flip_handler = [](int, unsigned int, unsigned int, unsigned int, void * data)
+    {
+        static_cast<drm_backend *>(data)->_flip_pending = false;
+    };
+
+    while (_flip_pending)
+    {
+        pollfd p { _fd, POLLIN, 0 };
+        if (poll(&p, 1, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw drm_error("could not wait for page flip");
+        }
+
+        if (drmHandleEvent(_fd, &ev) < 0)
+            throw drm_error("could not handle DRM event");
+    }
+}
+
+void drm_backend::present(damage_region const * damage)
+{
+    software_backend::present(damage);
+
+    // Nothing to show.
+    if (damage != nullptr && damage->empty())
+        return;
+
+    buffer const & shown = _buffers[_back];
+    if (drmModePageFlip(_fd, _crtc_id, shown.fb_id, DRM_MODE_PAGE_FLIP_EVENT, this) < 0)
+        throw drm_error("could not flip page");
+
+    // The previous buffer is scanned out until the flip happens.
+    _flip_pending = true;
+    wait_for_flip();
+
+    // The new back buffer is one frame behind, copy what has changed instead
+    // of drawing it again.
+    _back = 1 - _back;
+    buffer & next = _buffers[_back];
+    if (damage == nullptr)
+    {
+        std::memcpy(next.map, shown.map, std::min(next.size, shown.size));
+    }
+    else
+    {
+        rect const screen { 0, 0, _size.w, _size.h };
+        for (rect r : damage->rects())
+        {
+            if (SDL_IntersectRect(&r, &screen, &r) != SDL_TRUE)
+                continue;
+
+            for (int y = r.y; y < r.y + r.h; ++y)
+            {
+                std::size_t const offset = static_cast<std::size_t>(y) * shown.pitch + static_cast<std::size_t>(r.x) * 4;
+                std::memcpy(next.map + offset, shown.map + offset, static_cast<std::size_t>(r.w) * 4);
+            }
+        }
+    }
+
+    set_framebuffer(next.surface.get());
+}
+
+vec drm_backend::size() const
+{
+    return _size;
+}
+
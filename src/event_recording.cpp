@@ -0,0 +1,219 @@
+#include <cstring>
+#include <stdexcept>
+
+#include <SDL2/SDL_timer.h>
+#include <SDL2/SDL_version.h>
+
+#include "event_recording.hpp"
+#include "widget_context.hpp"
+
+// Changes whenever the layout of the file changes.
+uint32_t const FORMAT_VERSION = 1;
+
+// Detects files written on a machine with a different byte order.
+uint32_t const BYTE_ORDER_MARK = 0x01020304;
+
+char const MAGIC[8] = { 'W', 'T', 'K', 'E', 'V', 'E', 'N', 'T' };
+
+// Used as the type of records that end a frame.
+uint32_t const FRAME_END = 0;
+
+uint16_t const FULL_REDRAW_FLAG = 1;
+
+struct event_file_header
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+
+    // Events are stored as they are in memory.
+    uint8_t sdl_major;
+    uint8_t sdl_minor;
+    uint8_t sdl_patch;
+    uint8_t reserved;
+};
+
+struct event_record_header
+{
+    uint32_t type;
+    uint32_t timestamp;
+    uint16_t size;
+    uint16_t flags;
+};
+
+// Only the part of the union that belongs to the type is stored. Returns
+// 0 for unsupported events.
+std::size_t event_payload_size(uint32_t type)
+{
+    switch (type)
+    {
+        case SDL_KEYDOWN:
+        case SDL_KEYUP:
+            return sizeof(SDL_KeyboardEvent);
+        case SDL_TEXTINPUT:
+            return sizeof(SDL_TextInputEvent);
+        case SDL_MOUSEMOTION:
+            return sizeof(SDL_MouseMotionEvent);
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            return sizeof(SDL_MouseButtonEvent);
+        case SDL_MOUSEWHEEL:
+            return sizeof(SDL_MouseWheelEvent);
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION:
+            return sizeof(SDL_TouchFingerEvent);
+        case SDL_WINDOWEVENT:
+            return sizeof(SDL_WindowEvent);
+        case SDL_QUIT:
+            return sizeof(SDL_QuitEvent);
+        default:
+            return 0;
+    }
+}
+
+event_recorder::event_recorder(std::string path)
+    : _out(path, std::ios::binary | std::ios::trunc)
+    , _start_ticks(SDL_GetTicks())
+{
+    if (!_out)
+        throw std::runtime_error("could not create event recording " + path);
+
+    SDL_version v;
+    SDL_GetVersion(&v);
+
+    event_file_header h;
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.byte_order = BYTE_ORDER_MARK;
+    h.version = FORMAT_VERSION;
+    h.sdl_major = v.major;
+    h.sdl_minor = v.minor;
+    h.sdl_patch = v.patch;
+    h.reserved = 0;
+    _out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+}
+
+void event_recorder::add(SDL_Event const & ev)
+{
+    std::size_t const size = event_payload_size(ev.type);
+    if (size != 0)
+        write(ev.type, 0, &ev, size);
+}
+
+void event_recorder::end_frame(bool full_redraw)
+{
+    write(FRAME_END, full_redraw ? FULL_REDRAW_FLAG : 0, nullptr, 0);
+}
+
+void event_recorder::finish()
+{
+    _out.flush();
+    if (!_out)
+        throw std::runtime_error("could not write event recording");
+}
+
+void event_recorder::write(uint32_t type, uint16_t flags, void const * payload, std::size_t size)
+{
+    event_record_header rh { type, SDL_GetTicks() - _start_ticks, static_cast<uint16_t>(size), flags };
+    _out.write(reinterpret_cast<char const *>(&rh), sizeof(rh));
+    _out.write(static_cast<char const *>(payload), size);
+}
+
+event_reader::event_reader(std::string const & path)
+    : _file(path)
+    , _ptr(_file.data())
+    , _end(_file.data() + _file.size())
+{
+    SDL_version v;
+    SDL_GetVersion(&v);
+
+    event_file_header h;
+    if (_file.data() == nullptr || _file.size() < sizeof(h))
+    {
+        _ptr = _end;
+        return;
+    }
+
+    std::memcpy(&h, _ptr, sizeof(h));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+        && h.byte_order == BYTE_ORDER_MARK
+        && h.version == FORMAT_VERSION
+        && h.sdl_major == v.major
+        && h.sdl_minor == v.minor
+        && h.sdl_patch == v.patch)
+    {
+        _ptr += sizeof(h);
+    }
+    else
+    {
+        _ptr = _end;
+    }
+}
+
+bool event_reader::next(recorded_event & e)
+{
+    event_record_header rh;
+    while (static_cast<std::size_t>(_end - _ptr) >= sizeof(rh))
+    {
+        std::memcpy(&rh, _ptr, sizeof(rh));
+
+        // Never trust the file, it might have been truncated.
+        if (static_cast<std::size_t>(_end - _ptr) < sizeof(rh) + rh.size)
+            break;
+
+        uint8_t const * payload = _ptr + sizeof(rh);
+        _ptr = payload + rh.size;
+
+        e.timestamp = rh.timestamp;
+        e.frame_end = rh.type == FRAME_END;
+        e.full_redraw = rh.flags & FULL_REDRAW_FLAG;
+        std::memset(&e.event, 0, sizeof(e.event));
+
+        if (e.frame_end)
+            return true;
+
+        if (rh.size == event_payload_size(rh.type))
+        {
+            std::memcpy(&e.event, payload, rh.size);
+            return true;
+        }
+    }
+
+    _ptr = _end;
+    return false;
+}
+
+std::vector<replay_frame> replay_events(widget_context & ctx, std::string const & path)
+{
+    std::vector<replay_frame> frames;
+
+    event_reader reader(path);
+    recorded_event e;
+    std::size_t events = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (reader.next(e))
+    {
+        if (e.frame_end)
+        {
+            if (e.full_redraw)
+                ctx.draw();
+            else
+                ctx.draw_dirty();
+
+            auto const now = std::chrono::steady_clock::now();
+            frames.push_back({ e.timestamp, events, now - start });
+            events = 0;
+            start = now;
+        }
+        else
+        {
+            // Window events that are handled by process_frame() are handled
+            // by process_event() as well.
+            ctx.process_event(e.event);
+            events++;
+        }
+    }
+
+    return frames;
+}
+
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <SDL2/SDL_events.h>
+
+#include "event_source.hpp"
+#include "navigation_type.hpp"
+#include "widget_context.hpp"
+
+event_source::~event_source()
+{
+}
+
+line_event_source::line_event_source(int fd, std::function<void(std::string_view, widget_context &)> handle_line)
+    : _fd(fd)
+    , _handle_line(std::move(handle_line))
+    , _filled(0)
+    , _dropping(false)
+{
+}
+
+line_event_source::~line_event_source()
+{
+    if (_fd >= 0)
+        close(_fd);
+}
+
+int line_event_source::fd() const
+{
+    return _fd;
+}
+
+void line_event_source::on_readable(widget_context & ctx)
+{
+    // Readable, so it does not block once.
+    ssize_t const n = read(_fd, _buffer.data() + _filled, _buffer.size() - _filled);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+
+    if (n <= 0)
+    {
+        // The end of the input or an error, nothing more will arrive.
+        close(_fd);
+        _fd = -1;
+        return;
+    }
+
+    _filled += n;
+
+    char * begin = _buffer.data();
+    char * const end = _buffer.data() + _filled;
+    while (true)
+    {
+        char * const newline = std::find(begin, end, '\n');
+        if (newline == end)
+            break;
+
+        std::string_view line(begin, newline - begin);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        if (!_dropping)
+            _handle_line(line, ctx);
+        _dropping = false;
+        begin = newline + 1;
+    }
+
+    _filled = end - begin;
+    if (_filled == _buffer.size())
+    {
+        // Too long, skip until the next line starts.
+        _dropping = true;
+        _filled = 0;
+    }
+    else
+    {
+        std::memmove(_buffer.data(), begin, _filled);
+    }
+}
+
+bool dispatch_navigation_command(std::string_view command, widget_context & ctx)
+{
+    if (command.substr(0, 4) == "KEY_")
+        command.remove_prefix(4);
+
+    if (command == "UP")
+        ctx.navigate_selection(navigation_type::PREV_Y);
+    else if (command == "DOWN")
+        ctx.navigate_selection(navigation_type::NEXT_Y);
+    else if (command == "LEFT")
+        ctx.navigate_selection(navigation_type::PREV_X);
+    else if (command == "RIGHT")
+        ctx.navigate_selection(navigation_type::NEXT_X);
+    else if (command == "NEXT")
+        ctx.navigate_selection(navigation_type::NEXT);
+    else if (command == "PREV")
+        ctx.navigate_selection(navigation_type::PREV);
+    else if (command == "OK" || command == "ENTER" || command == "SELECT")
+        ctx.activate();
+    else
+        return false;
+
+    return true;
+}
+
+std::string_view lirc_button(std::string_view line)
+{
+    // code, repeat count, button name, remote name
+    for (int field = 0; field < 2; ++field)
+    {
+        std::size_t const space = line.find(' ');
+        if (space == std::string_view::npos)
+            return {};
+        line.remove_prefix(space + 1);
+    }
+
+    return line.substr(0, line.find(' '));
+}
+
+event_source_watcher::event_source_watcher(uint32_t wakeup_event)
+    : _stop(false)
+    , _wakeup_event(wakeup_event)
+{
+    if (pipe(_pipe) != 0)
+        throw std::runtime_error(std::string("could not create pipe: ") + std::strerror(errno));
+
+    fcntl(_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(_pipe[1], F_SETFL, O_NONBLOCK);
+    _thread = std::thread(&event_source_watcher::run, this);
+}
+
+event_source_watcher::~event_source_watcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_one();
+    interrupt();
+    _thread.join();
+
+    close(_pipe[0]);
+    close(_pipe[1]);
+}
+
+void event_source_watcher::add(event_source & s)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sources.push_back(&s);
+    }
+    interrupt();
+}
+
+void event_source_watcher::remove(event_source & s)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _sources.erase(std::remove(_sources.begin(), _sources.end(), &s), _sources.end());
+        _ready.erase(std::remove(_ready.begin(), _ready.end(), &s), _ready.end());
+    }
+    interrupt();
+}
+
+bool event_source_watcher::dispatch(widget_context & ctx)
+{
+    std::vector<event_source *> ready;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ready = _ready;
+    }
+
+    if (ready.empty())
+        return false;
+
+    // The watching thread waits meanwhile. Sources might be removed by
+    // earlier ones.
+    for (event_source * s : ready)
+    {
+        if (std::find(_sources.begin(), _sources.end(), s) != _sources.end())
+            s->on_readable(ctx);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.clear();
+    }
+    _cv.notify_one();
+    return true;
+}
+
+void event_source_watcher::run()
+{
+    std::vector<pollfd> fds;
+    std::vector<event_source *> watched;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _cv.wait(lock, [this](){ return _stop || _ready.empty(); });
+        if (_stop)
+            break;
+
+        fds.clear();
+        fds.push_back({ _pipe[0], POLLIN, 0 });
+        watched = _sources;
+        for (event_source * s : watched)
+            fds.push_back({ s->fd(), POLLIN, 0 });
+
+        lock.unlock();
+        int const result = poll(fds.data(), fds.size(), -1);
+        lock.lock();
+
+        if (result < 0)
+            continue;
+
+        if (fds[0].revents & POLLIN)
+        {
+            char discard[64];
+            while (read(_pipe[0], discard, sizeof(discard)) > 0)
+            {
+            }
+        }
+
+        // Sources removed meanwhile are only compared, not accessed.
+        for (std::size_t k = 0; k < watched.size(); ++k)
+        {
+            bool const readable = fds[k + 1].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL);
+            if (readable && std::find(_sources.begin(), _sources.end(), watched[k]) != _sources.end())
+                _ready.push_back(watched[k]);
+        }
+
+        if (!_ready.empty() && _wakeup_event != static_cast<uint32_t>(-1))
+        {
+            SDL_Event ev;
+            SDL_zero(ev);
+            ev.type = _wakeup_event;
+            SDL_PushEvent(&ev);
+        }
+    }
+}
+
+void event_source_watcher::interrupt()
+{
+    char const c = 0;
+    if (write(_pipe[1], &c, 1) < 0)
+    {
+        // The pipe is full, the thread will wake up anyway.
+    }
+}
+
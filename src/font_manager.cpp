@@ -1,42 +1,430 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
 #include "font_manager.hpp"
 
+std::string persistent_cache_path(std::string const & directory, font const & f)
+{
+    return directory + "/" + std::to_string(std::hash<std::string>()(f.path)) + "-" + std::to_string(f.size) + ".words";
+}
+
 font_manager::font_manager(SDL_Renderer * renderer, std::vector<font> fonts)
     : _renderer(renderer)
+    , _registry(nullptr)
+    , _keep_alpha(false)
+{
+    for (font const & f : fonts)
+        load_font(f);
+}
+
+font_manager::font_manager(SDL_Renderer * renderer, std::vector<font> fonts, font_registry & registry)
+    : _renderer(renderer)
+    , _registry(&registry)
+    , _keep_alpha(false)
 {
     for (font const & f : fonts)
+        load_font(f);
+}
+
+font_manager::~font_manager()
+{
+    // Another user of a shared cache takes over.
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
     {
-        _font_word_caches.emplace_back(renderer, f);
+        if (!is_duplicate(k))
+            _font_word_caches[k]->release_owner(this);
     }
 }
 
+std::shared_ptr<font_word_cache> open_font_word_cache(SDL_Renderer * renderer, font_registry * registry, font const & f)
+{
+    if (registry != nullptr)
+        return registry->get(renderer, f);
+    else
+        return std::make_shared<font_word_cache>(renderer, f);
+}
+
 std::size_t font_manager::load_font(font f)
 {
-    _font_word_caches.emplace_back(_renderer, f);
-    return _font_word_caches.size() - 1;
+    _font_word_caches.emplace_back();
+    _open.emplace_back(false);
+    _opening.emplace_back();
+    _cache_indices.push_back(_fonts.size());
+    _fonts.push_back(f);
+    _scales.push_back(1);
+    return _fonts.size() - 1;
+}
+
+void font_manager::open_font_async(std::size_t font_idx)
+{
+    std::lock_guard<std::mutex> lock(_open_mutex);
+
+    std::size_t const k = _cache_indices.at(font_idx);
+    if (_font_word_caches[k] || _opening[k].valid())
+        return;
+
+    // Only opening the font happens on the thread, it is set up once it is
+    // used.
+    _opening[k] = std::async(std::launch::async, open_font_word_cache, _renderer, _registry, _fonts[k]);
+}
+
+bool font_manager::is_font_open(std::size_t font_idx) const
+{
+    return _open.at(font_idx).load(std::memory_order_acquire);
+}
+
+font_word_cache & font_manager::cache(std::size_t font_idx) const
+{
+    if (_open.at(font_idx).load(std::memory_order_acquire))
+        return *_font_word_caches[font_idx];
+
+    std::lock_guard<std::mutex> lock(_open_mutex);
+
+    // Scaled fonts use the cache of another font.
+    std::size_t const k = _cache_indices[font_idx];
+    if (!_font_word_caches[k])
+    {
+        auto fwc = _opening[k].valid() ? _opening[k].get() : open_font_word_cache(_renderer, _registry, _fonts[k]);
+        configure(*fwc, _fonts[k]);
+
+        for (std::size_t j = 0; j < _font_word_caches.size(); ++j)
+        {
+            if (_cache_indices[j] == k)
+            {
+                _font_word_caches[j] = fwc;
+                _open[j].store(true, std::memory_order_release);
+            }
+        }
+    }
+    return *_font_word_caches[font_idx];
+}
+
+void font_manager::configure(font_word_cache & fwc, font const & f) const
+{
+    owns_cache(fwc);
+    // Do not take away the threads of another user of a shared cache.
+    if (_pool)
+        fwc.set_thread_pool(_pool);
+    if (_persistent_cache_directory.has_value())
+        fwc.enable_persistent_cache(persistent_cache_path(_persistent_cache_directory.value(), f));
+    if (_keep_alpha)
+        fwc.set_keep_alpha(true);
+    if (_glyph_run_mode.has_value())
+        fwc.set_glyph_run_mode(_glyph_run_mode.value());
+    if (_render_deadline.has_value())
+        fwc.set_render_deadline(_render_deadline);
+}
+
+std::size_t font_manager::load_scaled_font(std::size_t font_idx, unsigned int size)
+{
+    // A scaled font may be scaled again, the scale is always relative to the
+    // loaded font whose words are drawn.
+    std::size_t const base = _cache_indices.at(font_idx);
+
+    // Everything else is set up once the font is opened.
+    font const f = _fonts[base];
+    _font_word_caches.push_back(_font_word_caches[base]);
+    _open.emplace_back(_font_word_caches.back() != nullptr);
+    _opening.emplace_back();
+    _cache_indices.push_back(base);
+    _fonts.push_back(f);
+    _scales.push_back(static_cast<double>(size) / f.size);
+    return _fonts.size() - 1;
+}
+
+void font_manager::set_cache_byte_budget(std::size_t bytes)
+{
+    _cache_byte_budget = bytes;
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
+    {
+        if (!is_duplicate(k))
+            owns_cache(*_font_word_caches[k]);
+    }
+}
+
+void font_manager::clear_caches()
+{
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
+    {
+        if (!is_duplicate(k))
+            _font_word_caches[k]->clear();
+    }
+}
+
+void font_manager::enable_async_rendering(std::size_t num_threads)
+{
+    if (_pool)
+        return;
+
+    _pool = std::make_shared<thread_pool>(num_threads);
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            fwc->set_thread_pool(_pool);
+    }
+}
+
+bool font_manager::upload_rendered_words()
+{
+    bool uploaded = false;
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            uploaded = fwc->upload_rendered_words() || uploaded;
+    }
+    return uploaded;
+}
+
+void font_manager::set_render_deadline(std::optional<std::chrono::steady_clock::time_point> deadline)
+{
+    _render_deadline = deadline;
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            fwc->set_render_deadline(deadline);
+    }
+}
+
+bool font_manager::take_deferred_words()
+{
+    bool deferred = false;
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            deferred = fwc->take_deferred_words() || deferred;
+    }
+    return deferred;
+}
+
+void font_manager::prewarm(std::vector<std::string> const & texts, int font_idx)
+{
+    cache(font_idx).prewarm(texts);
+}
+
+void font_manager::enable_persistent_cache(std::string directory)
+{
+    _persistent_cache_directory = directory;
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
+    {
+        if (!is_duplicate(k))
+            _font_word_caches[k]->enable_persistent_cache(persistent_cache_path(directory, _fonts[k]));
+    }
+}
+
+void font_manager::flush_persistent_cache()
+{
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            fwc->flush_persistent_cache();
+    }
+}
+
+void font_manager::set_keep_alpha(bool keep)
+{
+    _keep_alpha = keep;
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            fwc->set_keep_alpha(keep);
+    }
+}
+
+void font_manager::set_glyph_run_mode(glyph_run_mode mode)
+{
+    _glyph_run_mode = mode;
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            fwc->set_glyph_run_mode(mode);
+    }
+}
+
+void font_manager::set_glyph_run_mode(glyph_run_mode mode, int font_idx)
+{
+    cache(font_idx).set_glyph_run_mode(mode);
+}
+
+font_cache_stats font_manager::cache_stats() const
+{
+    font_cache_stats result {};
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
+    {
+        // The same font might be loaded more than once.
+        if (!is_duplicate(k))
+            result += _font_word_caches[k]->stats();
+    }
+    return result;
+}
+
+font_cache_stats font_manager::cache_stats(int font_idx) const
+{
+    auto const & fwc = _font_word_caches.at(font_idx);
+    return fwc ? fwc->stats() : font_cache_stats {};
+}
+
+void font_manager::reset_cache_stats()
+{
+    for (auto & fwc : _font_word_caches)
+    {
+        if (fwc)
+            fwc->reset_stats();
+    }
+}
+
+std::size_t font_manager::resident_bytes() const
+{
+    return cache_stats().bytes_resident;
+}
+
+void font_manager::set_memory_limit(std::optional<std::size_t> bytes)
+{
+    std::size_t remaining = bytes.value_or(0);
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
+    {
+        if (is_duplicate(k) || !owns_cache(*_font_word_caches[k]))
+            continue;
+
+        font_word_cache & fwc = *_font_word_caches[k];
+        if (bytes.has_value())
+        {
+            fwc.set_memory_limit(remaining);
+            remaining -= std::min(remaining, fwc.used_bytes());
+        }
+        else
+        {
+            fwc.set_memory_limit(std::nullopt);
+        }
+    }
+}
+
+void font_manager::end_frame()
+{
+    // A frame ends once for every cache, shared ones are ended by their
+    // owner.
+    for (std::size_t k = 0; k < _font_word_caches.size(); ++k)
+    {
+        if (!is_duplicate(k) && owns_cache(*_font_word_caches[k]))
+            _font_word_caches[k]->end_frame();
+    }
+}
+
+int scale_coordinate(int v, double scale)
+{
+    return static_cast<int>(std::lround(v * scale));
+}
+
+// Enough to contain the scaled text.
+int scale_size(int v, double scale)
+{
+    return static_cast<int>(std::ceil(v * scale));
+}
+
+std::tuple<vec, std::vector<copy_command>> const & font_manager::text(std::string_view t, int max_line_width, int font_idx)
+{
+    return forward_text(t, max_line_width, font_idx);
+}
+
+std::tuple<vec, std::vector<copy_command>> const & font_manager::text(interned_text const & t, int max_line_width, int font_idx)
+{
+    return forward_text(t, max_line_width, font_idx);
+}
+
+template <typename Text>
+std::tuple<vec, std::vector<copy_command>> const & font_manager::forward_text(Text const & t, int max_line_width, int font_idx)
+{
+    font_word_cache & fwc = cache(font_idx);
+    if (!is_scaled(font_idx))
+        return fwc.text(t, max_line_width);
+
+    double const scale = _scales[font_idx];
+    auto const & result = fwc.text(t, max_line_width == -1 ? -1 : static_cast<int>(max_line_width / scale));
+
+    vec const & size = std::get<0>(result);
+    std::get<0>(_scaled_text) = { scale_size(size.w, scale), scale_size(size.h, scale) };
+
+    auto & commands = std::get<1>(_scaled_text);
+    commands = std::get<1>(result);
+    for (auto & c : commands)
+    {
+        // Scaling the ends keeps adjacent glyphs from overlapping or leaving
+        // gaps.
+        int const x = scale_coordinate(c.x_offset, scale);
+        int const y = scale_coordinate(c.y_offset, scale);
+        c.size = { scale_coordinate(c.x_offset + c.size.w, scale) - x, scale_coordinate(c.y_offset + c.size.h, scale) - y };
+        c.x_offset = x;
+        c.y_offset = y;
+    }
+    return _scaled_text;
+}
+
+vec font_manager::text_size(std::string_view t, int max_line_width, int font_idx)
+{
+    return forward_text_size(t, max_line_width, font_idx);
 }
 
-std::tuple<vec, std::vector<copy_command>> font_manager::text(std::string t, int max_line_width, int font_idx)
+vec font_manager::text_size(interned_text const & t, int max_line_width, int font_idx)
 {
-    return _font_word_caches.at(font_idx).text(t, max_line_width);
+    return forward_text_size(t, max_line_width, font_idx);
 }
 
-vec font_manager::text_size(std::string t, int max_line_width, int font_idx)
+template <typename Text>
+vec font_manager::forward_text_size(Text const & t, int max_line_width, int font_idx)
 {
-    return _font_word_caches.at(font_idx).text_size(t, max_line_width);
+    font_word_cache & fwc = cache(font_idx);
+    if (!is_scaled(font_idx))
+        return fwc.text_size(t, max_line_width);
+
+    double const scale = _scales[font_idx];
+    vec const size = fwc.text_size(t, max_line_width == -1 ? -1 : static_cast<int>(max_line_width / scale));
+    return { scale_size(size.w, scale), scale_size(size.h, scale) };
 }
 
-int font_manager::text_minimum_width(std::string t, int font_idx)
+void font_manager::text_line_starts(std::string_view t, int max_line_width, std::vector<std::size_t> & starts, int font_idx)
 {
-    return _font_word_caches.at(font_idx).text_minimum_width(t);
+    double const scale = _scales.at(font_idx);
+    cache(font_idx).text_line_starts(t, max_line_width == -1 || scale == 1 ? max_line_width : static_cast<int>(max_line_width / scale), starts);
+}
+
+int font_manager::text_minimum_width(std::string_view t, int font_idx)
+{
+    return scale_size(cache(font_idx).text_minimum_width(t), _scales[font_idx]);
 }
 
 unsigned int font_manager::font_height(int font_idx) const
 {
-    return _font_word_caches.at(font_idx).font_height();
+    return scale_size(cache(font_idx).font_height(), _scales[font_idx]);
 }
 
 int font_manager::font_line_skip(int font_idx) const
 {
-    return _font_word_caches.at(font_idx).font_line_skip();
+    return scale_size(cache(font_idx).font_line_skip(), _scales[font_idx]);
+}
+
+bool font_manager::is_scaled(int font_idx) const
+{
+    return _scales.at(font_idx) != 1;
+}
+
+bool font_manager::is_duplicate(std::size_t font_idx) const
+{
+    if (!_font_word_caches[font_idx])
+        return true;
+
+    auto const begin = _font_word_caches.begin();
+    return std::find(begin, begin + font_idx, _font_word_caches[font_idx]) != begin + font_idx;
+}
+
+bool font_manager::owns_cache(font_word_cache & fwc) const
+{
+    if (!fwc.claim_owner(this))
+        return false;
+
+    // Also applies the budget when the cache was taken over from another
+    // manager.
+    if (_cache_byte_budget.has_value() && fwc.byte_budget() != _cache_byte_budget.value())
+        fwc.set_byte_budget(_cache_byte_budget.value());
+    return true;
 }
 
@@ -0,0 +1,33 @@
+#include "font_registry.hpp"
+
+font_registry::font_registry()
+{
+}
+
+std::shared_ptr<font_word_cache> font_registry::get(SDL_Renderer * renderer, font f)
+{
+    key_type key { renderer, f.path, f.size };
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _caches.find(key);
+    if (it != _caches.end())
+    {
+        if (auto cache = it->second.lock())
+            return cache;
+    }
+
+    // Remove caches that are not used anymore.
+    for (auto eit = _caches.begin(); eit != _caches.end();)
+    {
+        if (eit->second.expired())
+            eit = _caches.erase(eit);
+        else
+            ++eit;
+    }
+
+    auto cache = std::make_shared<font_word_cache>(renderer, f);
+    _caches[key] = cache;
+    return cache;
+}
+
@@ -1,6 +1,10 @@
 #include <algorithm>
+#include <iterator>
+
+#include <SDL2/SDL_events.h>
 
 #include "font_word_cache.hpp"
+#include "trace.hpp"
 #include "utf8.hpp"
 #include "sdl_util.hpp"
 
@@ -14,22 +18,87 @@ font_render_error::font_render_error(std::string msg)
 {
 }
 
+// Fonts of SDL_ttf share one FreeType library, whose faces may not be created
+// or destroyed concurrently. Fonts are opened by background threads as well,
+// see font_manager::open_font_async() and the threads that render words.
+std::mutex & ttf_mutex()
+{
+    static std::mutex m;
+    return m;
+}
+
+TTF_Font * open_ttf_font(font const & f)
+{
+    std::lock_guard<std::mutex> lock(ttf_mutex());
+    return TTF_OpenFont(f.path.c_str(), f.size);
+}
+
+void close_ttf_font(TTF_Font * f)
+{
+    std::lock_guard<std::mutex> lock(ttf_mutex());
+    TTF_CloseFont(f);
+}
+
+// Roughly 16000 average sized words.
+std::size_t const DEFAULT_BYTE_BUDGET = 64 * 1024 * 1024;
+
+// Number of text layouts that are kept.
+std::size_t const MAX_LAYOUTS = 4096;
+
+// Number of measured words that are kept.
+std::size_t const MAX_WORD_WIDTHS = 100000;
+
+font_cache_stats & font_cache_stats::operator+=(font_cache_stats const & other)
+{
+    hits += other.hits;
+    misses += other.misses;
+    evictions += other.evictions;
+    layout_hits += other.layout_hits;
+    layout_misses += other.layout_misses;
+    entries += other.entries;
+    bytes_resident += other.bytes_resident;
+    atlas_pages += other.atlas_pages;
+    render_time += other.render_time;
+    async_render_time += other.async_render_time;
+    return *this;
+}
+
 font_word_cache::font_word_cache(SDL_Renderer * renderer, font f)
     : _renderer(renderer)
+    , _byte_budget(DEFAULT_BYTE_BUDGET)
+    , _used_bytes(0)
+    , _frame(0)
+    , _owner(nullptr)
+    , _eviction_generation(0)
+    , _atlas(renderer)
+    , _font_desc(f)
+    , _font_hash(0)
+    , _glyph_run_mode(glyph_run_mode::NUMERIC)
+    , _keep_alpha(false)
+    , _inserted_since_deadline(false)
+    , _deferred_words(false)
+    , _stats()
 {
     // load font and generate glyphs
-    _font = TTF_OpenFont(f.path.c_str(), f.size);
+    _font = open_ttf_font(f);
 
     if (_font == nullptr)
         throw font_not_found(TTF_GetError());
 
     // cache join point metrics
     TTF_GlyphMetrics(_font, ' ', &_space_minx, nullptr, nullptr, nullptr, &_space_advance);
+
+    for (uint32_t c = 0; c < _latin_space_kerning.size(); ++c)
+        _latin_space_kerning[c] = { TTF_GetFontKerningSizeGlyphs(_font, ' ', c), TTF_GetFontKerningSizeGlyphs(_font, c, ' ') };
 }
 
 font_word_cache::~font_word_cache()
 {
-    TTF_CloseFont(_font);
+    if (_async)
+        _async->cancelled = true;
+
+    if (_font != nullptr)
+        close_ttf_font(_font);
 
     clear();
 }
@@ -37,162 +106,288 @@ font_word_cache::~font_word_cache()
 font_word_cache::font_word_cache(font_word_cache && other)
     : _renderer(other._renderer)
     , _prerendered(std::move(other._prerendered))
+    , _lru(std::move(other._lru))
+    , _word_widths(std::move(other._word_widths))
+    , _word_width_keys(std::move(other._word_width_keys))
+    , _byte_budget(other._byte_budget)
+    , _memory_limit(other._memory_limit)
+    , _used_bytes(other._used_bytes)
+    , _frame(other._frame)
+    , _owner(other._owner.load())
+    , _layouts(std::move(other._layouts))
+    , _eviction_generation(other._eviction_generation)
+    , _atlas(std::move(other._atlas))
+    , _font_desc(other._font_desc)
     , _font(other._font)
     , _space_advance(other._space_advance)
     , _space_minx(other._space_minx)
+    , _latin_space_kerning(other._latin_space_kerning)
+    , _space_kerning(std::move(other._space_kerning))
+    , _pool(std::move(other._pool))
+    , _async(std::move(other._async))
+    , _pending(std::move(other._pending))
+    , _failed(std::move(other._failed))
+    , _persistent_path(std::move(other._persistent_path))
+    , _persistent_file(std::move(other._persistent_file))
+    , _font_hash(other._font_hash)
+    , _glyph_run_mode(other._glyph_run_mode)
+    , _keep_alpha(other._keep_alpha)
+    , _render_deadline(other._render_deadline)
+    , _inserted_since_deadline(other._inserted_since_deadline)
+    , _deferred_words(other._deferred_words)
+    , _stats(other._stats)
 {
     other._font = nullptr;
+    other._used_bytes = 0;
 }
 
-// http://stackoverflow.com/questions/18534494/convert-from-utf-8-to-unicode-c
-#include <deque>
-uint32_t utf8_to_ucs4(std::deque<uint8_t> coded)
+int font_word_cache::get_word_left_kerning(std::string_view const word)
 {
-    int charcode = 0;
-    int t = coded.front();
-    coded.pop_front();
-    if (t < 128)
-    {
-        return t;
-    }
-    int high_bit_mask = (1 << 6) -1;
-    int high_bit_shift = 0;
-    int total_bits = 0;
-    const int other_bits = 6;
-    while((t & 0xC0) == 0xC0)
-    {
-        t <<= 1;
-        t &= 0xff;
-        total_bits += 6;
-        high_bit_mask >>= 1;
-        high_bit_shift++;
-        charcode <<= other_bits;
-        charcode |= coded.front() & ((1 << other_bits)-1);
-        coded.pop_front();
-    }
-    charcode |= ((t >> high_bit_shift) & high_bit_mask) << total_bits;
-    return charcode;
+    return space_kerning(decode_last_utf8(word)).after;
 }
 
-// get the last utf8 character from a string
-uint32_t get_last_ucs4(std::string_view const s)
+int font_word_cache::get_word_right_kerning(std::string_view const word)
 {
-    char const * ptr = s.data() + s.size() - 1;
-    if (*ptr == 0) ptr = " ";
-
-    std::deque<uint8_t> d;
-    while (is_utf8_following_byte(*ptr))
-    {
-        d.push_front(*ptr);
-        ptr--;
-    }
-    d.push_front(*ptr);
-    return utf8_to_ucs4(d);
+    return space_kerning(decode_first_utf8(word)).before;
 }
 
-uint32_t get_first_ucs4(std::string_view const s)
+font_word_cache::space_kerning_pair font_word_cache::space_kerning(uint32_t c)
 {
-    char const * ptr = s.data();
-    if (*ptr == 0) ptr = " ";
+    if (c < _latin_space_kerning.size())
+        return _latin_space_kerning[c];
 
-    std::deque<uint8_t> d;
-    d.push_back(*ptr);
-    ptr++;
-    while (is_utf8_following_byte(*ptr))
-    {
-        d.push_back(*ptr);
-        ptr++;
-    }
-    return utf8_to_ucs4(d);
+    auto it = _space_kerning.find(c);
+    if (it == _space_kerning.end())
+        it = _space_kerning.emplace(c, space_kerning_pair { TTF_GetFontKerningSizeGlyphs(_font, ' ', c), TTF_GetFontKerningSizeGlyphs(_font, c, ' ') }).first;
+    return it->second;
 }
 
-int font_word_cache::get_word_left_kerning(std::string_view const word)
+word_splitter::word_splitter(std::string_view t)
+    : _t(t)
+    , _pos(0)
 {
-    return TTF_GetFontKerningSizeGlyphs(_font, get_last_ucs4(word), ' ');
 }
 
-int font_word_cache::get_word_right_kerning(std::string_view const word)
+bool word_splitter::next(word_fragment & wf)
 {
-    return TTF_GetFontKerningSizeGlyphs(_font, ' ', get_first_ucs4(word));
+    if (_pos == std::string_view::npos)
+        return false;
+
+    std::size_t const pos = _t.find(' ', _pos);
+    if (pos == std::string_view::npos)
+    {
+        std::string_view const w = _t.substr(_pos);
+        _pos = std::string_view::npos;
+
+        if (w.empty())
+            return false;
+
+        wf = word_fragment{ w, 0 };
+        return true;
+    }
+
+    std::size_t num_spaces = 1;
+    while (pos + num_spaces < _t.size() && _t[pos + num_spaces] == ' ')
+        num_spaces++;
+
+    wf = word_fragment{ _t.substr(_pos, pos - _pos), num_spaces - 1 };
+    _pos = pos + num_spaces;
+    return true;
 }
 
-std::vector<word_fragment> split_words(std::string t)
+int font_word_cache::layout_word_width(std::string_view w, std::vector<word_entry *> * used_words)
 {
-    std::vector<word_fragment> words;
+    _placed.clear();
 
-    std::size_t pos;
-    std::size_t last_pos = 0;
-    while ((pos = t.find(' ', last_pos)) != std::string::npos)
+    if (used_words != nullptr)
     {
-        std::string const & w = t.substr(last_pos, pos - last_pos);
-
-        std::size_t num_spaces = 1;
-
-        while (pos + num_spaces < t.size())
+        int width;
+        if (glyph_run(w, width))
         {
-            if (t[pos + num_spaces] == ' ')
+            // The glyphs are cached like words, the run itself is never
+            // rendered.
+            for (auto const & g : _glyph_run)
             {
-                num_spaces++;
+                word_entry * e = layout_word(g.glyph, used_words, true);
+                if (e != nullptr)
+                    _placed.push_back({ e, g.x });
             }
-            else
-                break;
+            return width;
         }
 
-        words.push_back(word_fragment{ w, num_spaces - 1 });
+        if (w.empty())
+            return 0;
+
+        word_entry * e = layout_word(w, used_words, is_run_glyph(w));
+        if (e == nullptr)
+            return word_width(w);
 
-        last_pos = pos + num_spaces;
+        _placed.push_back({ e, 0 });
+        return e->source.w;
     }
+    else
     {
-        std::string const & w = t.substr(last_pos);
-        if (!w.empty())
-            words.push_back(word_fragment{ w, 0 });
+        return word_width(w);
     }
+}
 
-    return words;
+font_word_cache::word_entry * font_word_cache::layout_word(std::string_view w, std::vector<word_entry *> * used_words, bool run_glyph)
+{
+    if (_pool != nullptr && !w.empty() && _prerendered.find(w) == _prerendered.end())
+    {
+        request_word(w);
+        used_words->push_back(nullptr);
+        return nullptr;
+    }
+
+    // The layout is repeated until no word is missing.
+    if (!w.empty() && !run_glyph && past_render_deadline() && _prerendered.find(w) == _prerendered.end())
+    {
+        _deferred_words = true;
+        used_words->push_back(nullptr);
+        return nullptr;
+    }
+
+    word_entry * entry = word(w);
+    if (entry != nullptr)
+        used_words->push_back(entry);
+    return entry;
 }
 
-vec font_word_cache::texture_dim_nullptr(SDL_Texture * texture) const
+bool is_numeric_glyph(uint32_t c)
 {
-    if (texture == nullptr)
+    switch (c)
     {
-        return { 0, font_line_skip() };
+        case ':': case '.': case ',': case '-': case '+': case '/': case '%':
+            return true;
+        default:
+            return c >= '0' && c <= '9';
     }
-    else
+}
+
+bool font_word_cache::might_be_glyph_run(std::string_view w) const
+{
+    switch (_glyph_run_mode)
     {
-        return texture_dim(texture);
+        case glyph_run_mode::NEVER:
+            return false;
+        case glyph_run_mode::NUMERIC:
+        {
+            char const * ptr = w.data();
+            char const * const end = ptr + w.size();
+            while (ptr != end)
+            {
+                int length;
+                if (!is_numeric_glyph(decode_utf8(ptr, end, length)))
+                    return false;
+                ptr += length;
+            }
+            return w.size() > 1;
+        }
+        case glyph_run_mode::ALWAYS:
+        default:
+            return w.size() > 1;
     }
 }
 
+bool font_word_cache::is_run_glyph(std::string_view w) const
+{
+    if (_glyph_run_mode == glyph_run_mode::NEVER || w.empty())
+        return false;
+
+    int length;
+    uint32_t const c = decode_utf8(w.data(), w.data() + w.size(), length);
+    if (static_cast<std::size_t>(length) != w.size())
+        return false;
+    return _glyph_run_mode == glyph_run_mode::ALWAYS || is_numeric_glyph(c);
+}
+
+bool font_word_cache::glyph_run(std::string_view w, int & width)
+{
+    if (_glyph_run_mode == glyph_run_mode::NEVER || w.size() < 2)
+        return false;
+
+    _glyph_run.clear();
+
+    char const * ptr = w.data();
+    char const * const end = ptr + w.size();
+    uint32_t prev = 0;
+    int pen = 0;
+    int extent = 0;
+    while (ptr != end)
+    {
+        int length;
+        uint32_t const c = decode_utf8(ptr, end, length);
+
+        // SDL_ttf only measures glyphs of the basic multilingual plane.
+        if (c > 0xffff || (_glyph_run_mode == glyph_run_mode::NUMERIC && !is_numeric_glyph(c)))
+            return false;
+
+        int minx, maxx, advance;
+        if (TTF_GlyphMetrics(_font, c, &minx, &maxx, nullptr, nullptr, &advance) < 0)
+            return false;
+
+        if (prev != 0)
+            pen += TTF_GetFontKerningSizeGlyphs(_font, prev, c);
+        else if (minx < 0)
+            pen = -minx;
+
+        // A glyph rendered on its own starts at its left bearing if it is
+        // negative.
+        _glyph_run.push_back({ std::string_view(ptr, length), pen + std::min(0, minx) });
+        extent = std::max(extent, pen + maxx);
+        pen += advance;
+
+        prev = c;
+        ptr += length;
+    }
+
+    // A single glyph is a word of its own.
+    if (_glyph_run.size() < 2)
+        return false;
+
+    width = std::max(pen, extent);
+    return true;
+}
+
 template <typename BackInsertIt>
-vec font_word_cache::compute_text_layout(std::string t, int max_line_width, BackInsertIt it)
+vec font_word_cache::compute_text_layout(std::string_view t, int max_line_width, BackInsertIt it, std::vector<word_entry *> * used_words, std::vector<std::size_t> * line_starts)
 {
     vec target_size { 0, 0 };
-    
-    auto word_fragments = split_words(t);
-    if (!word_fragments.empty())
+
+    if (line_starts != nullptr)
+        line_starts->push_back(0);
+
+    word_splitter words(t);
+    word_fragment first_wf;
+    if (words.next(first_wf))
     {
         int actual_max_width = 0;
 
-        auto first_texture = word(word_fragments[0].word);
-        vec const first_dim = texture_dim_nullptr(first_texture);
-        int const first_left_kerning = (word_fragments[0].extra_spaces > 0 ? get_word_left_kerning(word_fragments[0].word) : 0);
-
-        if (first_texture != nullptr)
+        // Copies the pieces of the last word laid out.
+        auto place = [this, &it](int x, int y)
         {
-            *it = { first_texture, origin_rect(first_dim), 0, 0 };
-            ++it;
-        }
+            for (auto const & p : _placed)
+            {
+                *it = { p.entry->texture, p.entry->source, x + p.x, y, p.entry->alpha, length(p.entry->source) };
+                ++it;
+            }
+        };
+
+        int const first_width = layout_word_width(first_wf.word, used_words);
+        int const first_left_kerning = (first_wf.extra_spaces > 0 ? get_word_left_kerning(first_wf.word) : 0);
 
-        int line_width = first_dim.w + first_left_kerning + word_fragments[0].extra_spaces * _space_advance;
+        place(0, 0);
+
+        int line_width = first_width + first_left_kerning + first_wf.extra_spaces * _space_advance;
         int height = 0;
 
-        int prev_post_left_kerning = word_fragments[0].extra_spaces > 0 ? 0 : get_word_left_kerning(word_fragments[0].word);
+        int prev_post_left_kerning = first_wf.extra_spaces > 0 ? 0 : get_word_left_kerning(first_wf.word);
 
-        for (std::size_t k = 1; k < word_fragments.size(); ++k)
+        word_fragment current_wf;
+        while (words.next(current_wf))
         {
-            auto const & current_wf = word_fragments[k];
-            auto current_texture = word(current_wf.word);
-            vec const current_dim = texture_dim_nullptr(current_texture);
+            int const current_width = layout_word_width(current_wf.word, used_words);
 
             int current_pre_left_kerning;
             int current_post_left_kerning;
@@ -209,31 +404,26 @@ vec font_word_cache::compute_text_layout(std::string t, int max_line_width, Back
             }
 
             int const spacing = prev_post_left_kerning + _space_advance + get_word_right_kerning(current_wf.word);
-            int const next_line_width = line_width + spacing + current_dim.w + current_pre_left_kerning + current_wf.extra_spaces * _space_advance;
+            int const next_line_width = line_width + spacing + current_width + current_pre_left_kerning + current_wf.extra_spaces * _space_advance;
 
             if (max_line_width == -1 || next_line_width <= max_line_width)
             {
                 // word does fit
 
-                if (current_texture != nullptr)
-                {
-                    *it = { current_texture, origin_rect(current_dim), line_width + spacing, height };
-                    ++it;
-                }
+                place(line_width + spacing, height);
 
                 line_width = next_line_width;
             }
             else
             {
                 // word does not fit, start a new line
+                if (line_starts != nullptr)
+                    line_starts->push_back(current_wf.word.data() - t.data());
                 actual_max_width = std::max(actual_max_width, line_width);
-                line_width = current_dim.w;
+                line_width = current_width;
                 height += font_line_skip();
 
-                if (current_texture != nullptr)
-                {
-                    *it = { current_texture, origin_rect(current_dim), 0, height };
-                }
+                place(0, height);
             }
 
             prev_post_left_kerning = current_post_left_kerning;
@@ -246,18 +436,6 @@ vec font_word_cache::compute_text_layout(std::string t, int max_line_width, Back
     return target_size;
 }
 
-std::tuple<vec, std::vector<copy_command>> font_word_cache::text(std::string t, int max_line_width)
-{
-    // FIXME: temporary solution - do not use too much memory, although with words caching it's not as bad as before
-    // TODO add use count? would it cause ui lag?
-    if (_prerendered.size() > 40000)
-        clear();
-
-    std::vector<copy_command> copy_commands;
-    vec target_size = compute_text_layout(t, max_line_width, std::back_inserter(copy_commands));
-    return std::make_tuple(target_size, copy_commands);
-}
-
 // Not really an iterator but satisfies the use case.
 struct null_iterator
 {
@@ -269,23 +447,149 @@ struct null_iterator
     assignment_dummy operator*() { return assignment_dummy(); };
 };
 
-vec font_word_cache::text_size(std::string t, int max_line_width)
+std::tuple<vec, std::vector<copy_command>> const & font_word_cache::text(std::string_view t, int max_line_width)
+{
+    return text(t, std::hash<std::string_view>()(t), max_line_width);
+}
+
+std::tuple<vec, std::vector<copy_command>> const & font_word_cache::text(interned_text const & t, int max_line_width)
+{
+    return text(t.view(), t.hash(), max_line_width);
+}
+
+std::tuple<vec, std::vector<copy_command>> const & font_word_cache::text(std::string_view t, std::size_t hash, int max_line_width)
+{
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+    layout_entry & e = layout(t, hash, max_line_width);
+
+    if (!e.rendered || e.generation != _eviction_generation)
+    {
+        _stats.layout_misses++;
+
+        auto & copy_commands = std::get<1>(e.result);
+        copy_commands.clear();
+        e.words.clear();
+        std::get<0>(e.result) = compute_text_layout(t, max_line_width, std::back_inserter(copy_commands), &e.words);
+        e.sized = true;
+
+        // Try again once all words are available.
+        e.rendered = std::find(e.words.begin(), e.words.end(), nullptr) == e.words.end();
+        e.generation = _eviction_generation;
+    }
+    else
+    {
+        _stats.layout_hits++;
+
+        // The words are not looked up, keep them from being evicted.
+        for (auto w : e.words)
+            touch(*w);
+    }
+
+    return e.result;
+}
+
+vec font_word_cache::text_size(std::string_view t, int max_line_width)
+{
+    return text_size(t, std::hash<std::string_view>()(t), max_line_width);
+}
+
+vec font_word_cache::text_size(interned_text const & t, int max_line_width)
 {
-    return compute_text_layout(t, max_line_width, null_iterator());
+    return text_size(t.view(), t.hash(), max_line_width);
 }
 
-int font_word_cache::text_minimum_width(std::string t)
+vec font_word_cache::text_size(std::string_view t, std::size_t hash, int max_line_width)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_measure_mutex);
+        layout_entry const * e = find_layout(t, hash, max_line_width);
+        if (e != nullptr && e->sized)
+            return std::get<0>(e->result);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+
+    // The size does not depend on the words still being cached.
+    layout_entry & e = layout(t, hash, max_line_width);
+    if (!e.sized)
+    {
+        std::get<0>(e.result) = compute_text_layout(t, max_line_width, null_iterator(), nullptr);
+        e.sized = true;
+    }
+    return std::get<0>(e.result);
+}
+
+std::size_t layout_key(std::size_t hash, int max_line_width)
+{
+    return hash ^ (std::hash<int>()(max_line_width) * 0x9e3779b97f4a7c15ull);
+}
+
+font_word_cache::layout_entry const * font_word_cache::find_layout(std::string_view t, std::size_t hash, int max_line_width) const
+{
+    auto it = _layouts.find(layout_key(hash, max_line_width));
+    if (it != _layouts.end() && it->second.text == t && it->second.max_line_width == max_line_width)
+        return &it->second;
+    return nullptr;
+}
+
+font_word_cache::layout_entry & font_word_cache::layout(std::string_view t, std::size_t hash, int max_line_width)
+{
+    std::size_t const key = layout_key(hash, max_line_width);
+
+    auto it = _layouts.find(key);
+    if (it != _layouts.end() && it->second.text == t && it->second.max_line_width == max_line_width)
+        return it->second;
+
+    if (it == _layouts.end() && _layouts.size() >= MAX_LAYOUTS)
+        _layouts.clear();
+
+    layout_entry & e = _layouts[key];
+    e.text = t;
+    e.max_line_width = max_line_width;
+    e.sized = false;
+    e.rendered = false;
+    return e;
+}
+
+void font_word_cache::text_line_starts(std::string_view t, int max_line_width, std::vector<std::size_t> & starts)
+{
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+
+    starts.clear();
+    compute_text_layout(t, max_line_width, null_iterator(), nullptr, &starts);
+}
+
+int font_word_cache::text_minimum_width(std::string_view t)
 {
     int max_width = 0;
-    auto word_fragments = split_words(t);
-    for (auto wf : word_fragments)
+    word_splitter words(t);
+    word_fragment wf;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(_measure_mutex);
+        int width;
+        bool complete = true;
+        while (complete && words.next(wf))
+        {
+            complete = find_word_width(wf.word, width);
+            max_width = std::max(max_width, width + static_cast<int>(wf.extra_spaces) * _space_advance);
+        }
+        if (complete)
+            return max_width;
+    }
+
+    // Words that were measured already are found again.
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+    max_width = 0;
+    words = word_splitter(t);
+    while (words.next(wf))
     {
-        max_width = std::max(max_width, texture_dim_nullptr(word(wf.word)).w + static_cast<int>(wf.extra_spaces) * _space_advance);
+        max_width = std::max(max_width, word_width(wf.word) + static_cast<int>(wf.extra_spaces) * _space_advance);
     }
     return max_width;
 }
 
-SDL_Texture * font_word_cache::word(std::string w)
+font_word_cache::word_entry * font_word_cache::word(std::string_view w)
 {
     auto it = _prerendered.find(w);
     if (it == _prerendered.end())
@@ -297,29 +601,444 @@ SDL_Texture * font_word_cache::word(std::string w)
         }
         else
         {
+            // The key has to be owned and SDL_ttf requires a terminated string.
+            std::string key(w);
+
+            _stats.misses++;
+            auto const start = std::chrono::steady_clock::now();
+            LIBWTK_SDL2_TRACE_SCOPE("text", "render_word");
+
             // Render in white, then we can use the SDL_SetTextureColorMod to get
             // any color.
-            SDL_Surface * s = TTF_RenderUTF8_Blended(_font, w.c_str(), {255, 255, 255});
+            SDL_Surface * s = TTF_RenderUTF8_Blended(_font, key.c_str(), {255, 255, 255});
 
             if (s == nullptr)
                 throw font_render_error(TTF_GetError());
 
-            SDL_Texture * t = SDL_CreateTextureFromSurface(_renderer, s);
+            word_entry * e = insert_word(std::move(key), s);
+            _stats.render_time += std::chrono::steady_clock::now() - start;
+            return e;
+        }
+    }
+    else
+    {
+        _stats.hits++;
+        touch(it->second);
+        return &it->second;
+    }
+}
+
+// Copies the alpha channel of a rendered word.
+std::unique_ptr<uint8_t[]> extract_alpha(SDL_Surface * s)
+{
+    unique_surface_ptr converted;
+    if (s->format->format != SDL_PIXELFORMAT_ARGB8888)
+    {
+        converted.reset(SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0));
+        if (!converted)
+            throw font_render_error(SDL_GetError());
+        s = converted.get();
+    }
+
+    std::unique_ptr<uint8_t[]> alpha(new uint8_t[static_cast<std::size_t>(s->w) * s->h]);
+
+    if (SDL_MUSTLOCK(s))
+        SDL_LockSurface(s);
+
+    for (int y = 0; y < s->h; ++y)
+    {
+        auto const * row = reinterpret_cast<uint32_t const *>(static_cast<uint8_t const *>(s->pixels) + y * s->pitch);
+        for (int x = 0; x < s->w; ++x)
+            alpha[y * s->w + x] = row[x] >> 24;
+    }
+
+    if (SDL_MUSTLOCK(s))
+        SDL_UnlockSurface(s);
+
+    return alpha;
+}
+
+font_word_cache::word_entry * font_word_cache::insert_word(std::string key, SDL_Surface * s, uint8_t const * alpha, bool least_recent)
+{
+    unique_surface_ptr surface(s);
+    LIBWTK_SDL2_TRACE_SCOPE("upload", "upload_word");
+    _inserted_since_deadline = true;
+
+    // Make room before allocating, such that released atlas areas can be
+    // reused right away.
+    evict(static_cast<std::size_t>(s->w) * s->h * 4);
+
+    auto a = _atlas.insert(s);
+
+    word_entry e { a.texture, a.source, a.texture == nullptr, {}, _frame, nullptr, alpha };
+
+    if ((!_persistent_path.empty() || _keep_alpha) && e.alpha == nullptr)
+    {
+        e.alpha_storage = extract_alpha(s);
+        e.alpha = e.alpha_storage.get();
+    }
+
+    // Too large for the atlas, use a texture of its own.
+    if (e.dedicated)
+    {
+        e.texture = SDL_CreateTextureFromSurface(_renderer, s);
+
+        if (e.texture == nullptr)
+            throw font_render_error(SDL_GetError());
+
+        // Use alpha blending to make use of the alpha channel.
+        if (SDL_SetTextureBlendMode(e.texture, SDL_BLENDMODE_BLEND) < 0)
+            throw font_render_error(SDL_GetError());
+    }
+
+    if (least_recent)
+    {
+        _lru.push_back(std::move(key));
+        e.lru_pos = std::prev(_lru.end());
+    }
+    else
+    {
+        _lru.push_front(std::move(key));
+        e.lru_pos = _lru.begin();
+    }
+    std::string_view const k(*e.lru_pos);
+    _used_bytes += entry_bytes(e);
+    auto result = _prerendered.emplace(k, std::move(e)).first;
+
+    return &result->second;
+}
+
+std::size_t font_word_cache::entry_bytes(word_entry const & e)
+{
+    std::size_t const pixels = static_cast<std::size_t>(e.source.w) * e.source.h;
+    return pixels * 4 + (e.alpha_storage ? pixels : 0);
+}
+
+std::size_t font_word_cache::effective_byte_budget() const
+{
+    return std::min(_byte_budget, _memory_limit.value_or(_byte_budget));
+}
+
+void font_word_cache::evict(std::size_t required_bytes)
+{
+    std::size_t const budget = effective_byte_budget();
+    while (!_lru.empty() && _used_bytes + required_bytes > budget)
+    {
+        auto it = _prerendered.find(std::string_view(_lru.back()));
+        word_entry const & e = it->second;
+
+        // Everything left has been used in this frame.
+        if (e.frame == _frame)
+            break;
+
+        if (e.dedicated)
+            destroy_texture(e.texture);
+        else
+            _atlas.release({ e.texture, e.source });
+
+        _used_bytes -= entry_bytes(e);
+        _prerendered.erase(it);
+        _lru.pop_back();
+
+        // Cached layouts might refer to the word.
+        _eviction_generation++;
+        _stats.evictions++;
+    }
+}
+
+void font_word_cache::set_byte_budget(std::size_t bytes)
+{
+    _byte_budget = bytes;
+    evict(0);
+}
+
+std::size_t font_word_cache::byte_budget() const
+{
+    return _byte_budget;
+}
+
+std::size_t font_word_cache::used_bytes() const
+{
+    return _used_bytes;
+}
+
+void font_word_cache::set_memory_limit(std::optional<std::size_t> bytes)
+{
+    _memory_limit = bytes;
+    evict(0);
+}
+
+void font_word_cache::touch(word_entry & e)
+{
+    _lru.splice(_lru.begin(), _lru, e.lru_pos);
+    e.frame = _frame;
+}
+
+void font_word_cache::end_frame()
+{
+    _frame++;
+}
+
+bool font_word_cache::claim_owner(void const * user)
+{
+    void const * expected = nullptr;
+    return _owner.compare_exchange_strong(expected, user) || expected == user;
+}
+
+void font_word_cache::release_owner(void const * user)
+{
+    void const * expected = user;
+    _owner.compare_exchange_strong(expected, nullptr);
+}
+
+font_word_cache::async_state::async_state(font f, Uint32 wakeup_event)
+    : f(f)
+    , wakeup_event(wakeup_event)
+    , ttf_font(nullptr)
+    , cancelled(false)
+    , render_nanoseconds(0)
+{
+}
+
+font_word_cache::async_state::~async_state()
+{
+    if (ttf_font != nullptr)
+        close_ttf_font(ttf_font);
+}
+
+void font_word_cache::set_thread_pool(std::shared_ptr<thread_pool> pool)
+{
+    _pool = std::move(pool);
+
+    if (_pool != nullptr && !_async)
+    {
+        static Uint32 const wakeup_event = SDL_RegisterEvents(1);
+        _async = std::make_shared<async_state>(_font_desc, wakeup_event);
+    }
+}
+
+void font_word_cache::request_word(std::string_view w)
+{
+    std::string key(w);
+    if (_failed.find(key) != _failed.end() || !_pending.insert(key).second)
+        return;
+
+    auto state = _async;
+    _pool->submit([state, key]()
+    {
+        if (state->cancelled)
+            return;
+
+        SDL_Surface * s = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->font_mutex);
+            auto const start = std::chrono::steady_clock::now();
+
+            if (state->ttf_font == nullptr)
+                state->ttf_font = open_ttf_font(state->f);
+
+            if (state->ttf_font != nullptr)
+                s = TTF_RenderUTF8_Blended(state->ttf_font, key.c_str(), {255, 255, 255});
+
+            state->render_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(state->rendered_mutex);
+            first = state->rendered.empty();
+            state->rendered.emplace_back(key, unique_surface_ptr(s));
+        }
+
+        // Wake up an event loop that waits for input.
+        if (first && state->wakeup_event != static_cast<Uint32>(-1))
+        {
+            SDL_Event ev;
+            SDL_zero(ev);
+            ev.type = state->wakeup_event;
+            SDL_PushEvent(&ev);
+        }
+    });
+}
+
+bool font_word_cache::upload_rendered_words()
+{
+    if (!_async)
+        return false;
+
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+
+    std::vector<std::pair<std::string, unique_surface_ptr>> rendered;
+    {
+        std::lock_guard<std::mutex> lock(_async->rendered_mutex);
+        rendered.swap(_async->rendered);
+    }
+
+    for (auto it = rendered.begin(); it != rendered.end(); ++it)
+    {
+        // The rest is uploaded in a later frame.
+        if (past_render_deadline())
+        {
+            _deferred_words = true;
+            std::lock_guard<std::mutex> lock(_async->rendered_mutex);
+            _async->rendered.insert(_async->rendered.begin(), std::make_move_iterator(it), std::make_move_iterator(rendered.end()));
+            rendered.erase(it, rendered.end());
+            break;
+        }
+
+        auto & p = *it;
+        _pending.erase(p.first);
+
+        // It might have been rendered in the meantime.
+        if (_prerendered.find(p.first) != _prerendered.end())
+            continue;
+
+        try
+        {
+            // Rendering failed, report the error as if it was rendered here,
+            // which counts the miss.
+            if (p.second == nullptr)
+            {
+                word(p.first);
+            }
+            else
+            {
+                _stats.misses++;
+                auto const start = std::chrono::steady_clock::now();
+                insert_word(std::string(p.first), p.second.release());
+                _stats.render_time += std::chrono::steady_clock::now() - start;
+            }
+        }
+        catch (...)
+        {
+            // The error is reported once, the rest of the words is uploaded
+            // in a later call.
+            _failed.insert(std::move(p.first));
+            std::lock_guard<std::mutex> lock(_async->rendered_mutex);
+            _async->rendered.insert(_async->rendered.begin(), std::make_move_iterator(it + 1), std::make_move_iterator(rendered.end()));
+            throw;
+        }
+    }
+
+    return !rendered.empty();
+}
 
-            if (t == nullptr)
-                throw font_render_error(SDL_GetError());
+void font_word_cache::set_render_deadline(std::optional<std::chrono::steady_clock::time_point> deadline)
+{
+    _render_deadline = deadline;
+    _inserted_since_deadline = false;
+}
 
-            // Use alpha blending to make use of the alpha channel.
-            if (SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND) < 0)
-                throw font_render_error(SDL_GetError());
+bool font_word_cache::take_deferred_words()
+{
+    bool const deferred = _deferred_words;
+    _deferred_words = false;
+    return deferred;
+}
 
-            return _prerendered[w] = t;
+bool font_word_cache::past_render_deadline()
+{
+    // At least one word is added each frame, such that text appears
+    // eventually even if the deadline passes before drawing.
+    return _render_deadline.has_value() && _inserted_since_deadline && std::chrono::steady_clock::now() >= _render_deadline.value();
+}
+
+void font_word_cache::prewarm(std::vector<std::string> const & texts)
+{
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+    for (auto const & t : texts)
+    {
+        word_splitter words(t);
+        word_fragment wf;
+        while (words.next(wf))
+        {
+            if (wf.word.empty())
+                continue;
+
+            int width;
+            if (glyph_run(wf.word, width))
+            {
+                for (auto const & g : _glyph_run)
+                    prewarm_word(g.glyph);
+            }
+            else
+            {
+                prewarm_word(wf.word);
+            }
         }
     }
+}
+
+void font_word_cache::prewarm_word(std::string_view w)
+{
+    if (_prerendered.find(w) != _prerendered.end())
+        return;
+
+    if (_pool != nullptr)
+        request_word(w);
     else
+        word(w);
+}
+
+bool font_word_cache::find_word_width(std::string_view w, int & width) const
+{
+    width = 0;
+    if (w.empty())
+        return true;
+
+    // Glyph runs are only found here.
+    auto it = _word_widths.find(w);
+    if (it != _word_widths.end())
+    {
+        width = it->second;
+        return true;
+    }
+
+    auto pit = _prerendered.find(w);
+    if (pit != _prerendered.end() && !might_be_glyph_run(w))
     {
+        width = pit->second.source.w;
+        return true;
+    }
+
+    return false;
+}
+
+int font_word_cache::word_width(std::string_view w)
+{
+    if (w.empty())
+        return 0;
+
+    // Glyph runs are measured by their glyphs, even if the word has been
+    // rendered as a whole, e.g., by a previous run.
+    auto it = _word_widths.find(w);
+    if (it != _word_widths.end())
         return it->second;
+
+    int width;
+    bool const run = glyph_run(w, width);
+
+    // A rendered word is already measured.
+    auto pit = _prerendered.find(w);
+    if (!run && pit != _prerendered.end())
+        return pit->second.source.w;
+
+    // Widths are cheap to recompute, there is no need for anything more
+    // sophisticated than starting over.
+    if (_word_widths.size() > MAX_WORD_WIDTHS)
+    {
+        _word_widths.clear();
+        _word_width_keys.clear();
     }
+
+    std::string key(w);
+
+    if (!run && TTF_SizeUTF8(_font, key.c_str(), &width, nullptr) < 0)
+        throw font_render_error(TTF_GetError());
+
+    _word_width_keys.push_back(std::move(key));
+    _word_widths.emplace(std::string_view(_word_width_keys.back()), width);
+    return width;
 }
 
 unsigned int font_word_cache::font_height() const
@@ -334,8 +1053,125 @@ int font_word_cache::font_line_skip() const
 
 void font_word_cache::clear()
 {
-    for (auto p : _prerendered)
-        SDL_DestroyTexture(p.second);
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+    for (auto const & p : _prerendered)
+    {
+        if (p.second.dedicated)
+            destroy_texture(p.second.texture);
+    }
     _prerendered.clear();
+    _failed.clear();
+    _lru.clear();
+    _word_widths.clear();
+    _word_width_keys.clear();
+    _layouts.clear();
+    _used_bytes = 0;
+    _atlas.clear();
+
+    // Nothing refers to the loaded words anymore.
+    _persistent_file = mapped_file();
+}
+
+
+void font_word_cache::set_glyph_run_mode(glyph_run_mode mode)
+{
+    if (mode == _glyph_run_mode)
+        return;
+
+    // Widths and layouts of runs differ from those of rendered words.
+    clear();
+    std::unique_lock<std::shared_mutex> lock(_measure_mutex);
+    _glyph_run_mode = mode;
 }
 
+glyph_run_mode font_word_cache::get_glyph_run_mode() const
+{
+    return _glyph_run_mode;
+}
+
+void font_word_cache::set_keep_alpha(bool keep)
+{
+    if (keep == _keep_alpha)
+        return;
+
+    _keep_alpha = keep;
+
+    // Words loaded from a persistent cache have their alpha already.
+    if (keep && _persistent_path.empty())
+        clear();
+}
+
+void font_word_cache::enable_persistent_cache(std::string path)
+{
+    // A shared cache might be enabled by every user.
+    if (path == _persistent_path)
+        return;
+
+    _persistent_path = path;
+    _font_hash = hash_file(_font_desc.path);
+    _persistent_file = mapped_file(path);
+
+    word_cache_reader reader(_persistent_file, _font_hash, _font_desc.size);
+
+    std::string_view w;
+    vec size;
+    uint8_t const * alpha;
+    while (reader.next(w, size, alpha))
+    {
+        // Words are stored most recently used first, keep as many as the
+        // budget allows.
+        if (_used_bytes + static_cast<std::size_t>(size.w) * size.h * 4 > effective_byte_budget())
+            break;
+
+        if (w.empty() || _prerendered.find(w) != _prerendered.end())
+            continue;
+
+        SDL_Surface * s = SDL_CreateRGBSurfaceWithFormat(0, size.w, size.h, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (s == nullptr)
+            throw font_render_error(SDL_GetError());
+
+        // Words are rendered in white.
+        for (int y = 0; y < size.h; ++y)
+        {
+            auto * row = reinterpret_cast<uint32_t *>(static_cast<uint8_t *>(s->pixels) + y * s->pitch);
+            for (int x = 0; x < size.w; ++x)
+                row[x] = (static_cast<uint32_t>(alpha[y * size.w + x]) << 24) | 0x00ffffff;
+        }
+
+        // Appended, such that the order of the file is kept.
+        insert_word(std::string(w), s, alpha, true);
+    }
+}
+
+void font_word_cache::flush_persistent_cache()
+{
+    if (_persistent_path.empty())
+        return;
+
+    word_cache_writer out(_persistent_path, _font_hash, _font_desc.size);
+    for (auto const & key : _lru)
+    {
+        word_entry const & e = _prerendered.find(std::string_view(key))->second;
+        if (e.alpha != nullptr)
+            out.add(key, length(e.source), e.alpha);
+    }
+    out.finish();
+}
+
+font_cache_stats font_word_cache::stats() const
+{
+    font_cache_stats result = _stats;
+    result.entries = _prerendered.size();
+    result.bytes_resident = _used_bytes;
+    result.atlas_pages = _atlas.page_count();
+    if (_async)
+        result.async_render_time = std::chrono::nanoseconds(_async->render_nanoseconds.load());
+    return result;
+}
+
+void font_word_cache::reset_stats()
+{
+    _stats = font_cache_stats();
+    if (_async)
+        _async->render_nanoseconds = 0;
+}
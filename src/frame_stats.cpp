@@ -0,0 +1,65 @@
+#include <algorithm>
+
+#include "frame_stats.hpp"
+
+frame_stats::frame_stats(std::size_t max_samples)
+    : _max_samples(std::max<std::size_t>(1, max_samples))
+    , _frame_times { {}, 0 }
+    , _input_latencies { {}, 0 }
+{
+}
+
+void frame_stats::reset()
+{
+    _frame_times = { {}, 0 };
+    _input_latencies = { {}, 0 };
+}
+
+void frame_stats::add(frame_report const & r)
+{
+    push(_frame_times, r.frame_time);
+    if (r.input_latency.has_value())
+        push(_input_latencies, r.input_latency.value());
+}
+
+duration_percentiles frame_stats::frame_times() const
+{
+    return percentiles(_frame_times);
+}
+
+duration_percentiles frame_stats::input_latencies() const
+{
+    return percentiles(_input_latencies);
+}
+
+void frame_stats::push(sample_ring & r, std::chrono::nanoseconds t)
+{
+    if (r.samples.size() < _max_samples)
+    {
+        r.samples.push_back(t);
+    }
+    else
+    {
+        r.samples[r.next] = t;
+        r.next = (r.next + 1) % _max_samples;
+    }
+}
+
+// The nearest rank, such that the percentile is one of the samples.
+std::chrono::nanoseconds sorted_percentile(std::vector<std::chrono::nanoseconds> const & sorted, std::size_t percent)
+{
+    std::size_t const rank = (sorted.size() * percent + 99) / 100;
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+duration_percentiles frame_stats::percentiles(sample_ring const & r) const
+{
+    if (r.samples.empty())
+        return { 0, {}, {}, {} };
+
+    // Sorting a thousand samples is cheap compared to a frame.
+    _sorted.assign(r.samples.begin(), r.samples.end());
+    std::sort(_sorted.begin(), _sorted.end());
+    return { _sorted.size(), sorted_percentile(_sorted, 50), sorted_percentile(_sorted, 95), sorted_percentile(_sorted, 99) };
+}
+
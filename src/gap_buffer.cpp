@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstring>
+
+#include "gap_buffer.hpp"
+#include "utf8.hpp"
+
+// Avoids growing the buffer on every keystroke.
+std::size_t const MIN_GAP_SIZE = 64;
+
+gap_buffer::gap_buffer(std::string_view text)
+{
+    assign(text);
+}
+
+void gap_buffer::assign(std::string_view text)
+{
+    _data.assign(text.data(), text.size());
+    _data.resize(text.size() + MIN_GAP_SIZE);
+    _gap_start = text.size();
+    _gap_end = _data.size();
+}
+
+std::size_t gap_buffer::size() const
+{
+    return _data.size() - (_gap_end - _gap_start);
+}
+
+bool gap_buffer::empty() const
+{
+    return size() == 0;
+}
+
+std::size_t gap_buffer::gap_position() const
+{
+    return _gap_start;
+}
+
+void gap_buffer::move_gap(std::size_t pos)
+{
+    pos = std::min(pos, size());
+    if (pos < _gap_start)
+    {
+        // The text between the position and the gap goes behind the gap.
+        std::size_t const n = _gap_start - pos;
+        std::memmove(&_data[_gap_end - n], &_data[pos], n);
+        _gap_start -= n;
+        _gap_end -= n;
+    }
+    else if (pos > _gap_start)
+    {
+        std::size_t const n = pos - _gap_start;
+        std::memmove(&_data[_gap_start], &_data[_gap_end], n);
+        _gap_start += n;
+        _gap_end += n;
+    }
+}
+
+void gap_buffer::insert(std::string_view text)
+{
+    reserve_gap(text.size());
+    std::memcpy(&_data[_gap_start], text.data(), text.size());
+    _gap_start += text.size();
+}
+
+void gap_buffer::erase_before(std::size_t n)
+{
+    _gap_start -= std::min(n, _gap_start);
+}
+
+void gap_buffer::erase_after(std::size_t n)
+{
+    _gap_end += std::min(n, _data.size() - _gap_end);
+}
+
+std::string_view gap_buffer::before_gap() const
+{
+    return std::string_view(_data.data(), _gap_start);
+}
+
+std::string_view gap_buffer::after_gap() const
+{
+    return std::string_view(_data.data() + _gap_end, _data.size() - _gap_end);
+}
+
+std::string gap_buffer::str() const
+{
+    std::string result;
+    result.reserve(size());
+    result.append(before_gap());
+    result.append(after_gap());
+    return result;
+}
+
+char gap_buffer::operator[](std::size_t pos) const
+{
+    return pos < _gap_start ? _data[pos] : _data[pos + (_gap_end - _gap_start)];
+}
+
+std::size_t gap_buffer::next_character(std::size_t pos) const
+{
+    std::size_t const n = size();
+    if (pos >= n)
+        return n;
+
+    // Malformed start bytes claim at most the rest of the text.
+    return std::min(n, pos + utf8_byte_count((*this)[pos]));
+}
+
+std::size_t gap_buffer::prev_character(std::size_t pos) const
+{
+    pos = std::min(pos, size());
+    if (pos == 0)
+        return 0;
+
+    pos--;
+    while (pos > 0 && is_utf8_following_byte((*this)[pos]))
+        pos--;
+    return pos;
+}
+
+void gap_buffer::reserve_gap(std::size_t n)
+{
+    if (_gap_end - _gap_start >= n)
+        return;
+
+    std::size_t const after = _data.size() - _gap_end;
+    std::size_t const capacity = std::max(2 * _data.size(), size() + n + MIN_GAP_SIZE);
+    _data.resize(capacity);
+
+    // The text after the gap stays at the end.
+    std::memmove(&_data[capacity - after], &_data[_gap_end], after);
+    _gap_end = capacity - after;
+}
@@ -21,6 +21,13 @@ bool fits(vec v, rect const & r)
     return v.w <= r.w && v.h <= r.h;
 }
 
+bool contains_rect(rect const & outer, rect const & inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y
+        && inner.x + inner.w <= outer.x + outer.w
+        && inner.y + inner.h <= outer.y + outer.h;
+}
+
 point rect_center(rect const & r)
 {
     return { r.x + r.w / 2, r.y + r.h / 2 };
@@ -1,19 +1,90 @@
 #include <algorithm>
 #include <numeric>
+#include <stdexcept>
 
 #include "grid.hpp"
+#include "layout_arena.hpp"
 #include "util.hpp"
 
 grid::grid(vec size, std::vector<entry> entries, int spacing)
-    : _entries(entries)
+    : _entries(std::move(entries))
     , _size(size)
-    , _grid(size.w, std::vector<int>(size.h, -1))
+    , _cells(size.w * size.h, -1)
     , _spacing(spacing)
     , _x_offsets(size.w + 1, 0)
     , _y_offsets(size.h + 1, 0)
 {
+    for (auto const & e : _entries)
+        _child_ptrs.push_back(e.wptr.get());
     init_children();
+    index_cells();
+}
+
+grid::~grid()
+{
+}
 
+void grid::insert(entry e)
+{
+    rect const & p = e.placement;
+    if (p.x < 0 || p.y < 0 || p.w <= 0 || p.h <= 0 || p.x + p.w > _size.w || p.y + p.h > _size.h)
+        throw std::runtime_error("grid entry is placed outside of the grid");
+
+    for (int x = p.x; x < p.x + p.w; ++x)
+    {
+        for (int y = p.y; y < p.y + p.h; ++y)
+        {
+            if (_cells[cell_index(x, y)] != -1)
+                throw std::runtime_error("grid entry overlaps another one");
+        }
+    }
+
+    attach_child(*e.wptr);
+    _child_ptrs.push_back(e.wptr.get());
+    _entries.push_back(std::move(e));
+    index_cells();
+    children_changed();
+}
+
+widget_ptr grid::remove(point cell)
+{
+    int const eidx = entry_at(cell);
+    if (eidx == -1)
+        return nullptr;
+
+    widget_ptr wptr = std::move(_entries[eidx].wptr);
+    detach_child(*wptr);
+    _entries.erase(_entries.begin() + eidx);
+    _child_ptrs.erase(_child_ptrs.begin() + eidx);
+    index_cells();
+    children_changed();
+    return wptr;
+}
+
+widget_ptr grid::replace(point cell, widget_ptr wptr)
+{
+    int const eidx = entry_at(cell);
+    if (eidx == -1)
+        return nullptr;
+
+    detach_child(*_entries[eidx].wptr);
+    attach_child(*wptr);
+    _child_ptrs[eidx] = wptr.get();
+    std::swap(_entries[eidx].wptr, wptr);
+    children_changed();
+    return wptr;
+}
+
+int grid::entry_at(point cell) const
+{
+    if (cell.x < 0 || cell.x >= _size.w || cell.y < 0 || cell.y >= _size.h)
+        return -1;
+    return _cells[cell_index(cell.x, cell.y)];
+}
+
+void grid::index_cells()
+{
+    std::fill(_cells.begin(), _cells.end(), -1);
     for (std::size_t k = 0; k < _entries.size(); ++k)
     {
         // TODO sanity check
@@ -22,33 +93,28 @@ grid::grid(vec size, std::vector<entry> entries, int spacing)
         {
             for (int y = e.placement.y; y < e.placement.y + e.placement.h; ++y)
             {
-                _grid[x][y] = k;
+                _cells[cell_index(x, y)] = k;
             }
         }
     }
 }
 
-grid::~grid()
+widget_range grid::get_children()
 {
+    return _child_ptrs;
 }
 
-std::vector<widget *> grid::get_children()
+const_widget_range grid::get_children() const
 {
-    std::vector<widget *> result;
-    for (auto & e : _entries)
-        result.push_back(e.wptr.get());
-    return result;
+    return widget_range(_child_ptrs);
 }
 
-std::vector<widget const *> grid::get_children() const
+int grid::cell_index(int x, int y) const
 {
-    std::vector<widget const *> result;
-    for (auto const & e : _entries)
-        result.push_back(e.wptr.get());
-    return result;
+    return x * _size.h + y;
 }
 
-void grid::compute_offsets(std::vector<int> & lengths, std::vector<int> & offsets, int n, int box_length, int box_start)
+void grid::compute_offsets(std::pmr::vector<int> & lengths, std::vector<int> & offsets, int n, int box_length, int box_start)
 {
     // TODO consider height-for-width (how?)
     // TODO distribute to empty cells?
@@ -72,8 +138,9 @@ void grid::compute_offsets(std::vector<int> & lengths, std::vector<int> & offset
 // TODO support natural widths
 void grid::on_box_allocated()
 {
-    std::vector<int> widths(_size.w, 0);
-    std::vector<int> heights(_size.h, 0);
+    std::pmr::memory_resource * const mr = layout_arena::resource();
+    std::pmr::vector<int> widths(_size.w, 0, mr);
+    std::pmr::vector<int> heights(_size.h, 0, mr);
 
     min_cell_dimensions(widths.data(), heights.data());
 
@@ -107,6 +174,25 @@ int find_x_index(It first, It last, point center, vec size)
     return std::min(size.w - 1, static_cast<int>(std::distance(first, it_x)) - 1);
 }
 
+widget * grid::find_child_at(point p)
+{
+    // Find the cell, the offsets are sorted.
+    auto const x_it = std::upper_bound(std::begin(_x_offsets), std::end(_x_offsets), p.x);
+    auto const y_it = std::upper_bound(std::begin(_y_offsets), std::end(_y_offsets), p.y);
+    int const x = std::distance(std::begin(_x_offsets), x_it) - 1;
+    int const y = std::distance(std::begin(_y_offsets), y_it) - 1;
+    if (x < 0 || x >= _size.w || y < 0 || y >= _size.h)
+        return nullptr;
+
+    int const eidx = _cells[cell_index(x, y)];
+    if (eidx == -1)
+        return nullptr;
+
+    // The spacing between cells does not belong to the widget.
+    widget * w = _entries[eidx].wptr.get();
+    return within_rect(p, w->get_box()) ? w : nullptr;
+}
+
 widget * grid::find_selectable(navigation_type nt, point center)
 {
     if (_entries.empty())
@@ -125,7 +211,7 @@ widget * grid::find_selectable(navigation_type nt, point center)
         int const y = find_y_index(std::begin(_y_offsets), std::end(_y_offsets), center, _size);
         for (int x = 0; x < _size.w; ++x)
         {
-            int eidx = _grid[x][y];
+            int eidx = _cells[cell_index(x, y)];
 
             if (eidx != -1)
                 return _entries[eidx].wptr.get();
@@ -136,7 +222,7 @@ widget * grid::find_selectable(navigation_type nt, point center)
         int const y = find_y_index(std::begin(_y_offsets), std::end(_y_offsets), center, _size);
         for (int x = _size.w - 1; x >= 0; --x)
         {
-            int eidx = _grid[x][y];
+            int eidx = _cells[cell_index(x, y)];
 
             if (eidx != -1)
                 return _entries[eidx].wptr.get();
@@ -148,7 +234,7 @@ widget * grid::find_selectable(navigation_type nt, point center)
 
         for (int y = 0; y < _size.h; ++y)
         {
-            int eidx = _grid[x][y];
+            int eidx = _cells[cell_index(x, y)];
 
             if (eidx != -1)
                 return _entries[eidx].wptr.get();
@@ -160,7 +246,7 @@ widget * grid::find_selectable(navigation_type nt, point center)
 
         for (int y = _size.h - 1; y >= 0; --y)
         {
-            int eidx = _grid[x][y];
+            int eidx = _cells[cell_index(x, y)];
 
             if (eidx != -1)
                 return _entries[eidx].wptr.get();
@@ -226,7 +312,7 @@ widget * grid::navigate_selectable_from_children(navigation_type nt, widget * w,
         {
             for (int p = x; p < _size.w; ++p)
             {
-                int eidx = _grid[p][y];
+                int eidx = _cells[cell_index(p, y)];
                 if (eidx != -1)
                 {
                     auto & e = _entries[eidx];
@@ -245,7 +331,7 @@ widget * grid::navigate_selectable_from_children(navigation_type nt, widget * w,
         {
             for (int p = x; p >= 0; --p)
             {
-                int eidx = _grid[p][y];
+                int eidx = _cells[cell_index(p, y)];
                 if (eidx != -1)
                 {
                     auto & e = _entries[eidx];
@@ -264,7 +350,7 @@ widget * grid::navigate_selectable_from_children(navigation_type nt, widget * w,
         {
             for (int p = y; p < _size.h; ++p)
             {
-                int eidx = _grid[x][p];
+                int eidx = _cells[cell_index(x, p)];
                 if (eidx != -1)
                 {
                     auto & e = _entries[eidx];
@@ -283,7 +369,7 @@ widget * grid::navigate_selectable_from_children(navigation_type nt, widget * w,
         {
             for (int p = y; p >= 0; --p)
             {
-                int eidx = _grid[x][p];
+                int eidx = _cells[cell_index(x, p)];
                 if (eidx != -1)
                 {
                     auto & e = _entries[eidx];
@@ -305,14 +391,15 @@ widget * grid::navigate_selectable_from_children(navigation_type nt, widget * w,
 
 size_hint grid::get_size_hint(int width, int height) const
 {
-    std::vector<int> min_widths(_size.w, 0);
-    std::vector<int> min_heights(_size.h, 0);
+    std::pmr::memory_resource * const mr = layout_arena::resource();
+    std::pmr::vector<int> min_widths(_size.w, 0, mr);
+    std::pmr::vector<int> min_heights(_size.h, 0, mr);
     min_cell_dimensions(min_widths.data(), min_heights.data());
 
     return size_hint({ length_with_spacing(min_widths), length_with_spacing(min_heights) });
 }
 
-int grid::length_with_spacing(std::vector<int> const & lengths) const
+int grid::length_with_spacing(std::pmr::vector<int> const & lengths) const
 {
     int const init = std::max(0, static_cast<int>(lengths.size()) - 1) * _spacing;
     return std::accumulate(std::cbegin(lengths), std::cend(lengths), init);
@@ -322,18 +409,18 @@ void grid::min_cell_dimensions(int * min_widths, int * min_heights) const
 {
     // Assumption: min_widths and min_heights are zero-initialized.
 
-    vec min_sizes[_entries.size()];
-    for (std::size_t k = 0; k < _entries.size(); ++k)
+    std::pmr::vector<vec> min_sizes(_entries.size(), layout_arena::resource());
+    layout_arena::parallel_for(_entries.size(), [&](std::size_t k)
     {
-        min_sizes[k] = _entries[k].wptr->get_size_hint().minimal;
-    }
+        min_sizes[k] = _entries[k].wptr->query_size_hint().minimal;
+    });
 
     // Determine the minimum width for each column and row in one go.
     for (int y = 0; y < _size.h; ++y)
     {
         for (int x = 0; x < _size.w; ++x)
         {
-            int const entry_index = _grid[x][y];
+            int const entry_index = _cells[cell_index(x, y)];
             if (entry_index != -1)
             {
                 auto const & e = _entries[entry_index];
@@ -0,0 +1,49 @@
+#include <algorithm>
+
+#include "grid_provider.hpp"
+
+grid_provider::~grid_provider()
+{
+}
+
+generated_grid_provider::generated_grid_provider(std::size_t size, std::function<void(std::size_t, std::string &)> format_caption, std::function<std::string(std::size_t)> image_path)
+    : _size(size)
+    , _format_caption(format_caption)
+    , _image_path(image_path)
+{
+}
+
+std::size_t generated_grid_provider::size() const
+{
+    return _size;
+}
+
+std::string_view generated_grid_provider::row(std::size_t index) const
+{
+    _buffer.clear();
+    _format_caption(index, _buffer);
+    return _buffer;
+}
+
+std::string generated_grid_provider::image_path(std::size_t index) const
+{
+    return _image_path(index);
+}
+
+void generated_grid_provider::insert_items(std::size_t position, std::size_t n)
+{
+    _size += n;
+    notify_rows_inserted(position, n);
+}
+
+void generated_grid_provider::remove_items(std::size_t position, std::size_t n)
+{
+    n = std::min(n, _size - std::min(position, _size));
+    _size -= n;
+    notify_rows_removed(position, n);
+}
+
+void generated_grid_provider::change_items(std::size_t position, std::size_t n)
+{
+    notify_rows_changed(position, n);
+}
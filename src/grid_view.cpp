@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <limits>
+
+#include "grid_view.hpp"
+
+// Between cells, horizontally and vertically.
+int const CELL_SPACING = 8;
+
+// Slots are kept for a row above and below the visible ones, such that
+// images are often ready before they scroll into view.
+int const PRELOAD_ROWS = 1;
+
+std::size_t const UNUSED_SLOT = std::numeric_limits<std::size_t>::max();
+
+grid_view::grid_view(std::shared_ptr<grid_provider> provider, image_loader & loader, vec cell_size, std::function<void(std::size_t)> activate_callback)
+    : _provider(provider)
+    , _loader(loader)
+    , _cell_size(cell_size)
+    , _activate_callback(activate_callback)
+    , _columns(1)
+    , _scroll_offset(0)
+    , _selected_position(0)
+{
+    _provider->add_observer(*this);
+}
+
+grid_view::~grid_view()
+{
+    for (auto & s : _slots)
+        reset_slot(s);
+    _provider->remove_observer(*this);
+}
+
+void grid_view::on_draw(draw_context & dc, selection_context const & sc) const
+{
+    rect const & box = get_box();
+    dc.draw_background(box);
+
+    std::size_t const size = _provider->size();
+    if (size == 0 || _slots.empty())
+        return;
+
+    // Cells at the border are only partially visible.
+    rect area = box;
+    std::optional<rect> const scissor = dc.get_scissor();
+    if (scissor.has_value() && SDL_IntersectRect(&scissor.value(), &area, &area) != SDL_TRUE)
+        return;
+    dc.set_scissor(&area);
+
+    int const rh = row_height();
+    for (std::size_t row = _scroll_offset / rh; row < row_count(); ++row)
+    {
+        if (static_cast<int>(row) * rh - _scroll_offset >= box.h)
+            break;
+
+        std::size_t const end = std::min(size, (row + 1) * _columns);
+        for (std::size_t index = row * _columns; index < end; ++index)
+        {
+            if (dc.is_visible(cell_box(index)))
+                draw_cell(dc, sc, index);
+        }
+    }
+
+    dc.set_scissor(scissor.has_value() ? &scissor.value() : nullptr);
+}
+
+bool grid_view::is_opaque() const
+{
+    return true;
+}
+
+void grid_view::on_mouse_down_event(mouse_down_event const & e)
+{
+    if (within_rect(e.position, get_box()))
+        _drag_start_offset = _scroll_offset;
+}
+
+void grid_view::on_mouse_up_event(mouse_up_event const & e)
+{
+    _drag_start_offset.reset();
+
+    // The grid already followed a swipe, a tap activates the item.
+    auto opt_info = get_swipe_info_with_context_info(e);
+    if (opt_info.has_value() && opt_info->type != swipe_info::type::DIRECTION)
+    {
+        std::size_t const index = hit_item(e.position);
+        if (index < _provider->size())
+        {
+            set_selected_position(index);
+            _activate_callback(index);
+        }
+    }
+}
+
+void grid_view::on_mouse_move_event(mouse_move_event const & e)
+{
+    if (_drag_start_offset.has_value() && e.opt_movement.has_value())
+        set_scroll_offset(_drag_start_offset.value() - e.opt_movement->length.h);
+}
+
+void grid_view::on_activate()
+{
+    if (_selected_position < _provider->size())
+        _activate_callback(_selected_position);
+}
+
+widget * grid_view::navigate_selectable(navigation_type nt, point center)
+{
+    std::size_t const size = _provider->size();
+    std::size_t const pos = _selected_position;
+    std::size_t const column = pos % _columns;
+
+    std::size_t next = UNUSED_SLOT;
+    switch (nt)
+    {
+        case navigation_type::NEXT_X:
+            if (column + 1 < _columns && pos + 1 < size)
+                next = pos + 1;
+            break;
+        case navigation_type::PREV_X:
+            if (column > 0)
+                next = pos - 1;
+            break;
+        case navigation_type::NEXT_Y:
+            // The last row might be shorter.
+            if (pos / _columns + 1 < row_count())
+                next = std::min(pos + _columns, size - 1);
+            break;
+        case navigation_type::PREV_Y:
+            if (pos >= _columns)
+                next = pos - _columns;
+            break;
+        case navigation_type::NEXT:
+            if (pos + 1 < size)
+                next = pos + 1;
+            break;
+        case navigation_type::PREV:
+            if (pos > 0 && pos < size)
+                next = pos - 1;
+            break;
+    }
+
+    if (next == UNUSED_SLOT)
+        return navigate_selectable_parent(nt, center);
+
+    set_selected_position(next);
+    return this;
+}
+
+void grid_view::on_box_allocated()
+{
+    rect const & box = get_box();
+    _columns = std::max(1, (box.w + CELL_SPACING) / (_cell_size.w + CELL_SPACING));
+
+    // One more for a partially visible row at both ends.
+    std::size_t const rows = box.h / row_height() + 2 + 2 * PRELOAD_ROWS;
+    std::size_t const slots = rows * _columns;
+    if (slots != _slots.size())
+    {
+        for (auto & s : _slots)
+            reset_slot(s);
+        _slots.resize(slots);
+        for (auto & s : _slots)
+            s.index = UNUSED_SLOT;
+    }
+
+    // Also assigns the slots.
+    set_scroll_offset(_scroll_offset);
+    update_slots();
+}
+
+void grid_view::release_resources()
+{
+    // Decoded surfaces are dropped after uploading, the images have to be
+    // loaded again.
+    for (auto & s : _slots)
+        reset_slot(s);
+    update_slots();
+
+    widget::release_resources();
+}
+
+size_hint grid_view::get_size_hint(int width, int height) const
+{
+    int const rh = row_height();
+    vec const minimal { opt_or_value(width, _cell_size.w), opt_or_value(height, rh) };
+    vec const natural { opt_or_value(width, 4 * _cell_size.w + 3 * CELL_SPACING), opt_or_value(height, 3 * rh) };
+    return size_hint(minimal, natural);
+}
+
+void grid_view::on_rows_inserted(std::size_t position, std::size_t n)
+{
+    if (_selected_position >= position && _selected_position + n < _provider->size())
+        _selected_position += n;
+
+    reset_slots_from(position);
+    set_scroll_offset(_scroll_offset);
+    update_slots();
+    mark_dirty();
+}
+
+void grid_view::on_rows_removed(std::size_t position, std::size_t n)
+{
+    if (_selected_position >= position + n)
+        _selected_position -= n;
+    else if (_selected_position >= position)
+        _selected_position = position;
+    std::size_t const size = _provider->size();
+    _selected_position = std::min(_selected_position, size == 0 ? 0 : size - 1);
+
+    reset_slots_from(position);
+    set_scroll_offset(_scroll_offset);
+    update_slots();
+    mark_dirty();
+}
+
+void grid_view::on_rows_changed(std::size_t position, std::size_t n)
+{
+    for (auto & s : _slots)
+    {
+        if (s.index != UNUSED_SLOT && s.index >= position && s.index - position < n)
+            reset_slot(s);
+    }
+    update_slots();
+    mark_dirty();
+}
+
+void grid_view::set_provider(std::shared_ptr<grid_provider> provider)
+{
+    _provider->remove_observer(*this);
+    _provider = provider;
+    _provider->add_observer(*this);
+
+    for (auto & s : _slots)
+        reset_slot(s);
+    _selected_position = 0;
+    _scroll_offset = 0;
+    update_slots();
+    mark_dirty();
+}
+
+void grid_view::set_scroll_offset(int offset)
+{
+    int const max_offset = std::max(0, static_cast<int>(row_count()) * row_height() - CELL_SPACING - get_box().h);
+    offset = std::clamp(offset, 0, max_offset);
+    if (offset == _scroll_offset)
+        return;
+
+    _scroll_offset = offset;
+    update_slots();
+    mark_dirty();
+}
+
+int grid_view::get_scroll_offset() const
+{
+    return _scroll_offset;
+}
+
+void grid_view::set_selected_position(std::size_t position)
+{
+    std::size_t const size = _provider->size();
+    position = std::min(position, size == 0 ? 0 : size - 1);
+    if (position == _selected_position)
+        return;
+
+    mark_dirty(cell_box(_selected_position));
+    _selected_position = position;
+    mark_dirty(cell_box(_selected_position));
+    scroll_to_item(_selected_position);
+}
+
+std::size_t grid_view::get_selected_position() const
+{
+    return _selected_position;
+}
+
+void grid_view::scroll_to_item(std::size_t index)
+{
+    int const top = static_cast<int>(index / _columns) * row_height();
+    int const bottom = top + row_height() - CELL_SPACING;
+    if (top < _scroll_offset)
+        set_scroll_offset(top);
+    else if (bottom > _scroll_offset + get_box().h)
+        set_scroll_offset(bottom - get_box().h);
+}
+
+int grid_view::row_height() const
+{
+    return _cell_size.h + get_context_info().font_line_skip() + CELL_SPACING;
+}
+
+std::size_t grid_view::row_count() const
+{
+    return (_provider->size() + _columns - 1) / _columns;
+}
+
+rect grid_view::cell_box(std::size_t index) const
+{
+    rect const & box = get_box();
+
+    // The columns are centered.
+    int const used_width = static_cast<int>(_columns) * (_cell_size.w + CELL_SPACING) - CELL_SPACING;
+    int const x_start = box.x + std::max(0, (box.w - used_width) / 2);
+
+    int const column = index % _columns;
+    int const row = index / _columns;
+    return { x_start + column * (_cell_size.w + CELL_SPACING)
+           , box.y + row * row_height() - _scroll_offset
+           , _cell_size.w
+           , row_height() - CELL_SPACING
+           };
+}
+
+std::size_t grid_view::hit_item(point p) const
+{
+    rect const & box = get_box();
+    if (!within_rect(p, box))
+        return UNUSED_SLOT;
+
+    std::size_t const row = (p.y - box.y + _scroll_offset) / row_height();
+    std::size_t const first = row * _columns;
+    std::size_t const end = std::min(_provider->size(), first + _columns);
+    for (std::size_t index = first; index < end; ++index)
+    {
+        if (within_rect(p, cell_box(index)))
+            return index;
+    }
+    return UNUSED_SLOT;
+}
+
+void grid_view::update_slots()
+{
+    if (_slots.empty())
+        return;
+
+    int const rh = row_height();
+    std::size_t const first_row = std::max(0, _scroll_offset / rh - PRELOAD_ROWS);
+    std::size_t const end_row = (_scroll_offset + get_box().h) / rh + 1 + PRELOAD_ROWS;
+
+    std::size_t const end = std::min(_provider->size(), end_row * _columns);
+    for (std::size_t index = first_row * _columns; index < end; ++index)
+        assign_slot(index % _slots.size(), index);
+}
+
+void grid_view::assign_slot(std::size_t slot, std::size_t index)
+{
+    cell_slot & s = _slots[slot];
+    if (s.index == index)
+        return;
+
+    reset_slot(s);
+    s.index = index;
+
+    std::string path = _provider->image_path(index);
+    if (path.empty())
+        return;
+
+    s.pending = _loader.load(std::move(path), _cell_size);
+    image_request const * r = s.pending.get();
+    s.pending->on_ready([this, slot, r](unique_surface_ptr surface)
+    {
+        // The slot might show another item by now.
+        if (slot >= _slots.size() || _slots[slot].pending.get() != r)
+            return;
+
+        cell_slot & s = _slots[slot];
+        s.pending.reset();
+        if (!surface)
+            return;
+
+        s.decoded = std::move(surface);
+        mark_dirty(cell_box(s.index));
+    });
+}
+
+void grid_view::reset_slot(cell_slot & s)
+{
+    if (s.pending)
+    {
+        s.pending->cancel();
+        s.pending.reset();
+    }
+    s.decoded.reset();
+    s.texture.reset();
+    s.index = UNUSED_SLOT;
+}
+
+void grid_view::reset_slots_from(std::size_t position)
+{
+    for (auto & s : _slots)
+    {
+        if (s.index != UNUSED_SLOT && s.index >= position)
+            reset_slot(s);
+    }
+}
+
+void grid_view::draw_cell(draw_context & dc, selection_context const & sc, std::size_t index) const
+{
+    rect const cell = cell_box(index);
+    rect const image_box { cell.x, cell.y, _cell_size.w, _cell_size.h };
+
+    if (index == _selected_position && sc.is_selected_widget(this))
+        dc.draw_entry_active_background(cell);
+
+    cell_slot & s = _slots[index % _slots.size()];
+    if (s.index == index && s.decoded)
+    {
+        s.texture = dc.create_texture(s.decoded.get());
+        s.decoded.reset();
+    }
+
+    if (s.index == index && s.texture)
+    {
+        rect target;
+        std::tie(target, std::ignore, std::ignore) = scale_preserve_ar(texture_dim(s.texture.get()), image_box);
+        dc.copy_texture(s.texture.get(), target);
+    }
+    else
+    {
+        // Shown while the image is loaded.
+        dc.draw_entry_background(image_box);
+    }
+
+    rect const caption_box { cell.x, cell.y + _cell_size.h, cell.w, cell.h - _cell_size.h };
+    dc.draw_text_line({ caption_box.x, caption_box.y }, caption_box, _provider->row(index));
+}
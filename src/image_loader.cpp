@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <SDL2/SDL_image.h>
+
+#include "image_loader.hpp"
+
+image_request::image_request()
+    : _cancelled(false)
+    , _done(false)
+    , _original_size{ 0, 0 }
+{
+}
+
+void image_request::cancel()
+{
+    _cancelled = true;
+}
+
+bool image_request::is_cancelled() const
+{
+    return _cancelled;
+}
+
+bool image_request::is_done() const
+{
+    return _done;
+}
+
+vec image_request::original_size() const
+{
+    return _original_size;
+}
+
+void image_request::on_ready(std::function<void(unique_surface_ptr)> f)
+{
+    if (_done)
+    {
+        if (!_cancelled)
+            f(std::move(_surface));
+    }
+    else
+    {
+        _on_ready = std::move(f);
+    }
+}
+
+void image_request::complete()
+{
+    _done = true;
+    if (!_cancelled && _on_ready)
+    {
+        // The callback might drop the last reference to the request.
+        auto f = std::move(_on_ready);
+        f(std::move(_surface));
+    }
+}
+
+image_loader::image_loader(std::shared_ptr<update_queue> updates, std::size_t num_threads)
+    : _updates(std::move(updates))
+    , _pool(num_threads)
+{
+}
+
+vec fit_image_size(vec size, vec max_size)
+{
+    double factor = 1.0;
+    if (max_size.w > 0)
+        factor = std::min(factor, static_cast<double>(max_size.w) / size.w);
+    if (max_size.h > 0)
+        factor = std::min(factor, static_cast<double>(max_size.h) / size.h);
+
+    if (factor >= 1.0)
+        return size;
+
+    return { std::max(1, static_cast<int>(size.w * factor + 0.5)), std::max(1, static_cast<int>(size.h * factor + 0.5)) };
+}
+
+std::shared_ptr<image_request> image_loader::load(std::string filename, vec max_size)
+{
+    auto request = std::make_shared<image_request>();
+    auto updates = _updates;
+    _pool.submit([request, updates, filename, max_size]()
+    {
+        // A track might have been skipped before its cover was decoded.
+        if (request->is_cancelled())
+            return;
+
+        unique_surface_ptr s(IMG_Load(filename.c_str()));
+        if (s)
+        {
+            vec const original { s->w, s->h };
+            vec const fitted = fit_image_size(original, max_size);
+            if (fitted.w != original.w || fitted.h != original.h)
+            {
+                try
+                {
+                    s = downscale_surface(s.get(), fitted);
+                }
+                catch (std::runtime_error const &)
+                {
+                    // Keep the original, the renderer scales it.
+                }
+            }
+            request->_original_size = original;
+        }
+
+        request->_surface = std::move(s);
+        updates->post([request]()
+        {
+            request->complete();
+        });
+    });
+    return request;
+}
+
@@ -0,0 +1,126 @@
+#include <mutex>
+#include <unordered_map>
+
+#include "interned_text.hpp"
+#include "utf8.hpp"
+
+// The keys refer to the texts of the entries, an entry has to be removed
+// before its text is destroyed.
+struct interned_text_table
+{
+    std::mutex mutex;
+    std::unordered_map<std::string_view, std::weak_ptr<interned_text::data const>> entries;
+};
+
+// Never destroyed, handles in static objects may outlive everything else.
+interned_text_table & interned_texts()
+{
+    static interned_text_table * table = new interned_text_table();
+    return *table;
+}
+
+void release_interned_text(interned_text::data const * d)
+{
+    {
+        interned_text_table & table = interned_texts();
+        std::lock_guard<std::mutex> lock(table.mutex);
+
+        // The text might have been interned again in the meantime, it then
+        // refers to the new entry.
+        auto it = table.entries.find(d->text);
+        if (it != table.entries.end() && it->first.data() == d->text.data())
+            table.entries.erase(it);
+    }
+    delete d;
+}
+
+std::size_t count_utf8_characters(std::string_view t)
+{
+    std::size_t n = 0;
+    for (char c : t)
+    {
+        if (!is_utf8_following_byte(c))
+            n++;
+    }
+    return n;
+}
+
+std::shared_ptr<interned_text::data const> intern_text(std::string_view t)
+{
+    // Keeps the common empty text out of the table.
+    static std::shared_ptr<interned_text::data const> const empty_text
+        = std::make_shared<interned_text::data const>(interned_text::data { std::string(), std::hash<std::string_view>()(std::string_view()), 0 });
+    if (t.empty())
+        return empty_text;
+
+    interned_text_table & table = interned_texts();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto it = table.entries.find(t);
+    if (it != table.entries.end())
+    {
+        if (auto d = it->second.lock())
+            return d;
+
+        // The text is about to be released, its key must not be used anymore.
+        table.entries.erase(it);
+    }
+
+    std::shared_ptr<interned_text::data const> d(
+        new interned_text::data { std::string(t), std::hash<std::string_view>()(t), count_utf8_characters(t) },
+        release_interned_text
+    );
+    table.entries.emplace(d->text, d);
+    return d;
+}
+
+interned_text::interned_text()
+    : interned_text(std::string_view())
+{
+}
+
+interned_text::interned_text(std::string_view t)
+    : _data(intern_text(t))
+{
+}
+
+std::string_view interned_text::view() const
+{
+    return _data->text;
+}
+
+std::string const & interned_text::str() const
+{
+    return _data->text;
+}
+
+interned_text::operator std::string_view() const
+{
+    return _data->text;
+}
+
+bool interned_text::empty() const
+{
+    return _data->text.empty();
+}
+
+std::size_t interned_text::hash() const
+{
+    return _data->hash;
+}
+
+std::size_t interned_text::length() const
+{
+    return _data->length;
+}
+
+bool interned_text::operator==(interned_text const & other) const
+{
+    return _data == other._data;
+}
+
+bool interned_text::operator!=(interned_text const & other) const
+{
+    return _data != other._data;
+}
+
@@ -1,19 +1,20 @@
 #include "label.hpp"
 #include "util.hpp"
 
-#include <sstream>
-
-std::vector<paragraph> parse_text_fragments(std::string text)
+std::vector<paragraph> parse_text_fragments(std::string_view text)
 {
     std::vector<paragraph> result;
-    std::istringstream iss;
-    iss.str(text);
 
-    std::string prev_paragraph;
+    std::string_view prev_paragraph;
     int trailing_newlines = 0;
 
-    for (std::string line; std::getline(iss, line);)
+    // A final newline does not start another line.
+    while (!text.empty())
     {
+        std::size_t const end = text.find('\n');
+        std::string_view const line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
         if (line.empty())
         {
             trailing_newlines++;
@@ -25,7 +26,7 @@ std::vector<paragraph> parse_text_fragments(std::string text)
                 result.emplace_back(prev_paragraph, trailing_newlines);
             }
 
-            prev_paragraph.swap(line);
+            prev_paragraph = line;
             trailing_newlines = 0;
         }
     }
@@ -35,24 +36,39 @@ std::vector<paragraph> parse_text_fragments(std::string text)
     return result;
 }
 
-paragraph::paragraph(std::string text, int trailing_newlines, int font_idx)
-    : text(text)
+paragraph::paragraph(interned_text text, int trailing_newlines, int font_idx)
+    : text(std::move(text))
     , trailing_newlines(trailing_newlines)
     , font_idx(font_idx)
 {
 }
 
-paragraph::paragraph(std::string text, int trailing_newlines)
+paragraph::paragraph(std::string_view text, int trailing_newlines, int font_idx)
+    : paragraph(interned_text(text), trailing_newlines, font_idx)
+{
+}
+
+paragraph::paragraph(std::string_view text, int trailing_newlines)
     : paragraph(text, trailing_newlines, 0)
 {
 }
 
-paragraph::paragraph(std::string text)
+paragraph::paragraph(std::string_view text)
     : paragraph(text, 0)
 {
 }
 
-label::label(std::string text)
+bool paragraph::operator==(paragraph const & other) const
+{
+    return text == other.text && trailing_newlines == other.trailing_newlines && font_idx == other.font_idx;
+}
+
+bool paragraph::operator!=(paragraph const & other) const
+{
+    return !(*this == other);
+}
+
+label::label(std::string_view text)
     : label(parse_text_fragments(text))
 {
 }
@@ -97,6 +113,11 @@ void label::on_draw(draw_context & dc, selection_context const & sc) const
 #endif
 }
 
+bool label::is_opaque() const
+{
+    return true;
+}
+
 size_hint label::get_size_hint(int width, int height) const
 {
     int wrap_param;
@@ -137,9 +158,30 @@ size_hint label::get_size_hint(int width, int height) const
 
 // label interface
 
-void label::set_text(std::string text)
+void label::set_text(std::string_view text)
 {
-    set_content(parse_text_fragments(text));
+    // Text without newlines is a single paragraph, e.g., a changing value.
+    if (text.find('\n') == std::string_view::npos)
+    {
+        if (_content.size() == 1 && _content.front().text.view() == text && _content.front().trailing_newlines == 0 && _content.front().font_idx == 0)
+            return;
+
+        set_paragraph(paragraph(text));
+    }
+    else
+    {
+        set_content(parse_text_fragments(text));
+    }
+}
+
+void label::set_paragraph(paragraph p)
+{
+    if (_content.size() == 1 && _content.front() == p)
+        return;
+
+    _content.resize(1);
+    _content.front() = std::move(p);
+    content_changed();
 }
 
 std::string label::get_text() const
@@ -147,7 +189,7 @@ std::string label::get_text() const
     std::string result;
     for (auto const & tf : _content)
     {
-        result += tf.text;
+        result += tf.text.view();
         for (int i = 0; i < tf.trailing_newlines; i++)
         {
             result += NEWLINE_C_STR;
@@ -158,8 +200,17 @@ std::string label::get_text() const
 
 void label::set_content(std::vector<paragraph> content)
 {
-    _content = content;
+    if (content == _content)
+        return;
 
+    _content = std::move(content);
+    content_changed();
+}
+
+void label::content_changed()
+{
+    invalidate_size_hint();
+    redo_layout();
     mark_dirty();
 }
 
@@ -171,15 +222,21 @@ std::vector<paragraph> const & label::get_content() const
 void label::set_minimum_width(int width)
 {
     _minimum_width = width;
+    invalidate_size_hint();
+    redo_layout();
 }
 
 void label::set_maximum_width(int width)
 {
     _maximum_width = width;
+    invalidate_size_hint();
+    redo_layout();
 }
 
 void label::set_wrap(bool wrap)
 {
     _wrap = wrap;
+    invalidate_size_hint();
+    redo_layout();
 }
 
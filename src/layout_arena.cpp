@@ -0,0 +1,54 @@
+#include <utility>
+
+#include "layout_arena.hpp"
+
+thread_local layout_arena * active_layout_arena = nullptr;
+
+layout_arena::layout_arena()
+    : _resource(_buffer.data(), _buffer.size())
+    , _depth(0)
+{
+}
+
+std::pmr::memory_resource * layout_arena::resource()
+{
+    if (active_layout_arena == nullptr)
+        return std::pmr::get_default_resource();
+    return &active_layout_arena->_resource;
+}
+
+void layout_arena::parallel_for(std::size_t n, std::function<void(std::size_t)> const & f)
+{
+    if (active_layout_arena == nullptr || active_layout_arena->_pool == nullptr || n < 2)
+    {
+        for (std::size_t k = 0; k < n; ++k)
+            f(k);
+    }
+    else
+    {
+        active_layout_arena->_pool->parallel_for(n, f);
+    }
+}
+
+void layout_arena::set_thread_pool(std::shared_ptr<thread_pool> pool)
+{
+    _pool = std::move(pool);
+}
+
+layout_arena::activation::activation(layout_arena & a)
+    : _arena(a)
+    , _previous(active_layout_arena)
+{
+    active_layout_arena = &a;
+    _arena._depth++;
+}
+
+layout_arena::activation::~activation()
+{
+    active_layout_arena = _previous;
+
+    // Nothing allocated in the pass is used anymore.
+    if (--_arena._depth == 0)
+        _arena._resource.release();
+}
+
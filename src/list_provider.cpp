@@ -0,0 +1,91 @@
+#include <algorithm>
+
+#include "list_provider.hpp"
+
+list_observer::~list_observer()
+{
+}
+
+list_provider::~list_provider()
+{
+}
+
+void list_provider::add_observer(list_observer & o)
+{
+    _observers.push_back(&o);
+}
+
+void list_provider::remove_observer(list_observer & o)
+{
+    _observers.erase(std::remove(_observers.begin(), _observers.end(), &o), _observers.end());
+}
+
+void list_provider::notify_rows_inserted(std::size_t position, std::size_t n)
+{
+    for (auto o : _observers)
+        o->on_rows_inserted(position, n);
+}
+
+void list_provider::notify_rows_removed(std::size_t position, std::size_t n)
+{
+    for (auto o : _observers)
+        o->on_rows_removed(position, n);
+}
+
+void list_provider::notify_rows_changed(std::size_t position, std::size_t n)
+{
+    for (auto o : _observers)
+        o->on_rows_changed(position, n);
+}
+
+vector_list_provider::vector_list_provider(std::vector<std::string> const & values)
+    : _values(values)
+{
+}
+
+std::size_t vector_list_provider::size() const
+{
+    return _values.get().size();
+}
+
+std::string_view vector_list_provider::row(std::size_t index) const
+{
+    return _values.get()[index];
+}
+
+generated_list_provider::generated_list_provider(std::size_t size, std::function<void(std::size_t, std::string &)> format_row)
+    : _size(size)
+    , _format_row(format_row)
+{
+}
+
+std::size_t generated_list_provider::size() const
+{
+    return _size;
+}
+
+std::string_view generated_list_provider::row(std::size_t index) const
+{
+    _buffer.clear();
+    _format_row(index, _buffer);
+    return _buffer;
+}
+
+void generated_list_provider::insert_rows(std::size_t position, std::size_t n)
+{
+    _size += n;
+    notify_rows_inserted(position, n);
+}
+
+void generated_list_provider::remove_rows(std::size_t position, std::size_t n)
+{
+    n = std::min(n, _size - std::min(position, _size));
+    _size -= n;
+    notify_rows_removed(position, n);
+}
+
+void generated_list_provider::change_rows(std::size_t position, std::size_t n)
+{
+    notify_rows_changed(position, n);
+}
+
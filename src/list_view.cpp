@@ -1,3 +1,6 @@
+#include <cmath>
+#include <cstdint>
+
 #include "list_view.hpp"
 #include "util.hpp"
 #include <iostream>
@@ -5,19 +8,37 @@
 // TODO use int for selected positions that can be invalid, otherwise increasing the size of the list will make them valid
 // TODO do bounds checking on positions
 list_view::list_view(std::vector<std::string> const & values, std::size_t position, std::function<void(std::size_t)> activate_callback)
+    : list_view(std::make_shared<vector_list_provider>(values), position, activate_callback)
+{
+}
+
+list_view::list_view(std::shared_ptr<list_provider> provider, std::size_t position, std::function<void(std::size_t)> activate_callback)
     : _opt_pressed_point{}
     , _position(position)
-    , _selected_position(values.size())
-    , _highlight_position(values.size())
+    , _selected_position(provider->size())
+    , _highlight_position(provider->size())
     , _x_shift(0)
-    , _values(values)
+    , _provider(provider)
     , _activate_callback(activate_callback)
     , _row_height(1)
+    , _visible_entries(0)
+    , _max_row_width(0)
+    , _row_texture(0)
+    , _row_texture_size{ 0, 0 }
+    , _cached_position(0)
+    , _cached_x_shift(0)
+    , _rows_valid(false)
+    , _kinetic_animation(NO_ANIMATION)
+    , _kinetic_velocity(0)
+    , _kinetic_offset(0)
 {
+    _provider->add_observer(*this);
 }
 
 list_view::~list_view()
 {
+    stop_kinetic_scrolling();
+    _provider->remove_observer(*this);
 }
 
 int const INDICATOR_MIN_WIDTH = 7;
@@ -27,48 +48,188 @@ void list_view::on_draw(draw_context & dc, selection_context const & sc) const
 {
     dc.draw_entry_box(get_box(), sc.is_selected_widget(this));
 
+    // the entry box has a border of 1 on each side TODO make more flexible
+    rect const rows_box { get_box().x + 1, get_box().y + 1, get_box().w - 2, get_box().h - 2 };
+    if (rows_box.w > 0 && rows_box.h > 0 && !draw_cached_rows(dc, sc, rows_box))
+    {
+        int const y_end = rows_box.y + rows_box.h;
+        for (std::size_t k = 0; rows_box.y + static_cast<int>(k) * _row_height < y_end; ++k)
+        {
+            int const y_offset = rows_box.y + static_cast<int>(k) * _row_height;
+            rect const r { rows_box.x, y_offset, rows_box.w, std::min(_row_height, y_end - y_offset) };
+
+            // Rows outside of a partial redraw do not have to be drawn.
+            if (dc.is_visible(r))
+                draw_row(dc, r, visible_slot(k, rows_box, sc));
+        }
+    }
+
+    // draw position indicator if it doesn't fit on one page
+    if (_provider->size() > static_cast<std::size_t>(_visible_entries))
+    {
+        int const ind_len = std::max(INDICATOR_MIN_HEIGHT, static_cast<int>(((get_box().h - 2) * _visible_entries) / _provider->size()));
+        int const ind_w = INDICATOR_MIN_WIDTH;
+
+        int const ind_y = get_box().y + 1 + ((get_box().h - 2 - ind_len) * _position) / (_provider->size() - _visible_entries);
+        rect ind_rect { get_box().x + get_box().w - ind_w - 1, ind_y, ind_w, ind_len};
+        dc.draw_entry_position_indicator(ind_rect);
+    }
+}
+
+bool list_view::row_slot::operator==(row_slot const & other) const
+{
+    return index == other.index && background == other.background;
+}
+
+bool list_view::row_slot::operator!=(row_slot const & other) const
+{
+    return !(*this == other);
+}
+
+list_view::row_slot list_view::visible_slot(std::size_t k, rect rows_box, selection_context const & sc) const
+{
+    std::size_t const n = _position + k;
+    if (n >= _provider->size())
+        return { SIZE_MAX, row_background::NORMAL };
+
     // TODO what was the difference between font height and font line skip?
     int const entry_height = static_cast<int>(get_context_info().font_height());
+    int const y_offset = rows_box.y + static_cast<int>(k) * _row_height;
+    rect const entry_rect { rows_box.x, y_offset, rows_box.w, std::min(entry_height, rows_box.y + rows_box.h - y_offset) };
+
+    // favor pressed over selected
+    if (_opt_pressed_point.has_value() && within_rect(_opt_pressed_point.value(), entry_rect))
+        return { n, row_background::PRESSED };
+    // favor pressed over active
+    else if (sc.is_selected_widget(this) && _selected_position == n)
+        return { n, row_background::ACTIVE };
+    else if (_highlight_position == n)
+        return { n, row_background::HIGHLIGHTED };
+    else
+        return { n, row_background::NORMAL };
+}
 
-    // the entry box has a border of 1 on each side TODO make more flexible
-    int const x_offset = get_box().x + 1;
-    int const entry_width = get_box().w - 2;
-    int y_offset = get_box().y + 1;
-    std::size_t n = _position;
-    int const y_end = get_box().y + get_box().h;
-    while (n < _values.get().size() && y_offset < y_end)
+void list_view::draw_row(draw_context & dc, rect r, row_slot s) const
+{
+    // The space between entries shows the background of the box.
+    dc.draw_entry_background(r);
+
+    int const entry_height = static_cast<int>(get_context_info().font_height());
+    rect const entry_rect { r.x, r.y, r.w, std::min(entry_height, r.h) };
+
+    switch (s.background)
     {
-        int const overlap = (y_offset + entry_height) - y_end;
-        int const entry_height_with_overlap = entry_height - /*(overlap < 0 ? 0 : overlap + 1);*/std::max(0, overlap + 1);
+        case row_background::PRESSED:
+            dc.draw_entry_pressed_background(entry_rect);
+            break;
+        case row_background::ACTIVE:
+            dc.draw_entry_active_background(entry_rect);
+            break;
+        case row_background::HIGHLIGHTED:
+            dc.draw_entry_hightlighted_background(entry_rect);
+            break;
+        case row_background::NORMAL:
+            break;
+    }
 
-        rect abs_rect { x_offset, y_offset, entry_width, entry_height_with_overlap};
+    if (s.index < _provider->size())
+        draw_row_content(dc, entry_rect, s.index);
+}
 
-        // favor pressed over selected
-        if (_opt_pressed_point.has_value() && within_rect(_opt_pressed_point.value(), abs_rect))
-            dc.draw_entry_pressed_background(abs_rect);
-        // favor pressed over active
-        else if (sc.is_selected_widget(this) && _selected_position == n)
-            dc.draw_entry_active_background(abs_rect);
-        else if (_highlight_position == n)
-            dc.draw_entry_hightlighted_background(abs_rect);
+void list_view::draw_row_content(draw_context & dc, rect entry_rect, std::size_t index) const
+{
+    std::string_view const row = _provider->row(index);
+    _max_row_width = std::max(_max_row_width, get_context_info().text_size(row).w);
+    dc.draw_entry_text(row, entry_rect, -static_cast<int>(_x_shift));
+}
+
+int list_view::content_width() const
+{
+    return _max_row_width;
+}
+
+void list_view::invalidate_cached_rows() const
+{
+    _rows_valid = false;
+}
+
+std::size_t list_view::get_x_shift() const
+{
+    return _x_shift;
+}
 
+std::size_t list_view::max_x_shift() const
+{
+    // The entry box has a border of 1 on each side.
+    return std::max(0, content_width() - (get_box().w - 2));
+}
 
-        dc.draw_entry_text(_values.get()[n], { x_offset, y_offset, entry_width, entry_height_with_overlap}, -_x_shift);
+bool list_view::draw_cached_rows(draw_context & dc, selection_context const & sc, rect rows_box) const
+{
+    // Only complete rows are kept, such that they can be moved.
+    std::size_t const slot_count = (rows_box.h + _row_height - 1) / _row_height;
+    vec const size { rows_box.w, static_cast<int>(slot_count) * _row_height };
 
-        y_offset += _row_height;
-        n++;
+    if (!_row_textures[_row_texture] || size.w != _row_texture_size.w || size.h != _row_texture_size.h)
+    {
+        for (auto & t : _row_textures)
+            t = dc.create_target_texture(size);
+        _row_texture_size = size;
+        _rows_valid = false;
     }
 
-    // draw position indicator if it doesn't fit on one page
-    if (_values.get().size() > static_cast<std::size_t>(_visible_entries))
+    if (!_row_textures[0] || !_row_textures[1])
+        return false;
+
+    // Swapped with the cached rows afterwards, such that neither allocates
+    // once they are large enough.
+    auto & slots = _slots;
+    slots.clear();
+    for (std::size_t k = 0; k < slot_count; ++k)
+        slots.push_back(visible_slot(k, rows_box, sc));
+
+    bool const reuse = _rows_valid && _cached_x_shift == _x_shift && _cached_rows.size() == slot_count;
+
+    // Positive when the rows moved up.
+    std::ptrdiff_t const shift = reuse ? static_cast<std::ptrdiff_t>(_position) - static_cast<std::ptrdiff_t>(_cached_position) : 0;
+    std::ptrdiff_t const count = static_cast<std::ptrdiff_t>(slot_count);
+    point const origin { rows_box.x, rows_box.y };
+
+    if (shift != 0 && shift > -count && shift < count)
     {
-        int const ind_len = std::max(INDICATOR_MIN_HEIGHT, static_cast<int>(((get_box().h - 2) * _visible_entries) / _values.get().size()));
-        int const ind_w = INDICATOR_MIN_WIDTH;
+        // A texture must not be drawn onto itself.
+        SDL_Texture * previous = _row_textures[_row_texture].get();
+        _row_texture = 1 - _row_texture;
+        dc.push_target(_row_textures[_row_texture].get(), origin);
+        dc.copy_texture(previous, { rows_box.x, rows_box.y - static_cast<int>(shift) * _row_height, size.w, size.h });
+    }
+    else
+    {
+        dc.push_target(_row_textures[_row_texture].get(), origin, !reuse);
+    }
 
-        int const ind_y = get_box().y + 1 + ((get_box().h - 2 - ind_len) * _position) / (_values.get().size() - _visible_entries);
-        rect ind_rect { get_box().x + get_box().w - ind_w - 1, ind_y, ind_w, ind_len};
-        dc.draw_entry_position_indicator(ind_rect);
+    for (std::size_t k = 0; k < slot_count; ++k)
+    {
+        std::ptrdiff_t const previous_k = static_cast<std::ptrdiff_t>(k) + shift;
+        bool const unchanged = reuse && previous_k >= 0 && previous_k < count && _cached_rows[previous_k] == slots[k];
+        if (!unchanged)
+            draw_row(dc, { rows_box.x, rows_box.y + static_cast<int>(k) * _row_height, size.w, _row_height }, slots[k]);
     }
+
+    dc.pop_target();
+
+    std::swap(_cached_rows, slots);
+    _cached_position = _position;
+    _cached_x_shift = _x_shift;
+    _rows_valid = true;
+
+    dc.copy_texture(_row_textures[_row_texture].get(), { 0, 0, rows_box.w, rows_box.h }, rows_box);
+    return true;
+}
+
+bool list_view::is_opaque() const
+{
+    return true;
 }
 
 int list_view::hit_entry(int y) const
@@ -100,11 +261,10 @@ void list_view::on_mouse_up_event(mouse_up_event const & e)
             {
                 // movement is positive here
                 std::size_t next_x_shift = _x_shift + (movement.length.w * font_height) / 15;
-                // TODO maximum? max of all entry widths
-                _x_shift = inc_ensure_upper(next_x_shift, _x_shift, 5000);
+                _x_shift = inc_ensure_upper(next_x_shift, _x_shift, max_x_shift());
                 mark_dirty();
             }
-            else
+            else if (!start_kinetic_scrolling(movement.velocity.h))
             {
                 int const distance = scroll_distance(movement.length.h);
 
@@ -124,7 +284,7 @@ void list_view::on_mouse_up_event(mouse_up_event const & e)
                 std::size_t const pressed_position = _position + down_entry;
 
                 // Ensure clicked entry is within bounds.
-                if (pressed_position < _values.get().size())
+                if (pressed_position < _provider->size())
                 {
                     _activate_callback(pressed_position);
                 }
@@ -155,7 +315,7 @@ int list_view::scroll_distance(int movement_height) const
     else
     {
         // move (size / 11) positions at most
-        int const y2 = _values.get().size() / 11;
+        int const y2 = _provider->size() / 11;
         int const x2 = get_box().h;
 
         double const slope = 0.0d;
@@ -173,20 +333,98 @@ int list_view::scroll_distance(int movement_height) const
     }
 }
 
+// Slower swipes jump instead, in pixels per second.
+int const KINETIC_MIN_START_VELOCITY = 200;
+
+// In rows per second.
+double const KINETIC_MIN_VELOCITY = 1.0;
+
+// The time in seconds after which the velocity dropped to about a third.
+double const KINETIC_TIME_CONSTANT = 0.325;
+
+bool list_view::start_kinetic_scrolling(int velocity)
+{
+    stop_kinetic_scrolling();
+
+    if (std::abs(velocity) < KINETIC_MIN_START_VELOCITY)
+        return false;
+
+    _kinetic_velocity = static_cast<double>(velocity) / _row_height;
+    _kinetic_offset = 0;
+    _kinetic_animation = get_context_info().start_animation([this](animation_scheduler::clock::duration dt)
+    {
+        return step_kinetic_scrolling(dt);
+    });
+    return _kinetic_animation != NO_ANIMATION;
+}
+
+void list_view::stop_kinetic_scrolling()
+{
+    if (_kinetic_animation != NO_ANIMATION)
+    {
+        get_context_info().stop_animation(_kinetic_animation);
+        _kinetic_animation = NO_ANIMATION;
+    }
+}
+
+bool list_view::step_kinetic_scrolling(animation_scheduler::clock::duration dt)
+{
+    // Integrating the decay exactly makes the distance independent of the
+    // frame rate.
+    double const seconds = std::chrono::duration<double>(dt).count();
+    double const decay = std::exp(-seconds / KINETIC_TIME_CONSTANT);
+    _kinetic_offset += _kinetic_velocity * KINETIC_TIME_CONSTANT * (1 - decay);
+    _kinetic_velocity *= decay;
+
+    double const rows = std::trunc(_kinetic_offset);
+    _kinetic_offset -= rows;
+
+    std::size_t const previous_position = _position;
+    if (rows < 0)
+        scroll_up(static_cast<std::size_t>(-rows));
+    else if (rows > 0)
+        scroll_down(static_cast<std::size_t>(rows));
+
+    // Stop at either end of the list.
+    bool const blocked = rows != 0 && _position == previous_position;
+    if (blocked || std::abs(_kinetic_velocity) < KINETIC_MIN_VELOCITY)
+    {
+        _kinetic_animation = NO_ANIMATION;
+        return false;
+    }
+    return true;
+}
+
 void list_view::on_mouse_down_event(mouse_down_event const & e)
 {
+    // Touching the list stops it.
+    stop_kinetic_scrolling();
+
     _opt_pressed_point = e.position;
     mark_dirty();
 }
 
+// Typing after a longer pause starts a new prefix.
+std::chrono::milliseconds const TYPE_AHEAD_TIMEOUT(1000);
+
 void list_view::on_key_event(key_event const & e)
 {
-    // implement scroll with keys?
+    if (e.type == key_type::TEXT && _prefix_index)
+    {
+        auto const now = std::chrono::steady_clock::now();
+        if (now - _last_type_ahead > TYPE_AHEAD_TIMEOUT)
+            _type_ahead.clear();
+        _last_type_ahead = now;
+
+        _type_ahead.append(e.text);
+        if (auto opt_row = _prefix_index->find(_type_ahead))
+            show_row(opt_row.value());
+    }
 }
 
 void list_view::on_activate()
 {
-    if (_selected_position < _values.get().size())
+    if (_selected_position < _provider->size())
         _activate_callback(_selected_position);
 }
 
@@ -197,6 +435,15 @@ void list_view::on_box_allocated()
     _visible_entries = (get_box().h - 2) / _row_height;
 }
 
+void list_view::release_resources()
+{
+    for (auto & t : _row_textures)
+        t.reset();
+    _rows_valid = false;
+
+    widget::release_resources();
+}
+
 
 size_hint list_view::get_size_hint(int width, int height) const
 {
@@ -221,14 +468,14 @@ size_hint list_view::get_size_hint(int width, int height) const
 
 void list_view::set_position(std::size_t position)
 {
-    auto size = _values.get().size();
+    auto size = _provider->size();
     _position = std::min(position, size == 0 ? 0 : size - 1);
     mark_dirty();
 }
 
 void list_view::set_selected_position(std::size_t position)
 {
-    auto size = _values.get().size();
+    auto size = _provider->size();
     _selected_position = std::min(position, size == 0 ? 0 : size - 1);
 
     if (_selected_position < _position + get_visible_entries()
@@ -238,7 +485,7 @@ void list_view::set_selected_position(std::size_t position)
 
 void list_view::set_highlight_position(std::size_t position)
 {
-    auto size = _values.get().size();
+    auto size = _provider->size();
     _highlight_position = std::min(position, size == 0 ? 0 : size - 1);
     if (_highlight_position < _position + get_visible_entries()
         && _highlight_position >= _position)
@@ -247,13 +494,91 @@ void list_view::set_highlight_position(std::size_t position)
 
 void list_view::set_list(std::vector<std::string> const & values, std::size_t position)
 {
-    _values = values;
+    set_provider(std::make_shared<vector_list_provider>(values), position);
+}
+
+void list_view::set_provider(std::shared_ptr<list_provider> provider, std::size_t position)
+{
+    _provider->remove_observer(*this);
+    _provider = provider;
+    _provider->add_observer(*this);
+    _rows_valid = false;
+    _max_row_width = 0;
+
     _position = position;
-    _selected_position = values.size();
-    _highlight_position = values.size();
+    _selected_position = _provider->size();
+    _highlight_position = _provider->size();
+    mark_dirty();
+}
+
+bool list_view::rows_visible(std::size_t position, std::size_t n) const
+{
+    return position < _position + static_cast<std::size_t>(_visible_entries) && position + n > _position;
+}
+
+// Positions at or beyond the old size refer to no row, those are kept beyond
+// the new size.
+void shift_inserted(std::size_t & p, std::size_t position, std::size_t n, std::size_t old_size)
+{
+    if (p >= old_size || p >= position)
+        p += n;
+}
+
+void shift_removed(std::size_t & p, std::size_t position, std::size_t n, std::size_t new_size)
+{
+    if (p >= new_size + n || (p >= position && p < position + n))
+        p = new_size;
+    else if (p >= position + n)
+        p -= n;
+}
+
+void list_view::on_rows_inserted(std::size_t position, std::size_t n)
+{
+    _rows_valid = false;
+
+    std::size_t const old_size = _provider->size() - n;
+    shift_inserted(_selected_position, position, n, old_size);
+    shift_inserted(_highlight_position, position, n, old_size);
+
+    // Keep showing the same rows.
+    if (position < _position)
+        _position += n;
+
+    // The position indicator changes as well.
     mark_dirty();
 }
 
+void list_view::on_rows_removed(std::size_t position, std::size_t n)
+{
+    _rows_valid = false;
+
+    std::size_t const new_size = _provider->size();
+    shift_removed(_selected_position, position, n, new_size);
+    shift_removed(_highlight_position, position, n, new_size);
+
+    if (_position >= position + n)
+        _position -= n;
+    else if (_position > position)
+        _position = position;
+    _position = std::min(_position, new_size == 0 ? 0 : new_size - 1);
+
+    mark_dirty();
+}
+
+void list_view::on_rows_changed(std::size_t position, std::size_t n)
+{
+    if (rows_visible(position, n))
+    {
+        _rows_valid = false;
+        mark_dirty();
+    }
+}
+
+std::size_t list_view::get_position() const
+{
+    return _position;
+}
+
 std::size_t list_view::get_visible_entries() const
 {
     return _visible_entries;
@@ -269,10 +594,35 @@ void list_view::scroll_up(std::size_t amount)
 void list_view::scroll_down(std::size_t amount)
 {
     unsigned int const next_selected_position = _position + amount;
-    _position = inc_ensure_upper(next_selected_position, _position, _values.get().size() < static_cast<std::size_t>(_visible_entries) ? 0 : _values.get().size() - _visible_entries);
+    _position = inc_ensure_upper(next_selected_position, _position, _provider->size() < static_cast<std::size_t>(_visible_entries) ? 0 : _provider->size() - _visible_entries);
     mark_dirty();
 }
 
+void list_view::set_prefix_index(std::shared_ptr<prefix_index> index)
+{
+    _prefix_index = index;
+    _type_ahead.clear();
+}
+
+bool list_view::jump_to_prefix(std::string_view prefix)
+{
+    if (!_prefix_index)
+        return false;
+
+    auto opt_row = _prefix_index->find_nearest(prefix);
+    if (!opt_row.has_value())
+        return false;
+
+    show_row(opt_row.value());
+    return true;
+}
+
+void list_view::show_row(std::size_t row)
+{
+    set_selected_position(row);
+    set_position(row);
+}
+
 void list_view::scroll_up()
 {
     scroll_up(_visible_entries);
@@ -0,0 +1,75 @@
+#include <algorithm>
+
+#include "memory_budget.hpp"
+
+memory_client::~memory_client()
+{
+}
+
+memory_budget::memory_budget()
+    : _limited(false)
+{
+}
+
+void memory_budget::add_client(memory_client & c, int priority)
+{
+    auto it = std::find_if(_clients.begin(), _clients.end(), [priority](client_entry const & e){ return e.priority < priority; });
+    _clients.insert(it, { &c, priority });
+}
+
+void memory_budget::remove_client(memory_client & c)
+{
+    auto it = std::find_if(_clients.begin(), _clients.end(), [&c](client_entry const & e){ return e.client == &c; });
+    if (it != _clients.end())
+        _clients.erase(it);
+}
+
+void memory_budget::set_byte_limit(std::optional<std::size_t> bytes)
+{
+    _byte_limit = bytes;
+}
+
+std::optional<std::size_t> memory_budget::byte_limit() const
+{
+    return _byte_limit;
+}
+
+std::size_t memory_budget::resident_bytes() const
+{
+    std::size_t result = 0;
+    for (auto const & e : _clients)
+        result += e.client->resident_bytes();
+    return result;
+}
+
+void memory_budget::enforce()
+{
+    if (!_byte_limit.has_value())
+    {
+        if (_limited)
+        {
+            for (auto const & e : _clients)
+                e.client->set_memory_limit(std::nullopt);
+            _limited = false;
+        }
+        return;
+    }
+
+    // A client may keep memory of the current frame beyond its limit, which
+    // is then taken from the following ones.
+    std::size_t remaining = _byte_limit.value();
+    for (auto const & e : _clients)
+    {
+        e.client->set_memory_limit(remaining);
+        remaining -= std::min(remaining, e.client->resident_bytes());
+    }
+    _limited = true;
+}
+
+void memory_budget::release_all()
+{
+    for (auto const & e : _clients)
+        e.client->set_memory_limit(0);
+    _limited = true;
+}
+
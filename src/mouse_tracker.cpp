@@ -1,49 +1,142 @@
 #include "mouse_tracker.hpp"
 
-void mouse_tracker::mouse_down(point p)
+// Older movements do not count towards the velocity, e.g., when the pointer
+// rested before it was released.
+uint32_t const VELOCITY_WINDOW_MS = 100;
+
+mouse_tracker::mouse_tracker()
 {
-    _opt_down_pos = p;
+    for (auto & ps : _pointers)
+    {
+        ps.down = false;
+        ps.next_sample = 0;
+        ps.num_samples = 0;
+    }
 }
 
-mouse_up_event mouse_tracker::mouse_up(point p)
+void mouse_tracker::mouse_down(point p, uint32_t time, pointer_id id)
 {
-    if (_opt_down_pos.has_value())
+    // An up event might have been missed.
+    pointer_state * ps = find_pointer(id);
+    if (ps == nullptr)
+    {
+        for (auto & candidate : _pointers)
+        {
+            if (!candidate.down)
+            {
+                ps = &candidate;
+                break;
+            }
+        }
+    }
+
+    if (ps != nullptr)
     {
-        auto down_p = _opt_down_pos.value();
-        auto length = p - down_p;
+        ps->id = id;
+        ps->down = true;
+        ps->down_position = p;
+        ps->next_sample = 0;
+        ps->num_samples = 0;
+        ps->add_sample(p, time);
+    }
+}
 
-        return mouse_up_event { p, std::make_optional(mouse_movement { down_p, length }) };
+mouse_up_event mouse_tracker::mouse_up(point p, uint32_t time, pointer_id id)
+{
+    pointer_state * ps = find_pointer(id);
+    if (ps != nullptr)
+    {
+        ps->add_sample(p, time);
+        ps->down = false;
 
-        _opt_down_pos.reset();
+        return mouse_up_event { p, std::make_optional(ps->movement()), id };
     }
     else
     {
-        return mouse_up_event { p, std::nullopt };
+        return mouse_up_event { p, std::nullopt, id };
     }
 }
 
-mouse_move_event mouse_tracker::mouse_move(point p)
+mouse_move_event mouse_tracker::mouse_move(point p, uint32_t time, pointer_id id)
 {
-
     // TODO make use of relative movement from SDL?
 
-    // TODO
-    /*
-    std::optional<mouse_movement> opt_movement;
+    pointer_state * ps = find_pointer(id);
+    if (ps != nullptr)
+    {
+        ps->add_sample(p, time);
+        return mouse_move_event { p, std::make_optional(ps->movement()), id };
+    }
+    else
+    {
+        return mouse_move_event { p, std::nullopt, id };
+    }
+}
 
-    if (_opt_down_pos.has_value())
+mouse_tracker::pointer_state * mouse_tracker::find_pointer(pointer_id id)
+{
+    for (auto & ps : _pointers)
     {
-        _opt_down_pos.value();
+        if (ps.down && ps.id == id)
+            return &ps;
+    }
+    return nullptr;
+}
 
-        _opt_movement = 
+void mouse_tracker::pointer_state::add_sample(point p, uint32_t time)
+{
+    samples[next_sample] = { p, time };
+    next_sample = (next_sample + 1) % MAX_SAMPLES;
+    if (num_samples < MAX_SAMPLES)
+        num_samples++;
+}
 
-        struct mouse_movement
-        {
-            point origin;
-            vec length;
-        };
+mouse_tracker::sample const & mouse_tracker::pointer_state::recent(std::size_t k) const
+{
+    return samples[(next_sample + MAX_SAMPLES - 1 - k) % MAX_SAMPLES];
+}
+
+// In pixels per second, zero if no time passed.
+vec sample_velocity(point from, uint32_t from_time, point to, uint32_t to_time)
+{
+    int const dt = static_cast<int>(to_time - from_time);
+    if (dt <= 0)
+        return { 0, 0 };
+
+    vec const d = to - from;
+    return { (d.w * 1000) / dt, (d.h * 1000) / dt };
+}
+
+mouse_movement mouse_tracker::pointer_state::movement() const
+{
+    sample const & last = recent(0);
+    mouse_movement m { down_position, last.position - down_position, { 0, 0 }, { 0, 0 } };
+
+    // The samples within the window.
+    std::size_t n = 1;
+    while (n < num_samples && last.time - recent(n).time <= VELOCITY_WINDOW_MS)
+        n++;
+
+    if (n < 2)
+        return m;
+
+    sample const & oldest = recent(n - 1);
+    m.velocity = sample_velocity(oldest.position, oldest.time, last.position, last.time);
+
+    // Compare the velocities of both halves of the window, which needs at
+    // least three samples.
+    if (n >= 3)
+    {
+        sample const & middle = recent((n - 1) / 2);
+        vec const v1 = sample_velocity(oldest.position, oldest.time, middle.position, middle.time);
+        vec const v2 = sample_velocity(middle.position, middle.time, last.position, last.time);
+
+        // Between the centers of the halves.
+        int const dt = static_cast<int>(last.time - oldest.time) / 2;
+        if (dt > 0)
+            m.acceleration = { ((v2.w - v1.w) * 1000) / dt, ((v2.h - v1.h) * 1000) / dt };
     }
-    */
 
-    return mouse_move_event { p };
+    return m;
 }
+
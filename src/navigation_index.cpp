@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "navigation_index.hpp"
+#include "navigation_type.hpp"
+#include "region.hpp"
+#include "selectable.hpp"
+#include "widget.hpp"
+
+navigation_index::navigation_index()
+    : _generation(0)
+    , _built(false)
+{
+}
+
+void navigation_index::rebuild(widget & root)
+{
+    _entries.clear();
+    _positions.clear();
+
+    // Depth first in child order, like the navigation of the containers.
+    std::vector<widget *> stack { &root };
+    while (!stack.empty())
+    {
+        widget * w = stack.back();
+        stack.pop_back();
+
+        if (dynamic_cast<selectable *>(w) != nullptr)
+        {
+            _positions[w] = _entries.size();
+            _entries.push_back({ w, rect_center(w->get_box()) });
+        }
+
+        auto children = w->get_visible_children();
+        for (auto it = children.end(); it != children.begin();)
+        {
+            --it;
+            stack.push_back(*it);
+        }
+    }
+
+    _by_x.resize(_entries.size());
+    _by_y.resize(_entries.size());
+    for (std::size_t k = 0; k < _entries.size(); ++k)
+    {
+        _by_x[k] = k;
+        _by_y[k] = k;
+    }
+    std::stable_sort(_by_x.begin(), _by_x.end(), [this](std::size_t a, std::size_t b){ return _entries[a].center.x < _entries[b].center.x; });
+    std::stable_sort(_by_y.begin(), _by_y.end(), [this](std::size_t a, std::size_t b){ return _entries[a].center.y < _entries[b].center.y; });
+
+    _generation = region::layout_generation();
+    _built = true;
+}
+
+bool navigation_index::is_current() const
+{
+    return _built && _generation == region::layout_generation();
+}
+
+widget * navigation_index::navigate(navigation_type nt, widget const * from, point center) const
+{
+    switch (nt)
+    {
+        case navigation_type::NEXT:
+        case navigation_type::PREV:
+        {
+            auto it = _positions.find(from);
+            if (it == _positions.end())
+                return nullptr;
+
+            std::size_t const k = it->second;
+            if (nt == navigation_type::NEXT)
+                return k + 1 < _entries.size() ? _entries[k + 1].w : nullptr;
+            else
+                return k > 0 ? _entries[k - 1].w : nullptr;
+        }
+        case navigation_type::NEXT_X:
+            return nearest(_by_x, true, true, from, center);
+        case navigation_type::PREV_X:
+            return nearest(_by_x, true, false, from, center);
+        case navigation_type::NEXT_Y:
+            return nearest(_by_y, false, true, from, center);
+        case navigation_type::PREV_Y:
+            return nearest(_by_y, false, false, from, center);
+    }
+    return nullptr;
+}
+
+bool navigation_index::contains(widget const * w) const
+{
+    return _positions.find(w) != _positions.end();
+}
+
+std::size_t navigation_index::size() const
+{
+    return _entries.size();
+}
+
+widget * navigation_index::nearest(std::vector<std::size_t> const & sorted, bool horizontal, bool forward, widget const * from, point center) const
+{
+    auto primary = [horizontal](point p){ return horizontal ? p.x : p.y; };
+    auto secondary = [horizontal](point p){ return horizontal ? p.y : p.x; };
+
+    int const origin = primary(center);
+    auto cmp_less = [&](std::size_t k, int v){ return primary(_entries[k].center) < v; };
+    auto cmp_greater = [&](int v, std::size_t k){ return v < primary(_entries[k].center); };
+
+    widget * best = nullptr;
+    long best_cost = 0;
+
+    auto consider = [&](std::size_t k)
+    {
+        entry const & e = _entries[k];
+        long const distance = std::abs(primary(e.center) - origin);
+        if (best != nullptr && distance >= best_cost)
+            return false;
+
+        long const cost = distance + 2L * std::abs(secondary(e.center) - secondary(center));
+        if (e.w != from && (best == nullptr || cost < best_cost))
+        {
+            best = e.w;
+            best_cost = cost;
+        }
+        return true;
+    };
+
+    // Only centers strictly beyond the origin count.
+    if (forward)
+    {
+        auto it = std::upper_bound(sorted.begin(), sorted.end(), origin, cmp_greater);
+        for (; it != sorted.end() && consider(*it); ++it)
+        {
+        }
+    }
+    else
+    {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), origin, cmp_less);
+        while (it != sorted.begin())
+        {
+            --it;
+            if (!consider(*it))
+                break;
+        }
+    }
+
+    return best;
+}
+
@@ -1,12 +1,22 @@
+#include <algorithm>
+
 #include "notebook.hpp"
 
 notebook::notebook(std::vector<widget_ptr> pages)
-    : _pages(pages)
+    : _pages(std::move(pages))
     , _current_page_index(0)
+    , _stale_layouts(_pages.size(), true)
+    , _page_retention(0)
 {
     // TODO enforce invariant that _current_page_index is always valid? zero elements ok?
-    for (auto p : _pages)
+    for (auto const & p : _pages)
+    {
         p->set_parent(this);
+        _page_ptrs.push_back(p.get());
+    }
+
+    if (!_pages.empty())
+        _recent_pages.push_back(0);
 }
 
 notebook::~notebook()
@@ -15,49 +25,67 @@ notebook::~notebook()
 
 void notebook::on_child_dirty(widget * w)
 {
-    if (w == get_shown_widget())
+    if (!_pages.empty() && w == get_shown_widget())
         mark_child_dirty(w);
 }
 
-std::vector<widget *> notebook::get_visible_children()
+widget_range notebook::get_visible_children()
 {
-    return { get_shown_widget() };
+    if (_page_ptrs.empty())
+        return {};
+    return { &_page_ptrs[_current_page_index], 1 };
 }
 
-std::vector<widget const *> notebook::get_visible_children() const
+const_widget_range notebook::get_visible_children() const
 {
-    return { get_shown_widget() };
+    if (_page_ptrs.empty())
+        return {};
+    return widget_range(&_page_ptrs[_current_page_index], 1);
 }
 
 void notebook::on_draw(draw_context & dc, selection_context const & sc) const
 {
-    dc.draw_background(get_box());
-    get_shown_widget()->on_draw(dc, sc);
+    // The page is drawn as a child.
+    if (!is_covered_by_children())
+        dc.draw_background(get_box());
+}
+
+bool notebook::is_opaque() const
+{
+    return true;
 }
 
 void notebook::on_mouse_up_event(mouse_up_event const & e)
 {
-    get_shown_widget()->on_mouse_up_event(e);
+    if (!_pages.empty())
+        get_shown_widget()->on_mouse_up_event(e);
 }
 
 void notebook::on_mouse_down_event(mouse_down_event const & e)
 {
-    get_shown_widget()->on_mouse_down_event(e);
+    if (!_pages.empty())
+        get_shown_widget()->on_mouse_down_event(e);
 }
 
 void notebook::on_box_allocated()
 {
-    for (auto p : _pages)
-        p->apply_layout(get_box());
+    // Only the shown page has to be laid out, the others are when they are
+    // shown.
+    std::fill(_stale_layouts.begin(), _stale_layouts.end(), true);
+    layout_shown_page();
 }
 
 widget * notebook::find_selectable(navigation_type nt, point center)
 {
+    if (_pages.empty())
+        return nullptr;
     return get_shown_widget()->find_selectable(nt, center);
 }
 
 widget * notebook::navigate_selectable(navigation_type nt, point center)
 {
+    if (_pages.empty())
+        return navigate_selectable_parent(nt, center);
     return get_shown_widget()->navigate_selectable(nt, center);
 }
 
@@ -84,27 +112,153 @@ std::size_t notebook::get_page() const
 void notebook::set_page(std::size_t index)
 {
     if (index < _pages.size())
+    {
         _current_page_index = index;
+        layout_shown_page();
+
+        _recent_pages.erase(std::remove(_recent_pages.begin(), _recent_pages.end(), index), _recent_pages.end());
+        _recent_pages.insert(_recent_pages.begin(), index);
+        release_unused_pages();
+    }
+    advance_layout_generation();
+    mark_dirty();
+}
+
+void notebook::set_page_retention(std::size_t pages)
+{
+    _page_retention = pages;
+    release_unused_pages();
+}
+
+std::size_t notebook::page_count() const
+{
+    return _pages.size();
+}
+
+void notebook::insert_page(std::size_t index, widget_ptr page)
+{
+    index = std::min(index, _pages.size());
+    attach_child(*page);
+    _page_ptrs.insert(_page_ptrs.begin() + index, page.get());
+    _pages.insert(_pages.begin() + index, std::move(page));
+    _stale_layouts.insert(_stale_layouts.begin() + index, true);
+
+    for (auto & k : _recent_pages)
+    {
+        if (k >= index)
+            k++;
+    }
+
+    if (_pages.size() == 1)
+    {
+        _current_page_index = 0;
+        _recent_pages.push_back(0);
+    }
+    else if (index <= _current_page_index)
+    {
+        _current_page_index++;
+    }
+
+    pages_changed();
+}
+
+widget_ptr notebook::remove_page(std::size_t index)
+{
+    widget_ptr page = std::move(_pages.at(index));
+    detach_child(*page);
+    _pages.erase(_pages.begin() + index);
+    _page_ptrs.erase(_page_ptrs.begin() + index);
+    _stale_layouts.erase(_stale_layouts.begin() + index);
+
+    _recent_pages.erase(std::remove(_recent_pages.begin(), _recent_pages.end(), index), _recent_pages.end());
+    for (auto & k : _recent_pages)
+    {
+        if (k > index)
+            k--;
+    }
+
+    if (index < _current_page_index)
+    {
+        _current_page_index--;
+    }
+    else if (index == _current_page_index && !_pages.empty())
+    {
+        _current_page_index = std::min(index, _pages.size() - 1);
+        _recent_pages.erase(std::remove(_recent_pages.begin(), _recent_pages.end(), _current_page_index), _recent_pages.end());
+        _recent_pages.insert(_recent_pages.begin(), _current_page_index);
+    }
+    else if (_pages.empty())
+    {
+        _current_page_index = 0;
+    }
+
+    pages_changed();
+    return page;
+}
+
+widget_ptr notebook::replace_page(std::size_t index, widget_ptr page)
+{
+    widget_ptr & old = _pages.at(index);
+    detach_child(*old);
+    attach_child(*page);
+    _page_ptrs[index] = page.get();
+    _stale_layouts[index] = true;
+    std::swap(old, page);
+
+    pages_changed();
+    return page;
+}
+
+void notebook::pages_changed()
+{
+    advance_layout_generation();
+    invalidate_size_hint();
+    redo_layout();
+
+    // The shown page might be a different one within the same box.
+    layout_shown_page();
     mark_dirty();
 }
 
-std::vector<widget *> notebook::get_children()
+void notebook::layout_shown_page()
+{
+    if (_pages.empty() || !_stale_layouts[_current_page_index])
+        return;
+
+    _stale_layouts[_current_page_index] = false;
+    get_shown_widget()->apply_layout(get_box());
+}
+
+void notebook::release_unused_pages()
 {
-    std::vector<widget *> res;
-    for (auto & ptr : _pages)
+    // The shown page is always in front.
+    if (_page_retention == 0)
+        return;
+
+    while (_recent_pages.size() > _page_retention)
     {
-        res.push_back(ptr.get());
+        _pages[_recent_pages.back()]->release_resources();
+        _recent_pages.pop_back();
     }
-    return res;
+}
+
+widget_range notebook::get_children()
+{
+    return _page_ptrs;
+}
+
+const_widget_range notebook::get_children() const
+{
+    return widget_range(_page_ptrs);
 }
 
 size_hint notebook::get_size_hint(int width, int height) const
 {
     vec minimal = { 0, 0 };
     vec natural = { 0, 0 };
-    for (auto p : _pages)
+    for (auto const & p : _pages)
     {
-        auto sh = p->get_size_hint(width, height);
+        auto sh = p->query_size_hint(width, height);
         minimal.w = std::max(minimal.w, sh.minimal.w);
         minimal.h = std::max(minimal.h, sh.minimal.h);
         natural.w = std::max(natural.w, sh.natural.w);
@@ -0,0 +1,76 @@
+#include <stdexcept>
+
+#include <SDL2/SDL_version.h>
+
+#include "offscreen_renderer.hpp"
+
+offscreen_renderer::offscreen_renderer(vec size)
+    : _surface(SDL_CreateRGBSurfaceWithFormat(0, size.w, size.h, 32, SDL_PIXELFORMAT_ARGB8888))
+    , _renderer(nullptr)
+{
+    if (!_surface)
+        throw std::runtime_error(std::string("could not create offscreen surface: ") + SDL_GetError());
+
+    _renderer = SDL_CreateSoftwareRenderer(_surface.get());
+    if (_renderer == nullptr)
+        throw std::runtime_error(std::string("could not create offscreen renderer: ") + SDL_GetError());
+}
+
+offscreen_renderer::~offscreen_renderer()
+{
+    SDL_DestroyRenderer(_renderer);
+}
+
+SDL_Renderer * offscreen_renderer::renderer() const
+{
+    return _renderer;
+}
+
+rect offscreen_renderer::box() const
+{
+    return { 0, 0, _surface->w, _surface->h };
+}
+
+SDL_Surface * offscreen_renderer::frame()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+    // Operations may still be queued.
+    SDL_RenderFlush(_renderer);
+#endif
+    return _surface.get();
+}
+
+unique_surface_ptr offscreen_renderer::copy_frame()
+{
+    SDL_Surface * s = frame();
+    unique_surface_ptr result(SDL_ConvertSurfaceFormat(s, s->format->format, 0));
+    if (!result)
+        throw std::runtime_error(std::string("could not copy frame: ") + SDL_GetError());
+    return result;
+}
+
+void offscreen_renderer::save_frame(std::string const & path)
+{
+    if (SDL_SaveBMP(frame(), path.c_str()) < 0)
+        throw std::runtime_error("could not save frame to " + path + ": " + SDL_GetError());
+}
+
+std::size_t frame_difference(SDL_Surface * a, SDL_Surface * b)
+{
+    if (a->w != b->w || a->h != b->h || a->format->format != b->format->format || a->format->BytesPerPixel != 4)
+        throw std::runtime_error("frames can not be compared");
+
+    std::size_t result = 0;
+    for (int y = 0; y < a->h; ++y)
+    {
+        auto const * ra = reinterpret_cast<uint32_t const *>(static_cast<uint8_t const *>(a->pixels) + y * a->pitch);
+        auto const * rb = reinterpret_cast<uint32_t const *>(static_cast<uint8_t const *>(b->pixels) + y * b->pitch);
+        for (int x = 0; x < a->w; ++x)
+        {
+            if (ra[x] != rb[x])
+                ++result;
+        }
+    }
+    return result;
+}
+
@@ -37,7 +37,7 @@ size_hint padding::get_size_hint(int width, int height) const
     int const hpad = _pad_left + _pad_right;
     int const vpad = _pad_top + _pad_bottom;
 
-    auto sh = _child->get_size_hint(opt_change(width, width - hpad), opt_change(height, height - vpad));
+    auto sh = _child->query_size_hint(opt_change(width, width - hpad), opt_change(height, height - vpad));
 
     sh.minimal.w += hpad;
     sh.minimal.h += vpad;
@@ -50,21 +50,29 @@ size_hint padding::get_size_hint(int width, int height) const
 void padding::set_pad_left(int pad_left)
 {
     _pad_left = std::max(0, pad_left);
+    invalidate_size_hint();
+    redo_layout();
 }
 
 void padding::set_pad_right(int pad_right)
 {
     _pad_right = std::max(0, pad_right);
+    invalidate_size_hint();
+    redo_layout();
 }
 
 void padding::set_pad_top(int pad_top)
 {
     _pad_top = std::max(0, pad_top);
+    invalidate_size_hint();
+    redo_layout();
 }
 
 void padding::set_pad_bottom(int pad_bottom)
 {
     _pad_bottom = std::max(0, pad_bottom);
+    invalidate_size_hint();
+    redo_layout();
 }
 
 int padding::get_pad_left() const
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <SDL2/SDL_surface.h>
+
+#include "pipelined_backend.hpp"
+
+// The frame shown and the one waiting, the next one is recorded meanwhile.
+std::size_t const MAX_QUEUED_FRAMES = 2;
+
+// Coverage of words is small, a block holds that of many.
+std::size_t const COVERAGE_BLOCK_SIZE = 64 * 1024;
+
+pipelined_backend::pipelined_backend(std::unique_ptr<render_backend> backend)
+    : _backend(std::move(backend))
+    , _recording(std::make_unique<frame>())
+    , _stopping(false)
+{
+    if (!_backend->needs_pixels())
+        throw std::runtime_error("pipelined presenting requires a backend that draws without the renderer");
+
+    recycle(*_recording);
+    _thread = std::thread([this](){ run(); });
+}
+
+pipelined_backend::~pipelined_backend()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _frame_queued.notify_one();
+
+    // Frames that were presented are still shown.
+    _thread.join();
+
+    for (auto & f : _shown)
+        recycle(*f);
+    recycle(*_recording);
+}
+
+void pipelined_backend::fill_rects(render_state const & s, rect const * rs, int count)
+{
+    record_rects(display_command_type::FILL_RECT, s, rs, count);
+}
+
+void pipelined_backend::draw_rects(render_state const & s, rect const * rs, int count)
+{
+    record_rects(display_command_type::DRAW_RECT, s, rs, count);
+}
+
+void pipelined_backend::copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod)
+{
+    texture_ref kept = t;
+
+    // The backends only use the texture to look up its color modulation, the
+    // pixels have to outlive the frame.
+    if (t.surface != nullptr)
+    {
+        t.surface->refcount++;
+        _recording->surfaces.push_back(t.surface);
+    }
+    else if (t.alpha != nullptr && src != nullptr)
+    {
+        kept.alpha = keep_coverage(t.alpha, static_cast<std::size_t>(src->w) * src->h);
+    }
+    else
+    {
+        kept.alpha = nullptr;
+    }
+
+    _recording->commands.push({ display_command_type::COPY, s, dst, kept, src == nullptr ? std::nullopt : std::optional<rect>(*src), color_mod });
+}
+
+void pipelined_backend::present(damage_region const * damage)
+{
+    if (damage != nullptr)
+        _recording->damage = *damage;
+    else
+        _recording->damage.reset();
+
+    std::unique_ptr<frame> next;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // Recording may not get further ahead than one frame.
+        _frame_shown.wait(lock, [this](){ return _queued.size() < MAX_QUEUED_FRAMES; });
+        rethrow_error();
+
+        _queued.push_back(std::move(_recording));
+        if (!_shown.empty())
+        {
+            next = std::move(_shown.back());
+            _shown.pop_back();
+        }
+    }
+    _frame_queued.notify_one();
+
+    if (!next)
+        next = std::make_unique<frame>();
+    recycle(*next);
+    _recording = std::move(next);
+}
+
+unique_texture_ptr pipelined_backend::create_target_texture(vec size)
+{
+    return unique_texture_ptr();
+}
+
+void pipelined_backend::set_target(SDL_Texture * t, bool clear)
+{
+    // Without targets everything is drawn to the framebuffer.
+}
+
+bool pipelined_backend::needs_pixels() const
+{
+    return true;
+}
+
+void pipelined_backend::invalidate_state()
+{
+    _recording->invalidate_state = true;
+}
+
+void pipelined_backend::wait_for_frames()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _frame_shown.wait(lock, [this](){ return _queued.empty(); });
+    rethrow_error();
+}
+
+uint8_t const * pipelined_backend::keep_coverage(uint8_t const * alpha, std::size_t size)
+{
+    frame & f = *_recording;
+
+    // Continue in the next block if the current one is used up, insert one
+    // if the next is too small.
+    if (f.block_used > 0 && f.blocks[f.block_index].size - f.block_used < size)
+    {
+        f.block_index++;
+        f.block_used = 0;
+    }
+
+    if (f.block_index == f.blocks.size() || f.blocks[f.block_index].size < size)
+    {
+        std::size_t const block_size = std::max(COVERAGE_BLOCK_SIZE, size);
+        f.blocks.insert(f.blocks.begin() + f.block_index, { std::make_unique<uint8_t[]>(block_size), block_size });
+    }
+
+    uint8_t * result = f.blocks[f.block_index].data.get() + f.block_used;
+    std::memcpy(result, alpha, size);
+    f.block_used += size;
+    return result;
+}
+
+void pipelined_backend::record_rects(display_command_type type, render_state const & s, rect const * rs, int count)
+{
+    for (int k = 0; k < count; ++k)
+        _recording->commands.push({ type, s, rs[k], {}, std::nullopt, std::nullopt });
+}
+
+void pipelined_backend::recycle(frame & f)
+{
+    for (SDL_Surface * s : f.surfaces)
+        SDL_FreeSurface(s);
+    f.surfaces.clear();
+
+    f.commands.clear();
+    f.damage.reset();
+    f.invalidate_state = false;
+    f.block_index = 0;
+    f.block_used = 0;
+}
+
+void pipelined_backend::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        _frame_queued.wait(lock, [this](){ return _stopping || !_queued.empty(); });
+        if (_queued.empty())
+            return;
+
+        frame & f = *_queued.front();
+        lock.unlock();
+
+        std::exception_ptr error;
+        try
+        {
+            execute(f);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        if (error && !_error)
+            _error = error;
+
+        // Surfaces are released when the frame is recorded to again, the
+        // recording thread might release them as well.
+        _shown.push_back(std::move(_queued.front()));
+        _queued.pop_front();
+        _frame_shown.notify_all();
+    }
+}
+
+void pipelined_backend::execute(frame & f)
+{
+    if (f.invalidate_state)
+        _backend->invalidate_state();
+
+    auto const & cs = f.commands.commands();
+    for (std::size_t i = 0; i < cs.size();)
+    {
+        display_command const & c = cs[i];
+        if (c.type == display_command_type::COPY)
+        {
+            _backend->copy(c.state, c.texture, c.source.has_value() ? &c.source.value() : nullptr, c.target, c.color_mod);
+            ++i;
+            continue;
+        }
+
+        // Rectangles were passed together, draw them in one call again.
+        _rects.clear();
+        std::size_t j = i;
+        for (; j < cs.size() && cs[j].type == c.type && cs[j].state == c.state; ++j)
+            _rects.push_back(cs[j].target);
+
+        if (c.type == display_command_type::FILL_RECT)
+            _backend->fill_rects(c.state, _rects.data(), static_cast<int>(_rects.size()));
+        else
+            _backend->draw_rects(c.state, _rects.data(), static_cast<int>(_rects.size()));
+        i = j;
+    }
+
+    _backend->present(f.damage.has_value() ? &f.damage.value() : nullptr);
+}
+
+void pipelined_backend::rethrow_error()
+{
+    if (_error)
+    {
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
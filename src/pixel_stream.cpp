@@ -0,0 +1,70 @@
+#include <utility>
+
+#include "pixel_stream.hpp"
+
+pixel_stream::pixel_stream(vec size, std::shared_ptr<update_queue> updates)
+    : _size(size)
+    , _updates(std::move(updates))
+    , _back(0)
+    , _ready(1)
+    , _front(2)
+    , _fresh(false)
+    , _notify_pending(false)
+{
+    for (auto & b : _buffers)
+        b.resize(static_cast<std::size_t>(size.w) * size.h);
+}
+
+vec pixel_stream::size() const
+{
+    return _size;
+}
+
+uint32_t * pixel_stream::back_buffer()
+{
+    return _buffers[_back].data();
+}
+
+void pixel_stream::publish()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::swap(_back, _ready);
+        _fresh = true;
+    }
+
+    // Only one notification is in flight.
+    if (!_notify_pending.exchange(true))
+    {
+        std::weak_ptr<pixel_stream> weak = weak_from_this();
+        _updates->post([weak]()
+        {
+            if (auto s = weak.lock())
+            {
+                s->_notify_pending = false;
+                if (s->_listener)
+                    s->_listener();
+            }
+        });
+    }
+}
+
+bool pixel_stream::consume(std::function<void(uint32_t const *)> const & f)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_fresh)
+            return false;
+        std::swap(_ready, _front);
+        _fresh = false;
+    }
+
+    f(_buffers[_front].data());
+    return true;
+}
+
+void pixel_stream::set_listener(std::function<void()> listener)
+{
+    _listener = std::move(listener);
+}
+
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+
+#include "prefix_index.hpp"
+
+// Longer prefixes compare by their start only.
+std::size_t const MAX_KEY_LENGTH = 32;
+
+// Case folding only touches ASCII, other characters are compared by bytes.
+void append_folded_key(std::string & out, std::string_view text)
+{
+    std::size_t const n = std::min(text.size(), MAX_KEY_LENGTH);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        char const c = text[k];
+        out.push_back(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+}
+
+prefix_index::prefix_index(std::shared_ptr<list_provider> provider)
+    : _provider(provider)
+    , _stale(true)
+    , _ready(false)
+{
+    _provider->add_observer(*this);
+    start_building();
+}
+
+prefix_index::~prefix_index()
+{
+    _provider->remove_observer(*this);
+
+    // A running build is waited for by the future.
+}
+
+void prefix_index::on_rows_inserted(std::size_t position, std::size_t n)
+{
+    _stale = true;
+    _ready = false;
+}
+
+void prefix_index::on_rows_removed(std::size_t position, std::size_t n)
+{
+    _stale = true;
+    _ready = false;
+}
+
+void prefix_index::on_rows_changed(std::size_t position, std::size_t n)
+{
+    _stale = true;
+    _ready = false;
+}
+
+std::string_view prefix_index::sorted_keys::key(key_entry const & e) const
+{
+    return std::string_view(data.data() + e.offset, e.length);
+}
+
+void prefix_index::start_building()
+{
+    // Rows are only valid until the next call of the provider, which is not
+    // safe to call from another thread.
+    sorted_keys keys;
+    std::size_t const size = _provider->size();
+    keys.entries.reserve(size);
+    for (std::size_t row = 0; row < size; ++row)
+    {
+        std::size_t const offset = keys.data.size();
+        append_folded_key(keys.data, _provider->row(row));
+        keys.entries.push_back({ static_cast<uint32_t>(offset), static_cast<uint32_t>(row), static_cast<uint8_t>(keys.data.size() - offset) });
+    }
+
+    _stale = false;
+    _building = std::async(std::launch::async, [](sorted_keys keys)
+    {
+        std::sort(keys.entries.begin(), keys.entries.end(), [&keys](key_entry const & a, key_entry const & b)
+        {
+            int const cmp = keys.key(a).compare(keys.key(b));
+            return cmp < 0 || (cmp == 0 && a.row < b.row);
+        });
+        return keys;
+    }, std::move(keys));
+}
+
+bool prefix_index::is_ready()
+{
+    if (_building.valid() && _building.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        _keys = _building.get();
+        _ready = !_stale;
+    }
+
+    // Rows changing while building make the result outdated as well.
+    if (_stale && !_building.valid())
+        start_building();
+
+    return _ready;
+}
+
+std::vector<prefix_index::key_entry>::const_iterator prefix_index::lower_bound(std::string_view prefix)
+{
+    _prefix.clear();
+    append_folded_key(_prefix, prefix);
+
+    return std::lower_bound(_keys.entries.begin(), _keys.entries.end(), _prefix, [this](key_entry const & e, std::string const & p)
+    {
+        return _keys.key(e) < p;
+    });
+}
+
+std::optional<std::size_t> prefix_index::find(std::string_view prefix)
+{
+    if (!is_ready())
+        return std::nullopt;
+
+    auto it = lower_bound(prefix);
+    if (it == _keys.entries.end() || _keys.key(*it).substr(0, _prefix.size()) != _prefix)
+        return std::nullopt;
+
+    return it->row;
+}
+
+std::optional<std::size_t> prefix_index::find_nearest(std::string_view prefix)
+{
+    if (!is_ready() || _keys.entries.empty())
+        return std::nullopt;
+
+    auto it = lower_bound(prefix);
+    if (it == _keys.entries.end())
+        --it;
+
+    return it->row;
+}
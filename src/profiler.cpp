@@ -0,0 +1,135 @@
+#include <cstdlib>
+#include <memory>
+#include <typeinfo>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include "profiler.hpp"
+#include "region.hpp"
+
+// Enough for a graph of the last couple of seconds.
+std::size_t const FRAME_TIME_HISTORY = 120;
+
+thread_local profiler * active_profiler = nullptr;
+
+std::string type_name(region const & r)
+{
+    char const * name = typeid(r).name();
+#ifdef __GNUG__
+    int status = 0;
+    std::unique_ptr<char, void (*)(void *)> demangled(abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+    if (status == 0 && demangled)
+        return demangled.get();
+#endif
+    return name;
+}
+
+void add_counter(profile_counter & c, profile_counter const & other)
+{
+    c.calls += other.calls;
+    c.time += other.time;
+}
+
+region_profile & region_profile::operator+=(region_profile const & other)
+{
+    add_counter(draw, other.draw);
+    add_counter(layout, other.layout);
+    add_counter(size_hint, other.size_hint);
+    texture_copies += other.texture_copies;
+    return *this;
+}
+
+profiler::profiler()
+{
+}
+
+void profiler::reset()
+{
+    _regions.clear();
+    _frame_times.clear();
+}
+
+std::unordered_map<region const *, region_profile> const & profiler::regions() const
+{
+    return _regions;
+}
+
+std::unordered_map<std::string, region_profile> profiler::types() const
+{
+    std::unordered_map<std::string, region_profile> result;
+    for (auto const & p : _regions)
+    {
+        auto it = result.find(p.second.type);
+        if (it == result.end())
+            result.emplace(p.second.type, p.second);
+        else
+            it->second += p.second;
+    }
+    return result;
+}
+
+void profiler::add_frame_time(std::chrono::nanoseconds t)
+{
+    _frame_times.push_back(t);
+    if (_frame_times.size() > FRAME_TIME_HISTORY)
+        _frame_times.pop_front();
+}
+
+std::deque<std::chrono::nanoseconds> const & profiler::frame_times() const
+{
+    return _frame_times;
+}
+
+void profiler::record(region const & r, profile_kind k, std::chrono::nanoseconds t, std::size_t texture_copies)
+{
+    auto it = _regions.find(&r);
+    if (it == _regions.end())
+        it = _regions.emplace(&r, region_profile { type_name(r), {}, {}, {}, 0 }).first;
+
+    region_profile & p = it->second;
+    profile_counter & c = k == profile_kind::DRAW ? p.draw : (k == profile_kind::LAYOUT ? p.layout : p.size_hint);
+    c.calls++;
+    c.time += t;
+    p.texture_copies += texture_copies;
+}
+
+profiler * profiler::active()
+{
+    return active_profiler;
+}
+
+profiler::activation::activation(profiler * p)
+    : _previous(active_profiler)
+{
+    active_profiler = p;
+}
+
+profiler::activation::~activation()
+{
+    active_profiler = _previous;
+}
+
+profiler::scope::scope(region const & r, profile_kind k)
+    : _p(active_profiler)
+    , _r(r)
+    , _k(k)
+    , _texture_copies(0)
+{
+    // Reading the clock is the expensive part.
+    if (_p != nullptr)
+        _start = std::chrono::steady_clock::now();
+}
+
+profiler::scope::~scope()
+{
+    if (_p != nullptr)
+        _p->record(_r, _k, std::chrono::steady_clock::now() - _start, _texture_copies);
+}
+
+void profiler::scope::set_texture_copies(std::size_t n)
+{
+    _texture_copies = n;
+}
+
@@ -88,6 +88,8 @@ void radio_button::select()
 
 void radio_button::on_draw(draw_context & dc, selection_context const & sc) const
 {
+    dc.draw_background(get_box());
+
     // draw a radio box on the left
     auto box = get_box();
     auto box_len = get_context_info().font_line_skip();
@@ -105,6 +107,11 @@ void radio_button::on_draw(draw_context & dc, selection_context const & sc) cons
     dc.draw_label_text(text_box, _label, true);
 }
 
+bool radio_button::is_opaque() const
+{
+    return true;
+}
+
 void radio_button::on_activate()
 {
     select();
@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <atomic>
 
+#include "profiler.hpp"
 #include "region.hpp"
+#include "trace.hpp"
 
 size_hint::size_hint(vec min, vec nat)
     : minimal(min)
@@ -13,21 +16,121 @@ size_hint::size_hint(vec min)
 {
 }
 
-void region::apply_layout(rect box)
+// Boxes might be allocated on several threads.
+std::atomic<std::size_t> region_layout_generation(0);
+
+region::region()
+    : _box{ 0, 0, 0, 0 }
+    , _size_hint_cache_size(0)
+    , _size_hint_cache_next(0)
+    , _layout_valid(false)
 {
-    _box = box;
+}
 
+void region::apply_layout(rect box)
+{
     // If we can't assing enough space for a region make at least a sane box.
-    _box.w = std::max(0, _box.w);
-    _box.h = std::max(0, _box.h);
+    box.w = std::max(0, box.w);
+    box.h = std::max(0, box.h);
 
+    if (_layout_valid && SDL_RectEquals(&box, &_box))
+        return;
+
+    profiler::scope s(*this, profile_kind::LAYOUT);
+    LIBWTK_SDL2_TRACE_SCOPE("layout", "apply_layout");
+
+    _box = box;
+    _layout_valid = true;
+    advance_layout_generation();
     on_box_allocated();
 }
 
+std::size_t region::layout_generation()
+{
+    return region_layout_generation.load(std::memory_order_relaxed);
+}
+
+void region::advance_layout_generation()
+{
+    region_layout_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_hint region::query_size_hint(int width, int height) const
+{
+    for (std::size_t k = 0; k < _size_hint_cache_size; ++k)
+    {
+        auto const & e = _size_hint_cache[k];
+        if (e.width == width && e.height == height)
+            return size_hint(e.minimal, e.natural);
+    }
+
+    profiler::scope s(*this, profile_kind::SIZE_HINT);
+    LIBWTK_SDL2_TRACE_SCOPE("layout", "get_size_hint");
+    size_hint const sh = get_size_hint(width, height);
+
+    _size_hint_cache[_size_hint_cache_next] = { width, height, sh.minimal, sh.natural };
+    _size_hint_cache_next = (_size_hint_cache_next + 1) % SIZE_HINT_CACHE_ENTRIES;
+    _size_hint_cache_size = std::min(_size_hint_cache_size + 1, SIZE_HINT_CACHE_ENTRIES);
+    return sh;
+}
+
+void region_control::on_widget_detached(widget & w)
+{
+}
+
+void region_control::capture_mouse(widget & w, pointer_id id)
+{
+}
+
+void region::invalidate_size_hint()
+{
+    _size_hint_cache_size = 0;
+    _size_hint_cache_next = 0;
+    _layout_valid = false;
+    on_size_hint_invalidated();
+}
+
+void region::on_size_hint_invalidated()
+{
+}
+
 void region::on_box_allocated()
 {
 }
 
+void region::redo_layout(redo_layout_type t)
+{
+    if (defer_redo_layout(t))
+        return;
+
+    if (t != redo_layout_type::FULL)
+    {
+        auto const sh = query_size_hint(_box.w, _box.h);
+        vec const & size = t == redo_layout_type::TRY_LOCAL_MIN ? sh.minimal : sh.natural;
+        if (fits(size, _box))
+        {
+            apply_layout(_box);
+            on_layout_redone();
+            return;
+        }
+    }
+
+    on_redo_layout_request(t);
+}
+
+void region::on_redo_layout_request(redo_layout_type t)
+{
+}
+
+void region::on_layout_redone()
+{
+}
+
+bool region::defer_redo_layout(redo_layout_type t)
+{
+    return false;
+}
+
 bool region::can_use_intermediate_size() const
 {
     return true;
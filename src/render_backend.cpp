@@ -0,0 +1,19 @@
+#include "render_backend.hpp"
+
+render_backend::~render_backend()
+{
+}
+
+void render_backend::copy_quads(render_state const & s, texture_ref const & t, texture_quad const * quads, int count, SDL_Color color_mod)
+{
+    for (int k = 0; k < count; ++k)
+    {
+        texture_quad const & q = quads[k];
+        copy(s, { t.texture, q.alpha, t.surface }, &q.source, q.target, k == 0 ? std::optional<SDL_Color>(color_mod) : std::nullopt);
+    }
+}
+
+void render_backend::invalidate_state()
+{
+}
+
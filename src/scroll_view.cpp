@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "scroll_view.hpp"
+
+// Laid out and drawn above and below the visible part, such that scrolling a
+// bit does not have to draw anything.
+int const SCROLL_WINDOW_MARGIN = 256;
+
+scroll_view::scroll_view(std::vector<widget_ptr> children, int children_spacing)
+    : _children(std::move(children))
+    , _children_spacing(children_spacing)
+    , _tops{ 0 }
+    , _measured_width(-1)
+    , _scroll_offset(0)
+    , _drag_pointer(MOUSE_POINTER_ID)
+    , _dragging(false)
+    , _window_top(0)
+    , _moving_children(false)
+    , _texture(0)
+    , _texture_size{ 0, 0 }
+    , _drawn_window_top(0)
+    , _texture_valid(false)
+{
+    for (auto const & c : _children)
+        _child_ptrs.push_back(c.get());
+    init_children();
+}
+
+scroll_view::~scroll_view()
+{
+}
+
+void scroll_view::on_draw(draw_context & dc, selection_context const & sc) const
+{
+    dc.draw_background(get_box());
+}
+
+bool scroll_view::is_opaque() const
+{
+    return true;
+}
+
+void scroll_view::on_child_dirty(widget * w)
+{
+    // Moved children look the same. Hidden children are drawn once they are
+    // shown.
+    if (_moving_children || !is_visible_child(w))
+        return;
+
+    _dirty_children.push_back(w);
+
+    // Children within the margin only change the texture.
+    rect area;
+    rect const box = get_box();
+    if (SDL_IntersectRect(&w->get_box(), &box, &area) != SDL_TRUE)
+        area = { box.x, box.y, 0, 0 };
+    mark_dirty(area);
+}
+
+void scroll_view::on_mouse_down_event(mouse_down_event const & me)
+{
+    // Captured before the children are pressed, such that moves over them
+    // reach the view. Children may still capture the pointer themselves.
+    capture_mouse(me.pointer);
+    _drag_start_offset = _scroll_offset;
+    _drag_pointer = me.pointer;
+    _dragging = false;
+
+    container::on_mouse_down_event(me);
+}
+
+void scroll_view::on_mouse_up_event(mouse_up_event const & me)
+{
+    bool const dragged = _dragging && me.pointer == _drag_pointer;
+    if (me.pointer == _drag_pointer)
+    {
+        _drag_start_offset.reset();
+        _dragging = false;
+    }
+
+    // The pressed child has already been released when the drag started.
+    if (!dragged)
+        container::on_mouse_up_event(me);
+}
+
+void scroll_view::on_mouse_move_event(mouse_move_event const & e)
+{
+    if (_drag_start_offset.has_value() && e.pointer == _drag_pointer && e.opt_movement.has_value())
+    {
+        int const dy = e.opt_movement->length.h;
+        if (!_dragging && std::abs(dy) >= get_context_info().swipe_cfg.lower_threshold)
+        {
+            _dragging = true;
+            cancel_pressed_child(e.pointer);
+        }
+
+        if (_dragging)
+        {
+            int const max_offset = std::max(0, get_content_height() - get_box().h);
+            set_scroll_offset(std::clamp(_drag_start_offset.value() - dy, 0, max_offset));
+            return;
+        }
+    }
+
+    container::on_mouse_move_event(e);
+}
+
+void scroll_view::on_mouse_capture_released(pointer_id id)
+{
+    // A child that captured the pointer followed the drag instead.
+    if (id == _drag_pointer)
+    {
+        _drag_start_offset.reset();
+        _dragging = false;
+    }
+    container::on_mouse_capture_released(id);
+}
+
+widget_range scroll_view::get_visible_children()
+{
+    return _window_children;
+}
+
+const_widget_range scroll_view::get_visible_children() const
+{
+    return widget_range(_window_children);
+}
+
+widget_range scroll_view::get_children()
+{
+    return _child_ptrs;
+}
+
+const_widget_range scroll_view::get_children() const
+{
+    return widget_range(_child_ptrs);
+}
+
+void scroll_view::on_box_allocated()
+{
+    layout_window();
+}
+
+void scroll_view::on_size_hint_invalidated()
+{
+    // The size hint does not depend on the children, so the parent is not
+    // notified.
+    reset_measurements();
+}
+
+void scroll_view::release_resources()
+{
+    for (auto & t : _textures)
+        t.reset();
+    _texture_valid = false;
+
+    widget::release_resources();
+}
+
+widget * scroll_view::find_selectable(navigation_type nt, point center)
+{
+    // Orthogonal navigation stays within the visible part.
+    if (nt == navigation_type::NEXT_X || nt == navigation_type::PREV_X)
+    {
+        for (widget * c : _window_children)
+        {
+            if (SDL_HasIntersection(&c->get_box(), &get_box()) != SDL_TRUE)
+                continue;
+
+            if (widget * w = c->find_selectable(nt, center))
+                return w;
+        }
+        return nullptr;
+    }
+
+    std::size_t const n = _children.size();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        std::size_t const index = is_forward(nt) ? k : n - 1 - k;
+        if (widget * w = _children[index]->find_selectable(nt, center))
+        {
+            scroll_to_child(index);
+            return w;
+        }
+    }
+    return nullptr;
+}
+
+widget * scroll_view::navigate_selectable_from_children(navigation_type nt, widget * w, point center)
+{
+    if (nt == navigation_type::NEXT_X || nt == navigation_type::PREV_X)
+        return navigate_selectable_parent(nt, center);
+
+    auto const it = std::find(_child_ptrs.begin(), _child_ptrs.end(), w);
+    if (it == _child_ptrs.end())
+        return navigate_selectable_parent(nt, center);
+
+    std::size_t index = it - _child_ptrs.begin();
+    while (is_forward(nt) ? index + 1 < _children.size() : index > 0)
+    {
+        index = is_forward(nt) ? index + 1 : index - 1;
+        if (widget * result = _children[index]->find_selectable(nt, center))
+        {
+            scroll_to_child(index);
+            return result;
+        }
+    }
+
+    return navigate_selectable_parent(nt, center);
+}
+
+widget * scroll_view::find_child_at(point p)
+{
+    // Children in the margin are outside of the box.
+    if (!within_rect(p, get_box()))
+        return nullptr;
+
+    for (widget * c : _window_children)
+    {
+        if (within_rect(p, c->get_box()))
+            return c;
+    }
+    return nullptr;
+}
+
+size_hint scroll_view::get_size_hint(int width, int height) const
+{
+    // The content is scrolled, its height does not matter.
+    int const line_skip = get_context_info().font_line_skip();
+    vec const minimal { opt_or_value(width, 4 * line_skip), opt_or_value(height, 4 * line_skip) };
+    vec const natural { opt_or_value(width, 20 * line_skip), opt_or_value(height, 20 * line_skip) };
+    return size_hint(minimal, natural);
+}
+
+void scroll_view::set_scroll_offset(int offset)
+{
+    if (offset == _scroll_offset)
+        return;
+
+    _scroll_offset = offset;
+
+    // The texture is moved instead of drawing the children again.
+    _moving_children = true;
+    layout_window();
+    _moving_children = false;
+
+    mark_dirty();
+}
+
+int scroll_view::get_scroll_offset() const
+{
+    return _scroll_offset;
+}
+
+void scroll_view::scroll_to_child(std::size_t index)
+{
+    if (index >= _children.size())
+        return;
+
+    while (_tops.size() <= index + 1)
+        measure_next();
+
+    int const top = _tops[index];
+    int const bottom = _tops[index + 1] - _children_spacing;
+    int const height = get_box().h;
+
+    if (top < _scroll_offset)
+        set_scroll_offset(top);
+    else if (bottom > _scroll_offset + height)
+        set_scroll_offset(std::min(top, bottom - height));
+}
+
+int scroll_view::get_content_height() const
+{
+    std::size_t const measured = _tops.size() - 1;
+    if (measured == 0)
+        return 0;
+
+    int const measured_height = _tops.back();
+    int const unmeasured = static_cast<int>(_children.size() - measured);
+    return std::max(0, measured_height + unmeasured * (measured_height / static_cast<int>(measured)) - _children_spacing);
+}
+
+void scroll_view::measure_next()
+{
+    widget const & c = *_children[_tops.size() - 1];
+    _tops.push_back(_tops.back() + c.query_size_hint(get_box().w, -1).natural.h + _children_spacing);
+}
+
+void scroll_view::measure_until(int offset)
+{
+    while (_tops.size() <= _children.size() && _tops.back() < offset)
+        measure_next();
+}
+
+void scroll_view::reset_measurements()
+{
+    _tops.assign(1, 0);
+    _texture_valid = false;
+}
+
+int scroll_view::window_height() const
+{
+    return get_box().h + 2 * SCROLL_WINDOW_MARGIN;
+}
+
+void scroll_view::layout_window()
+{
+    rect const box = get_box();
+    if (box.w != _measured_width)
+    {
+        reset_measurements();
+        _measured_width = box.w;
+    }
+
+    measure_until(_scroll_offset + box.h + SCROLL_WINDOW_MARGIN);
+    _scroll_offset = std::max(0, std::min(_scroll_offset, get_content_height() - box.h));
+
+    // The window only moves once the visible part leaves it.
+    if (_scroll_offset < _window_top || _scroll_offset + box.h > _window_top + window_height())
+        _window_top = std::max(0, _scroll_offset - SCROLL_WINDOW_MARGIN);
+
+    int const window_end = _window_top + window_height();
+    measure_until(window_end);
+
+    // The first child that ends within the window.
+    std::size_t const measured = _tops.size() - 1;
+    std::size_t k = std::upper_bound(_tops.begin() + 1, _tops.end(), _window_top) - (_tops.begin() + 1);
+
+    _window_children.clear();
+    for (; k < measured && _tops[k] < window_end; ++k)
+    {
+        int const height = _tops[k + 1] - _tops[k] - _children_spacing;
+        _children[k]->apply_layout({ box.x, box.y + _tops[k] - _scroll_offset, box.w, height });
+        _window_children.push_back(_child_ptrs[k]);
+    }
+}
+
+bool scroll_view::is_visible_child(widget const * w) const
+{
+    return std::find(_window_children.begin(), _window_children.end(), w) != _window_children.end();
+}
+
+void scroll_view::draw_area(draw_context & dc, selection_context const & sc, rect area) const
+{
+    dc.set_scissor(&area);
+    dc.draw_background(area);
+    for (widget const * c : _window_children)
+        c->draw(dc, sc);
+    dc.set_scissor(nullptr);
+}
+
+void scroll_view::draw_children(draw_context & dc, selection_context const & sc) const
+{
+    rect const box = get_box();
+    vec const size { box.w, window_height() };
+    if (box.w <= 0 || box.h <= 0)
+        return;
+
+    if (!_textures[_texture] || size.w != _texture_size.w || size.h != _texture_size.h)
+    {
+        for (auto & t : _textures)
+            t = dc.create_target_texture(size);
+        _texture_size = size;
+        _texture_valid = false;
+    }
+
+    // Without render targets everything visible is drawn.
+    if (!_textures[0] || !_textures[1])
+    {
+        dc.push_visible_area(box);
+        container::draw_children(dc, sc);
+        dc.pop_visible_area();
+        _dirty_children.clear();
+        return;
+    }
+
+    // The texture is drawn with the coordinates of the children.
+    point const origin { box.x, box.y + _window_top - _scroll_offset };
+    rect const window { origin.x, origin.y, size.w, size.h };
+
+    // Positive when the window moved down.
+    int const shift = _window_top - _drawn_window_top;
+    if (!_texture_valid || std::abs(shift) >= size.h)
+    {
+        dc.push_target(_textures[_texture].get(), origin, false);
+        draw_area(dc, sc, window);
+    }
+    else if (shift != 0)
+    {
+        // A texture must not be drawn onto itself.
+        SDL_Texture * previous = _textures[_texture].get();
+        _texture = 1 - _texture;
+        dc.push_target(_textures[_texture].get(), origin, false);
+        dc.copy_texture(previous, { origin.x, origin.y - shift, size.w, size.h });
+
+        if (shift > 0)
+            draw_area(dc, sc, { origin.x, origin.y + size.h - shift, size.w, shift });
+        else
+            draw_area(dc, sc, { origin.x, origin.y, size.w, -shift });
+    }
+    else
+    {
+        dc.push_target(_textures[_texture].get(), origin, false);
+    }
+
+    for (widget const * c : _dirty_children)
+    {
+        rect area;
+        if (is_visible_child(c) && SDL_IntersectRect(&c->get_box(), &window, &area) == SDL_TRUE)
+            draw_area(dc, sc, area);
+    }
+    _dirty_children.clear();
+
+    dc.pop_target();
+
+    _drawn_window_top = _window_top;
+    _texture_valid = true;
+
+    dc.copy_texture(_textures[_texture].get(), { 0, _scroll_offset - _window_top, box.w, box.h }, box);
+}
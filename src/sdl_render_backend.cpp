@@ -0,0 +1,217 @@
+#include <stdexcept>
+#include <string>
+
+#include <SDL2/SDL_version.h>
+#include <SDL2/SDL_video.h>
+
+#include "sdl_render_backend.hpp"
+
+rect const * optional_rect_ptr(std::optional<rect> const & r)
+{
+    return r.has_value() ? &r.value() : nullptr;
+}
+
+sdl_render_backend::sdl_render_backend(SDL_Renderer * renderer)
+    : _renderer(renderer)
+    , _color_mod_destructions(texture_destructions())
+{
+}
+
+void sdl_render_backend::fill_rects(render_state const & s, rect const * rs, int count)
+{
+    apply_state(s);
+    if (count == 1)
+        SDL_RenderFillRect(_renderer, rs);
+    else
+        SDL_RenderFillRects(_renderer, rs, count);
+}
+
+void sdl_render_backend::draw_rects(render_state const & s, rect const * rs, int count)
+{
+    apply_state(s);
+    if (count == 1)
+        SDL_RenderDrawRect(_renderer, rs);
+    else
+        SDL_RenderDrawRects(_renderer, rs, count);
+}
+
+void sdl_render_backend::copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod)
+{
+    apply_state(s);
+    if (color_mod.has_value())
+        set_texture_color_mod(t.texture, color_mod.value());
+    SDL_RenderCopy(_renderer, t.texture, src, &dst);
+}
+
+void sdl_render_backend::copy_quads(render_state const & s, texture_ref const & t, texture_quad const * quads, int count, SDL_Color color_mod)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int w, h;
+    if (count == 1 || SDL_QueryTexture(t.texture, nullptr, nullptr, &w, &h) < 0)
+    {
+        render_backend::copy_quads(s, t, quads, count, color_mod);
+        return;
+    }
+
+    apply_state(s);
+
+    // The color stays in the modulation of the texture, copies that follow
+    // without a color rely on it.
+    set_texture_color_mod(t.texture, color_mod);
+
+    _vertices.clear();
+    _indices.clear();
+    SDL_Color const white { 255, 255, 255, 255 };
+    float const tw = w;
+    float const th = h;
+    for (int k = 0; k < count; ++k)
+    {
+        rect const & src = quads[k].source;
+        rect const & dst = quads[k].target;
+
+        float const x0 = dst.x;
+        float const y0 = dst.y;
+        float const x1 = dst.x + dst.w;
+        float const y1 = dst.y + dst.h;
+        float const u0 = src.x / tw;
+        float const v0 = src.y / th;
+        float const u1 = (src.x + src.w) / tw;
+        float const v1 = (src.y + src.h) / th;
+
+        int const first = _vertices.size();
+        _vertices.push_back({ { x0, y0 }, white, { u0, v0 } });
+        _vertices.push_back({ { x1, y0 }, white, { u1, v0 } });
+        _vertices.push_back({ { x1, y1 }, white, { u1, v1 } });
+        _vertices.push_back({ { x0, y1 }, white, { u0, v1 } });
+
+        for (int i : { 0, 1, 2, 0, 2, 3 })
+            _indices.push_back(first + i);
+    }
+
+    if (SDL_RenderGeometry(_renderer, t.texture, _vertices.data(), _vertices.size(), _indices.data(), _indices.size()) < 0)
+        throw std::runtime_error(SDL_GetError());
+#else
+    render_backend::copy_quads(s, t, quads, count, color_mod);
+#endif
+}
+
+bool sdl_render_backend::updates_window_surface() const
+{
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(_renderer, &info) < 0 || !(info.flags & SDL_RENDERER_SOFTWARE))
+        return false;
+
+    // Damage is only known in unscaled coordinates.
+    float sx, sy;
+    SDL_RenderGetScale(_renderer, &sx, &sy);
+    return SDL_RenderGetWindow(_renderer) != nullptr && sx == 1.0f && sy == 1.0f;
+}
+
+void sdl_render_backend::present(damage_region const * damage)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+    // The software renderer draws directly to the window surface, updating the
+    // whole surface is the most expensive part on slow displays.
+    if (damage != nullptr && updates_window_surface())
+    {
+        if (!damage->empty())
+        {
+            SDL_RenderFlush(_renderer);
+            auto const & rs = damage->rects();
+            SDL_UpdateWindowSurfaceRects(SDL_RenderGetWindow(_renderer), rs.data(), rs.size());
+        }
+        return;
+    }
+#endif
+    SDL_RenderPresent(_renderer);
+}
+
+unique_texture_ptr sdl_render_backend::create_target_texture(vec size)
+{
+    if (SDL_RenderTargetSupported(_renderer) != SDL_TRUE)
+        return nullptr;
+
+    unique_texture_ptr t(SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, size.w, size.h));
+    if (t && SDL_SetTextureBlendMode(t.get(), SDL_BLENDMODE_BLEND) < 0)
+        throw std::runtime_error(SDL_GetError());
+    return t;
+}
+
+void sdl_render_backend::set_target(SDL_Texture * t, bool clear)
+{
+    if (SDL_SetRenderTarget(_renderer, t) < 0)
+        throw std::runtime_error(std::string("could not set render target: ") + SDL_GetError());
+
+    // Changing the target resets viewport and clip rect.
+    invalidate_state();
+
+    if (t != nullptr && clear)
+    {
+        // Areas that are not drawn show what is below the texture.
+        apply_state({ { 0, 0, 0, 0 }, SDL_BLENDMODE_NONE, std::nullopt, std::nullopt });
+        SDL_RenderClear(_renderer);
+    }
+}
+
+bool sdl_render_backend::needs_pixels() const
+{
+    return false;
+}
+
+void sdl_render_backend::invalidate_state()
+{
+    _applied_draw_color.reset();
+    _applied_blend_mode.reset();
+    _applied_clip.reset();
+    _applied_viewport.reset();
+    _applied_color_mods.clear();
+}
+
+void sdl_render_backend::set_texture_color_mod(SDL_Texture * t, SDL_Color c)
+{
+    // A texture created since might have the address of a destroyed one.
+    std::size_t const destructions = texture_destructions();
+    if (destructions != _color_mod_destructions)
+    {
+        _applied_color_mods.clear();
+        _color_mod_destructions = destructions;
+    }
+
+    auto it = _applied_color_mods.find(t);
+    if (it != _applied_color_mods.end() && it->second.r == c.r && it->second.g == c.g && it->second.b == c.b)
+        return;
+
+    if (SDL_SetTextureColorMod(t, c.r, c.g, c.b) < 0)
+        throw std::runtime_error(SDL_GetError());
+    _applied_color_mods[t] = c;
+}
+
+void sdl_render_backend::apply_state(render_state const & s)
+{
+    if (!_applied_draw_color.has_value() || !same_color(_applied_draw_color.value(), s.draw_color))
+    {
+        SDL_Color const & c = s.draw_color;
+        SDL_SetRenderDrawColor(_renderer, c.r, c.g, c.b, c.a);
+        _applied_draw_color = c;
+    }
+
+    if (_applied_blend_mode != s.blend_mode)
+    {
+        SDL_SetRenderDrawBlendMode(_renderer, s.blend_mode);
+        _applied_blend_mode = s.blend_mode;
+    }
+
+    // The viewport comes first, the clip rect is relative to it.
+    if (!_applied_viewport.has_value() || !same_optional_rect(_applied_viewport.value(), s.viewport))
+    {
+        SDL_RenderSetViewport(_renderer, optional_rect_ptr(s.viewport));
+        _applied_viewport = s.viewport;
+    }
+
+    if (!_applied_clip.has_value() || !same_optional_rect(_applied_clip.value(), s.clip))
+    {
+        SDL_RenderSetClipRect(_renderer, optional_rect_ptr(s.clip));
+        _applied_clip = s.clip;
+    }
+}
+
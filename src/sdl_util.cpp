@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
+
 #include <SDL2/SDL_image.h>
 
 #include "sdl_util.hpp"
@@ -9,8 +14,21 @@ void surface_deleter::operator()(SDL_Surface * s)
 }
 
 void texture_destroyer::operator()(SDL_Texture * t)
+{
+    destroy_texture(t);
+}
+
+std::atomic<std::size_t> texture_destruction_count(0);
+
+void destroy_texture(SDL_Texture * t)
 {
     SDL_DestroyTexture(t);
+    texture_destruction_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::size_t texture_destructions()
+{
+    return texture_destruction_count.load(std::memory_order_relaxed);
 }
 
 SDL_Texture * load_raw_texture_from_image(SDL_Renderer * r, std::string filename)
@@ -122,6 +140,76 @@ rect pad_rect(rect box, int padding)
     return { box.x + padding, box.y + padding, box.w - 2 * padding, box.h - 2 * padding };
 }
 
+unique_surface_ptr downscale_surface(SDL_Surface * s, vec size)
+{
+    unique_surface_ptr converted;
+    SDL_Surface * source = s;
+    if (s->format->format != SDL_PIXELFORMAT_ARGB8888)
+    {
+        converted.reset(SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0));
+        if (!converted)
+            throw std::runtime_error(std::string("could not convert surface: ") + SDL_GetError());
+        source = converted.get();
+    }
+
+    int const sw = source->w;
+    int const sh = source->h;
+    int const dw = std::clamp(size.w, 1, std::max(1, sw));
+    int const dh = std::clamp(size.h, 1, std::max(1, sh));
+
+    unique_surface_ptr result(SDL_CreateRGBSurfaceWithFormat(0, dw, dh, 32, SDL_PIXELFORMAT_ARGB8888));
+    if (!result)
+        throw std::runtime_error(std::string("could not create surface: ") + SDL_GetError());
+
+    if (SDL_MUSTLOCK(source))
+        SDL_LockSurface(source);
+
+    // The source columns covered by each target column, at least one as the
+    // surface only shrinks.
+    std::vector<int> x_begin(dw + 1);
+    for (int dx = 0; dx <= dw; ++dx)
+        x_begin[dx] = static_cast<int>((static_cast<int64_t>(dx) * sw) / dw);
+
+    // Sums of each channel of a target row, enough for 16 million pixels per
+    // target pixel. The channels are independent, so byte order does not
+    // matter.
+    std::vector<uint32_t> sums(dw * 4);
+
+    for (int dy = 0; dy < dh; ++dy)
+    {
+        int const y0 = static_cast<int>((static_cast<int64_t>(dy) * sh) / dh);
+        int const y1 = static_cast<int>((static_cast<int64_t>(dy + 1) * sh) / dh);
+
+        std::fill(sums.begin(), sums.end(), 0);
+        for (int y = y0; y < y1; ++y)
+        {
+            uint8_t const * row = static_cast<uint8_t const *>(source->pixels) + y * source->pitch;
+            for (int dx = 0; dx < dw; ++dx)
+            {
+                uint32_t * sum = sums.data() + dx * 4;
+                for (int x = x_begin[dx]; x < x_begin[dx + 1]; ++x)
+                {
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += row[x * 4 + c];
+                }
+            }
+        }
+
+        uint8_t * out = static_cast<uint8_t *>(result->pixels) + dy * result->pitch;
+        for (int dx = 0; dx < dw; ++dx)
+        {
+            uint32_t const count = (x_begin[dx + 1] - x_begin[dx]) * (y1 - y0);
+            for (int c = 0; c < 4; ++c)
+                out[dx * 4 + c] = static_cast<uint8_t>((sums[dx * 4 + c] + count / 2) / count);
+        }
+    }
+
+    if (SDL_MUSTLOCK(source))
+        SDL_UnlockSurface(source);
+
+    return result;
+}
+
 vec texture_dim(SDL_Texture const * tex)
 {
     vec size;
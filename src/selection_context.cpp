@@ -1,3 +1,4 @@
+#include "navigation_index.hpp"
 #include "selection_context.hpp"
 #include "widget.hpp"
 
@@ -6,6 +7,7 @@ selection_context::selection_context(rect widget_area, widget * w)
     : _selected_position(rect_center(widget_area))
     , _selected_widget(w == nullptr ? w : w->find_selectable(navigation_type::NEXT, _selected_position))
     , _widget_area(widget_area)
+    , _index(nullptr)
 {
     select_helper();
 }
@@ -60,7 +62,10 @@ void selection_context::navigate_selection(navigation_type nt, widget * main_wid
     else
     {
         _selected_widget->on_unselect();
-        _selected_widget = _selected_widget->navigate_selectable(nt, _selected_position);
+        if (_index != nullptr && _index->contains(_selected_widget))
+            _selected_widget = _index->navigate(nt, _selected_widget, _selected_position);
+        else
+            _selected_widget = _selected_widget->navigate_selectable(nt, _selected_position);
     }
     select_helper();
 }
@@ -72,6 +77,11 @@ void selection_context::change_widget_area(rect new_box)
         _selected_position = rect_center(_widget_area);
 }
 
+void selection_context::set_navigation_index(navigation_index const * index)
+{
+    _index = index;
+}
+
 void selection_context::unselect_helper()
 {
     if (_selected_widget != nullptr)
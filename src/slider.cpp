@@ -15,6 +15,10 @@ slider::slider(int start, int end, int num_steps, std::function<void(int)> value
     , _num_steps(num_steps)
     , _current_step(0)
     , _pressed_step(-1)
+    , _reported_step(0)
+    , _drag_updates(false)
+    , _drag_update_interval(animation_scheduler::clock::duration::zero())
+    , _drag_update_animation(NO_ANIMATION)
     , _value_callback(value_callback)
 {
 }
@@ -26,6 +30,7 @@ slider::slider(int start, int end, std::function<void(int)> value_callback)
 
 slider::~slider()
 {
+    stop_drag_update();
 }
 
 void slider::on_draw(draw_context & dc, selection_context const & sc) const
@@ -59,14 +64,20 @@ void slider::on_draw(draw_context & dc, selection_context const & sc) const
     dc.draw_button_box(_knob_box, _pressed_step != -1, selected);
 }
 
+bool slider::is_opaque() const
+{
+    return true;
+}
+
 void slider::on_mouse_up_event(mouse_up_event const & e)
 {
     if (_pressed_step != -1)
     {
-        if (_pressed_step != _current_step)
-            emit_value_callback(_pressed_step);
+        stop_drag_update();
+        if (_reported_step != _current_step)
+            emit_value_callback();
         _pressed_step = -1;
-        mark_dirty();
+        mark_dirty(_knob_box);
     }
 }
 
@@ -78,19 +89,16 @@ void slider::on_mouse_down_event(mouse_down_event const & e)
         if (within_rect(e.position, _knob_box))
         {
             _pressed_step = _current_step;
+            mark_dirty(_knob_box);
         }
         // move directly to position
         else
         {
-            int next_step = get_step_with_abs_pos(e.position.x);
-            int last_step = _current_step;
-            set_step(next_step);
+            set_step(get_step_with_abs_pos(e.position.x));
 
-            // TODO signal on slide already?
-            if (next_step != last_step)
-                emit_value_callback(next_step);
+            if (_current_step != _reported_step)
+                emit_value_callback();
         }
-        mark_dirty();
     }
 }
 
@@ -100,9 +108,10 @@ void slider::on_mouse_move_event(mouse_move_event const & e)
     // (even if not in box).
     if (_pressed_step != -1)
     {
-        int next_step = get_step_with_abs_pos(e.position.x);
-        set_step(next_step);
-        mark_dirty();
+        set_step(get_step_with_abs_pos(e.position.x));
+
+        if (_drag_updates && _current_step != _reported_step)
+            schedule_drag_update();
     }
 }
 
@@ -136,7 +145,9 @@ size_hint slider::get_size_hint(int width, int height) const
 void slider::set_step_interval(int n)
 {
     set_step(std::clamp(n, 0, _num_steps - 1));
-    mark_dirty();
+
+    // Changes that are not made by the user are not reported.
+    _reported_step = _current_step;
 }
 
 int slider::get_step_interval() const
@@ -149,6 +160,14 @@ int slider::get_value() const
     return _start + _current_step * _step;
 }
 
+void slider::set_drag_updates(bool enabled, animation_scheduler::clock::duration min_interval)
+{
+    _drag_updates = enabled;
+    _drag_update_interval = min_interval;
+    if (!enabled)
+        stop_drag_update();
+}
+
 void slider::refresh_knob_box()
 {
     // Distribute remaining width to first segements.
@@ -182,13 +201,60 @@ int slider::get_step_with_abs_pos(int abs_pos)
 
 void slider::set_step(int step)
 {
+    if (step == _current_step)
+        return;
+
+    // Only the part between the old and the new knob changes.
+    rect const old_knob_box = _knob_box;
     _current_step = step;
     refresh_knob_box();
+
+    rect area;
+    SDL_UnionRect(&old_knob_box, &_knob_box, &area);
+    mark_dirty(area);
+}
+
+void slider::emit_value_callback()
+{
+    _reported_step = _current_step;
+    _value_callback(get_value());
+}
+
+void slider::schedule_drag_update()
+{
+    if (_drag_update_animation != NO_ANIMATION)
+        return;
+
+    // Animations are stepped once per frame.
+    _drag_update_animation = get_context_info().start_animation([this](animation_scheduler::clock::duration)
+    {
+        return step_drag_update();
+    });
+
+    // Without a scheduler every change is reported right away.
+    if (_drag_update_animation == NO_ANIMATION)
+        emit_value_callback();
+}
+
+bool slider::step_drag_update()
+{
+    auto const now = animation_scheduler::clock::now();
+    if (now - _last_drag_update < _drag_update_interval)
+        return true;
+
+    _drag_update_animation = NO_ANIMATION;
+    _last_drag_update = now;
+    if (_current_step != _reported_step)
+        emit_value_callback();
+    return false;
 }
 
-void slider::emit_value_callback(int step)
+void slider::stop_drag_update()
 {
-    // TODO cache value?
-    _value_callback(_start + _current_step * _step);
+    if (_drag_update_animation != NO_ANIMATION)
+    {
+        get_context_info().stop_animation(_drag_update_animation);
+        _drag_update_animation = NO_ANIMATION;
+    }
 }
 
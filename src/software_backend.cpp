@@ -0,0 +1,386 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "software_backend.hpp"
+
+// Kernels work on packed 32-bit pixels with 8-bit channels. The order of the
+// channels does not matter, since every channel is treated the same.
+
+// Divides by 255 with correct rounding for products of two bytes.
+uint32_t div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+uint32_t blend_pixel(uint32_t d, uint32_t c, uint32_t a)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t const dc = (d >> shift) & 0xff;
+        uint32_t const cc = (c >> shift) & 0xff;
+        result |= div255(cc * a + dc * (255 - a)) << shift;
+    }
+    return result;
+}
+
+void fill_span(uint32_t * p, int n, uint32_t c)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i const cv = _mm_set1_epi32(static_cast<int>(c));
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), cv);
+#elif defined(__ARM_NEON)
+    uint32x4_t const cv = vdupq_n_u32(c);
+    for (; i + 4 <= n; i += 4)
+        vst1q_u32(p + i, cv);
+#endif
+    for (; i < n; ++i)
+        p[i] = c;
+}
+
+#ifdef __SSE2__
+// Blends two pixels widened to 16-bit channels.
+__m128i blend_epi16(__m128i d, __m128i c, __m128i a)
+{
+    __m128i const inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_mullo_epi16(d, inv));
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+#endif
+
+#ifdef __ARM_NEON
+// Blends two pixels, the factors have one byte per channel.
+uint8x8_t blend_u8x8(uint8x8_t d, uint8x8_t c, uint8x8_t a)
+{
+    uint16x8_t x = vmlal_u8(vmull_u8(c, a), d, vsub_u8(vdup_n_u8(255), a));
+    x = vaddq_u16(x, vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+}
+#endif
+
+void blend_span(uint32_t * p, int n, uint32_t c, uint8_t a)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const cv = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(c)), zero);
+    __m128i const av = _mm_set1_epi16(a);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+        __m128i const lo = blend_epi16(_mm_unpacklo_epi8(d, zero), cv, av);
+        __m128i const hi = blend_epi16(_mm_unpackhi_epi8(d, zero), cv, av);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    uint8x8_t const cv = vreinterpret_u8_u32(vdup_n_u32(c));
+    uint8x8_t const av = vdup_n_u8(a);
+    for (; i + 2 <= n; i += 2)
+    {
+        uint8x8_t const d = vreinterpret_u8_u32(vld1_u32(p + i));
+        vst1_u32(p + i, vreinterpret_u32_u8(blend_u8x8(d, cv, av)));
+    }
+#endif
+    for (; i < n; ++i)
+        p[i] = blend_pixel(p[i], c, a);
+}
+
+// Blends the color with a coverage value for each pixel.
+void blend_coverage_span(uint32_t * p, uint8_t const * coverage, int n, uint32_t c)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const cv = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(c)), zero);
+    for (; i + 4 <= n; i += 4)
+    {
+        uint32_t cov4;
+        std::memcpy(&cov4, coverage + i, sizeof(cov4));
+        if (cov4 == 0)
+            continue;
+
+        // Spread the coverage of each pixel over its channels.
+        __m128i a = _mm_cvtsi32_si128(static_cast<int>(cov4));
+        a = _mm_unpacklo_epi8(a, a);
+        a = _mm_unpacklo_epi16(a, a);
+
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + i));
+        __m128i const lo = blend_epi16(_mm_unpacklo_epi8(d, zero), cv, _mm_unpacklo_epi8(a, zero));
+        __m128i const hi = blend_epi16(_mm_unpackhi_epi8(d, zero), cv, _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + i), _mm_packus_epi16(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    uint8x8_t const cv = vreinterpret_u8_u32(vdup_n_u32(c));
+    uint8x8_t const spread = { 0, 0, 0, 0, 1, 1, 1, 1 };
+    for (; i + 2 <= n; i += 2)
+    {
+        if ((coverage[i] | coverage[i + 1]) == 0)
+            continue;
+
+        uint8x8_t const cov = vcreate_u8(static_cast<uint64_t>(coverage[i]) | (static_cast<uint64_t>(coverage[i + 1]) << 8));
+        uint8x8_t const d = vreinterpret_u8_u32(vld1_u32(p + i));
+        vst1_u32(p + i, vreinterpret_u32_u8(blend_u8x8(d, cv, vtbl1_u8(cov, spread))));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        uint8_t const a = coverage[i];
+        if (a == 255)
+            p[i] = c;
+        else if (a != 0)
+            p[i] = blend_pixel(p[i], c, a);
+    }
+}
+
+uint32_t * pixel_row(SDL_Surface * s, int y)
+{
+    return reinterpret_cast<uint32_t *>(static_cast<uint8_t *>(s->pixels) + y * s->pitch);
+}
+
+// Keeps a surface locked while drawing.
+struct surface_lock
+{
+    surface_lock(SDL_Surface * s)
+        : _s(SDL_MUSTLOCK(s) ? s : nullptr)
+    {
+        if (_s != nullptr && SDL_LockSurface(_s) < 0)
+            throw std::runtime_error(std::string("could not lock framebuffer: ") + SDL_GetError());
+    }
+
+    ~surface_lock()
+    {
+        if (_s != nullptr)
+            SDL_UnlockSurface(_s);
+    }
+
+    private:
+
+    SDL_Surface * _s;
+};
+
+software_backend::software_backend(SDL_Window * window)
+    : _window(window)
+    , _framebuffer(nullptr)
+{
+    SDL_Surface * s = SDL_GetWindowSurface(window);
+    if (s == nullptr)
+        throw std::runtime_error(std::string("could not get window surface: ") + SDL_GetError());
+    set_framebuffer(s);
+}
+
+software_backend::software_backend(SDL_Surface * framebuffer)
+    : _window(nullptr)
+    , _framebuffer(nullptr)
+{
+    set_framebuffer(framebuffer);
+}
+
+software_backend::software_backend()
+    : _window(nullptr)
+    , _framebuffer(nullptr)
+{
+}
+
+void software_backend::set_framebuffer(SDL_Surface * framebuffer)
+{
+    if (framebuffer->format->BytesPerPixel != 4)
+        throw std::runtime_error("framebuffer has to use 32-bit pixels");
+    _framebuffer = framebuffer;
+}
+
+rect software_backend::bounds(render_state const & s, point & origin) const
+{
+    rect result { 0, 0, _framebuffer->w, _framebuffer->h };
+    origin = { 0, 0 };
+
+    if (s.viewport.has_value())
+    {
+        rect const & v = s.viewport.value();
+        origin = { v.x, v.y };
+        if (SDL_IntersectRect(&result, &v, &result) != SDL_TRUE)
+            return { 0, 0, 0, 0 };
+    }
+
+    if (s.clip.has_value())
+    {
+        rect clip = s.clip.value();
+        clip.x += origin.x;
+        clip.y += origin.y;
+        if (SDL_IntersectRect(&result, &clip, &result) != SDL_TRUE)
+            return { 0, 0, 0, 0 };
+    }
+
+    return result;
+}
+
+void software_backend::fill(render_state const & s, rect r)
+{
+    point origin;
+    rect const b = bounds(s, origin);
+    r.x += origin.x;
+    r.y += origin.y;
+    if (SDL_IntersectRect(&r, &b, &r) != SDL_TRUE)
+        return;
+
+    SDL_Color const & c = s.draw_color;
+    bool const blend = s.blend_mode != SDL_BLENDMODE_NONE && c.a != 255;
+    if (blend && c.a == 0)
+        return;
+
+    uint32_t const pixel = SDL_MapRGBA(_framebuffer->format, c.r, c.g, c.b, blend ? 255 : c.a);
+
+    surface_lock lock(_framebuffer);
+    for (int y = r.y; y < r.y + r.h; ++y)
+    {
+        uint32_t * row = pixel_row(_framebuffer, y) + r.x;
+        if (blend)
+            blend_span(row, r.w, pixel, c.a);
+        else
+            fill_span(row, r.w, pixel);
+    }
+}
+
+void software_backend::fill_rects(render_state const & s, rect const * rs, int count)
+{
+    for (int i = 0; i < count; ++i)
+        fill(s, rs[i]);
+}
+
+void software_backend::draw_rects(render_state const & s, rect const * rs, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        rect const & r = rs[i];
+        if (r.w <= 0 || r.h <= 0)
+            continue;
+
+        // The frame lies within the rectangle, like with SDL_RenderDrawRect.
+        fill(s, { r.x, r.y, r.w, 1 });
+        if (r.h > 1)
+            fill(s, { r.x, r.y + r.h - 1, r.w, 1 });
+        if (r.h > 2)
+        {
+            fill(s, { r.x, r.y + 1, 1, r.h - 2 });
+            if (r.w > 1)
+                fill(s, { r.x + r.w - 1, r.y + 1, 1, r.h - 2 });
+        }
+    }
+}
+
+void software_backend::copy(render_state const & s, texture_ref const & t, rect const * src, rect dst, std::optional<SDL_Color> color_mod)
+{
+    if (color_mod.has_value() && t.texture != nullptr)
+        _color_mods[t.texture] = color_mod.value();
+
+    point origin;
+    rect const b = bounds(s, origin);
+    dst.x += origin.x;
+    dst.y += origin.y;
+
+    if (t.surface != nullptr)
+    {
+        // SDL's blitters are fast enough for images.
+        rect old_clip;
+        SDL_GetClipRect(_framebuffer, &old_clip);
+        SDL_SetClipRect(_framebuffer, &b);
+
+        rect full { 0, 0, t.surface->w, t.surface->h };
+        rect const * source = src == nullptr ? &full : src;
+        if (source->w == dst.w && source->h == dst.h)
+            SDL_BlitSurface(t.surface, source, _framebuffer, &dst);
+        else
+            SDL_BlitScaled(t.surface, source, _framebuffer, &dst);
+
+        SDL_SetClipRect(_framebuffer, &old_clip);
+    }
+    else if (t.alpha != nullptr && src != nullptr)
+    {
+        // Scaled coverage is sampled at the nearest source pixel, which is
+        // good enough for scaled fonts.
+        bool const scaled = dst.w != src->w || dst.h != src->h;
+        rect target { dst.x, dst.y, scaled ? dst.w : src->w, scaled ? dst.h : src->h };
+        if (target.w <= 0 || target.h <= 0)
+            return;
+
+        rect visible;
+        if (SDL_IntersectRect(&target, &b, &visible) != SDL_TRUE)
+            return;
+
+        SDL_Color c { 255, 255, 255, 255 };
+        if (color_mod.has_value())
+            c = color_mod.value();
+        else if (t.texture != nullptr)
+        {
+            auto it = _color_mods.find(t.texture);
+            if (it != _color_mods.end())
+                c = it->second;
+        }
+        uint32_t const pixel = SDL_MapRGBA(_framebuffer->format, c.r, c.g, c.b, 255);
+
+        surface_lock lock(_framebuffer);
+        for (int y = visible.y; y < visible.y + visible.h; ++y)
+        {
+            if (scaled)
+            {
+                uint8_t const * row = t.alpha + (y - target.y) * src->h / target.h * src->w;
+                _scaled_coverage.resize(visible.w);
+                for (int x = 0; x < visible.w; ++x)
+                    _scaled_coverage[x] = row[(visible.x - target.x + x) * src->w / target.w];
+                blend_coverage_span(pixel_row(_framebuffer, y) + visible.x, _scaled_coverage.data(), visible.w, pixel);
+            }
+            else
+            {
+                uint8_t const * coverage = t.alpha + (y - target.y) * src->w + (visible.x - target.x);
+                blend_coverage_span(pixel_row(_framebuffer, y) + visible.x, coverage, visible.w, pixel);
+            }
+        }
+    }
+}
+
+void software_backend::present(damage_region const * damage)
+{
+    _color_mods.clear();
+
+    if (_window == nullptr)
+        return;
+
+    if (damage == nullptr)
+        SDL_UpdateWindowSurface(_window);
+    else if (!damage->empty())
+        SDL_UpdateWindowSurfaceRects(_window, damage->rects().data(), damage->rects().size());
+
+    // The surface is recreated when the window size changes.
+    SDL_Surface * s = SDL_GetWindowSurface(_window);
+    if (s != nullptr)
+        set_framebuffer(s);
+}
+
+unique_texture_ptr software_backend::create_target_texture(vec size)
+{
+    return nullptr;
+}
+
+void software_backend::set_target(SDL_Texture * t, bool clear)
+{
+    if (t != nullptr)
+        throw std::runtime_error("render targets are not supported by the software backend");
+}
+
+bool software_backend::needs_pixels() const
+{
+    return true;
+}
+
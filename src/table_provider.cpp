@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "table_provider.hpp"
+
+table_provider::~table_provider()
+{
+}
+
+cell_type table_provider::column_type(std::size_t column) const
+{
+    return cell_type::TEXT;
+}
+
+std::string_view table_provider::row(std::size_t index) const
+{
+    _row_buffer.clear();
+    for (std::size_t c = 0; c < column_count(); ++c)
+    {
+        if (c > 0)
+            _row_buffer.push_back(' ');
+        _row_buffer.append(cell(index, c));
+    }
+    return _row_buffer;
+}
+
+generated_table_provider::generated_table_provider(std::size_t size, std::vector<cell_type> columns, std::function<void(std::size_t, std::size_t, std::string &)> format_cell)
+    : _size(size)
+    , _columns(std::move(columns))
+    , _format_cell(format_cell)
+{
+}
+
+std::size_t generated_table_provider::size() const
+{
+    return _size;
+}
+
+std::size_t generated_table_provider::column_count() const
+{
+    return _columns.size();
+}
+
+cell_type generated_table_provider::column_type(std::size_t column) const
+{
+    return _columns[column];
+}
+
+std::string_view generated_table_provider::cell(std::size_t row, std::size_t column) const
+{
+    _buffer.clear();
+    _format_cell(row, column, _buffer);
+    return _buffer;
+}
+
+void generated_table_provider::insert_rows(std::size_t position, std::size_t n)
+{
+    _size += n;
+    notify_rows_inserted(position, n);
+}
+
+void generated_table_provider::remove_rows(std::size_t position, std::size_t n)
+{
+    n = std::min(n, _size - std::min(position, _size));
+    _size -= n;
+    notify_rows_removed(position, n);
+}
+
+void generated_table_provider::change_rows(std::size_t position, std::size_t n)
+{
+    notify_rows_changed(position, n);
+}
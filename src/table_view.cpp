@@ -0,0 +1,130 @@
+#include <algorithm>
+
+#include <SDL2/SDL_rect.h>
+
+#include "table_view.hpp"
+
+// The space between columns.
+int const COLUMN_GAP = 12;
+
+table_view::table_view(std::shared_ptr<table_provider> provider, std::size_t position, std::function<void(std::size_t)> activate_callback)
+    : list_view(provider, position, activate_callback)
+    , _table(provider)
+    , _measured_position(0)
+    , _measured_count(0)
+    , _measured_valid(false)
+{
+}
+
+table_view::~table_view()
+{
+}
+
+void table_view::on_draw(draw_context & dc, selection_context const & sc) const
+{
+    // The widths have to be known before any row is drawn.
+    measure_visible_rows();
+    list_view::on_draw(dc, sc);
+}
+
+void table_view::on_rows_inserted(std::size_t position, std::size_t n)
+{
+    _measured_valid = false;
+    list_view::on_rows_inserted(position, n);
+}
+
+void table_view::on_rows_removed(std::size_t position, std::size_t n)
+{
+    _measured_valid = false;
+    list_view::on_rows_removed(position, n);
+}
+
+void table_view::on_rows_changed(std::size_t position, std::size_t n)
+{
+    _measured_valid = false;
+    list_view::on_rows_changed(position, n);
+}
+
+void table_view::set_provider(std::shared_ptr<table_provider> provider, std::size_t position)
+{
+    _table = provider;
+    _column_widths.clear();
+    _measured_valid = false;
+    list_view::set_provider(provider, position);
+}
+
+std::vector<int> const & table_view::get_column_widths() const
+{
+    return _column_widths;
+}
+
+void table_view::draw_row_content(draw_context & dc, rect entry_rect, std::size_t index) const
+{
+    context_info const & ci = get_context_info();
+
+    int x = entry_rect.x - static_cast<int>(get_x_shift());
+    for (std::size_t c = 0; c < _column_widths.size() && x < entry_rect.x + entry_rect.w; ++c)
+    {
+        int const width = _column_widths[c];
+        rect const cell_rect { x, entry_rect.y, width, entry_rect.h };
+        x += width + COLUMN_GAP;
+
+        // Columns scrolled out on the left are not drawn at all.
+        rect visible;
+        if (SDL_IntersectRect(&cell_rect, &entry_rect, &visible) != SDL_TRUE)
+            continue;
+
+        std::string_view const text = _table->cell(index, c);
+        int offset = cell_rect.x - visible.x;
+        if (_table->column_type(c) == cell_type::NUMBER)
+            offset += width - ci.text_size(text).w;
+
+        dc.draw_entry_text(text, visible, offset);
+    }
+}
+
+int table_view::content_width() const
+{
+    int width = 0;
+    for (int w : _column_widths)
+        width += w + COLUMN_GAP;
+    return std::max(0, width - COLUMN_GAP);
+}
+
+void table_view::measure_visible_rows() const
+{
+    std::size_t const size = _table->size();
+    std::size_t const position = std::min(get_position(), size);
+
+    // A partially visible row at the bottom is drawn as well.
+    std::size_t const count = std::min(get_visible_entries() + 1, size - position);
+
+    if (_measured_valid && _measured_position == position && _measured_count == count)
+        return;
+
+    context_info const & ci = get_context_info();
+    std::size_t const columns = _table->column_count();
+    _column_widths.resize(columns, 0);
+
+    bool grown = false;
+    for (std::size_t r = position; r < position + count; ++r)
+    {
+        for (std::size_t c = 0; c < columns; ++c)
+        {
+            int const w = ci.text_size(_table->cell(r, c)).w;
+            if (w > _column_widths[c])
+            {
+                _column_widths[c] = w;
+                grown = true;
+            }
+        }
+    }
+
+    // Rows drawn with narrower columns are outdated.
+    if (grown)
+        invalidate_cached_rows();
+
+    _measured_position = position;
+    _measured_count = count;
+    _measured_valid = true;
+}
@@ -1,8 +1,13 @@
 #include "text_button.hpp"
 
-text_button::text_button(std::string text, std::function<void()> callback)
+text_button::text_button(std::string_view text, std::function<void()> callback)
+    : text_button(interned_text(text), callback)
+{
+}
+
+text_button::text_button(interned_text text, std::function<void()> callback)
     : button(callback)
-    , _text(text)
+    , _text(std::move(text))
 {
 }
 
@@ -23,9 +28,19 @@ void text_button::draw_drawable(draw_context & dc, rect box) const
     }
 }
 
-void text_button::set_label(std::string text)
+void text_button::set_label(std::string_view text)
 {
-    _text = text;
+    set_label(interned_text(text));
+}
+
+void text_button::set_label(interned_text text)
+{
+    if (text == _text)
+        return;
+
+    _text = std::move(text);
+    invalidate_size_hint();
+    redo_layout();
     mark_dirty();
 }
 
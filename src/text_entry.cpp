@@ -0,0 +1,289 @@
+#include <algorithm>
+
+#include "text_entry.hpp"
+#include "utf8.hpp"
+
+// The frame of the entry box and the space between it and the text.
+int const TEXT_ENTRY_INSET = 4;
+
+int const CARET_WIDTH = 2;
+
+// Kerning lets a character reach into its neighbours.
+int const KERNING_MARGIN = 2;
+
+text_entry::text_entry(std::string_view text, std::function<void(std::string const &)> change_callback)
+    : _buffer(text)
+    , _caret_x(0)
+    , _x_shift(0)
+    , _change_callback(change_callback)
+{
+}
+
+text_entry::~text_entry()
+{
+}
+
+void text_entry::on_draw(draw_context & dc, selection_context const & sc) const
+{
+    bool const selected = sc.is_selected_widget(this);
+    dc.draw_entry_box(get_box(), selected);
+
+    rect const tb = text_box();
+    std::string_view const before = _buffer.before_gap();
+    std::string_view const after = _buffer.after_gap();
+
+    // The text after the cursor does not change while typing, its layout is
+    // reused.
+    if (!before.empty())
+        dc.draw_entry_text(before, tb, -_x_shift);
+    if (!after.empty())
+        dc.draw_entry_text(after, tb, _caret_x - _x_shift);
+
+    if (selected)
+        dc.draw_entry_position_indicator(caret_rect());
+}
+
+bool text_entry::is_opaque() const
+{
+    return true;
+}
+
+void text_entry::on_mouse_down_event(mouse_down_event const & e)
+{
+    rect const tb = text_box();
+    if (within_rect(e.position, get_box()))
+        set_cursor(position_at(e.position.x - tb.x + _x_shift));
+}
+
+void text_entry::on_key_event(key_event const & e)
+{
+    switch (e.type)
+    {
+        case key_type::TEXT:
+            insert(e.text);
+            break;
+        case key_type::BACKSPACE:
+            erase_before();
+            break;
+        case key_type::FORWARD_DELETE:
+            erase_after();
+            break;
+        case key_type::LEFT:
+            set_cursor(_buffer.prev_character(get_cursor()));
+            break;
+        case key_type::RIGHT:
+            set_cursor(_buffer.next_character(get_cursor()));
+            break;
+        case key_type::HOME:
+            set_cursor(0);
+            break;
+        case key_type::END:
+            set_cursor(_buffer.size());
+            break;
+        case key_type::OTHER:
+            break;
+    }
+}
+
+void text_entry::on_activate()
+{
+    if (_activate_callback)
+        _activate_callback(get_text());
+}
+
+void text_entry::on_box_allocated()
+{
+    update_caret();
+}
+
+size_hint text_entry::get_size_hint(int width, int height) const
+{
+    int const line_height = get_context_info().font_line_skip();
+
+    int const preset_min_width = 2 * TEXT_ENTRY_INSET + 2 * line_height;
+    int const preset_nat_width = preset_min_width + 200;
+    int const preset_height = 2 * TEXT_ENTRY_INSET + line_height;
+
+    vec minimal { opt_or_value(width, preset_min_width), preset_height };
+    vec natural { opt_or_value(width, preset_nat_width), preset_height };
+
+    return size_hint(minimal, natural);
+}
+
+void text_entry::set_text(std::string_view text)
+{
+    _buffer.assign(text);
+    _x_shift = 0;
+    update_caret();
+    mark_dirty();
+}
+
+std::string text_entry::get_text() const
+{
+    return _buffer.str();
+}
+
+void text_entry::set_cursor(std::size_t position)
+{
+    position = std::min(position, _buffer.size());
+    while (position > 0 && position < _buffer.size() && is_utf8_following_byte(_buffer[position]))
+        position--;
+
+    if (position == get_cursor())
+        return;
+
+    // Kerning between the text before and after the cursor changes as well.
+    rect const old_caret = caret_rect();
+    _buffer.move_gap(position);
+    if (update_caret())
+    {
+        mark_dirty();
+    }
+    else
+    {
+        mark_dirty(old_caret);
+        mark_dirty(caret_rect());
+    }
+}
+
+std::size_t text_entry::get_cursor() const
+{
+    return _buffer.gap_position();
+}
+
+void text_entry::set_activate_callback(std::function<void(std::string const &)> activate_callback)
+{
+    _activate_callback = activate_callback;
+}
+
+void text_entry::insert(std::string_view text)
+{
+    if (text.empty())
+        return;
+
+    int const from_x = _caret_x;
+    _buffer.insert(text);
+    text_changed(from_x);
+}
+
+void text_entry::erase_before()
+{
+    std::size_t const cursor = get_cursor();
+    std::size_t const n = cursor - _buffer.prev_character(cursor);
+    if (n == 0)
+        return;
+
+    _buffer.erase_before(n);
+    text_changed(prefix_width(_buffer.before_gap()));
+}
+
+void text_entry::erase_after()
+{
+    std::size_t const cursor = get_cursor();
+    std::size_t const n = _buffer.next_character(cursor) - cursor;
+    if (n == 0)
+        return;
+
+    _buffer.erase_after(n);
+    text_changed(_caret_x);
+}
+
+void text_entry::text_changed(int from_x)
+{
+    if (update_caret())
+    {
+        mark_dirty();
+    }
+    else
+    {
+        // Everything behind the edit moves.
+        rect const box = get_box();
+        int const x = std::max(box.x, text_box().x + from_x - _x_shift - KERNING_MARGIN);
+        mark_dirty({ x, box.y, std::max(0, box.x + box.w - x), box.h });
+    }
+
+    if (_change_callback)
+        _change_callback(get_text());
+}
+
+bool text_entry::update_caret()
+{
+    std::string_view const after = _buffer.after_gap();
+
+    _caret_x = prefix_width(_buffer.before_gap());
+    int const end_x = _caret_x + (after.empty() ? 0 : get_context_info().text_size(after).w);
+
+    // Do not scroll further than necessary to show the end of the text.
+    int const width = text_box().w - CARET_WIDTH;
+    int shift = std::min(_x_shift, std::max(0, end_x - width));
+
+    if (_caret_x - shift > width)
+        shift = _caret_x - width;
+    else if (_caret_x < shift)
+        shift = _caret_x;
+
+    bool const scrolled = shift != _x_shift;
+    _x_shift = shift;
+    return scrolled;
+}
+
+int text_entry::prefix_width(std::string_view prefix) const
+{
+    if (prefix.empty())
+        return 0;
+
+    context_info const & ci = get_context_info();
+
+    // A single trailing space only separates words and is not part of the
+    // width, another one is.
+    if (prefix.back() == ' ')
+    {
+        _measure_buffer.assign(prefix.data(), prefix.size());
+        _measure_buffer.push_back(' ');
+        return ci.text_size(_measure_buffer).w;
+    }
+
+    return ci.text_size(prefix).w;
+}
+
+std::size_t text_entry::position_at(int x)
+{
+    std::string const text = _buffer.str();
+
+    _positions.clear();
+    for (std::size_t pos = 0; pos < text.size(); pos = _buffer.next_character(pos))
+        _positions.push_back(pos);
+    _positions.push_back(text.size());
+
+    // Widths grow with the positions, only a few prefixes are measured.
+    std::string_view const t = text;
+    auto it = std::partition_point(_positions.begin(), _positions.end(), [&](std::size_t pos)
+    {
+        return prefix_width(t.substr(0, pos)) <= x;
+    });
+
+    if (it == _positions.begin())
+        return 0;
+    if (it == _positions.end())
+        return text.size();
+
+    // Choose the closer boundary of the character.
+    std::size_t const left = *(it - 1);
+    std::size_t const right = *it;
+    int const left_x = prefix_width(t.substr(0, left));
+    int const right_x = prefix_width(t.substr(0, right));
+    return x - left_x <= right_x - x ? left : right;
+}
+
+rect text_entry::text_box() const
+{
+    rect const box = get_box();
+    int const height = std::min(static_cast<int>(get_context_info().font_height()), std::max(0, box.h - 2 * TEXT_ENTRY_INSET));
+    return { box.x + TEXT_ENTRY_INSET, box.y + (box.h - height) / 2, std::max(0, box.w - 2 * TEXT_ENTRY_INSET), height };
+}
+
+rect text_entry::caret_rect() const
+{
+    rect const tb = text_box();
+    return { tb.x + _caret_x - _x_shift, tb.y, CARET_WIDTH, tb.h };
+}
@@ -0,0 +1,219 @@
+#include <algorithm>
+
+#include "text_view.hpp"
+
+text_view::text_view(std::vector<paragraph> content)
+    : _wrap_width(-1)
+    , _scroll_offset(0)
+{
+    set_content(std::move(content));
+}
+
+text_view::text_view(std::string_view text)
+    : text_view(parse_text_fragments(text))
+{
+}
+
+text_view::~text_view()
+{
+}
+
+void text_view::on_draw(draw_context & dc, selection_context const & sc) const
+{
+    rect const box = get_box();
+    dc.draw_background(box);
+
+    if (_content.empty())
+        return;
+
+    // Skip paragraphs that end above the visible area.
+    std::size_t k = std::upper_bound(_tops.begin() + 1, _tops.end(), _scroll_offset) - (_tops.begin() + 1);
+    for (; k < _content.size() && _tops[k] < _scroll_offset + box.h; ++k)
+    {
+        wrapped_paragraph const & wp = _wrapped[k];
+        if (wp.line_starts.empty())
+            continue;
+
+        int const top = box.y + _tops[k] - _scroll_offset;
+
+        std::size_t line = top < box.y ? (box.y - top) / wp.line_skip : 0;
+        for (; line < wp.line_starts.size(); ++line)
+        {
+            int const y = top + static_cast<int>(line) * wp.line_skip;
+            if (y >= box.y + box.h)
+                break;
+
+            dc.draw_text_line({ box.x, y }, box, line_text(k, line), _content[k].font_idx);
+        }
+    }
+}
+
+bool text_view::is_opaque() const
+{
+    return true;
+}
+
+void text_view::on_mouse_down_event(mouse_down_event const & e)
+{
+    if (within_rect(e.position, get_box()))
+        _drag_start_offset = _scroll_offset;
+}
+
+void text_view::on_mouse_up_event(mouse_up_event const & e)
+{
+    _drag_start_offset.reset();
+}
+
+void text_view::on_mouse_move_event(mouse_move_event const & e)
+{
+    // The text follows the pointer.
+    if (_drag_start_offset.has_value() && e.opt_movement.has_value())
+        set_scroll_offset(_drag_start_offset.value() - e.opt_movement->length.h);
+}
+
+void text_view::on_box_allocated()
+{
+    int const width = get_box().w;
+    if (width != _wrap_width)
+    {
+        _wrap_width = width;
+        for (std::size_t k = 0; k < _content.size(); ++k)
+            wrap(k);
+        update_tops(0);
+    }
+
+    set_scroll_offset(_scroll_offset);
+}
+
+size_hint text_view::get_size_hint(int width, int height) const
+{
+    // The text is scrolled, its length does not matter. Wrapping works with
+    // any width, but about 45 characters should fit on a line, see label.
+    int const line_skip = get_context_info().font_line_skip();
+    vec const minimal { opt_or_value(width, 4 * line_skip), opt_or_value(height, 2 * line_skip) };
+    vec const natural { opt_or_value(width, 13 * line_skip), opt_or_value(height, 10 * line_skip) };
+    return size_hint(minimal, natural);
+}
+
+void text_view::set_text(std::string_view text)
+{
+    set_content(parse_text_fragments(text));
+}
+
+void text_view::set_content(std::vector<paragraph> content)
+{
+    _content = std::move(content);
+    _wrapped.assign(_content.size(), { -1, {}, 0 });
+    for (std::size_t k = 0; k < _content.size(); ++k)
+        wrap(k);
+    update_tops(0);
+
+    set_scroll_offset(_scroll_offset);
+    mark_dirty();
+}
+
+std::vector<paragraph> const & text_view::get_content() const
+{
+    return _content;
+}
+
+void text_view::append_paragraph(paragraph p)
+{
+    bool const at_end = _scroll_offset >= max_scroll_offset();
+
+    _content.push_back(std::move(p));
+    _wrapped.push_back({ -1, {}, 0 });
+    wrap(_content.size() - 1);
+    update_tops(_content.size() - 1);
+
+    if (at_end)
+        scroll_to_end();
+
+    // Not visible below the end otherwise.
+    if (_tops[_content.size() - 1] < _scroll_offset + get_box().h)
+        mark_dirty();
+}
+
+void text_view::set_paragraph(std::size_t index, paragraph p)
+{
+    if (_content.at(index) == p)
+        return;
+
+    _content[index] = std::move(p);
+    _wrapped[index].width = -1;
+    wrap(index);
+    update_tops(index);
+
+    set_scroll_offset(_scroll_offset);
+    mark_dirty();
+}
+
+void text_view::set_scroll_offset(int offset)
+{
+    offset = std::clamp(offset, 0, max_scroll_offset());
+    if (offset != _scroll_offset)
+    {
+        _scroll_offset = offset;
+        mark_dirty();
+    }
+}
+
+int text_view::get_scroll_offset() const
+{
+    return _scroll_offset;
+}
+
+void text_view::scroll_to_end()
+{
+    set_scroll_offset(max_scroll_offset());
+}
+
+int text_view::get_content_height() const
+{
+    return _tops.back();
+}
+
+void text_view::wrap(std::size_t index)
+{
+    // Fonts are only available once the view has a box.
+    wrapped_paragraph & wp = _wrapped[index];
+    if (_wrap_width < 0 || wp.width == _wrap_width)
+        return;
+
+    paragraph const & p = _content[index];
+    get_context_info().text_line_starts(p.text, _wrap_width, wp.line_starts, p.font_idx);
+    wp.line_skip = get_context_info().font_line_skip(p.font_idx);
+    wp.width = _wrap_width;
+}
+
+void text_view::update_tops(std::size_t index)
+{
+    _tops.resize(_content.size() + 1);
+    if (index == 0)
+        _tops[0] = 0;
+
+    for (std::size_t k = index; k < _content.size(); ++k)
+    {
+        wrapped_paragraph const & wp = _wrapped[k];
+        int const lines = static_cast<int>(wp.line_starts.size()) + _content[k].trailing_newlines;
+        _tops[k + 1] = _tops[k] + lines * wp.line_skip;
+    }
+}
+
+int text_view::max_scroll_offset() const
+{
+    return std::max(0, _tops.back() - get_box().h);
+}
+
+std::string_view text_view::line_text(std::size_t index, std::size_t line) const
+{
+    std::string_view const t = _content[index].text;
+    auto const & starts = _wrapped[index].line_starts;
+
+    std::size_t const begin = starts[line];
+    std::size_t end = line + 1 < starts.size() ? starts[line + 1] : t.size();
+    while (end > begin && t[end - 1] == ' ')
+        end--;
+    return t.substr(begin, end - begin);
+}
+
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "texture_atlas.hpp"
+#include "sdl_util.hpp"
+
+// Free space that is kept between entries, such that filtering never picks up
+// pixels of a neighbour.
+int const ENTRY_SPACING = 1;
+
+texture_atlas::texture_atlas(SDL_Renderer * renderer, vec page_size)
+    : _renderer(renderer)
+    , _page_size(page_size)
+    , _page_size_limited(false)
+{
+}
+
+texture_atlas::~texture_atlas()
+{
+    clear();
+}
+
+texture_atlas::texture_atlas(texture_atlas && other)
+    : _renderer(other._renderer)
+    , _page_size(other._page_size)
+    , _page_size_limited(other._page_size_limited)
+    , _pages(std::move(other._pages))
+{
+    other._pages.clear();
+}
+
+texture_atlas::allocation texture_atlas::insert(SDL_Surface * s)
+{
+    vec const size { s->w, s->h };
+
+    limit_page_size();
+    if (size.w > _page_size.w || size.h > _page_size.h)
+        return { nullptr, origin_rect(size) };
+
+    rect r;
+    auto it = std::find_if(_pages.begin(), _pages.end(), [&](page & p){ return allocate(p, size, r); });
+    if (it == _pages.end())
+    {
+        _pages.push_back(create_page());
+        it = std::prev(_pages.end());
+
+        // Always succeeds on an empty page.
+        allocate(*it, size, r);
+    }
+
+    // Pages use a fixed pixel format, convert if necessary.
+    SDL_Surface * converted = nullptr;
+    if (s->format->format != SDL_PIXELFORMAT_ARGB8888)
+    {
+        converted = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (converted == nullptr)
+            throw std::runtime_error(std::string("could not convert surface for texture atlas: ") + SDL_GetError());
+        s = converted;
+    }
+
+    int const result = SDL_UpdateTexture(it->texture, &r, s->pixels, s->pitch);
+
+    if (converted != nullptr)
+        SDL_FreeSurface(converted);
+
+    if (result < 0)
+        throw std::runtime_error(std::string("could not update texture atlas page: ") + SDL_GetError());
+
+    it->live++;
+
+    return { it->texture, r };
+}
+
+void texture_atlas::release(allocation const & a)
+{
+    auto pit = std::find_if(_pages.begin(), _pages.end(), [&](page const & p){ return p.texture == a.texture; });
+    if (pit == _pages.end())
+        return;
+
+    if (--pit->live == 0)
+    {
+        // Nothing on the page is used anymore, give the memory back.
+        destroy_texture(pit->texture);
+        _pages.erase(pit);
+        return;
+    }
+
+    auto sit = std::find_if(pit->shelves.begin(), pit->shelves.end(), [&](shelf const & sh){ return sh.y == a.source.y; });
+    if (sit == pit->shelves.end())
+        return;
+
+    auto & slots = sit->free_slots;
+    int x = a.source.x;
+    int w = a.source.w + ENTRY_SPACING;
+
+    auto next = std::lower_bound(slots.begin(), slots.end(), std::make_pair(x, 0));
+
+    // Merge with adjacent released areas.
+    if (next != slots.end() && next->first == x + w)
+    {
+        w += next->second;
+        next = slots.erase(next);
+    }
+    if (next != slots.begin() && std::prev(next)->first + std::prev(next)->second == x)
+    {
+        auto prev = std::prev(next);
+        x = prev->first;
+        w += prev->second;
+        next = slots.erase(prev);
+    }
+
+    // Areas at the end of the shelf are merged with the unused space.
+    if (x + w == sit->x)
+        sit->x = x;
+    else
+        slots.insert(next, { x, w });
+}
+
+void texture_atlas::clear()
+{
+    for (auto & p : _pages)
+        destroy_texture(p.texture);
+    _pages.clear();
+}
+
+std::size_t texture_atlas::page_count() const
+{
+    return _pages.size();
+}
+
+vec texture_atlas::page_size() const
+{
+    limit_page_size();
+    return _page_size;
+}
+
+void texture_atlas::limit_page_size() const
+{
+    if (_page_size_limited)
+        return;
+    _page_size_limited = true;
+
+    // Respect the limits of the renderer, 0 means there is none.
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(_renderer, &info) == 0)
+    {
+        if (info.max_texture_width > 0)
+            _page_size.w = std::min(_page_size.w, info.max_texture_width);
+        if (info.max_texture_height > 0)
+            _page_size.h = std::min(_page_size.h, info.max_texture_height);
+    }
+}
+
+bool texture_atlas::allocate(page & p, vec size, rect & result)
+{
+    int const padded_w = size.w + ENTRY_SPACING;
+
+    // Pick the shelf that wastes the least height. Shelves that are a lot
+    // higher than requested are not considered, otherwise small entries would
+    // quickly consume the space for larger ones.
+    shelf * best = nullptr;
+    for (auto & sh : p.shelves)
+    {
+        if (sh.height >= size.h
+            && sh.height <= size.h + size.h / 4
+            && allocate_free_slot(sh, padded_w, result.x))
+        {
+            result = { result.x, sh.y, size.w, size.h };
+            return true;
+        }
+    }
+
+    for (auto & sh : p.shelves)
+    {
+        if (sh.height >= size.h
+            && sh.height <= size.h + size.h / 4
+            && sh.x + padded_w <= _page_size.w + ENTRY_SPACING
+            && (best == nullptr || sh.height < best->height))
+        {
+            best = &sh;
+        }
+    }
+
+    if (best == nullptr)
+    {
+        // Open a new shelf.
+        if (p.y + size.h > _page_size.h)
+            return false;
+
+        p.shelves.push_back({ p.y, size.h, 0 });
+        p.y += size.h + ENTRY_SPACING;
+        best = &p.shelves.back();
+    }
+
+    result = { best->x, best->y, size.w, size.h };
+    best->x += padded_w;
+    return true;
+}
+
+texture_atlas::page texture_atlas::create_page()
+{
+    SDL_Texture * t = SDL_CreateTexture(_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, _page_size.w, _page_size.h);
+
+    if (t == nullptr)
+        throw std::runtime_error(std::string("could not create texture atlas page: ") + SDL_GetError());
+
+    // Use alpha blending to make use of the alpha channel.
+    if (SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND) < 0)
+        throw std::runtime_error(SDL_GetError());
+
+    return { t, {}, 0, 0 };
+}
+
+bool texture_atlas::allocate_free_slot(shelf & sh, int width, int & x)
+{
+    auto it = std::find_if(sh.free_slots.begin(), sh.free_slots.end(), [=](auto const & slot){ return slot.second >= width; });
+    if (it == sh.free_slots.end())
+        return false;
+
+    x = it->first;
+    if (it->second == width)
+    {
+        sh.free_slots.erase(it);
+    }
+    else
+    {
+        it->first += width;
+        it->second -= width;
+    }
+    return true;
+}
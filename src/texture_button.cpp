@@ -8,15 +8,55 @@ texture_button::texture_button(shared_texture_ptr texture, std::function<void()>
 
 texture_button::~texture_button()
 {
+    cancel_pending();
 }
 
 void texture_button::set_texture(shared_texture_ptr texture)
 {
+    cancel_pending();
+    _decoded.reset();
     _texture = texture;
+    invalidate_size_hint();
+    redo_layout();
+}
+
+void texture_button::set_texture(std::shared_ptr<image_request> pending)
+{
+    cancel_pending();
+    if (!pending)
+        return;
+
+    _pending = pending;
+    _pending->on_ready([this](unique_surface_ptr s)
+    {
+        _pending.reset();
+        if (!s)
+            return;
+
+        _decoded = std::move(s);
+        mark_dirty();
+        invalidate_size_hint();
+        redo_layout();
+    });
+}
+
+void texture_button::cancel_pending()
+{
+    if (_pending)
+    {
+        _pending->cancel();
+        _pending.reset();
+    }
 }
 
 void texture_button::draw_drawable(draw_context & dc, rect box) const
 {
+    if (_decoded)
+    {
+        _texture = shared_texture_ptr(dc.create_texture(_decoded.get()).release(), texture_destroyer());
+        _decoded.reset();
+    }
+
     // TODO cache ?
     rect tex_box = center_vec_within_rect(texture_dim(_texture.get()), get_box());
     // TODO allow nullptr? how to prevent it?
@@ -25,6 +65,8 @@ void texture_button::draw_drawable(draw_context & dc, rect box) const
 
 vec texture_button::get_drawable_size() const
 {
+    if (_decoded)
+        return { _decoded->w, _decoded->h };
     return texture_dim(_texture.get());
 }
 
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <SDL2/SDL_image.h>
+
+#include "image_loader.hpp"
+#include "texture_cache.hpp"
+
+texture_cache::texture_cache(std::size_t byte_budget)
+    : _byte_budget(byte_budget)
+    , _bytes_retained(0)
+    , _hits(0)
+    , _misses(0)
+    , _evictions(0)
+{
+}
+
+shared_texture_ptr texture_cache::load(SDL_Renderer * r, std::string const & path, vec size)
+{
+    auto it = _entries.find(key { r, path, size.w, size.h });
+    if (it != _entries.end())
+    {
+        shared_texture_ptr t = it->second.retained ? it->second.retained : it->second.weak.lock();
+        if (t)
+        {
+            _hits++;
+            retain(it, t);
+            return t;
+        }
+    }
+
+    _misses++;
+
+    unique_surface_ptr s(IMG_Load(path.c_str()));
+    if (!s)
+        throw std::runtime_error(std::string("could not load image: ") + IMG_GetError());
+
+    vec const fitted = fit_image_size({ s->w, s->h }, size);
+    if (fitted.w != s->w || fitted.h != s->h)
+        s = downscale_surface(s.get(), fitted);
+
+    shared_texture_ptr t(SDL_CreateTextureFromSurface(r, s.get()), texture_destroyer());
+    if (!t)
+        throw std::runtime_error(std::string("could not create texture: ") + SDL_GetError());
+
+    if (it == _entries.end())
+        it = _entries.emplace(key { r, path, size.w, size.h }, entry { {}, nullptr, _lru.end(), 0 }).first;
+
+    it->second.weak = t;
+    it->second.bytes = static_cast<std::size_t>(s->w) * s->h * 4;
+    retain(it, t);
+    return t;
+}
+
+void texture_cache::set_byte_budget(std::size_t bytes)
+{
+    _byte_budget = bytes;
+    evict();
+}
+
+std::size_t texture_cache::byte_budget() const
+{
+    return _byte_budget;
+}
+
+texture_cache_stats texture_cache::stats() const
+{
+    return { _hits, _misses, _evictions, _entries.size(), _bytes_retained };
+}
+
+void texture_cache::clear()
+{
+    _lru.clear();
+    _entries.clear();
+    _bytes_retained = 0;
+}
+
+std::size_t texture_cache::resident_bytes() const
+{
+    return _bytes_retained;
+}
+
+void texture_cache::set_memory_limit(std::optional<std::size_t> bytes)
+{
+    _memory_limit = bytes;
+    evict();
+}
+
+void texture_cache::retain(entry_iterator it, shared_texture_ptr t)
+{
+    entry & e = it->second;
+    if (e.retained)
+    {
+        _lru.splice(_lru.begin(), _lru, e.lru_pos);
+    }
+    else
+    {
+        e.retained = std::move(t);
+        _lru.push_front(it);
+        e.lru_pos = _lru.begin();
+        _bytes_retained += e.bytes;
+    }
+    evict();
+}
+
+void texture_cache::evict()
+{
+    // The most recent texture is kept even if it is too large on its own,
+    // unless memory is scarce.
+    std::size_t const budget = std::min(_byte_budget, _memory_limit.value_or(_byte_budget));
+    std::size_t const keep = _memory_limit.has_value() ? 0 : 1;
+    while (_bytes_retained > budget && _lru.size() > keep)
+    {
+        entry_iterator it = _lru.back();
+        _lru.pop_back();
+        _bytes_retained -= it->second.bytes;
+        it->second.retained.reset();
+        _evictions++;
+
+        // Nobody uses it anymore.
+        if (it->second.weak.expired())
+            _entries.erase(it);
+    }
+}
+
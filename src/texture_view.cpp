@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include <SDL2/SDL_image.h>
 
 #include "texture_view.hpp"
@@ -8,6 +10,11 @@ texture_view::texture_view()
     , _min_width(0)
     , _nat_width(0)
     , _target { 0, 0, 0, 0 }
+    , _loader(nullptr)
+    , _requested_size { 0, 0 }
+    , _min_width_param(-1)
+    , _nat_width_param(-1)
+    , _streaming(false)
 {
 }
 
@@ -17,16 +24,52 @@ texture_view::texture_view(unique_texture_ptr p, int min_width, int nat_width)
     , _min_width(decode_min_width_param(min_width))
     , _nat_width(decode_nat_width_param(nat_width))
     , _target { 0, 0, 0, 0 }
+    , _loader(nullptr)
+    , _requested_size { 0, 0 }
+    , _min_width_param(-1)
+    , _nat_width_param(-1)
+    , _streaming(false)
 {
 }
 
 texture_view::~texture_view()
 {
+    stop_streaming();
+    cancel_pending();
 }
 
 
 void texture_view::on_draw(draw_context & dc, selection_context const & sc) const
 {
+    if (_streaming)
+    {
+        if (!_p)
+            _p = dc.create_streaming_texture(_size);
+
+        if (_stream_write)
+        {
+            dc.update_streaming_texture(_p.get(), _stream_write);
+            _stream_write = nullptr;
+        }
+        else if (_stream)
+        {
+            int const row_bytes = _size.w * 4;
+            _stream->consume([&](uint32_t const * frame)
+            {
+                dc.update_streaming_texture(_p.get(), [&](void * pixels, int pitch)
+                {
+                    for (int y = 0; y < _size.h; ++y)
+                        std::memcpy(static_cast<char *>(pixels) + y * pitch, reinterpret_cast<char const *>(frame) + y * row_bytes, row_bytes);
+                });
+            });
+        }
+    }
+    else if (_decoded)
+    {
+        _p = dc.create_texture(_decoded.get());
+        _decoded.reset();
+    }
+
     if (_p)
         dc.copy_texture(_p.get(), _target);
     else
@@ -35,10 +78,11 @@ void texture_view::on_draw(draw_context & dc, selection_context const & sc) cons
 
 void texture_view::on_box_allocated()
 {
-    if (_p)
+    if (_p || _decoded)
     {
         refresh_target();
     }
+    reload_if_scaled_badly();
 }
 
 size_hint texture_view::get_size_hint(int width, int height) const
@@ -51,6 +95,11 @@ size_hint texture_view::get_size_hint(int width, int height) const
 
 void texture_view::set_texture(unique_texture_ptr p, int min_width, int nat_width)
 {
+    stop_streaming();
+    cancel_pending();
+    _decoded.reset();
+    _loader = nullptr;
+
     bool was_nullptr = _p.operator bool();
 
     _p = std::move(p);
@@ -71,6 +120,148 @@ void texture_view::set_texture(unique_texture_ptr p, int min_width, int nat_widt
             mark_dirty();
         }
     }
+    invalidate_size_hint();
+    redo_layout();
+}
+
+void texture_view::set_texture(std::shared_ptr<image_request> pending, int min_width, int nat_width)
+{
+    // Draw the placeholder meanwhile.
+    set_texture(unique_texture_ptr(), min_width, nat_width);
+    attach_pending(pending, min_width, nat_width);
+}
+
+void texture_view::set_image(image_loader & loader, std::string filename, int min_width, int nat_width)
+{
+    set_texture(unique_texture_ptr(), min_width, nat_width);
+
+    _loader = &loader;
+    _filename = std::move(filename);
+    _min_width_param = min_width;
+    _nat_width_param = nat_width;
+    load_image();
+}
+
+void texture_view::attach_pending(std::shared_ptr<image_request> pending, int min_width, int nat_width)
+{
+    cancel_pending();
+    if (!pending)
+        return;
+
+    _pending = pending;
+    image_request const * r = pending.get();
+    _pending->on_ready([this, r, min_width, nat_width](unique_surface_ptr s)
+    {
+        _pending.reset();
+        if (!s)
+            return;
+
+        vec const original = r->original_size();
+        vec const size = original.w > 0 ? original : vec { s->w, s->h };
+        _decoded = std::move(s);
+
+        // A rescaled image has the same layout, only the texture changes.
+        bool const resized = size.w != _size.w || size.h != _size.h;
+        _size = size;
+        _min_width = decode_min_width_param(min_width);
+        _nat_width = decode_nat_width_param(nat_width);
+        refresh_target();
+        mark_dirty();
+        if (resized)
+        {
+            invalidate_size_hint();
+            redo_layout();
+        }
+
+        // The box might not have been known when it was requested.
+        reload_if_scaled_badly();
+    });
+}
+
+void texture_view::load_image()
+{
+    // The box is usually known already, e.g., when the cover changes with the
+    // track.
+    rect const & box = get_box();
+    _requested_size = box.w > 0 && box.h > 0 ? vec { box.w, box.h } : vec { 0, 0 };
+
+    // The current texture is shown until the new one is ready.
+    attach_pending(_loader->load(_filename, _requested_size), _min_width_param, _nat_width_param);
+}
+
+// Decoding again is only worth it if the size changed a lot.
+bool significantly_different_width(int w, int reference)
+{
+    return w * 4 > reference * 5 || w * 2 < reference;
+}
+
+void texture_view::reload_if_scaled_badly()
+{
+    if (_loader == nullptr || _pending || _size.w <= 0)
+        return;
+
+    rect const & box = get_box();
+    if (box.w <= 0 || box.h <= 0)
+        return;
+
+    vec const wanted = fit_image_size(_size, { box.w, box.h });
+    vec const requested = fit_image_size(_size, _requested_size);
+    if (significantly_different_width(wanted.w, requested.w))
+        load_image();
+}
+
+void texture_view::set_streaming(vec size, int min_width, int nat_width)
+{
+    set_texture(unique_texture_ptr(), min_width, nat_width);
+
+    _streaming = true;
+    _size = size;
+    _min_width = decode_min_width_param(min_width);
+    _nat_width = decode_nat_width_param(nat_width);
+    refresh_target();
+    mark_dirty();
+    invalidate_size_hint();
+    redo_layout();
+}
+
+void texture_view::update_stream(std::function<void(void *, int)> write)
+{
+    if (!_streaming)
+        return;
+
+    _stream_write = std::move(write);
+    mark_dirty();
+}
+
+void texture_view::set_stream(std::shared_ptr<pixel_stream> stream, int min_width, int nat_width)
+{
+    set_streaming(stream->size(), min_width, nat_width);
+
+    _stream = stream;
+    _stream->set_listener([this]()
+    {
+        mark_dirty();
+    });
+}
+
+void texture_view::stop_streaming()
+{
+    if (_stream)
+    {
+        _stream->set_listener(nullptr);
+        _stream.reset();
+    }
+    _stream_write = nullptr;
+    _streaming = false;
+}
+
+void texture_view::cancel_pending()
+{
+    if (_pending)
+    {
+        _pending->cancel();
+        _pending.reset();
+    }
 }
 
 void texture_view::refresh_target()
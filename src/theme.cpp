@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "theme.hpp"
+
+color_theme::color_theme()
+    : button_bg_color{25, 25, 25}
+    , button_fg_color{235, 235, 235}
+    , button_frame_color{105, 105, 105}
+    , button_pressed_bg_color{105, 55, 55}
+    , button_selected_bg_color{55, 55, 105}
+
+    , entry_fg_color{0, 0, 0}
+    , entry_selected_bg_color{250, 200, 200}
+    , entry_highlight_bg_color{240, 240, 240}
+
+    , entry_box_bg_color{255, 255, 255}
+    , entry_box_frame_color{100, 100, 100}
+    , entry_box_selected_frame_color{155, 155, 205}
+
+    , fg_color{255, 255, 255}
+    , bg_color{0, 0, 0}
+    , active_color{230, 230, 255}
+    , hightlight_color{210, 210, 210}
+{}
+
+box_state make_box_state(bool pressed, bool selected)
+{
+    return static_cast<box_state>((pressed ? 1 : 0) | (selected ? 2 : 0));
+}
+
+theme::theme(color_theme colors, int corner_radius)
+    : _colors(colors)
+    , _corner_radius(std::max(0, corner_radius))
+{
+}
+
+theme::~theme()
+{
+}
+
+color_theme const & theme::colors() const
+{
+    return _colors;
+}
+
+int theme::border_width(box_type bt) const
+{
+    // The frame has to fit into the corners.
+    return std::max(1, _corner_radius);
+}
+
+// Blends the color over the pixel, which is ARGB8888.
+void blend_theme_pixel(uint32_t & p, SDL_Color c, float coverage)
+{
+    if (coverage <= 0)
+        return;
+
+    float const a = std::min(1.0f, coverage);
+    float const da = (p >> 24) / 255.0f;
+    float const oa = a + da * (1 - a);
+
+    auto channel = [&](uint32_t dc, uint8_t sc)
+    {
+        return static_cast<uint32_t>(std::lround((sc * a + dc * da * (1 - a)) / oa));
+    };
+
+    uint32_t const r = channel((p >> 16) & 0xff, c.r);
+    uint32_t const g = channel((p >> 8) & 0xff, c.g);
+    uint32_t const b = channel(p & 0xff, c.b);
+    p = static_cast<uint32_t>(std::lround(oa * 255)) << 24 | r << 16 | g << 8 | b;
+}
+
+void theme::render_box(box_type bt, box_state s, SDL_Surface * target, rect area) const
+{
+    bool const pressed = s == box_state::PRESSED || s == box_state::PRESSED_SELECTED;
+    bool const selected = s == box_state::SELECTED || s == box_state::PRESSED_SELECTED;
+
+    SDL_Color bg;
+    SDL_Color frame;
+    switch (bt)
+    {
+        case box_type::BUTTON:
+            bg = pressed ? _colors.button_pressed_bg_color : (selected ? _colors.button_selected_bg_color : _colors.button_bg_color);
+            frame = _colors.button_frame_color;
+            break;
+        case box_type::ENTRY:
+            bg = _colors.entry_box_bg_color;
+            frame = selected ? _colors.entry_box_selected_frame_color : _colors.entry_box_frame_color;
+            break;
+        case box_type::RADIO_MARK:
+        default:
+            bg = _colors.entry_fg_color;
+            frame = bg;
+            break;
+    }
+
+    // Distances are measured from the centers of the corner circles, both
+    // the outline and the inner edge of the frame are antialiased.
+    float const radius = _corner_radius;
+    float const cx0 = area.x + radius;
+    float const cy0 = area.y + radius;
+    float const cx1 = area.x + area.w - radius;
+    float const cy1 = area.y + area.h - radius;
+
+    if (SDL_MUSTLOCK(target))
+        SDL_LockSurface(target);
+
+    for (int y = area.y; y < area.y + area.h; ++y)
+    {
+        uint32_t * row = reinterpret_cast<uint32_t *>(static_cast<uint8_t *>(target->pixels) + y * target->pitch);
+        for (int x = area.x; x < area.x + area.w; ++x)
+        {
+            float const px = x + 0.5f;
+            float const py = y + 0.5f;
+
+            // The distance to the outline, positive inside.
+            float inside;
+            float const dx = px < cx0 ? cx0 - px : (px > cx1 ? px - cx1 : 0);
+            float const dy = py < cy0 ? cy0 - py : (py > cy1 ? py - cy1 : 0);
+            if (radius > 0 && dx > 0 && dy > 0)
+                inside = radius - std::sqrt(dx * dx + dy * dy);
+            else
+                inside = std::min({ px - area.x, area.x + area.w - px, py - area.y, area.y + area.h - py });
+
+            float const outer = std::min(1.0f, inside + 0.5f);
+            float const inner = std::min(1.0f, inside - 0.5f);
+            blend_theme_pixel(row[x], frame, outer);
+            blend_theme_pixel(row[x], bg, inner);
+        }
+    }
+
+    if (SDL_MUSTLOCK(target))
+        SDL_UnlockSurface(target);
+}
+
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+#include "thread_pool.hpp"
+
+thread_pool::thread_pool(std::size_t num_threads)
+    : _stop(false)
+{
+    for (std::size_t k = 0; k < num_threads; ++k)
+        _threads.emplace_back(&thread_pool::run, this);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+        _tasks.clear();
+    }
+    _cv.notify_all();
+
+    for (auto & t : _threads)
+        t.join();
+}
+
+void thread_pool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _cv.notify_one();
+}
+
+void thread_pool::parallel_for(std::size_t n, std::function<void(std::size_t)> const & f)
+{
+    // Shared with the helper tasks, which may start after the call returned.
+    struct state
+    {
+        std::function<void(std::size_t)> const * f;
+        std::size_t n;
+        std::atomic<std::size_t> next;
+        std::size_t done;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::exception_ptr error;
+    };
+
+    auto s = std::make_shared<state>();
+    s->f = &f;
+    s->n = n;
+    s->next = 0;
+    s->done = 0;
+
+    // Claims indices until none are left. f is only used while indices are
+    // left, which keeps the caller waiting.
+    auto work = [](state & s)
+    {
+        std::size_t k;
+        while ((k = s.next.fetch_add(1)) < s.n)
+        {
+            std::exception_ptr error;
+            try
+            {
+                (*s.f)(k);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (error && !s.error)
+                s.error = error;
+            if (++s.done == s.n)
+                s.cv.notify_all();
+        }
+    };
+
+    std::size_t const helpers = std::min(_threads.size(), n > 0 ? n - 1 : 0);
+    for (std::size_t k = 0; k < helpers; ++k)
+        submit([s, work](){ work(*s); });
+
+    work(*s);
+
+    std::unique_lock<std::mutex> lock(s->mutex);
+    s->cv.wait(lock, [&](){ return s->done == s->n; });
+    if (s->error)
+        std::rethrow_exception(s->error);
+}
+
+std::size_t thread_pool::size() const
+{
+    return _threads.size();
+}
+
+void thread_pool::run()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this](){ return _stop || !_tasks.empty(); });
+
+            if (_stop)
+                return;
+
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+
+        task();
+    }
+}
+
@@ -0,0 +1,116 @@
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "trace.hpp"
+
+// Enough for a couple of minutes of frames.
+std::size_t const DEFAULT_MAX_EVENTS = 1000000;
+
+thread_local tracer * active_tracer = nullptr;
+
+tracer::tracer()
+    : _origin(std::chrono::steady_clock::now())
+    , _max_events(DEFAULT_MAX_EVENTS)
+    , _dropped_events(0)
+{
+}
+
+void tracer::reset()
+{
+    _origin = std::chrono::steady_clock::now();
+    _events.clear();
+    _dropped_events = 0;
+}
+
+std::vector<trace_event> const & tracer::events() const
+{
+    return _events;
+}
+
+void tracer::set_max_events(std::size_t n)
+{
+    _max_events = n;
+}
+
+std::size_t tracer::dropped_events() const
+{
+    return _dropped_events;
+}
+
+void tracer::record(char const * category, char const * name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    if (_events.size() >= _max_events)
+    {
+        _dropped_events++;
+        return;
+    }
+
+    _events.push_back({ category, name, start - _origin, end - start });
+}
+
+// Microseconds with a fraction, as expected by the trace viewer.
+void write_microseconds(std::ostream & out, std::chrono::nanoseconds t)
+{
+    out << t.count() / 1000 << '.' << std::setw(3) << std::setfill('0') << t.count() % 1000;
+}
+
+void tracer::write_chrome_trace(std::ostream & out) const
+{
+    // Scopes end in reverse order, the viewer nests complete events by their
+    // times regardless of their order.
+    out << "{\"traceEvents\":[";
+    for (std::size_t k = 0; k < _events.size(); ++k)
+    {
+        trace_event const & e = _events[k];
+        if (k > 0)
+            out << ',';
+        out << "\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.category << "\",\"ph\":\"X\",\"ts\":";
+        write_microseconds(out, e.start);
+        out << ",\"dur\":";
+        write_microseconds(out, e.duration);
+        out << ",\"pid\":1,\"tid\":1}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void tracer::write_chrome_trace(std::string const & path) const
+{
+    std::ofstream out(path, std::ios::trunc);
+    write_chrome_trace(out);
+    out.flush();
+    if (!out)
+        throw std::runtime_error("could not write trace " + path);
+}
+
+tracer * tracer::active()
+{
+    return active_tracer;
+}
+
+tracer::activation::activation(tracer * t)
+    : _previous(active_tracer)
+{
+    active_tracer = t;
+}
+
+tracer::activation::~activation()
+{
+    active_tracer = _previous;
+}
+
+tracer::scope::scope(char const * category, char const * name)
+    : _t(active_tracer)
+    , _category(category)
+    , _name(name)
+{
+    if (_t != nullptr)
+        _start = std::chrono::steady_clock::now();
+}
+
+tracer::scope::~scope()
+{
+    if (_t != nullptr)
+        _t->record(_category, _name, _start, std::chrono::steady_clock::now());
+}
+
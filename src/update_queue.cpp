@@ -0,0 +1,83 @@
+#include <memory>
+
+#include <SDL2/SDL_events.h>
+
+#include "update_queue.hpp"
+
+update_queue::update_queue(uint32_t wakeup_event)
+    : _head(nullptr)
+    , _wakeup_event(wakeup_event)
+{
+}
+
+update_queue::~update_queue()
+{
+    // Nobody is there to receive updates anymore.
+    node * n = _head.exchange(nullptr, std::memory_order_acquire);
+    while (n != nullptr)
+    {
+        node * next = n->next;
+        delete n;
+        n = next;
+    }
+}
+
+void update_queue::post(std::function<void()> update)
+{
+    node * n = new node { std::move(update), _head.load(std::memory_order_relaxed) };
+    while (!_head.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+
+    // Only the first update since the last drain wakes up the event loop.
+    if (n->next == nullptr && _wakeup_event != static_cast<uint32_t>(-1))
+    {
+        SDL_Event ev;
+        SDL_zero(ev);
+        ev.type = _wakeup_event;
+        SDL_PushEvent(&ev);
+    }
+}
+
+bool update_queue::drain()
+{
+    node * n = _head.exchange(nullptr, std::memory_order_acquire);
+    if (n == nullptr)
+        return false;
+
+    // Restore the order of posting.
+    node * reversed = nullptr;
+    while (n != nullptr)
+    {
+        node * next = n->next;
+        n->next = reversed;
+        reversed = n;
+        n = next;
+    }
+
+    while (reversed != nullptr)
+    {
+        node * next = reversed->next;
+
+        // Freed even if the update throws.
+        std::unique_ptr<node> current(reversed);
+        reversed = next;
+        try
+        {
+            current->update();
+        }
+        catch (...)
+        {
+            // The remaining updates are dropped, nothing may leak.
+            while (reversed != nullptr)
+            {
+                node * rest = reversed->next;
+                delete reversed;
+                reversed = rest;
+            }
+            throw;
+        }
+    }
+    return true;
+}
+
@@ -1,3 +1,9 @@
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "utf8.hpp"
 
 int utf8_byte_count(uint8_t start_byte)
@@ -58,3 +64,152 @@ int count_utf8_backwards(char const * ptr)
     return count;
 }
 
+
+uint32_t decode_utf8(char const * ptr, char const * end, int & length)
+{
+    uint8_t const b0 = *ptr;
+
+    // ascii is by far the most common case
+    if (b0 < 0x80)
+    {
+        length = 1;
+        return b0;
+    }
+
+    int n;
+    uint32_t cp;
+    if ((b0 & 0xe0) == 0xc0)
+    {
+        n = 2;
+        cp = b0 & 0x1f;
+    }
+    else if ((b0 & 0xf0) == 0xe0)
+    {
+        n = 3;
+        cp = b0 & 0x0f;
+    }
+    else if ((b0 & 0xf8) == 0xf0)
+    {
+        n = 4;
+        cp = b0 & 0x07;
+    }
+    else
+    {
+        length = 1;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    if (end - ptr < n)
+    {
+        length = 1;
+        return UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    for (int k = 1; k < n; ++k)
+    {
+        uint8_t const b = ptr[k];
+        if (!is_utf8_following_byte(b))
+        {
+            length = 1;
+            return UTF8_REPLACEMENT_CHARACTER;
+        }
+        cp = (cp << 6) | (b & 0x3f);
+    }
+
+    length = n;
+    return cp;
+}
+
+uint32_t decode_first_utf8(std::string_view s)
+{
+    if (s.empty())
+        return ' ';
+
+    int length;
+    return decode_utf8(s.data(), s.data() + s.size(), length);
+}
+
+uint32_t decode_last_utf8(std::string_view s)
+{
+    if (s.empty())
+        return ' ';
+
+    char const * const begin = s.data();
+    char const * const end = begin + s.size();
+    char const * ptr = end - 1;
+
+    if (static_cast<uint8_t>(*ptr) < 0x80)
+        return static_cast<uint8_t>(*ptr);
+
+    // a character has at most 3 following bytes
+    while (ptr != begin && end - ptr < 4 && is_utf8_following_byte(*ptr))
+        ptr--;
+
+    int length;
+    uint32_t const cp = decode_utf8(ptr, end, length);
+    return ptr + length == end ? cp : UTF8_REPLACEMENT_CHARACTER;
+}
+
+std::size_t utf8_ascii_prefix_length(std::string_view s)
+{
+    char const * const begin = s.data();
+    char const * const end = begin + s.size();
+    char const * ptr = begin;
+
+#ifdef __SSE2__
+    // check 16 bytes at once, the most significant bits form the mask
+    while (end - ptr >= 16)
+    {
+        __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(ptr));
+        int const mask = _mm_movemask_epi8(chunk);
+        if (mask != 0)
+            return (ptr - begin) + __builtin_ctz(mask);
+        ptr += 16;
+    }
+#endif
+
+    // check a word at once
+    while (end - ptr >= 8)
+    {
+        uint64_t chunk;
+        std::memcpy(&chunk, ptr, sizeof(chunk));
+        if (chunk & 0x8080808080808080ull)
+            break;
+        ptr += 8;
+    }
+
+    while (ptr != end && static_cast<uint8_t>(*ptr) < 0x80)
+        ptr++;
+
+    return ptr - begin;
+}
+
+bool is_valid_utf8(std::string_view s)
+{
+    char const * ptr = s.data();
+    char const * const end = ptr + s.size();
+
+    while (ptr != end)
+    {
+        ptr += utf8_ascii_prefix_length(std::string_view(ptr, end - ptr));
+        if (ptr == end)
+            break;
+
+        int length;
+        uint32_t const cp = decode_utf8(ptr, end, length);
+
+        // reject overlong encodings, surrogates and values out of range
+        static uint32_t const min_value[] = { 0, 0, 0x80, 0x800, 0x10000 };
+        if ((cp == UTF8_REPLACEMENT_CHARACTER && length == 1)
+            || cp < min_value[length]
+            || (cp >= 0xd800 && cp <= 0xdfff)
+            || cp > 0x10ffff)
+        {
+            return false;
+        }
+
+        ptr += length;
+    }
+
+    return true;
+}
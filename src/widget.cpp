@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <iterator>
+
+#include "profiler.hpp"
 #include "widget.hpp"
+#include "widget_batch.hpp"
 
 dirty_type combine(dirty_type a, dirty_type b)
 {
@@ -7,12 +12,18 @@ dirty_type combine(dirty_type a, dirty_type b)
 
 widget::widget()
     : _dirty(dirty_type::DIRTY)
+    , _retained(false)
+    , _retained_size{ 0, 0 }
+    , _retained_valid(false)
     , _parent(nullptr)
+    , _context_info(nullptr)
 {
 }
 
 widget::~widget()
 {
+    if (_context_info != nullptr && _context_info->get_widget_batch() != nullptr)
+        _context_info->get_widget_batch()->forget(*this);
 }
 
 void widget::on_child_dirty(widget * child)
@@ -20,12 +31,12 @@ void widget::on_child_dirty(widget * child)
     mark_child_dirty(child);
 }
 
-std::vector<widget *> widget::get_visible_children()
+widget_range widget::get_visible_children()
 {
     return get_children();
 }
 
-std::vector<widget const *> widget::get_visible_children() const
+const_widget_range widget::get_visible_children() const
 {
     return get_children();
 }
@@ -47,42 +58,219 @@ void widget::clear_dirty()
 
 void widget::mark_dirty()
 {
+    // A widget that is not clean has already notified its parent. A valid
+    // retained texture has to be invalidated further up as well.
+    bool const notify = _dirty == dirty_type::CLEAN || _retained_valid;
+    _dirty = dirty_type::DIRTY;
+    _dirty_area.reset();
+    _retained_valid = false;
+    if (notify)
+        notify_parent_child_dirty();
+}
+
+void widget::mark_dirty(rect area)
+{
+    bool const notify = _dirty == dirty_type::CLEAN || _retained_valid;
+
+    // A widget that is dirty already might be redrawn entirely anyway.
+    if (_dirty != dirty_type::DIRTY)
+        _dirty_area = area;
+    else if (_dirty_area.has_value())
+        SDL_UnionRect(&_dirty_area.value(), &area, &_dirty_area.value());
+
     _dirty = dirty_type::DIRTY;
-    notify_parent_child_dirty();
+    _retained_valid = false;
+    if (notify)
+        notify_parent_child_dirty();
 }
 
 void widget::mark_child_dirty(widget * child)
 {
+    bool const notify = _dirty == dirty_type::CLEAN || _retained_valid;
     _dirty = combine(_dirty, dirty_type::CHILD_DIRTY);
-    notify_parent_child_dirty();
+    _retained_valid = false;
+    if (notify)
+        notify_parent_child_dirty();
 }
 
 void widget::draw(draw_context & dc, selection_context const & sc) const
 {
-    on_draw(dc, sc);
-    auto const & vcs = get_visible_children();
+    // Children are within the box of their parent.
+    if (!dc.is_visible(get_box()))
+        return;
+
+    if (_retained)
+        draw_retained(dc, sc);
+    else
+        draw_subtree(dc, sc);
+}
+
+bool widget::is_opaque() const
+{
+    return false;
+}
+
+bool widget::children_may_overlap() const
+{
+    return false;
+}
+
+bool widget::is_covered_by_children() const
+{
+    for (widget const * c : get_visible_children())
+    {
+        if (c->is_opaque() && contains_rect(c->get_box(), get_box()))
+            return true;
+    }
+    return false;
+}
+
+void widget::set_retained(bool retained)
+{
+    _retained = retained;
+    if (!retained)
+        _retained_texture.reset();
+    _retained_valid = false;
+}
+
+bool widget::is_retained() const
+{
+    return _retained;
+}
+
+void widget::release_resources()
+{
+    _retained_texture.reset();
+    _retained_valid = false;
+
+    for (widget * c : get_children())
+        c->release_resources();
+}
+
+void widget::draw_retained(draw_context & dc, selection_context const & sc) const
+{
+    rect const box = get_box();
+    if (box.w <= 0 || box.h <= 0)
+        return;
+
+    if (!_retained_texture || _retained_size.w != box.w || _retained_size.h != box.h)
+    {
+        _retained_texture = dc.create_target_texture(length(box));
+        _retained_size = length(box);
+        _retained_valid = false;
+    }
+
+    if (!_retained_texture)
+    {
+        draw_subtree(dc, sc);
+        return;
+    }
+
+    if (!_retained_valid)
+    {
+        dc.push_target(_retained_texture.get(), { box.x, box.y });
+        draw_subtree(dc, sc);
+        dc.pop_target();
+        _retained_valid = true;
+    }
+
+    dc.copy_texture(_retained_texture.get(), box);
+}
+
+void widget::draw_subtree(draw_context & dc, selection_context const & sc) const
+{
+    {
+        std::size_t const copies = dc.copy_count();
+        profiler::scope s(*this, profile_kind::DRAW);
+        on_draw(dc, sc);
+        s.set_texture_copies(dc.copy_count() - copies);
+    }
+    draw_children(dc, sc);
+}
+
+void widget::draw_children(draw_context & dc, selection_context const & sc) const
+{
+    auto const vcs = get_visible_children();
+    bool const may_overlap = children_may_overlap();
     // Draw in reversed Z-order.
-    for (auto it = std::crbegin(vcs); it != std::crend(vcs); ++it)
+    for (auto it = vcs.rbegin(); it != vcs.rend(); ++it)
     {
+        // Children in front of the current one come first in Z-order.
+        if (may_overlap)
+        {
+            rect const & box = (*it)->get_box();
+            auto const front_end = std::prev(it.base());
+            if (std::any_of(vcs.begin(), front_end, [&](widget const * c){ return c->is_opaque() && contains_rect(c->get_box(), box); }))
+                continue;
+        }
+
         (*it)->draw(dc, sc);
     }
 }
 
-// Draws only dirty widgets.
-void widget::draw_dirty(draw_context & dc, selection_context const & sc) const
+void widget::draw_dirty_area(draw_context & dc, selection_context const & sc, damage_region * damage) const
 {
-    // If dirty do a complete redraw of the subtree.
-    if (_dirty == dirty_type::DIRTY)
+    rect area = get_box();
+    if (_dirty_area.has_value() && SDL_IntersectRect(&_dirty_area.value(), &area, &area) != SDL_TRUE)
+        return;
+
+    if (_dirty_area.has_value())
+    {
+        // Drawing of the dirty widgets happens without a scissor, the
+        // previous one is kept nonetheless.
+        std::optional<rect> const scissor = dc.get_scissor();
+        if (scissor.has_value() && SDL_IntersectRect(&scissor.value(), &area, &area) != SDL_TRUE)
+            return;
+
+        dc.set_scissor(&area);
+        draw(dc, sc);
+        dc.set_scissor(scissor.has_value() ? &scissor.value() : nullptr);
+    }
+    else
+    {
         draw(dc, sc);
+    }
+
+    if (damage != nullptr)
+        damage->add(area);
+}
+
+// Draws only dirty widgets.
+void widget::draw_dirty(draw_context & dc, selection_context const & sc, damage_region * damage) const
+{
+    // If dirty do a complete redraw of the subtree. A retained subtree is
+    // rendered as a whole.
+    if (_dirty == dirty_type::DIRTY || (_retained && _dirty == dirty_type::CHILD_DIRTY))
+    {
+        draw_dirty_area(dc, sc, damage);
+    }
     else if (_dirty == dirty_type::CHILD_DIRTY)
     {
         // TODO Current assumption: child box hasn't changed so redrawing
         // background is not necessary. This may change in the future and then
         // the dirty areas from children are necessary.
-        auto const & vcs = get_visible_children();
-        for (auto it = std::crbegin(vcs); it != std::crend(vcs); ++it)
+        auto const vcs = get_visible_children();
+        for (auto it = vcs.rbegin(); it != vcs.rend(); ++it)
+        {
+            (*it)->draw_dirty(dc, sc, damage);
+        }
+    }
+}
+
+void widget::draw_and_clear_dirty(draw_context & dc, selection_context const & sc, damage_region * damage)
+{
+    if (_dirty == dirty_type::DIRTY || (_retained && _dirty == dirty_type::CHILD_DIRTY))
+    {
+        draw_dirty_area(dc, sc, damage);
+        clear_dirty();
+    }
+    else if (_dirty == dirty_type::CHILD_DIRTY)
+    {
+        _dirty = dirty_type::CLEAN;
+        auto const vcs = get_visible_children();
+        for (auto it = vcs.rbegin(); it != vcs.rend(); ++it)
         {
-            (*it)->draw_dirty(dc, sc);
+            (*it)->draw_and_clear_dirty(dc, sc, damage);
         }
     }
 }
@@ -104,6 +292,16 @@ void widget::on_key_event(key_event const & e)
 {
 }
 
+void widget::on_mouse_capture_released(pointer_id id)
+{
+}
+
+void widget::notify_ancestors_mouse_capture_released(pointer_id id)
+{
+    for (widget * w = _parent; w != nullptr; w = w->_parent)
+        w->on_mouse_capture_released(id);
+}
+
 void widget::on_activate()
 {
 }
@@ -111,6 +309,39 @@ void widget::on_activate()
 void widget::set_context_info(context_info const & ci)
 {
     _context_info = &ci;
+
+    // Size hints depend on fonts.
+    invalidate_size_hint();
+}
+
+void widget::on_redo_layout_request(redo_layout_type t)
+{
+    if (_parent != nullptr)
+        _parent->redo_layout(t);
+    // Without a context the layout is done once it is attached.
+    else if (_context_info != nullptr)
+        _context_info->queue_redo_layout();
+}
+
+void widget::on_layout_redone()
+{
+    mark_dirty();
+}
+
+bool widget::defer_redo_layout(redo_layout_type t)
+{
+    widget_batch * b = _context_info != nullptr ? _context_info->get_widget_batch() : nullptr;
+    if (b == nullptr)
+        return false;
+
+    b->defer_redo_layout(*this, t);
+    return true;
+}
+
+void widget::on_size_hint_invalidated()
+{
+    if (_parent != nullptr)
+        _parent->invalidate_size_hint();
 }
 
 context_info const & widget::get_context_info() const
@@ -123,12 +354,35 @@ void widget::set_parent(widget * parent)
     _parent = parent;
 }
 
-std::vector<widget *> widget::get_children()
+void share_context_info(widget & w, context_info const & ci)
+{
+    w.set_context_info(ci);
+    for (widget * c : w.get_children())
+        share_context_info(*c, ci);
+}
+
+void widget::attach_child(widget & child)
+{
+    child.set_parent(this);
+
+    // Without a context it is shared once the parent is attached.
+    if (_context_info != nullptr)
+        share_context_info(child, *_context_info);
+}
+
+void widget::detach_child(widget & child)
+{
+    if (_context_info != nullptr)
+        _context_info->notify_widget_detached(child);
+    child.set_parent(nullptr);
+}
+
+widget_range widget::get_children()
 {
     return {};
 }
 
-std::vector<widget const *> widget::get_children() const
+const_widget_range widget::get_children() const
 {
     return {};
 }
@@ -164,6 +418,11 @@ std::optional<swipe_info> widget::get_swipe_info_with_context_info(mouse_up_even
     return std::nullopt;
 }
 
+void widget::capture_mouse(pointer_id id)
+{
+    _context_info->capture_mouse(*this, id);
+}
+
 widget * widget::navigate_selectable_parent(navigation_type nt, point center)
 {
     if (_parent == nullptr)
@@ -182,7 +441,13 @@ void widget::on_unselect()
 
 void widget::notify_parent_child_dirty()
 {
-    if (_parent != nullptr)
+    if (_parent == nullptr)
+        return;
+
+    // The widget is dirty already, only the propagation is deferred.
+    if (_context_info != nullptr && _context_info->get_widget_batch() != nullptr)
+        _context_info->get_widget_batch()->defer_child_dirty(*this);
+    else
         _parent->on_child_dirty(this);
 }
 
@@ -0,0 +1,18 @@
+#include "widget_arena.hpp"
+
+widget_arena::state::state(std::size_t initial_bytes)
+    : resource(initial_bytes)
+    , allocated_bytes(0)
+{
+}
+
+widget_arena::widget_arena(std::size_t initial_bytes)
+    : _state(std::make_shared<state>(initial_bytes))
+{
+}
+
+std::size_t widget_arena::allocated_bytes() const
+{
+    return _state->allocated_bytes;
+}
+
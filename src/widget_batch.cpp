@@ -0,0 +1,70 @@
+#include <algorithm>
+
+#include "widget.hpp"
+#include "widget_batch.hpp"
+
+widget_batch::widget_batch()
+{
+}
+
+void widget_batch::defer_child_dirty(widget & w)
+{
+    // A widget only notifies once until it is drawn, no need to look for
+    // duplicates.
+    _dirty.push_back(&w);
+}
+
+void widget_batch::defer_redo_layout(widget & w, redo_layout_type t)
+{
+    auto const [it, inserted] = _layout_types.emplace(&w, t);
+    if (inserted)
+        _layouts.push_back(&w);
+    else
+        it->second = std::max(it->second, t);
+}
+
+void widget_batch::forget(widget const & w)
+{
+    _dirty.erase(std::remove(_dirty.begin(), _dirty.end(), &w), _dirty.end());
+    if (_layout_types.erase(&w) > 0)
+        _layouts.erase(std::remove(_layouts.begin(), _layouts.end(), &w), _layouts.end());
+}
+
+bool widget_batch::empty() const
+{
+    return _dirty.empty() && _layouts.empty();
+}
+
+void widget_batch::commit()
+{
+    // Requests that are made while committing are not batched, the pending
+    // ones are taken out first.
+    std::vector<widget *> layouts;
+    layouts.swap(_layouts);
+    layout_map layout_types;
+    layout_types.swap(_layout_types);
+
+    for (widget * w : layouts)
+    {
+        // Children are laid out again along with the ancestor, their size
+        // hints have been invalidated on the way up.
+        if (!has_pending_ancestor(*w, layout_types))
+            w->redo_layout(layout_types[w]);
+    }
+
+    std::vector<widget *> dirty;
+    dirty.swap(_dirty);
+    for (widget * w : dirty)
+        w->notify_parent_child_dirty();
+}
+
+bool widget_batch::has_pending_ancestor(widget const & w, layout_map const & pending)
+{
+    for (widget const * p = w._parent; p != nullptr; p = p->_parent)
+    {
+        if (pending.count(p) > 0)
+            return true;
+    }
+    return false;
+}
+
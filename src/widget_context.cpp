@@ -1,3 +1,11 @@
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include <SDL2/SDL_timer.h>
+
+#include "trace.hpp"
 #include "widget_context.hpp"
 #include "widget.hpp"
 #include "sdl_util.hpp"
@@ -21,57 +29,259 @@ widget_context::widget_context(SDL_Renderer * renderer, std::vector<font> fonts,
                      }
                    )
 {
+    init(main_widget, box);
+}
+
+widget_context::widget_context(SDL_Renderer * renderer, font_registry & registry, std::vector<font> fonts, widget & main_widget)
+    : widget_context(renderer, registry, fonts, main_widget, box_from_renderer(renderer))
+{
+}
+
+widget_context::widget_context(SDL_Renderer * renderer, font_registry & registry, std::vector<font> fonts, widget & main_widget, rect box)
+    : _box(box)
+    , _renderer(renderer)
+    , _fm(_renderer, fonts, registry)
+    , _dc(_renderer, _fm)
+    , _sc(box)
+    , _mt()
+    , _main_widget(main_widget)
+    , _context_info( _fm
+                   , { .lower_threshold = _fm.font_line_skip() * 2
+                     , .dir_unambig_factor = 0.3
+                     }
+                   )
+{
+    init(main_widget, box);
+}
+
+widget_context::widget_context(SDL_Renderer * renderer, std::unique_ptr<render_backend> backend, std::vector<font> fonts, widget & main_widget, rect box)
+    : _box(box)
+    , _renderer(renderer)
+    , _fm(_renderer, fonts)
+    , _dc(_renderer, _fm, std::move(backend))
+    , _sc(box)
+    , _mt()
+    , _main_widget(main_widget)
+    , _context_info( _fm
+                   , { .lower_threshold = _fm.font_line_skip() * 2
+                     , .dir_unambig_factor = 0.3
+                     }
+                   )
+{
+    init(main_widget, box);
+}
+
+// Text is evicted last, as it is needed by most widgets. Images evicted from
+// the texture cache stay alive as long as widgets show them.
+int const TEXT_MEMORY_PRIORITY = 2;
+int const SURFACE_MEMORY_PRIORITY = 1;
+int const IMAGE_MEMORY_PRIORITY = 0;
+
+// Wakes up process_frame() for updates and event sources, only processing
+// follows.
+Uint32 wakeup_event_type()
+{
+    static Uint32 const type = SDL_RegisterEvents(1);
+    return type;
+}
+
+void widget_context::init(widget & main_widget, rect box)
+{
+    _context_info.set_region_control(this);
+    _context_info.set_animation_scheduler(&_animations);
+    _redo_layout_queued = false;
+    _batch_depth = 0;
+    _tree_stale = false;
+
     std::vector<widget *> stack { &main_widget };
     do
     {
         widget * wptr = stack.back();
         stack.pop_back();
-        auto cs = wptr->get_children();
-        for (auto c : cs)
+        for (widget * c : wptr->get_children())
             stack.push_back(c);
         wptr->set_context_info(_context_info);
     }
     while (!stack.empty());
 
-    main_widget.apply_layout(box);
+    {
+        layout_arena::activation la(_layout_arena);
+        main_widget.apply_layout(box);
+    }
+
+    _min_frame_interval = 0;
+    _frame_render_budget = std::chrono::steady_clock::duration::zero();
+    _last_frame_ticks = 0;
+    _profiling = false;
+    _profiler_overlay = false;
+    _tracing = false;
+    _frame_stats_enabled = false;
+    _latency_marker = false;
+    _latency_marker_lit = false;
+    _coalesce_motion = true;
+
+    _updates = std::make_shared<update_queue>(wakeup_event_type());
+
+    _memory_budget.add_client(_fm, TEXT_MEMORY_PRIORITY);
+    _memory_budget.add_client(_dc, SURFACE_MEMORY_PRIORITY);
+    _memory_budget.add_client(_texture_cache, IMAGE_MEMORY_PRIORITY);
 }
 
+// Buffers that are still reused with a redraw of everything.
+std::size_t const MAX_DAMAGE_HISTORY = 4;
+
 point tfinger_to_point(SDL_TouchFingerEvent const & tfinger, rect const & box)
 {
     return { static_cast<int>(tfinger.x * box.w), static_cast<int>(tfinger.y * box.h) };
 }
 
+// Looked at ahead of a motion event.
+int const MAX_PEEKED_EVENTS = 16;
+
+bool same_pointer_motion(SDL_Event const & a, SDL_Event const & b)
+{
+    if (a.type != b.type)
+        return false;
+    else if (a.type == SDL_MOUSEMOTION)
+        return a.motion.which == b.motion.which;
+    else
+        return a.tfinger.touchId == b.tfinger.touchId && a.tfinger.fingerId == b.tfinger.fingerId;
+}
+
+bool widget_context::superseded_motion(SDL_Event const & ev)
+{
+    if (ev.type != SDL_MOUSEMOTION && ev.type != SDL_FINGERMOTION)
+        return false;
+
+    SDL_Event queued[MAX_PEEKED_EVENTS];
+    int const n = SDL_PeepEvents(queued, MAX_PEEKED_EVENTS, SDL_PEEKEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+    // Motion of other pointers may be skipped, anything else keeps its order
+    // relative to the motion.
+    for (int k = 0; k < n; ++k)
+    {
+        if (same_pointer_motion(ev, queued[k]))
+            return true;
+        else if (queued[k].type != SDL_MOUSEMOTION && queued[k].type != SDL_FINGERMOTION)
+            return false;
+    }
+    return false;
+}
+
+void widget_context::set_motion_coalescing(bool enabled)
+{
+    _coalesce_motion = enabled;
+}
+
+key_type sdl_keycode_to_key_type(SDL_Keycode sym)
+{
+    switch (sym)
+    {
+        case SDLK_BACKSPACE: return key_type::BACKSPACE;
+        case SDLK_DELETE:    return key_type::FORWARD_DELETE;
+        case SDLK_LEFT:      return key_type::LEFT;
+        case SDLK_RIGHT:     return key_type::RIGHT;
+        case SDLK_HOME:      return key_type::HOME;
+        case SDLK_END:       return key_type::END;
+        default:             return key_type::OTHER;
+    }
+}
+
+// Events whose effect is shown by a frame, for the latency measurement.
+bool is_input_event(Uint32 type)
+{
+    switch (type)
+    {
+        case SDL_KEYDOWN:
+        case SDL_TEXTINPUT:
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEMOTION:
+        case SDL_MOUSEWHEEL:
+        case SDL_FINGERDOWN:
+        case SDL_FINGERUP:
+        case SDL_FINGERMOTION:
+            return true;
+        default:
+            return false;
+    }
+}
+
 void widget_context::process_event(SDL_Event const & ev)
 {
+    profiler::activation pa(active_profiler());
+    tracer::activation ta(active_tracer());
+    LIBWTK_SDL2_TRACE_SCOPE("event", "process_event");
+
+    if (_event_recorder)
+        _event_recorder->add(ev);
+
+    if (is_input_event(ev.type) && !_oldest_input_timestamp.has_value())
+        _oldest_input_timestamp = ev.common.timestamp;
+
+    // Only the latest position is dispatched, the path is still tracked.
+    if (_coalesce_motion && superseded_motion(ev))
+    {
+        if (ev.type == SDL_MOUSEMOTION)
+            _mt.mouse_move({ ev.motion.x, ev.motion.y }, ev.motion.timestamp);
+        else
+            _mt.mouse_move(tfinger_to_point(ev.tfinger, _box), ev.tfinger.timestamp, ev.tfinger.fingerId);
+        return;
+    }
+
+    // Handlers might cause a local layout.
+    layout_arena::activation la(_layout_arena);
+
     // TODO hardcoded keys are probably not the best idea for reusability
 
-    if (ev.type == SDL_MOUSEBUTTONDOWN)
+    if (ev.type == SDL_WINDOWEVENT && ev.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+    {
+        resize({ 0, 0, ev.window.data1, ev.window.data2 });
+    }
+    else if (ev.type == SDL_APP_LOWMEMORY)
+    {
+        release_memory();
+    }
+    else if (ev.type == SDL_RENDER_TARGETS_RESET)
+    {
+        // The content of retained drawings is lost, the framebuffer might be
+        // as well.
+        _main_widget.release_resources();
+        _dc.invalidate_render_state();
+        _main_widget.mark_dirty();
+    }
+    else if (ev.type == SDL_RENDER_DEVICE_RESET)
     {
-        point p { ev.button.x, ev.button.y };
-        _main_widget.on_mouse_down_event({p});
-        _mt.mouse_down(p);
+        _main_widget.release_resources();
+        _fm.clear_caches();
+        _dc.reset_textures();
+        _texture_cache.clear();
+        _dc.invalidate_render_state();
+        _main_widget.mark_dirty();
+    }
+    else if (ev.type == SDL_MOUSEBUTTONDOWN)
+    {
+        mouse_down({ ev.button.x, ev.button.y }, ev.button.timestamp);
     }
     else if (ev.type == SDL_MOUSEBUTTONUP)
     {
-        _main_widget.on_mouse_up_event(_mt.mouse_up({ ev.button.x, ev.button.y }));
+        mouse_up({ ev.button.x, ev.button.y }, ev.button.timestamp);
     }
     else if (ev.type == SDL_MOUSEMOTION)
     {
-        _main_widget.on_mouse_move_event(_mt.mouse_move({ ev.motion.x, ev.motion.y }));
+        mouse_move({ ev.motion.x, ev.motion.y }, ev.motion.timestamp);
     }
     else if (ev.type == SDL_FINGERDOWN)
     {
-        point p = tfinger_to_point(ev.tfinger, _box);
-        _main_widget.on_mouse_down_event({p});
-        _mt.mouse_down(p);
+        mouse_down(tfinger_to_point(ev.tfinger, _box), ev.tfinger.timestamp, ev.tfinger.fingerId);
     }
     else if (ev.type == SDL_FINGERUP)
     {
-        _main_widget.on_mouse_up_event(_mt.mouse_up(tfinger_to_point(ev.tfinger, _box)));
+        mouse_up(tfinger_to_point(ev.tfinger, _box), ev.tfinger.timestamp, ev.tfinger.fingerId);
     }
     else if (ev.type == SDL_FINGERMOTION)
     {
-        _main_widget.on_mouse_move_event(_mt.mouse_move(tfinger_to_point(ev.tfinger, _box)));
+        mouse_move(tfinger_to_point(ev.tfinger, _box), ev.tfinger.timestamp, ev.tfinger.fingerId);
     }
     else if (ev.type == SDL_KEYDOWN)
     {
@@ -83,11 +293,11 @@ void widget_context::process_event(SDL_Event const & ev)
         {
             if (keysym.mod & KMOD_SHIFT)
             {
-                _sc.navigate_selection(navigation_type::PREV, &_main_widget);
+                navigate_selection(navigation_type::PREV);
             }
             else
             {
-                _sc.navigate_selection(navigation_type::NEXT, &_main_widget);
+                navigate_selection(navigation_type::NEXT);
             }
         }
         else if (keysym.mod & KMOD_SHIFT)
@@ -101,34 +311,413 @@ void widget_context::process_event(SDL_Event const & ev)
                 case SDLK_RIGHT: nt = navigation_type::NEXT_X; break;
                 default: return;
             }
-            _sc.navigate_selection(nt, &_main_widget);
+            navigate_selection(nt);
         }
         else if (keysym.sym == SDLK_RETURN)
             _sc.dispatch_activation();
         else
-            _sc.dispatch_key_event(key_event());
+            _sc.dispatch_key_event({ sdl_keycode_to_key_type(keysym.sym), std::string_view() });
+    }
+    else if (ev.type == SDL_TEXTINPUT)
+    {
+        _sc.dispatch_key_event({ key_type::TEXT, ev.text.text });
     }
 }
 
+bool widget_context::process_frame(std::function<bool(SDL_Event const &)> const & handler, int dirty_redraws)
+{
+    bool full_redraw = false;
+
+    auto handle = [&](SDL_Event const & ev)
+    {
+        if (ev.type == SDL_QUIT || (handler && !handler(ev)))
+            return false;
+
+        if (ev.type == SDL_WINDOWEVENT)
+        {
+            // Not passed to process_event().
+            if (_event_recorder)
+                _event_recorder->add(ev);
+
+            if (ev.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+            {
+                resize({ 0, 0, ev.window.data1, ev.window.data2 });
+                full_redraw = true;
+            }
+            else if (ev.window.event == SDL_WINDOWEVENT_EXPOSED)
+            {
+                full_redraw = true;
+            }
+        }
+        else
+        {
+            process_event(ev);
+        }
+        return true;
+    };
+
+    // Without anything scheduled there is nothing to do until an event
+    // arrives. Otherwise waking up at the deadline is a frame of its own.
+    SDL_Event ev;
+    bool running = true;
+    int const timeout = _animations.timeout(animation_scheduler::clock::now());
+    if (timeout < 0)
+    {
+        if (SDL_WaitEvent(&ev) == 0)
+            throw std::runtime_error(std::string("could not wait for events: ") + SDL_GetError());
+        running = handle(ev);
+    }
+    else if (SDL_WaitEventTimeout(&ev, timeout) == 1)
+    {
+        running = handle(ev);
+    }
+
+    // Everything that is already queued belongs to the same frame.
+    while (running && SDL_PollEvent(&ev) == 1)
+        running = handle(ev);
+
+    if (_min_frame_interval > 0)
+    {
+        Uint32 const due = _last_frame_ticks + _min_frame_interval;
+        while (running)
+        {
+            Sint32 const remaining = static_cast<Sint32>(due - SDL_GetTicks());
+            if (remaining <= 0)
+                break;
+            if (SDL_WaitEventTimeout(&ev, remaining) == 1)
+                running = handle(ev);
+        }
+    }
+
+    if (!running)
+        return false;
+
+    if (_source_watcher)
+    {
+        profiler::activation pa(active_profiler());
+        tracer::activation ta(active_tracer());
+        LIBWTK_SDL2_TRACE_SCOPE("event", "dispatch_event_sources");
+        layout_arena::activation la(_layout_arena);
+        _source_watcher->dispatch(*this);
+    }
+
+    advance_animations();
+
+    if (full_redraw)
+        draw();
+    else
+        draw_dirty(dirty_redraws);
+
+    _last_frame_ticks = SDL_GetTicks();
+    return true;
+}
+
+void widget_context::run(std::function<bool(SDL_Event const &)> const & handler, int dirty_redraws)
+{
+    while (process_frame(handler, dirty_redraws))
+    {
+    }
+}
+
+void widget_context::set_frame_rate_cap(unsigned int fps)
+{
+    _min_frame_interval = fps == 0 ? 0 : std::max(1u, 1000 / fps);
+}
+
+void widget_context::advance_animations()
+{
+    if (_animations.empty())
+        return;
+
+    profiler::activation pa(active_profiler());
+    tracer::activation ta(active_tracer());
+    LIBWTK_SDL2_TRACE_SCOPE("event", "advance_animations");
+
+    // Animations might cause a local layout.
+    layout_arena::activation la(_layout_arena);
+    _animations.advance(animation_scheduler::clock::now());
+}
+
+animation_scheduler & widget_context::get_animation_scheduler()
+{
+    return _animations;
+}
+
 void widget_context::draw(bool present)
 {
+    profiler::activation pa(active_profiler());
+    tracer::activation ta(active_tracer());
+    LIBWTK_SDL2_TRACE_SCOPE("frame", "draw");
+    auto const start = std::chrono::steady_clock::now();
+
+    begin_render_budget(start);
+    drain_updates();
+    update_layout();
+    upload_rendered_words();
     _main_widget.draw(_dc, _sc);
+    _main_widget.clear_dirty();
+    end_render_budget();
+
+    _damage.clear();
+    _damage.add(_box);
+    enforce_memory_budget();
+    auto const frame_time = std::chrono::steady_clock::now() - start;
+    finish_frame(frame_time);
+    draw_latency_marker(_damage, _damage);
+    push_damage_history(_damage);
+
+    if (_event_recorder)
+        _event_recorder->end_frame(true);
+
     if (present)
-        _dc.present();
+    {
+        _dc.present(_damage);
+        report_frame(frame_time);
+    }
 }
 
-void widget_context::draw_dirty(int dirty_redraws)
+damage_region const & widget_context::draw_dirty(int dirty_redraws)
 {
-    _main_widget.draw_dirty(_dc, _sc);
+    profiler::activation pa(active_profiler());
+    tracer::activation ta(active_tracer());
+    LIBWTK_SDL2_TRACE_SCOPE("frame", "draw_dirty");
+    auto const start = std::chrono::steady_clock::now();
+
+    begin_render_budget(start);
+    drain_updates();
+    update_layout();
+    upload_rendered_words();
 
-    while (dirty_redraws > 0)
+    _damage.clear();
+    if (_tree.has_value())
     {
-        _dc.present();
-        _main_widget.draw_dirty(_dc, _sc);
-        dirty_redraws--;
+        _tree->draw_and_clear_dirty(_dc, _sc, &_damage);
+        _tree_stale = false;
     }
+    else
+        _main_widget.draw_and_clear_dirty(_dc, _sc, &_damage);
 
-    _main_widget.clear_dirty();
+    // With multiple buffers the one drawn to shows an older frame. Everything
+    // that changed since has to be repainted as well.
+    std::size_t const buffer_age = std::max(0, dirty_redraws);
+    damage_region stale;
+    for (std::size_t k = 0; k < _damage_history.size() && k < buffer_age; ++k)
+        stale.add(_damage_history[k]);
+
+    // The overlay of the last frame has to disappear.
+    stale.add(_overlay_damage);
+
+    for (rect const & r : stale.rects())
+    {
+        _dc.set_scissor(&r);
+        _main_widget.draw(_dc, _sc);
+    }
+    _dc.set_scissor(nullptr);
+    end_render_budget();
+
+    damage_region frame = _damage;
+    enforce_memory_budget();
+    auto const frame_time = std::chrono::steady_clock::now() - start;
+    finish_frame(frame_time);
+    frame.add(_overlay_damage);
+    draw_latency_marker(frame, stale);
+
+    if (_event_recorder)
+        _event_recorder->end_frame(false);
+
+    push_damage_history(frame);
+    while (_damage_history.size() > buffer_age)
+        _damage_history.pop_back();
+
+    // Nothing changed, presenting would only cost time. Input that had no
+    // visible effect is not measured.
+    stale.add(frame);
+    if (!stale.empty())
+    {
+        _dc.present(stale);
+        report_frame(frame_time);
+    }
+    else
+    {
+        _oldest_input_timestamp.reset();
+    }
+
+    return _damage;
+}
+
+void widget_context::start_event_recording(std::string path)
+{
+    _event_recorder = std::make_unique<event_recorder>(path);
+}
+
+void widget_context::stop_event_recording()
+{
+    if (!_event_recorder)
+        return;
+
+    // The recorder is gone even if writing failed.
+    std::unique_ptr<event_recorder> r = std::move(_event_recorder);
+    r->finish();
+}
+
+void widget_context::set_profiling(bool enabled)
+{
+    _profiling = enabled;
+}
+
+void widget_context::set_profiler_overlay(bool enabled)
+{
+    _profiler_overlay = enabled;
+}
+
+profiler const & widget_context::get_profiler() const
+{
+    return _profiler;
+}
+
+void widget_context::reset_profiler()
+{
+    _profiler.reset();
+}
+
+void widget_context::set_frame_stats(bool enabled)
+{
+    _frame_stats_enabled = enabled;
+}
+
+frame_stats const & widget_context::get_frame_stats() const
+{
+    return _frame_stats;
+}
+
+void widget_context::reset_frame_stats()
+{
+    _frame_stats.reset();
+}
+
+void widget_context::set_frame_callback(std::function<void(frame_report const &)> callback)
+{
+    _frame_callback = std::move(callback);
+}
+
+void widget_context::set_latency_marker(bool enabled)
+{
+    _latency_marker = enabled;
+    _latency_marker_lit = false;
+}
+
+profiler * widget_context::active_profiler()
+{
+    return _profiling || _profiler_overlay ? &_profiler : nullptr;
+}
+
+void widget_context::set_tracing(bool enabled)
+{
+    _tracing = enabled;
+}
+
+tracer & widget_context::get_tracer()
+{
+    return _tracer;
+}
+
+tracer * widget_context::active_tracer()
+{
+    return _tracing ? &_tracer : nullptr;
+}
+
+// The graph shows this many frames.
+int const FRAME_GRAPH_BAR_WIDTH = 2;
+int const FRAME_GRAPH_BARS = 120;
+int const FRAME_GRAPH_HEIGHT = 64;
+
+// Frames within budget reach up to half of the graph.
+std::chrono::nanoseconds const FRAME_BUDGET = std::chrono::microseconds(16667);
+
+int const LATENCY_MARKER_SIZE = 16;
+
+bool intersects_region(damage_region const & d, rect const & r)
+{
+    return std::any_of(d.rects().begin(), d.rects().end(), [&](rect const & dr){ return SDL_HasIntersection(&dr, &r); });
+}
+
+void widget_context::draw_latency_marker(damage_region & frame, damage_region const & stale)
+{
+    if (!_latency_marker)
+        return;
+
+    rect const r { _box.x, _box.y + _box.h - LATENCY_MARKER_SIZE, LATENCY_MARKER_SIZE, LATENCY_MARKER_SIZE };
+    bool const lit = _oldest_input_timestamp.has_value();
+    bool const covered = intersects_region(frame, r) || intersects_region(stale, r);
+    if (!covered && lit == _latency_marker_lit)
+        return;
+
+    _latency_marker_lit = lit;
+    _dc.set_color(lit ? SDL_Color { 255, 255, 255, 255 } : SDL_Color { 0, 0, 0, 255 });
+    _dc.draw_rect_filled(r);
+    frame.add(r);
+}
+
+void widget_context::report_frame(std::chrono::nanoseconds frame_time)
+{
+    std::optional<Uint32> const input = _oldest_input_timestamp;
+    _oldest_input_timestamp.reset();
+    if (!_frame_stats_enabled && !_frame_callback)
+        return;
+
+    frame_report r { frame_time, input, std::nullopt };
+
+    // Replayed events carry the timestamps of the recording.
+    Uint32 const now = SDL_GetTicks();
+    if (input.has_value() && SDL_TICKS_PASSED(now, input.value()))
+        r.input_latency = std::chrono::milliseconds(now - input.value());
+
+    if (_frame_stats_enabled)
+        _frame_stats.add(r);
+    if (_frame_callback)
+        _frame_callback(r);
+}
+
+void widget_context::finish_frame(std::chrono::nanoseconds frame_time)
+{
+    _overlay_damage.clear();
+
+    if (active_profiler() != nullptr)
+        _profiler.add_frame_time(frame_time);
+
+    if (!_profiler_overlay)
+        return;
+
+    rect const graph { _box.x + 8, _box.y + 8, FRAME_GRAPH_BARS * FRAME_GRAPH_BAR_WIDTH, FRAME_GRAPH_HEIGHT };
+    _dc.draw_rect_blended(graph, { 0, 0, 0, 180 });
+
+    auto const & ts = _profiler.frame_times();
+    int const bars = std::min<int>(ts.size(), FRAME_GRAPH_BARS);
+    int x = graph.x + graph.w - bars * FRAME_GRAPH_BAR_WIDTH;
+    for (auto it = ts.end() - bars; it != ts.end(); ++it)
+    {
+        int const h = std::min<long>(FRAME_GRAPH_HEIGHT, it->count() * (FRAME_GRAPH_HEIGHT / 2) / FRAME_BUDGET.count());
+        SDL_Color const c = *it > FRAME_BUDGET ? SDL_Color{ 230, 60, 60, 220 } : SDL_Color{ 60, 200, 60, 220 };
+        _dc.draw_rect_blended({ x, graph.y + graph.h - h, FRAME_GRAPH_BAR_WIDTH, h }, c);
+        x += FRAME_GRAPH_BAR_WIDTH;
+    }
+    _dc.draw_rect_blended({ graph.x, graph.y + graph.h / 2, graph.w, 1 }, { 255, 255, 255, 120 });
+    _overlay_damage.add(graph);
+
+    // Highlight what has been redrawn.
+    _dc.set_color({ 255, 0, 255 });
+    for (rect const & r : _damage.rects())
+    {
+        _dc.draw_rect(r);
+        _overlay_damage.add(r);
+    }
+}
+
+void widget_context::push_damage_history(damage_region const & damage)
+{
+    _damage_history.push_front(damage);
+    if (_damage_history.size() > MAX_DAMAGE_HISTORY)
+        _damage_history.pop_back();
 }
 
 void widget_context::select_widget(widget & w)
@@ -148,10 +737,362 @@ bool widget_context::is_selected_widget(widget const & w)
 
 void widget_context::change_widget_area(rect new_box)
 {
+    profiler::activation pa(active_profiler());
+    tracer::activation ta(active_tracer());
+    layout_arena::activation la(_layout_arena);
+
     _box = new_box;
     _main_widget.apply_layout(_box);
     _main_widget.mark_dirty();
     _sc.change_widget_area(new_box);
+
+    if (_tree.has_value())
+        _tree->update_boxes();
+}
+
+void widget_context::mouse_down(point p, Uint32 time, pointer_id id)
+{
+    // An up event might have been missed.
+    _mouse_captures.erase(id);
+
+    _main_widget.on_mouse_down_event({ p, id });
+    _mt.mouse_down(p, time, id);
+
+    // Keep a capture that has been set by the handler.
+    if (_mouse_captures.find(id) == _mouse_captures.end())
+    {
+        if (widget * w = find_widget_at(p))
+            _mouse_captures[id] = w;
+    }
+}
+
+void widget_context::mouse_up(point p, Uint32 time, pointer_id id)
+{
+    auto const e = _mt.mouse_up(p, time, id);
+
+    auto it = _mouse_captures.find(id);
+    if (it != _mouse_captures.end())
+    {
+        widget * w = it->second;
+        _mouse_captures.erase(it);
+
+        // The handler might remove the widget.
+        w->notify_ancestors_mouse_capture_released(id);
+        w->on_mouse_up_event(e);
+    }
+    else
+    {
+        _main_widget.on_mouse_up_event(e);
+    }
+}
+
+void widget_context::mouse_move(point p, Uint32 time, pointer_id id)
+{
+    auto const e = _mt.mouse_move(p, time, id);
+
+    if (widget * w = get_mouse_capture(id))
+        w->on_mouse_move_event(e);
+    else
+        _main_widget.on_mouse_move_event(e);
+}
+
+void widget_context::capture_mouse(widget & w, pointer_id id)
+{
+    _mouse_captures[id] = &w;
+}
+
+void widget_context::release_mouse(pointer_id id)
+{
+    _mouse_captures.erase(id);
+}
+
+widget * widget_context::get_mouse_capture(pointer_id id) const
+{
+    auto it = _mouse_captures.find(id);
+    return it != _mouse_captures.end() ? it->second : nullptr;
+}
+
+void widget_context::queue_redo_layout()
+{
+    _redo_layout_queued = true;
+}
+
+void widget_context::on_widget_detached(widget & w)
+{
+    std::vector<widget *> stack { &w };
+    do
+    {
+        widget * wptr = stack.back();
+        stack.pop_back();
+        for (widget * c : wptr->get_children())
+            stack.push_back(c);
+
+        for (auto it = _mouse_captures.begin(); it != _mouse_captures.end();)
+        {
+            if (it->second == wptr)
+                it = _mouse_captures.erase(it);
+            else
+                ++it;
+        }
+        if (_sc.is_selected_widget(wptr))
+            _sc.unselect_widget();
+        if (_batch_depth > 0)
+            _batch.forget(*wptr);
+    }
+    while (!stack.empty());
+
+    _tree_stale = _tree.has_value();
+}
+
+void widget_context::begin_batch()
+{
+    if (_batch_depth++ == 0)
+        _context_info.set_widget_batch(&_batch);
+}
+
+void widget_context::end_batch()
+{
+    if (--_batch_depth > 0)
+        return;
+
+    _context_info.set_widget_batch(nullptr);
+    if (!_batch.empty())
+    {
+        LIBWTK_SDL2_TRACE_SCOPE("layout", "commit_batch");
+        layout_arena::activation la(_layout_arena);
+        _batch.commit();
+    }
+}
+
+widget_context::batch::batch(widget_context & ctx)
+    : _ctx(ctx)
+{
+    _ctx.begin_batch();
+}
+
+widget_context::batch::~batch()
+{
+    _ctx.end_batch();
+}
+
+void widget_context::resize(rect new_box)
+{
+    _pending_box = new_box;
+}
+
+void widget_context::update_layout()
+{
+    if (_pending_box.has_value())
+    {
+        rect const new_box = _pending_box.value();
+        _pending_box.reset();
+        _redo_layout_queued = false;
+        change_widget_area(new_box);
+    }
+    else if (_redo_layout_queued)
+    {
+        _redo_layout_queued = false;
+        change_widget_area(_box);
+    }
+}
+
+void widget_context::set_flat_tree(bool enabled)
+{
+    if (enabled)
+    {
+        _tree.emplace();
+        _tree->rebuild(_main_widget);
+        _tree_stale = false;
+    }
+    else
+    {
+        _tree.reset();
+    }
+}
+
+void widget_context::set_navigation_index(bool enabled)
+{
+    if (enabled)
+    {
+        _navigation_index.emplace();
+        _navigation_index->rebuild(_main_widget);
+        _sc.set_navigation_index(&*_navigation_index);
+    }
+    else
+    {
+        _sc.set_navigation_index(nullptr);
+        _navigation_index.reset();
+    }
+}
+
+widget * find_widget_at(widget * w, point p)
+{
+    if (!within_rect(p, w->get_box()))
+        return nullptr;
+
+    // The first child in Z-order is on top.
+    for (widget * c : w->get_visible_children())
+    {
+        widget * result = find_widget_at(c, p);
+        if (result != nullptr)
+            return result;
+    }
+    return w;
+}
+
+widget * widget_context::find_widget_at(point p)
+{
+    if (_tree.has_value() && !_tree_stale)
+        return _tree->find_widget_at(p);
+    else
+        return ::find_widget_at(&_main_widget, p);
+}
+
+void widget_context::set_font_cache_byte_budget(std::size_t bytes)
+{
+    _fm.set_cache_byte_budget(bytes);
+}
+
+void widget_context::enable_async_text_rendering(std::size_t num_threads)
+{
+    _fm.enable_async_rendering(num_threads);
+}
+
+void widget_context::set_frame_render_budget(std::chrono::steady_clock::duration budget)
+{
+    _frame_render_budget = budget;
+}
+
+void widget_context::enable_parallel_layout(std::size_t num_threads)
+{
+    _layout_arena.set_thread_pool(num_threads == 0 ? nullptr : std::make_shared<thread_pool>(num_threads));
+}
+
+void widget_context::open_font_async(std::size_t font_idx)
+{
+    _fm.open_font_async(font_idx);
+}
+
+void widget_context::prewarm_text(std::vector<std::string> const & texts, int font_idx)
+{
+    _fm.prewarm(texts, font_idx);
+}
+
+void widget_context::enable_persistent_text_cache(std::string directory)
+{
+    _fm.enable_persistent_cache(directory);
+}
+
+void widget_context::flush_persistent_text_cache()
+{
+    _fm.flush_persistent_cache();
+}
+
+font_cache_stats widget_context::get_font_cache_stats() const
+{
+    return _fm.cache_stats();
+}
+
+texture_cache & widget_context::get_texture_cache()
+{
+    return _texture_cache;
+}
+
+void widget_context::set_theme(std::shared_ptr<theme const> t)
+{
+    _dc.set_theme(std::move(t));
+    _main_widget.release_resources();
+}
+
+void widget_context::set_texture_byte_budget(std::size_t bytes)
+{
+    _memory_budget.set_byte_limit(bytes);
+    enforce_memory_budget();
+}
+
+memory_budget & widget_context::get_memory_budget()
+{
+    return _memory_budget;
+}
+
+void widget_context::release_memory()
+{
+    LIBWTK_SDL2_TRACE_SCOPE("frame", "release_memory");
+
+    // Retained drawings are not needed to show what is on screen already.
+    _main_widget.release_resources();
+    _memory_budget.release_all();
+}
+
+void widget_context::enforce_memory_budget()
+{
+    _memory_budget.enforce();
+}
+
+void widget_context::post(std::function<void()> update)
+{
+    _updates->post(std::move(update));
+}
+
+std::shared_ptr<update_queue> widget_context::get_update_queue() const
+{
+    return _updates;
+}
+
+void widget_context::drain_updates()
+{
+    LIBWTK_SDL2_TRACE_SCOPE("frame", "drain_updates");
+
+    // Updates might cause a local layout.
+    layout_arena::activation la(_layout_arena);
+    batch b(*this);
+    _updates->drain();
+}
+
+void widget_context::upload_rendered_words()
+{
+    // It is not known which widgets use the words, redraw everything.
+    if (_fm.upload_rendered_words())
+        _main_widget.mark_dirty();
+}
+
+void widget_context::begin_render_budget(std::chrono::steady_clock::time_point frame_start)
+{
+    if (_frame_render_budget > std::chrono::steady_clock::duration::zero())
+        _fm.set_render_deadline(frame_start + _frame_render_budget);
+}
+
+void widget_context::end_render_budget()
+{
+    if (_frame_render_budget <= std::chrono::steady_clock::duration::zero())
+        return;
+
+    // Text drawn outside of frames, e.g., when prewarming, is not limited.
+    _fm.set_render_deadline(std::nullopt);
+
+    // It is not known which widgets left out words, redraw everything.
+    if (_fm.take_deferred_words())
+    {
+        _main_widget.mark_dirty();
+
+        SDL_Event ev;
+        SDL_zero(ev);
+        ev.type = wakeup_event_type();
+        SDL_PushEvent(&ev);
+    }
+}
+
+void widget_context::add_event_source(event_source & s)
+{
+    if (!_source_watcher)
+        _source_watcher = std::make_unique<event_source_watcher>(wakeup_event_type());
+    _source_watcher->add(s);
+}
+
+void widget_context::remove_event_source(event_source & s)
+{
+    if (_source_watcher)
+        _source_watcher->remove(s);
 }
 
 void widget_context::activate()
@@ -161,6 +1102,9 @@ void widget_context::activate()
 
 void widget_context::navigate_selection(navigation_type nt)
 {
+    if (_navigation_index.has_value() && !_navigation_index->is_current())
+        _navigation_index->rebuild(_main_widget);
+
     _sc.navigate_selection(nt, &_main_widget);
 }
 
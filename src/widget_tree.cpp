@@ -0,0 +1,130 @@
+#include "widget.hpp"
+#include "widget_tree.hpp"
+
+widget_tree::widget_tree()
+{
+}
+
+void widget_tree::rebuild(widget & root)
+{
+    _widgets.clear();
+    _boxes.clear();
+    _subtree_sizes.clear();
+    flatten(&root);
+}
+
+void widget_tree::flatten(widget * w)
+{
+    std::size_t const k = _widgets.size();
+    _widgets.push_back(w);
+    _boxes.push_back(w->get_box());
+    _subtree_sizes.push_back(1);
+
+    auto const vcs = w->get_visible_children();
+    for (auto it = vcs.rbegin(); it != vcs.rend(); ++it)
+        flatten(*it);
+
+    _subtree_sizes[k] = _widgets.size() - k;
+}
+
+void widget_tree::update_boxes()
+{
+    for (std::size_t k = 0; k < _widgets.size(); ++k)
+        _boxes[k] = _widgets[k]->get_box();
+}
+
+void widget_tree::update_boxes(std::size_t k)
+{
+    std::size_t const end = k + _subtree_sizes[k];
+    for (; k < end; ++k)
+        _boxes[k] = _widgets[k]->get_box();
+}
+
+std::size_t widget_tree::size() const
+{
+    return _widgets.size();
+}
+
+bool widget_tree::children_match(std::size_t k) const
+{
+    auto const vcs = _widgets[k]->get_visible_children();
+    std::size_t const end = k + _subtree_sizes[k];
+    std::size_t c = k + 1;
+    for (auto it = vcs.rbegin(); it != vcs.rend(); ++it)
+    {
+        if (c == end || _widgets[c] != *it)
+            return false;
+        c += _subtree_sizes[c];
+    }
+    return c == end;
+}
+
+bool widget_tree::subtree_matches(std::size_t k) const
+{
+    std::size_t const end = k + _subtree_sizes[k];
+    for (std::size_t c = k; c < end; ++c)
+    {
+        if (!children_match(c))
+            return false;
+    }
+    return true;
+}
+
+void widget_tree::draw_and_clear_dirty(draw_context & dc, selection_context const & sc, damage_region * damage)
+{
+    std::size_t k = 0;
+    while (k < _widgets.size())
+    {
+        widget * w = _widgets[k];
+
+        if (w->_dirty == dirty_type::DIRTY || (w->_retained && w->_dirty == dirty_type::CHILD_DIRTY))
+        {
+            // The subtree is drawn entirely anyway. Widgets before k are not
+            // affected by changes within it, so the scan continues at the
+            // same index.
+            // The layout of the subtree might have been redone.
+            if (!subtree_matches(k))
+                rebuild(*_widgets.front());
+            else
+                update_boxes(k);
+
+            w->draw_dirty_area(dc, sc, damage);
+            w->clear_dirty();
+            k += _subtree_sizes[k];
+        }
+        else if (w->_dirty == dirty_type::CHILD_DIRTY)
+        {
+            if (!children_match(k))
+                rebuild(*_widgets.front());
+
+            w->_dirty = dirty_type::CLEAN;
+            ++k;
+        }
+        else
+        {
+            k += _subtree_sizes[k];
+        }
+    }
+}
+
+widget * widget_tree::find_widget_at(point p) const
+{
+    // Later widgets are drawn on top, the last one containing the point is
+    // the result.
+    widget * result = nullptr;
+    std::size_t k = 0;
+    while (k < _widgets.size())
+    {
+        if (within_rect(p, _boxes[k]))
+        {
+            result = _widgets[k];
+            ++k;
+        }
+        else
+        {
+            k += _subtree_sizes[k];
+        }
+    }
+    return result;
+}
+
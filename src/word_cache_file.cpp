@@ -0,0 +1,214 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "word_cache_file.hpp"
+
+// Changes whenever the layout of the file changes.
+uint32_t const FORMAT_VERSION = 1;
+
+// Detects files written on a machine with a different byte order.
+uint32_t const BYTE_ORDER_MARK = 0x01020304;
+
+char const MAGIC[8] = { 'W', 'T', 'K', 'W', 'O', 'R', 'D', 'S' };
+
+struct file_header
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t version;
+    uint64_t font_hash;
+    uint32_t font_size;
+    uint32_t count;
+};
+
+struct entry_header
+{
+    uint32_t word_length;
+    uint16_t w;
+    uint16_t h;
+};
+
+mapped_file::mapped_file()
+    : _data(nullptr)
+    , _size(0)
+{
+}
+
+mapped_file::mapped_file(std::string const & path)
+    : mapped_file()
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void * p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            _data = static_cast<uint8_t const *>(p);
+            _size = st.st_size;
+        }
+    }
+
+    // The mapping stays valid.
+    close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    unmap();
+}
+
+mapped_file::mapped_file(mapped_file && other)
+    : _data(other._data)
+    , _size(other._size)
+{
+    other._data = nullptr;
+    other._size = 0;
+}
+
+mapped_file & mapped_file::operator=(mapped_file && other)
+{
+    if (this != &other)
+    {
+        unmap();
+        _data = other._data;
+        _size = other._size;
+        other._data = nullptr;
+        other._size = 0;
+    }
+    return *this;
+}
+
+uint8_t const * mapped_file::data() const
+{
+    return _data;
+}
+
+std::size_t mapped_file::size() const
+{
+    return _size;
+}
+
+void mapped_file::unmap()
+{
+    if (_data != nullptr)
+        munmap(const_cast<uint8_t *>(_data), _size);
+}
+
+uint64_t hash_file(std::string const & path)
+{
+    mapped_file f(path);
+    if (f.data() == nullptr)
+        return 0;
+
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (std::size_t k = 0; k < f.size(); ++k)
+    {
+        h ^= f.data()[k];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+word_cache_reader::word_cache_reader(mapped_file const & f, uint64_t font_hash, uint32_t font_size)
+    : _ptr(f.data())
+    , _end(f.data() + f.size())
+    , _remaining(0)
+{
+    file_header h;
+    if (f.data() == nullptr || f.size() < sizeof(h))
+        return;
+
+    std::memcpy(&h, _ptr, sizeof(h));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0
+        && h.byte_order == BYTE_ORDER_MARK
+        && h.version == FORMAT_VERSION
+        && h.font_hash == font_hash
+        && h.font_size == font_size)
+    {
+        _ptr += sizeof(h);
+        _remaining = h.count;
+    }
+}
+
+bool word_cache_reader::next(std::string_view & word, vec & size, uint8_t const * & alpha)
+{
+    entry_header eh;
+    if (_remaining == 0 || static_cast<std::size_t>(_end - _ptr) < sizeof(eh))
+        return false;
+
+    std::memcpy(&eh, _ptr, sizeof(eh));
+    std::size_t const alpha_size = static_cast<std::size_t>(eh.w) * eh.h;
+
+    // Never trust the file, it might have been truncated.
+    if (static_cast<std::size_t>(_end - _ptr) < sizeof(eh) + eh.word_length + alpha_size)
+    {
+        _remaining = 0;
+        return false;
+    }
+
+    _ptr += sizeof(eh);
+    word = std::string_view(reinterpret_cast<char const *>(_ptr), eh.word_length);
+    _ptr += eh.word_length;
+    size = { eh.w, eh.h };
+    alpha = _ptr;
+    _ptr += alpha_size;
+
+    _remaining--;
+    return true;
+}
+
+word_cache_writer::word_cache_writer(std::string path, uint64_t font_hash, uint32_t font_size)
+    : _path(path)
+    , _tmp_path(path + ".tmp")
+    , _out(_tmp_path, std::ios::binary | std::ios::trunc)
+    , _count(0)
+{
+    file_header h;
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.byte_order = BYTE_ORDER_MARK;
+    h.version = FORMAT_VERSION;
+    h.font_hash = font_hash;
+    h.font_size = font_size;
+    // Updated once finished.
+    h.count = 0;
+    _out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+}
+
+void word_cache_writer::add(std::string_view word, vec size, uint8_t const * alpha)
+{
+    // Does not fit into the entry header.
+    if (size.w > UINT16_MAX || size.h > UINT16_MAX)
+        return;
+
+    entry_header eh { static_cast<uint32_t>(word.size()), static_cast<uint16_t>(size.w), static_cast<uint16_t>(size.h) };
+    _out.write(reinterpret_cast<char const *>(&eh), sizeof(eh));
+    _out.write(word.data(), word.size());
+    _out.write(reinterpret_cast<char const *>(alpha), static_cast<std::size_t>(size.w) * size.h);
+    _count++;
+}
+
+void word_cache_writer::finish()
+{
+    _out.seekp(offsetof(file_header, count));
+    _out.write(reinterpret_cast<char const *>(&_count), sizeof(_count));
+    _out.close();
+
+    if (!_out)
+        throw std::runtime_error("could not write word cache: " + _tmp_path);
+
+    // Readers of the old file keep their mapping.
+    if (std::rename(_tmp_path.c_str(), _path.c_str()) != 0)
+        throw std::runtime_error("could not replace word cache: " + _path);
+}
+